@@ -0,0 +1,26 @@
+#ifndef BINARY_IO_H
+#define BINARY_IO_H
+
+#include <cstddef>
+#include <cstdint>
+#include <istream>
+#include <ostream>
+
+// Little-endian integer encoding for the emulator's binary files, so that
+// they're portable between machines.
+
+template <typename T>
+inline void write_int(std::ostream& out, const T value) {
+    for (size_t i = 0; i < sizeof(T); ++i)
+        out.put(static_cast<char>((static_cast<uint64_t>(value) >> (8 * i)) & 0xFF));
+}
+
+template <typename T>
+inline T read_int(std::istream& in) {
+    uint64_t value = 0;
+    for (size_t i = 0; i < sizeof(T); ++i)
+        value |= static_cast<uint64_t>(static_cast<uint8_t>(in.get())) << (8 * i);
+    return static_cast<T>(value);
+}
+
+#endif
@@ -0,0 +1,83 @@
+#include "BitParallelSimulator.h"
+#include "Rom.h"
+
+// The 64-bit word holding `lane`'s bit.
+template <typename Bits>
+static uint64_t& lane_word(Bits& bits, const int lane) {
+    return reinterpret_cast<uint64_t*>(&bits)[lane / 64];
+}
+
+template <int LANES>
+BitParallelSimulator<LANES>::BitParallelSimulator(std::shared_ptr<const Netlist> netlist)
+        : _netlist(netlist), _wires(netlist->num_wires(), Bits{}), _dff_states(netlist->dffs().size(), Bits{}) {
+    if (!netlist->memories().empty())
+        throw HackRomError("'" + netlist->name() + "' has built-in memories, which can't be simulated bit-parallel.");
+    _wires[Netlist::TRUE_WIRE] = ~Bits{};
+    eval();
+}
+
+template <int LANES>
+void BitParallelSimulator<LANES>::set(const int lane, const std::string& name, const int16_t value) {
+    const NetlistPin& pin = find_pin(name, true);
+    const uint64_t lane_bit = 1ull << (lane % 64);
+    for (size_t i = 0; i < pin.wires.size(); ++i) {
+        uint64_t& word = lane_word(_wires[pin.wires[i]], lane);
+        word = (value >> i) & 1 ? word | lane_bit : word & ~lane_bit;
+    }
+}
+
+template <int LANES>
+int16_t BitParallelSimulator<LANES>::get(const int lane, const std::string& name) const {
+    const NetlistPin& pin = find_pin(name, false);
+    uint16_t value = 0;
+    for (size_t i = 0; i < pin.wires.size(); ++i) {
+        Bits bits = _wires[pin.wires[i]];
+        value |= ((lane_word(bits, lane) >> (lane % 64)) & 1) << i;
+    }
+    return value;
+}
+
+template <int LANES>
+void BitParallelSimulator<LANES>::set_wire(const uint32_t wire, const Bits& bits) {
+    _wires[wire] = bits;
+}
+
+template <int LANES>
+const typename BitParallelSimulator<LANES>::Bits& BitParallelSimulator<LANES>::wire(const uint32_t wire) const {
+    return _wires[wire];
+}
+
+template <int LANES>
+void BitParallelSimulator<LANES>::eval() {
+    Bits* wires = _wires.data();
+    Bits* out = wires + _netlist->first_nand_wire();
+    for (const NandGate& nand : _netlist->nands()) *out++ = ~(wires[nand.a] & wires[nand.b]);
+}
+
+template <int LANES>
+void BitParallelSimulator<LANES>::tick() {
+    eval();
+    const std::vector<DffGate>& dffs = _netlist->dffs();
+    for (size_t i = 0; i < dffs.size(); ++i) _dff_states[i] = _wires[dffs[i].in];
+}
+
+template <int LANES>
+void BitParallelSimulator<LANES>::tock() {
+    const std::vector<DffGate>& dffs = _netlist->dffs();
+    for (size_t i = 0; i < dffs.size(); ++i) _wires[dffs[i].out] = _dff_states[i];
+    eval();
+}
+
+template <int LANES>
+const NetlistPin& BitParallelSimulator<LANES>::find_pin(const std::string& name, const bool is_input_only) const {
+    for (const std::vector<NetlistPin>* pins : { &_netlist->inputs(), &_netlist->outputs() }) {
+        for (const NetlistPin& pin : *pins)
+            if (pin.name == name) return pin;
+        if (is_input_only) break;
+    }
+    throw HackRomError("'" + _netlist->name() + "' has no " + (is_input_only ? "input" : "pin") + " called '" + name + "'.");
+}
+
+// Supported lane counts.
+template class BitParallelSimulator<64>;
+template class BitParallelSimulator<256>;
@@ -0,0 +1,69 @@
+#ifndef BIT_PARALLEL_SIMULATOR_H
+#define BIT_PARALLEL_SIMULATOR_H
+
+#include "Netlist.h"
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+// One bit per lane, as a GCC vector of 64-bit words. Spelled out per lane
+// count for the same reason as LaneVector.
+template <int LANES>
+struct LaneBits;
+template <>
+struct LaneBits<64> { typedef uint64_t type; };
+template <>
+struct LaneBits<256> { typedef uint64_t type __attribute__((vector_size(32))); };
+
+/**
+ * Simulates LANES copies of a Netlist at once, each with its own inputs and
+ * DFF states. Each wire holds one bit per lane, so a NAND gate is evaluated
+ * for every lane with a single AND and NOT over 64 bits, or over 256 bits
+ * with AVX2 (see HACK_EMULATOR_AVX2). Intended for checking chips
+ * exhaustively or against many random inputs, see ChipChecker.
+ *
+ * Timing follows ChipSimulator.
+ */
+template <int LANES>
+class BitParallelSimulator {
+public:
+    typedef typename LaneBits<LANES>::type Bits;
+
+    /**
+     * Creates LANES copies of the chip with every input and DFF at 0. Throws
+     * if the chip has built-in memories.
+     */
+    explicit BitParallelSimulator(std::shared_ptr<const Netlist> netlist);
+
+    /**
+     * Sets an input pin of one lane. Throws if the chip has no such input.
+     */
+    void set(const int lane, const std::string& name, const int16_t value);
+
+    /**
+     * Reads an input or output pin of one lane. Throws if the chip has no such
+     * pin.
+     */
+    int16_t get(const int lane, const std::string& name) const;
+
+    /**
+     * Sets or reads one wire in every lane at once, with bit i of the result
+     * standing for lane i. Wires are numbered as in the Netlist.
+     */
+    void set_wire(const uint32_t wire, const Bits& bits);
+    const Bits& wire(const uint32_t wire) const;
+
+    void eval();
+    void tick();
+    void tock();
+
+private:
+    std::shared_ptr<const Netlist> _netlist;
+    std::vector<Bits> _wires;
+    std::vector<Bits> _dff_states;
+
+    const NetlistPin& find_pin(const std::string& name, const bool is_input_only) const;
+};
+
+#endif
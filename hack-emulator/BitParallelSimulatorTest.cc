@@ -0,0 +1,64 @@
+#include "BitParallelSimulator.h"
+#include "ChipSimulator.h"
+#include "Rom.h"
+#include <gtest/gtest.h>
+#include <memory>
+#include <random>
+
+// Evaluates the ALU with different inputs in every lane, and checks each lane
+// against the scalar simulator.
+template <int LANES>
+void check_alu_lanes() {
+    auto netlist = std::make_shared<const Netlist>(Netlist::from_file("../nand2tetris-exercises/02/ALU.hdl"));
+    const std::vector<std::string> inputs = { "x", "y", "zx", "nx", "zy", "ny", "f", "no" };
+    std::mt19937 rng(LANES);
+    std::vector<std::vector<int16_t>> lane_inputs(LANES);
+    BitParallelSimulator<LANES> lanes(netlist);
+    for (int l = 0; l < LANES; ++l) {
+        for (const std::string& name : inputs) {
+            const int16_t value = name.size() == 1 ? rng() : rng() & 1;
+            lane_inputs[l].push_back(value);
+            lanes.set(l, name, value);
+        }
+    }
+    lanes.eval();
+
+    for (int l = 0; l < LANES; ++l) {
+        ChipSimulator scalar(netlist);
+        for (size_t i = 0; i < inputs.size(); ++i) scalar.set(inputs[i], lane_inputs[l][i]);
+        scalar.eval();
+        for (const std::string name : { "out", "zr", "ng", "x" }) EXPECT_EQ(lanes.get(l, name), scalar.get(name)) << l;
+    }
+}
+
+TEST(BitParallelSimulatorTest, MatchesScalarSimulator64) {
+    check_alu_lanes<64>();
+}
+
+TEST(BitParallelSimulatorTest, MatchesScalarSimulator256) {
+    check_alu_lanes<256>();
+}
+
+TEST(BitParallelSimulatorTest, ClocksEachLane) {
+    BitParallelSimulator<64> bits(std::make_shared<const Netlist>(Netlist::from_file("../nand2tetris-exercises/03/a/Bit.hdl")));
+    // Even lanes load a 1.
+    for (int l = 0; l < 64; ++l) {
+        bits.set(l, "in", 1);
+        bits.set(l, "load", l % 2 == 0);
+    }
+    bits.tick();
+    EXPECT_EQ(bits.get(0, "out"), 0);
+    bits.tock();
+    for (int l = 0; l < 64; ++l) EXPECT_EQ(bits.get(l, "out"), l % 2 == 0) << l;
+    EXPECT_THROW(bits.set(0, "out", 1), HackRomError);
+    EXPECT_THROW(bits.get(0, "missing"), HackRomError);
+}
+
+TEST(BitParallelSimulatorTest, SetsWholeWires) {
+    auto netlist = std::make_shared<const Netlist>(Netlist::from_file("../nand2tetris-exercises/01/Xor.hdl"));
+    BitParallelSimulator<64> lanes(netlist);
+    lanes.set_wire(netlist->inputs()[0].wires[0], 0b0101);
+    lanes.set_wire(netlist->inputs()[1].wires[0], 0b0011);
+    lanes.eval();
+    EXPECT_EQ(lanes.wire(netlist->outputs()[0].wires[0]) & 0b1111, 0b0110);
+}
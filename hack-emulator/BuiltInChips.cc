@@ -0,0 +1,141 @@
+#include "BuiltInChips.h"
+#include <functional>
+#include <unordered_map>
+
+// Repeats `part` for bits 0 to 15, replacing each `#` with the bit's index.
+static std::string for_each_bit(const std::string& part) {
+    std::string parts;
+    for (int i = 0; i < 16; ++i) {
+        for (const char c : part) parts += c == '#' ? std::to_string(i) : std::string(1, c);
+        parts += '\n';
+    }
+    return parts;
+}
+
+// The pins of a memory chip that Netlist keeps as an array of words. It has
+// no parts, since it isn't built from gates.
+static std::string memory_hdl(const std::string& name, const int address_bits, const bool is_writable) {
+    std::string inputs = is_writable ? "in[16], load, " : "";
+    if (address_bits) inputs += "address[" + std::to_string(address_bits) + "]";
+    return "CHIP " + name + " { " + (inputs.empty() ? "" : "IN " + inputs + "; ") + "OUT out[16]; PARTS: }";
+}
+
+static const std::unordered_map<std::string, std::function<std::string()>> BUILT_IN_CHIPS = {
+    { "Not", [] { return "CHIP Not { IN in; OUT out; PARTS: Nand(a=in, b=in, out=out); }"; } },
+    { "And", [] { return "CHIP And { IN a, b; OUT out; PARTS: Nand(a=a, b=b, out=n); Nand(a=n, b=n, out=out); }"; } },
+    { "Or", [] {
+        return "CHIP Or { IN a, b; OUT out; PARTS:"
+               "Nand(a=a, b=a, out=na); Nand(a=b, b=b, out=nb); Nand(a=na, b=nb, out=out); }";
+    } },
+    { "Xor", [] {
+        return "CHIP Xor { IN a, b; OUT out; PARTS:"
+               "Nand(a=a, b=b, out=n); Nand(a=a, b=n, out=x); Nand(a=b, b=n, out=y); Nand(a=x, b=y, out=out); }";
+    } },
+    { "Mux", [] {
+        return "CHIP Mux { IN a, b, sel; OUT out; PARTS:"
+               "Nand(a=sel, b=sel, out=nsel); Nand(a=a, b=nsel, out=x); Nand(a=b, b=sel, out=y); Nand(a=x, b=y, out=out); }";
+    } },
+    { "DMux", [] {
+        return "CHIP DMux { IN in, sel; OUT a, b; PARTS:"
+               "Not(in=sel, out=nsel); And(a=in, b=nsel, out=a); And(a=in, b=sel, out=b); }";
+    } },
+    { "Not16", [] { return "CHIP Not16 { IN in[16]; OUT out[16]; PARTS:" + for_each_bit("Not(in=in[#], out=out[#]);") + "}"; } },
+    { "And16", [] {
+        return "CHIP And16 { IN a[16], b[16]; OUT out[16]; PARTS:" + for_each_bit("And(a=a[#], b=b[#], out=out[#]);") + "}";
+    } },
+    { "Or16", [] {
+        return "CHIP Or16 { IN a[16], b[16]; OUT out[16]; PARTS:" + for_each_bit("Or(a=a[#], b=b[#], out=out[#]);") + "}";
+    } },
+    { "Mux16", [] {
+        return "CHIP Mux16 { IN a[16], b[16], sel; OUT out[16]; PARTS:" +
+               for_each_bit("Mux(a=a[#], b=b[#], sel=sel, out=out[#]);") + "}";
+    } },
+    { "Or8Way", [] {
+        return "CHIP Or8Way { IN in[8]; OUT out; PARTS:"
+               "Or(a=in[0], b=in[1], out=o01); Or(a=in[2], b=in[3], out=o23); Or(a=in[4], b=in[5], out=o45);"
+               "Or(a=in[6], b=in[7], out=o67); Or(a=o01, b=o23, out=o03); Or(a=o45, b=o67, out=o47);"
+               "Or(a=o03, b=o47, out=out); }";
+    } },
+    { "Mux4Way16", [] {
+        return "CHIP Mux4Way16 { IN a[16], b[16], c[16], d[16], sel[2]; OUT out[16]; PARTS:"
+               "Mux16(a=a, b=b, sel=sel[0], out=ab); Mux16(a=c, b=d, sel=sel[0], out=cd);"
+               "Mux16(a=ab, b=cd, sel=sel[1], out=out); }";
+    } },
+    { "Mux8Way16", [] {
+        return "CHIP Mux8Way16 { IN a[16], b[16], c[16], d[16], e[16], f[16], g[16], h[16], sel[3]; OUT out[16]; PARTS:"
+               "Mux4Way16(a=a, b=b, c=c, d=d, sel=sel[0..1], out=ad); Mux4Way16(a=e, b=f, c=g, d=h, sel=sel[0..1], out=eh);"
+               "Mux16(a=ad, b=eh, sel=sel[2], out=out); }";
+    } },
+    { "DMux4Way", [] {
+        return "CHIP DMux4Way { IN in, sel[2]; OUT a, b, c, d; PARTS:"
+               "DMux(in=in, sel=sel[1], a=ab, b=cd); DMux(in=ab, sel=sel[0], a=a, b=b); DMux(in=cd, sel=sel[0], a=c, b=d); }";
+    } },
+    { "DMux8Way", [] {
+        return "CHIP DMux8Way { IN in, sel[3]; OUT a, b, c, d, e, f, g, h; PARTS:"
+               "DMux(in=in, sel=sel[2], a=ad, b=eh);"
+               "DMux4Way(in=ad, sel=sel[0..1], a=a, b=b, c=c, d=d); DMux4Way(in=eh, sel=sel[0..1], a=e, b=f, c=g, d=h); }";
+    } },
+    { "HalfAdder", [] {
+        return "CHIP HalfAdder { IN a, b; OUT sum, carry; PARTS: Xor(a=a, b=b, out=sum); And(a=a, b=b, out=carry); }";
+    } },
+    { "FullAdder", [] {
+        return "CHIP FullAdder { IN a, b, c; OUT sum, carry; PARTS:"
+               "HalfAdder(a=a, b=b, sum=ab, carry=c1); HalfAdder(a=ab, b=c, sum=sum, carry=c2); Or(a=c1, b=c2, out=carry); }";
+    } },
+    { "Add16", [] {
+        std::string hdl = "CHIP Add16 { IN a[16], b[16]; OUT out[16]; PARTS: HalfAdder(a=a[0], b=b[0], sum=out[0], carry=c0);\n";
+        for (int i = 1; i < 16; ++i) {
+            const std::string bit = std::to_string(i);
+            hdl += "FullAdder(a=a[" + bit + "], b=b[" + bit + "], c=c" + std::to_string(i - 1) + ", sum=out[" + bit + "], carry=c" + bit + ");\n";
+        }
+        return hdl + "}";
+    } },
+    { "Inc16", [] { return "CHIP Inc16 { IN in[16]; OUT out[16]; PARTS: Add16(a=in, b[0]=true, out=out); }"; } },
+    { "ALU", [] {
+        return "CHIP ALU { IN x[16], y[16], zx, nx, zy, ny, f, no; OUT out[16], zr, ng; PARTS:"
+               "Mux16(a=x, b=false, sel=zx, out=x1); Not16(in=x1, out=notx1); Mux16(a=x1, b=notx1, sel=nx, out=x2);"
+               "Mux16(a=y, b=false, sel=zy, out=y1); Not16(in=y1, out=noty1); Mux16(a=y1, b=noty1, sel=ny, out=y2);"
+               "And16(a=x2, b=y2, out=xandy); Add16(a=x2, b=y2, out=xplusy); Mux16(a=xandy, b=xplusy, sel=f, out=o1);"
+               "Not16(in=o1, out=noto1); Mux16(a=o1, b=noto1, sel=no, out=out, out[0..7]=low, out[8..15]=high, out[15]=ng);"
+               "Or8Way(in=low, out=orlow); Or8Way(in=high, out=orhigh); Or(a=orlow, b=orhigh, out=nonzero);"
+               "Not(in=nonzero, out=zr); }";
+    } },
+    { "Bit", [] {
+        return "CHIP Bit { IN in, load; OUT out; PARTS: Mux(a=state, b=in, sel=load, out=next); DFF(in=next, out=state, out=out); }";
+    } },
+    { "Register", [] {
+        return "CHIP Register { IN in[16], load; OUT out[16]; PARTS:" +
+               for_each_bit("Bit(in=in[#], load=load, out=out[#]);") + "}";
+    } },
+    { "ARegister", [] { return "CHIP ARegister { IN in[16], load; OUT out[16]; PARTS: Register(in=in, load=load, out=out); }"; } },
+    { "DRegister", [] { return "CHIP DRegister { IN in[16], load; OUT out[16]; PARTS: Register(in=in, load=load, out=out); }"; } },
+    { "PC", [] {
+        return "CHIP PC { IN in[16], load, inc, reset; OUT out[16]; PARTS:"
+               "Inc16(in=state, out=incremented); Mux16(a=state, b=incremented, sel=inc, out=o1);"
+               "Mux16(a=o1, b=in, sel=load, out=o2); Mux16(a=o2, b=false, sel=reset, out=next);"
+               "Register(in=next, load=true, out=state, out=out); }";
+    } },
+    { "RAM8", [] { return memory_hdl("RAM8", 3, true); } },
+    { "RAM64", [] { return memory_hdl("RAM64", 6, true); } },
+    { "RAM512", [] { return memory_hdl("RAM512", 9, true); } },
+    { "RAM4K", [] { return memory_hdl("RAM4K", 12, true); } },
+    { "RAM16K", [] { return memory_hdl("RAM16K", 14, true); } },
+    { "Screen", [] { return memory_hdl("Screen", 13, true); } },
+    { "Keyboard", [] { return memory_hdl("Keyboard", 0, false); } },
+    { "ROM32K", [] { return memory_hdl("ROM32K", 15, false); } }
+};
+
+std::optional<std::string> built_in_chip_hdl(const std::string& name) {
+    const auto chip = BUILT_IN_CHIPS.find(name);
+    if (chip == BUILT_IN_CHIPS.end()) return std::nullopt;
+    return chip->second();
+}
+
+bool is_built_in_register(const std::string& name) {
+    return name == "ARegister" || name == "DRegister" || name == "PC";
+}
+
+bool is_built_in_memory(const std::string& name) {
+    return name == "RAM8" || name == "RAM64" || name == "RAM512" || name == "RAM4K" || name == "RAM16K" ||
+           name == "Screen" || name == "Keyboard" || name == "ROM32K";
+}
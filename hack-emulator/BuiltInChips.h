@@ -0,0 +1,32 @@
+#ifndef BUILT_IN_CHIPS_H
+#define BUILT_IN_CHIPS_H
+
+#include <optional>
+#include <string>
+
+/**
+ * Returns HDL for one of the course's built-in chips from projects 1 to 3,
+ * eg. `Mux16`, `ALU` or `PC`, built from Nand and DFF gates. The course's
+ * tools implement these in Java, and use them for any part that isn't
+ * defined next to the chip being tested. Returns std::nullopt for any other
+ * chip.
+ *
+ * The RAM chips and project 5's `Screen`, `Keyboard` and `ROM32K` only have
+ * their pins, see is_built_in_memory().
+ */
+std::optional<std::string> built_in_chip_hdl(const std::string& name);
+
+/**
+ * Whether test scripts can refer to the state of a built-in part called
+ * `name` as `<name>[]`, eg. `DRegister[]`.
+ */
+bool is_built_in_register(const std::string& name);
+
+/**
+ * Whether the built-in chip called `name` is a memory, which Netlist keeps
+ * as an array of words rather than building it from gates. Test scripts
+ * refer to its words as `<name>[i]`.
+ */
+bool is_built_in_memory(const std::string& name);
+
+#endif
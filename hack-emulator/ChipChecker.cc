@@ -0,0 +1,171 @@
+#include "ChipChecker.h"
+#include "BitParallelSimulator.h"
+#include "Rom.h"
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <thread>
+
+// Vectors per batch. 256 lanes fill an AVX2 register.
+#ifdef __AVX2__
+constexpr int CHECK_LANES = 256;
+#else
+constexpr int CHECK_LANES = 64;
+#endif
+typedef BitParallelSimulator<CHECK_LANES> Simulator;
+constexpr int WORDS_PER_WIRE = CHECK_LANES / 64;
+
+// Number of bits needed to number the lanes.
+constexpr int LANE_INDEX_BITS = CHECK_LANES == 256 ? 8 : 6;
+
+// Bit i of the lane index, for the lanes in one 64-bit word.
+static const uint64_t LANE_INDEX_PATTERNS[6] = {
+    0xAAAAAAAAAAAAAAAAull, 0xCCCCCCCCCCCCCCCCull, 0xF0F0F0F0F0F0F0F0ull,
+    0xFF00FF00FF00FF00ull, 0xFFFF0000FFFF0000ull, 0xFFFFFFFF00000000ull
+};
+
+// Beyond this, checking every input would take years.
+constexpr int MAX_EXHAUSTIVE_INPUT_BITS = 48;
+
+static uint64_t* words_of(Simulator::Bits& bits) {
+    return reinterpret_cast<uint64_t*>(&bits);
+}
+
+// SplitMix64's output function, which turns a counter into random bits.
+static uint64_t mix(uint64_t x) {
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ull;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EBull;
+    return x ^ (x >> 31);
+}
+
+// Pairs up the wires of pins with the same name, checking they match.
+static std::vector<std::pair<uint32_t, uint32_t>> match_pins(const std::vector<NetlistPin>& chip_pins,
+                                                             const std::vector<NetlistPin>& reference_pins,
+                                                             const std::string& chip_name) {
+    if (chip_pins.size() != reference_pins.size())
+        throw HackRomError("'" + chip_name + "' and its reference have different pins.");
+    std::vector<std::pair<uint32_t, uint32_t>> wires;
+    for (const NetlistPin& pin : chip_pins) {
+        const auto reference_pin = std::find_if(reference_pins.begin(), reference_pins.end(),
+                                                [&](const NetlistPin& each_pin) { return each_pin.name == pin.name; });
+        if (reference_pin == reference_pins.end() || reference_pin->wires.size() != pin.wires.size())
+            throw HackRomError("'" + chip_name + "' and its reference have different pins.");
+        for (size_t i = 0; i < pin.wires.size(); ++i) wires.push_back({ pin.wires[i], reference_pin->wires[i] });
+    }
+    return wires;
+}
+
+ChipChecker::ChipChecker(std::shared_ptr<const Netlist> chip, std::shared_ptr<const Netlist> reference)
+        : _chip(chip), _reference(reference),
+          _input_wires(match_pins(chip->inputs(), reference->inputs(), chip->name())),
+          _output_wires(match_pins(chip->outputs(), reference->outputs(), chip->name())) {
+    for (const Netlist* netlist : { chip.get(), reference.get() }) {
+        if (!netlist->dffs().empty() || !netlist->memories().empty())
+            throw HackRomError("'" + netlist->name() + "' has DFFs or memories. Only combinational chips can be checked.");
+    }
+}
+
+int ChipChecker::num_input_bits() const {
+    return _input_wires.size();
+}
+
+ChipCheckResult ChipChecker::check_all_inputs(const int num_threads) const {
+    const int num_bits = num_input_bits();
+    if (num_bits > MAX_EXHAUSTIVE_INPUT_BITS)
+        throw HackRomError("'" + _chip->name() + "' has " + std::to_string(num_bits) + " input bits, too many to try them all.");
+
+    // The low input bits count up across the lanes and the rest count up
+    // across the batches.
+    auto input_bits = [](const uint64_t batch, const int input) {
+        Simulator::Bits bits;
+        uint64_t* words = words_of(bits);
+        for (int w = 0; w < WORDS_PER_WIRE; ++w) {
+            if (input < 6) words[w] = LANE_INDEX_PATTERNS[input];
+            else if (input < LANE_INDEX_BITS) words[w] = (w >> (input - 6)) & 1 ? ~0ull : 0;
+            else words[w] = (batch >> (input - LANE_INDEX_BITS)) & 1 ? ~0ull : 0;
+        }
+        return bits;
+    };
+    const uint64_t num_batches = num_bits <= LANE_INDEX_BITS ? 1 : 1ull << (num_bits - LANE_INDEX_BITS);
+    return { true, 1ull << num_bits, check_batches(num_batches, input_bits, num_threads) };
+}
+
+ChipCheckResult ChipChecker::check_random_inputs(const uint64_t num_vectors, const uint64_t seed, const int num_threads) const {
+    const uint64_t num_inputs = num_input_bits();
+    auto input_bits = [&](const uint64_t batch, const int input) {
+        Simulator::Bits bits;
+        uint64_t* words = words_of(bits);
+        for (int w = 0; w < WORDS_PER_WIRE; ++w) words[w] = mix(seed + ((batch * num_inputs + input) * WORDS_PER_WIRE + w));
+        return bits;
+    };
+    const uint64_t num_batches = (num_vectors + CHECK_LANES - 1) / CHECK_LANES;
+    return { false, num_batches * CHECK_LANES, check_batches(num_batches, input_bits, num_threads) };
+}
+
+ChipCheckResult ChipChecker::check(const uint64_t max_vectors, const int num_threads) const {
+    const int num_bits = num_input_bits();
+    if (num_bits < 64 && (1ull << num_bits) <= max_vectors) return check_all_inputs(num_threads);
+    return check_random_inputs(max_vectors, 0, num_threads);
+}
+
+template <typename InputBits>
+std::optional<ChipCounterexample> ChipChecker::check_batches(const uint64_t num_batches, const InputBits& input_bits,
+                                                             const int num_threads) const {
+    // Batches are handed out in chunks, and every worker stops once any of
+    // them finds a mismatch. The counterexample from the earliest batch
+    // found is kept.
+    static const uint64_t BATCHES_PER_CHUNK = 1024;
+    std::atomic<uint64_t> next_chunk(0);
+    std::atomic<bool> is_mismatch_found(false);
+    std::mutex counterexample_mutex;
+    std::optional<ChipCounterexample> counterexample;
+    uint64_t counterexample_batch = UINT64_MAX;
+
+    auto worker = [&]() {
+        Simulator chip(_chip);
+        Simulator reference(_reference);
+        for (uint64_t chunk = next_chunk++; chunk * BATCHES_PER_CHUNK < num_batches && !is_mismatch_found; chunk = next_chunk++) {
+            const uint64_t end_batch = std::min(num_batches, (chunk + 1) * BATCHES_PER_CHUNK);
+            for (uint64_t batch = chunk * BATCHES_PER_CHUNK; batch < end_batch; ++batch) {
+                for (size_t i = 0; i < _input_wires.size(); ++i) {
+                    const Simulator::Bits bits = input_bits(batch, i);
+                    chip.set_wire(_input_wires[i].first, bits);
+                    reference.set_wire(_input_wires[i].second, bits);
+                }
+                chip.eval();
+                reference.eval();
+
+                Simulator::Bits mismatches{};
+                for (const auto& [chip_wire, reference_wire] : _output_wires)
+                    mismatches |= chip.wire(chip_wire) ^ reference.wire(reference_wire);
+                const uint64_t* words = words_of(mismatches);
+                const auto word = std::find_if(words, words + WORDS_PER_WIRE, [](const uint64_t w) { return w != 0; });
+                if (word == words + WORDS_PER_WIRE) continue;
+
+                const int lane = (word - words) * 64 + __builtin_ctzll(*word);
+                ChipCounterexample found;
+                for (const NetlistPin& pin : _chip->inputs()) found.inputs.push_back({ pin.name, chip.get(lane, pin.name) });
+                for (const NetlistPin& pin : _chip->outputs()) {
+                    found.expected_outputs.push_back({ pin.name, reference.get(lane, pin.name) });
+                    found.actual_outputs.push_back({ pin.name, chip.get(lane, pin.name) });
+                }
+                std::lock_guard<std::mutex> lock(counterexample_mutex);
+                if (batch < counterexample_batch) {
+                    counterexample = found;
+                    counterexample_batch = batch;
+                }
+                is_mismatch_found = true;
+                return;
+            }
+        }
+    };
+
+    const uint64_t num_chunks = (num_batches + BATCHES_PER_CHUNK - 1) / BATCHES_PER_CHUNK;
+    const int num_workers = std::min<uint64_t>(num_threads > 0 ? num_threads : std::max(1u, std::thread::hardware_concurrency()),
+                                               std::max<uint64_t>(num_chunks, 1));
+    std::vector<std::thread> workers;
+    for (int i = 1; i < num_workers; ++i) workers.emplace_back(worker);
+    worker();
+    for (std::thread& each_worker : workers) each_worker.join();
+    return counterexample;
+}
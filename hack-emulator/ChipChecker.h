@@ -0,0 +1,87 @@
+#ifndef CHIP_CHECKER_H
+#define CHIP_CHECKER_H
+
+#include "Netlist.h"
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+/**
+ * Inputs on which a chip and its reference disagree, with both chips'
+ * outputs. Pins are in the order the chip declares them.
+ */
+struct ChipCounterexample {
+    std::vector<std::pair<std::string, int16_t>> inputs;
+    std::vector<std::pair<std::string, int16_t>> expected_outputs;
+    std::vector<std::pair<std::string, int16_t>> actual_outputs;
+};
+
+struct ChipCheckResult {
+    bool is_exhaustive;
+    uint64_t num_vectors;
+
+    // Set if the chips disagreed on any of the vectors.
+    std::optional<ChipCounterexample> counterexample;
+};
+
+/**
+ * Checks a combinational chip against a reference chip with the same pins,
+ * such as the built-in chip of the same name, on every possible input or on
+ * random inputs.
+ *
+ * Both chips are simulated with a BitParallelSimulator, 64 input vectors at a
+ * time, or 256 when built with AVX2. Inputs are dealt to the lanes as bit
+ * patterns rather than one vector at a time. Outputs are compared by XORing
+ * whole wires, so a vector only costs its share of one pass over each chip's
+ * gates.
+ */
+class ChipChecker {
+public:
+    /**
+     * Throws if the chips' pins differ or either has DFFs or memories.
+     */
+    ChipChecker(std::shared_ptr<const Netlist> chip, std::shared_ptr<const Netlist> reference);
+
+    /**
+     * Total width of the chip's inputs. Checking every input takes
+     * 2^num_input_bits() vectors.
+     */
+    int num_input_bits() const;
+
+    /**
+     * Checks every possible input on `num_threads` threads, or one per core if
+     * 0.
+     */
+    ChipCheckResult check_all_inputs(const int num_threads = 0) const;
+
+    /**
+     * Checks at least `num_vectors` random inputs, generated from `seed`.
+     */
+    ChipCheckResult check_random_inputs(const uint64_t num_vectors, const uint64_t seed, const int num_threads = 0) const;
+
+    /**
+     * Checks every input if that's at most `max_vectors` vectors, and
+     * otherwise `max_vectors` random ones.
+     */
+    ChipCheckResult check(const uint64_t max_vectors, const int num_threads = 0) const;
+
+private:
+    std::shared_ptr<const Netlist> _chip;
+    std::shared_ptr<const Netlist> _reference;
+
+    // Matching input and output wires of the two chips, least significant
+    // bit of the first pin first.
+    std::vector<std::pair<uint32_t, uint32_t>> _input_wires;
+    std::vector<std::pair<uint32_t, uint32_t>> _output_wires;
+
+    // Checks batches 0 to `num_batches` - 1 of vectors, one per lane. Input
+    // wire i of batch b is set to `input_bits(b, i)`.
+    template <typename InputBits>
+    std::optional<ChipCounterexample> check_batches(const uint64_t num_batches, const InputBits& input_bits,
+                                                    const int num_threads) const;
+};
+
+#endif
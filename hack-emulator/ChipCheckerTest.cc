@@ -0,0 +1,65 @@
+#include "ChipChecker.h"
+#include "Rom.h"
+#include <gtest/gtest.h>
+#include <memory>
+#include <sstream>
+
+static std::shared_ptr<const Netlist> netlist_of(const std::string& hdl) {
+    std::istringstream hdl_in(hdl);
+    return std::make_shared<const Netlist>(Netlist::from_chip(HdlChip::parse(hdl_in, "Test.hdl"), ""));
+}
+
+static std::shared_ptr<const Netlist> built_in(const std::string& name) {
+    return std::make_shared<const Netlist>(Netlist::from_built_in(name));
+}
+
+TEST(ChipCheckerTest, ChecksEveryInput) {
+    auto mux = std::make_shared<const Netlist>(Netlist::from_file("../nand2tetris-exercises/01/Mux4Way16.hdl"));
+    auto inc = std::make_shared<const Netlist>(Netlist::from_file("../nand2tetris-exercises/02/Inc16.hdl"));
+    ChipChecker inc_checker(inc, built_in("Inc16"));
+    EXPECT_EQ(inc_checker.num_input_bits(), 16);
+    const ChipCheckResult result = inc_checker.check_all_inputs(2);
+    EXPECT_TRUE(result.is_exhaustive);
+    EXPECT_EQ(result.num_vectors, 65536);
+    EXPECT_FALSE(result.counterexample);
+
+    ChipChecker mux_checker(mux, built_in("Mux4Way16"));
+    EXPECT_EQ(mux_checker.num_input_bits(), 66);
+    EXPECT_THROW(mux_checker.check_all_inputs(), HackRomError);
+    const ChipCheckResult random_result = mux_checker.check(100000);
+    EXPECT_FALSE(random_result.is_exhaustive);
+    EXPECT_GE(random_result.num_vectors, 100000);
+    EXPECT_FALSE(random_result.counterexample);
+}
+
+TEST(ChipCheckerTest, FindsCounterexamples) {
+    // An "Xor" that's really an Or.
+    auto wrong_xor = netlist_of("CHIP Xor { IN a, b; OUT out; PARTS: Or(a=a, b=b, out=out); }");
+    const ChipCheckResult result = ChipChecker(wrong_xor, built_in("Xor")).check(1000, 1);
+    EXPECT_TRUE(result.is_exhaustive);
+    ASSERT_TRUE(result.counterexample);
+    const ChipCounterexample& counterexample = *result.counterexample;
+    EXPECT_EQ(counterexample.inputs, (std::vector<std::pair<std::string, int16_t>>{ { "a", 1 }, { "b", 1 } }));
+    EXPECT_EQ(counterexample.expected_outputs, (std::vector<std::pair<std::string, int16_t>>{ { "out", 0 } }));
+    EXPECT_EQ(counterexample.actual_outputs, (std::vector<std::pair<std::string, int16_t>>{ { "out", 1 } }));
+
+    // An adder that drops the carry out of bit 11 is only wrong on a sixteenth
+    // of inputs, so random vectors find it straight away.
+    std::string hdl = "CHIP Add16 { IN a[16], b[16]; OUT out[16]; PARTS: HalfAdder(a=a[0], b=b[0], sum=out[0], carry=c0);";
+    for (int i = 1; i < 16; ++i) {
+        const std::string bit = std::to_string(i);
+        const std::string carry_in = i == 12 ? "false" : "c" + std::to_string(i - 1);
+        hdl += "FullAdder(a=a[" + bit + "], b=b[" + bit + "], c=" + carry_in + ", sum=out[" + bit + "], carry=c" + bit + ");";
+    }
+    const ChipCheckResult add_result = ChipChecker(netlist_of(hdl + "}"), built_in("Add16")).check_random_inputs(10000, 7);
+    ASSERT_TRUE(add_result.counterexample);
+    const int16_t a = add_result.counterexample->inputs[0].second;
+    const int16_t b = add_result.counterexample->inputs[1].second;
+    EXPECT_EQ(add_result.counterexample->expected_outputs[0].second, static_cast<int16_t>(a + b));
+    EXPECT_NE(add_result.counterexample->actual_outputs[0].second, static_cast<int16_t>(a + b));
+}
+
+TEST(ChipCheckerTest, RejectsMismatchedChips) {
+    EXPECT_THROW(ChipChecker(built_in("And"), built_in("Not")), HackRomError);
+    EXPECT_THROW(ChipChecker(built_in("Bit"), built_in("Bit")), HackRomError);
+}
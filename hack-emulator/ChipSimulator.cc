@@ -0,0 +1,246 @@
+#include "ChipSimulator.h"
+#include <algorithm>
+#include <cctype>
+#include <numeric>
+
+// How many consecutive NAND gates are scheduled and evaluated together, at
+// most 64. Within a block, evaluating a gate costs about as much as checking
+// whether it needs evaluating would.
+constexpr uint32_t BLOCK_SIZE = 64;
+
+// Finds a pin among `pins`.
+static const NetlistPin* find_pin(const std::vector<NetlistPin>& pins, const std::string& name) {
+    for (const NetlistPin& pin : pins)
+        if (pin.name == name) return &pin;
+    return nullptr;
+}
+
+ChipSimulator::ChipSimulator(std::shared_ptr<const Netlist> netlist)
+        : _netlist(netlist), _wires(netlist->num_wires(), 0), _dff_states(netlist->dffs().size(), 0),
+          _num_blocks(netlist->nands().size() / BLOCK_SIZE + 1), _fanout_start(netlist->num_wires() + 1, 0),
+          _first_scheduled_word(0), _num_scheduled(0), _is_dff_dirty(netlist->dffs().size(), 0) {
+    const std::vector<NandGate>& nands = netlist->nands();
+    const std::vector<NetlistMemory>& memories = netlist->memories();
+    const std::vector<DffGate>& dffs = netlist->dffs();
+    for (const NetlistMemory& memory : memories) _memory_words.emplace_back(1 << memory.address.size(), 0);
+
+    // Block b holds NAND gates b * BLOCK_SIZE onwards, and the memories read
+    // among them.
+    auto block_of_memory = [&](const size_t memory) { return memories[memory].num_nands_before / BLOCK_SIZE; };
+    _first_memory_of_block.assign(_num_blocks + 1, 0);
+    for (size_t i = 0; i < memories.size(); ++i) ++_first_memory_of_block[block_of_memory(i) + 1];
+    std::partial_sum(_first_memory_of_block.begin(), _first_memory_of_block.end(), _first_memory_of_block.begin());
+
+    // Each wire's fan-out is the blocks that read it, apart from the block
+    // driving it, which reads it later in the same pass anyway.
+    std::vector<uint32_t> driving_block(netlist->num_wires(), _num_blocks);
+    for (uint32_t i = 0; i < nands.size(); ++i) driving_block[netlist->first_nand_wire() + i] = i / BLOCK_SIZE;
+    for (uint32_t i = 0; i < memories.size(); ++i)
+        for (const uint32_t wire : memories[i].out) driving_block[wire] = block_of_memory(i);
+    std::vector<std::pair<uint32_t, uint32_t>> reads;
+    for (uint32_t i = 0; i < nands.size(); ++i) {
+        reads.push_back({ nands[i].a, i / BLOCK_SIZE });
+        reads.push_back({ nands[i].b, i / BLOCK_SIZE });
+    }
+    for (uint32_t i = 0; i < memories.size(); ++i)
+        for (const uint32_t wire : memories[i].address) reads.push_back({ wire, block_of_memory(i) });
+    for (uint32_t i = 0; i < dffs.size(); ++i) reads.push_back({ dffs[i].in, _num_blocks + i });
+    std::sort(reads.begin(), reads.end());
+    reads.erase(std::unique(reads.begin(), reads.end()), reads.end());
+    for (const auto& [wire, reader] : reads) {
+        if (reader == driving_block[wire]) continue;
+        ++_fanout_start[wire + 1];
+        _fanout.push_back(reader);
+    }
+    std::partial_sum(_fanout_start.begin(), _fanout_start.end(), _fanout_start.begin());
+
+    // Everything starts at 0, so the first evaluation covers every gate.
+    _wires[Netlist::TRUE_WIRE] = 1;
+    _scheduled.assign((_num_blocks + 63) / 64, 0);
+    for (uint32_t block = 0; block < _num_blocks; ++block) schedule(block);
+    for (uint32_t dff = 0; dff < dffs.size(); ++dff) mark_dirty(dff);
+    eval();
+}
+
+std::optional<int16_t> ChipSimulator::get(const std::string& name) const {
+    const NetlistPin* pin = find_pin(_netlist->inputs(), name);
+    if (!pin) pin = find_pin(_netlist->outputs(), name);
+    if (pin) {
+        uint16_t value = 0;
+        for (size_t i = 0; i < pin->wires.size(); ++i) value |= _wires[pin->wires[i]] << i;
+        return value;
+    }
+
+    // Built-in registers show what they latched on the tick straight away,
+    // as they do in the course's simulator. So do memories.
+    if (const NetlistRegister* chip_register = find_register(name)) {
+        uint16_t value = 0;
+        for (size_t i = 0; i < chip_register->dffs.size(); ++i) value |= _dff_states[chip_register->dffs[i]] << i;
+        return value;
+    }
+    if (const auto word = find_memory_word(name)) return _memory_words[word->first][word->second];
+    return std::nullopt;
+}
+
+bool ChipSimulator::set(const std::string& name, const int16_t value) {
+    if (const NetlistPin* pin = find_pin(_netlist->inputs(), name)) {
+        for (size_t i = 0; i < pin->wires.size(); ++i) set_wire(pin->wires[i], (value >> i) & 1);
+        return true;
+    }
+    if (const NetlistRegister* chip_register = find_register(name)) {
+        const std::vector<DffGate>& dffs = _netlist->dffs();
+        for (size_t i = 0; i < chip_register->dffs.size(); ++i) {
+            const uint32_t dff = chip_register->dffs[i];
+            _dff_states[dff] = (value >> i) & 1;
+            set_wire(dffs[dff].out, _dff_states[dff]);
+            // It has to latch its input again on the next tick.
+            mark_dirty(dff);
+        }
+        return true;
+    }
+    if (const auto word = find_memory_word(name)) {
+        _memory_words[word->first][word->second] = value;
+        schedule(_netlist->memories()[word->first].num_nands_before / BLOCK_SIZE);
+        return true;
+    }
+    return false;
+}
+
+bool ChipSimulator::load(const std::string& name, const std::vector<uint16_t>& words) {
+    const std::vector<NetlistMemory>& memories = _netlist->memories();
+    for (size_t i = 0; i < memories.size(); ++i) {
+        if (memories[i].name != name) continue;
+        if (words.size() > _memory_words[i].size()) return false;
+        std::copy(words.begin(), words.end(), _memory_words[i].begin());
+        schedule(memories[i].num_nands_before / BLOCK_SIZE);
+        return true;
+    }
+    return false;
+}
+
+void ChipSimulator::eval() {
+    const size_t num_nands = _netlist->nands().size();
+    // Evaluating a block only schedules later blocks, so one pass over the
+    // bitmap finds them all.
+    for (size_t word = _first_scheduled_word; _num_scheduled && word < _scheduled.size(); ++word) {
+        while (const uint64_t bits = _scheduled[word]) {
+            _scheduled[word] = bits & (bits - 1);
+            --_num_scheduled;
+            const size_t block = word * 64 + __builtin_ctzll(bits);
+            const size_t end = std::min(num_nands, (block + 1) * BLOCK_SIZE);
+            size_t first = block * BLOCK_SIZE;
+            for (uint32_t memory = _first_memory_of_block[block]; memory < _first_memory_of_block[block + 1]; ++memory) {
+                const size_t memory_nand = _netlist->memories()[memory].num_nands_before;
+                eval_nands(first, memory_nand);
+                read_memory(memory);
+                first = memory_nand;
+            }
+            eval_nands(first, end);
+        }
+    }
+    _first_scheduled_word = _scheduled.size();
+}
+
+void ChipSimulator::tick() {
+    eval();
+    const std::vector<DffGate>& dffs = _netlist->dffs();
+    for (const uint32_t dff : _dirty_dffs) {
+        _is_dff_dirty[dff] = 0;
+        _dff_states[dff] = _wires[dffs[dff].in];
+        if (_dff_states[dff] != _wires[dffs[dff].out]) _changed_dffs.push_back(dff);
+    }
+    _dirty_dffs.clear();
+
+    const std::vector<NetlistMemory>& memories = _netlist->memories();
+    for (size_t i = 0; i < memories.size(); ++i) {
+        if (!_wires[memories[i].load]) continue;
+        uint16_t value = 0;
+        for (size_t bit = 0; bit < memories[i].in.size(); ++bit) value |= _wires[memories[i].in[bit]] << bit;
+        _memory_words[i][memory_address(memories[i])] = value;
+        _written_memories.push_back(i);
+    }
+}
+
+void ChipSimulator::tock() {
+    const std::vector<DffGate>& dffs = _netlist->dffs();
+    for (const uint32_t dff : _changed_dffs) set_wire(dffs[dff].out, _dff_states[dff]);
+    _changed_dffs.clear();
+    for (const uint32_t memory : _written_memories) schedule(_netlist->memories()[memory].num_nands_before / BLOCK_SIZE);
+    _written_memories.clear();
+    eval();
+}
+
+void ChipSimulator::eval_nands(const size_t first, const size_t end) {
+    const NandGate* nands = _netlist->nands().data();
+    uint8_t* wires = _wires.data();
+    const uint32_t first_nand_wire = _netlist->first_nand_wire();
+    uint8_t* out = wires + first_nand_wire;
+    // Evaluate without branching, then fan out from the gates that changed.
+    uint64_t changed = 0;
+    for (size_t i = first; i < end; ++i) {
+        const uint8_t value = (wires[nands[i].a] & wires[nands[i].b]) ^ 1;
+        changed |= static_cast<uint64_t>(value ^ out[i]) << (i - first);
+        out[i] = value;
+    }
+    for (; changed; changed &= changed - 1) {
+        const uint32_t wire = first_nand_wire + first + __builtin_ctzll(changed);
+        for (uint32_t i = _fanout_start[wire]; i < _fanout_start[wire + 1]; ++i) schedule(_fanout[i]);
+    }
+}
+
+void ChipSimulator::set_wire(const uint32_t wire, const uint8_t value) {
+    if (_wires[wire] == value) return;
+    _wires[wire] = value;
+    for (uint32_t i = _fanout_start[wire]; i < _fanout_start[wire + 1]; ++i) schedule(_fanout[i]);
+}
+
+void ChipSimulator::schedule(const uint32_t block) {
+    if (block >= _num_blocks) {
+        mark_dirty(block - _num_blocks);
+        return;
+    }
+    uint64_t& word = _scheduled[block / 64];
+    const uint64_t bit = 1ull << (block % 64);
+    if (word & bit) return;
+    word |= bit;
+    ++_num_scheduled;
+    _first_scheduled_word = std::min(_first_scheduled_word, static_cast<size_t>(block / 64));
+}
+
+void ChipSimulator::mark_dirty(const uint32_t dff) {
+    if (_is_dff_dirty[dff]) return;
+    _is_dff_dirty[dff] = 1;
+    _dirty_dffs.push_back(dff);
+}
+
+void ChipSimulator::read_memory(const size_t memory) {
+    const NetlistMemory& netlist_memory = _netlist->memories()[memory];
+    const uint16_t value = _memory_words[memory][memory_address(netlist_memory)];
+    for (size_t bit = 0; bit < netlist_memory.out.size(); ++bit) set_wire(netlist_memory.out[bit], (value >> bit) & 1);
+}
+
+uint16_t ChipSimulator::memory_address(const NetlistMemory& memory) const {
+    uint16_t address = 0;
+    for (size_t bit = 0; bit < memory.address.size(); ++bit) address |= _wires[memory.address[bit]] << bit;
+    return address;
+}
+
+const NetlistRegister* ChipSimulator::find_register(const std::string& name) const {
+    for (const NetlistRegister& chip_register : _netlist->registers())
+        if (name == chip_register.name + "[]" || name == chip_register.name + "[0]") return &chip_register;
+    return nullptr;
+}
+
+std::optional<std::pair<size_t, uint32_t>> ChipSimulator::find_memory_word(const std::string& name) const {
+    const size_t open_bracket = name.find('[');
+    if (open_bracket == std::string::npos || name.back() != ']') return std::nullopt;
+    const std::string index = name.substr(open_bracket + 1, name.size() - open_bracket - 2);
+    if (index.size() > 5 || !std::all_of(index.begin(), index.end(), [](const char c) { return std::isdigit(c); }))
+        return std::nullopt;
+    const uint32_t word = index.empty() ? 0 : std::stoul(index);
+
+    const std::vector<NetlistMemory>& memories = _netlist->memories();
+    for (size_t i = 0; i < memories.size(); ++i)
+        if (memories[i].name == name.substr(0, open_bracket) && word < _memory_words[i].size()) return std::make_pair(i, word);
+    return std::nullopt;
+}
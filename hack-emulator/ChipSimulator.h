@@ -0,0 +1,113 @@
+#ifndef CHIP_SIMULATOR_H
+#define CHIP_SIMULATOR_H
+
+#include "Netlist.h"
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+/**
+ * Simulates a Netlist gate by gate, following the course's hardware
+ * simulator: setting an input changes nothing until the chip is evaluated,
+ * DFFs sample their inputs on the tick and change their outputs on the tock.
+ * Built-in memories are read like gates, and written on the tick.
+ *
+ * Simulation is event driven. Only gates with an input that changed are
+ * evaluated, found through each wire's fan-out list. Gates are scheduled in
+ * blocks of consecutive gates in evaluation order, so a busy stretch of logic
+ * like an ALU costs about what a plain pass over it would, while a quiet one,
+ * like the words of a RAM16K built from DFFs that aren't being accessed,
+ * costs nothing.
+ */
+class ChipSimulator {
+public:
+    explicit ChipSimulator(std::shared_ptr<const Netlist> netlist);
+
+    /**
+     * Reads an input or output pin, a built-in register as `<name>[]` or a
+     * word of a built-in memory as `<name>[i]`. Pins narrower than 16 bits
+     * read as unsigned. Returns std::nullopt if the chip has no such pin.
+     */
+    std::optional<int16_t> get(const std::string& name) const;
+
+    /**
+     * Sets an input pin, the state of a built-in register or a word of a
+     * built-in memory. Returns false if the chip has no such pin.
+     */
+    bool set(const std::string& name, const int16_t value);
+
+    /**
+     * Copies `words` into the built-in memory called `name`, eg. a program
+     * into `ROM32K`, starting from its first word. Returns false if the chip
+     * has no such memory or the words don't fit.
+     */
+    bool load(const std::string& name, const std::vector<uint16_t>& words);
+
+    /**
+     * Settles every wire for the current inputs and DFF outputs.
+     */
+    void eval();
+
+    /**
+     * The first half of a clock cycle: settles the wires, latches each DFF's
+     * input and writes to the memories.
+     */
+    void tick();
+
+    /**
+     * The second half of a clock cycle: the DFFs output what they latched and
+     * the wires settle again.
+     */
+    void tock();
+
+private:
+    std::shared_ptr<const Netlist> _netlist;
+    std::vector<uint8_t> _wires;
+
+    // What each DFF latched on the last tick.
+    std::vector<uint8_t> _dff_states;
+
+    std::vector<std::vector<int16_t>> _memory_words;
+
+    // NAND gates are scheduled in blocks of consecutive gates, along with the
+    // memories read among them, from `_first_memory_of_block[block]` up to
+    // the next block's. The blocks that read each wire are
+    // `_fanout[_fanout_start[wire]]` up to the next wire's start. DFF i is
+    // recorded as block `_num_blocks + i`.
+    uint32_t _num_blocks;
+    std::vector<uint32_t> _first_memory_of_block;
+    std::vector<uint32_t> _fanout_start;
+    std::vector<uint32_t> _fanout;
+
+    // One bit per block waiting to be evaluated, and the first word with any.
+    std::vector<uint64_t> _scheduled;
+    size_t _first_scheduled_word;
+    size_t _num_scheduled;
+
+    // DFFs whose input may have changed since the last tick, and the ones
+    // that latched a new value on it.
+    std::vector<uint32_t> _dirty_dffs;
+    std::vector<uint8_t> _is_dff_dirty;
+    std::vector<uint32_t> _changed_dffs;
+
+    // Memories written on the last tick.
+    std::vector<uint32_t> _written_memories;
+
+    // Evaluates NAND gates `first` to `end` - 1, which are in one block.
+    void eval_nands(const size_t first, const size_t end);
+    void set_wire(const uint32_t wire, const uint8_t value);
+    void schedule(const uint32_t block);
+    void mark_dirty(const uint32_t dff);
+    void read_memory(const size_t memory);
+    uint16_t memory_address(const NetlistMemory& memory) const;
+
+    const NetlistRegister* find_register(const std::string& name) const;
+
+    // Finds the memory word `<name>[i]`.
+    std::optional<std::pair<size_t, uint32_t>> find_memory_word(const std::string& name) const;
+};
+
+#endif
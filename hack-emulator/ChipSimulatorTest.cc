@@ -0,0 +1,113 @@
+#include "BitParallelSimulator.h"
+#include "ChipSimulator.h"
+#include "NetlistOptimiser.h"
+#include "Rom.h"
+#include <gtest/gtest.h>
+#include <memory>
+#include <random>
+#include <sstream>
+
+TEST(ChipSimulatorTest, EvaluatesCombinationalChips) {
+    ChipSimulator alu(std::make_shared<const Netlist>(Netlist::from_file("../nand2tetris-exercises/02/ALU.hdl")));
+    // x - y is zx=0, nx=1, zy=0, ny=0, f=1, no=1.
+    for (const auto& [name, value] : std::vector<std::pair<std::string, int16_t>>{
+             { "x", 17 }, { "y", 20 }, { "nx", 1 }, { "f", 1 }, { "no", 1 } })
+        ASSERT_TRUE(alu.set(name, value));
+    EXPECT_EQ(alu.get("out"), 0);  // Nothing changes until the chip is evaluated.
+    alu.eval();
+    EXPECT_EQ(alu.get("out"), -3);
+    EXPECT_EQ(alu.get("ng"), 1);
+    EXPECT_EQ(alu.get("zr"), 0);
+    EXPECT_EQ(alu.get("x"), 17);
+    EXPECT_EQ(alu.get("missing"), std::nullopt);
+    EXPECT_FALSE(alu.set("out", 1));
+}
+
+TEST(ChipSimulatorTest, ClocksDffs) {
+    ChipSimulator bit(std::make_shared<const Netlist>(Netlist::from_file("../nand2tetris-exercises/03/a/Bit.hdl")));
+    bit.set("in", 1);
+    bit.set("load", 1);
+    bit.tick();
+    EXPECT_EQ(bit.get("out"), 0);
+    bit.tock();
+    EXPECT_EQ(bit.get("out"), 1);
+
+    bit.set("in", 0);
+    bit.set("load", 0);
+    bit.tick();
+    bit.tock();
+    EXPECT_EQ(bit.get("out"), 1);
+}
+
+TEST(ChipSimulatorTest, ReadsAndWritesBuiltInRegisters) {
+    ChipSimulator cpu(std::make_shared<const Netlist>(Netlist::from_file("../nand2tetris-exercises/05/CPU.hdl")));
+    ASSERT_TRUE(cpu.set("DRegister[]", 5));
+    cpu.set("instruction", static_cast<int16_t>(0b1110011111010000));  // D=D+1
+    cpu.tick();
+    // The register shows its new value after the tick, but its output only
+    // changes on the tock.
+    EXPECT_EQ(cpu.get("DRegister[]"), 6);
+    EXPECT_EQ(cpu.get("outM"), 6);
+    cpu.tock();
+    EXPECT_EQ(cpu.get("outM"), 7);
+    EXPECT_EQ(cpu.get("pc"), 1);
+    EXPECT_EQ(cpu.get("PC[]"), 1);
+}
+
+TEST(ChipSimulatorTest, ReadsAndWritesBuiltInMemories) {
+    std::istringstream hdl_in("CHIP Test { IN in[16], load, address[3]; OUT out[16]; PARTS:"
+                              "RAM8(in=in, load=load, address=address, out=out); }");
+    ChipSimulator ram(std::make_shared<const Netlist>(Netlist::from_chip(HdlChip::parse(hdl_in, "Test.hdl"), "")));
+    ram.set("in", 5);
+    ram.set("load", 1);
+    ram.set("address", 3);
+    ram.tick();
+    // Like a register, the word shows its new value after the tick, but the
+    // output only changes on the tock.
+    EXPECT_EQ(ram.get("RAM8[3]"), 5);
+    EXPECT_EQ(ram.get("out"), 0);
+    ram.tock();
+    EXPECT_EQ(ram.get("out"), 5);
+
+    ASSERT_TRUE(ram.set("RAM8[7]", -9));
+    ram.set("address", 7);
+    ram.eval();
+    EXPECT_EQ(ram.get("out"), -9);
+    EXPECT_EQ(ram.get("RAM8[8]"), std::nullopt);
+    EXPECT_FALSE(ram.load("RAM8", std::vector<uint16_t>(9, 1)));
+}
+
+TEST(ChipSimulatorTest, RunsProgramsOnComputer) {
+    ChipSimulator computer(std::make_shared<const Netlist>(
+        NetlistOptimiser::optimise(Netlist::from_file("../nand2tetris-exercises/05/Computer.hdl"))));
+    ASSERT_TRUE(computer.load("ROM32K", Rom::from_file("../nand2tetris-exercises/05/Max.hack").words()));
+    computer.set("RAM16K[0]", 23456);
+    computer.set("RAM16K[1]", 12345);
+    for (int i = 0; i < 20; ++i) {
+        computer.tick();
+        computer.tock();
+    }
+    EXPECT_EQ(computer.get("RAM16K[2]"), 23456);
+}
+
+TEST(ChipSimulatorTest, MatchesFullPassSimulation) {
+    // Only the gates whose inputs changed are evaluated, so check against
+    // BitParallelSimulator, which evaluates every gate every time.
+    auto netlist = std::make_shared<const Netlist>(Netlist::from_file("../nand2tetris-exercises/05/CPU.hdl"));
+    ChipSimulator cpu(netlist);
+    BitParallelSimulator<64> reference(netlist);
+    std::mt19937 random(1);
+    for (int cycle = 0; cycle < 1000; ++cycle) {
+        for (const std::string name : { "inM", "instruction", "reset" }) {
+            const int16_t value = name == "reset" ? random() % 50 == 0 : static_cast<int16_t>(random());
+            cpu.set(name, value);
+            reference.set(0, name, value);
+        }
+        cpu.tick();
+        reference.tick();
+        for (const std::string name : { "outM", "writeM", "addressM", "pc" }) ASSERT_EQ(cpu.get(name), reference.get(0, name));
+        cpu.tock();
+        reference.tock();
+        for (const std::string name : { "outM", "writeM", "addressM", "pc" }) ASSERT_EQ(cpu.get(name), reference.get(0, name));
+    }
+}
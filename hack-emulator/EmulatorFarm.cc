@@ -0,0 +1,207 @@
+#include "EmulatorFarm.h"
+#include <chrono>
+#include <deque>
+#include <filesystem>
+#include <iomanip>
+#include <mutex>
+#include <sstream>
+#include <thread>
+#include <unordered_map>
+
+// Parses a `RAM[i]=v` token.
+static RamValue parse_ram_value(const std::string& token, const int line_num);
+
+// Puts `prefix` in front of a relative path from a manifest. Absolute paths
+// are kept as they are.
+static std::string resolve(const std::string& prefix, const std::string& path);
+
+bool FarmResult::passed() const {
+    return mismatches.empty() && halt_reason != HaltReason::OUT_OF_ROM;
+}
+
+EmulatorFarm::EmulatorFarm(const int num_threads)
+        : _num_threads(num_threads > 0 ? num_threads : std::max(1u, std::thread::hardware_concurrency())) {
+}
+
+std::vector<FarmResult> EmulatorFarm::run(const std::vector<FarmJob>& jobs) {
+    std::vector<FarmResult> results(jobs.size());
+    const int num_workers = std::min<int>(_num_threads, std::max<size_t>(jobs.size(), 1));
+
+    struct WorkQueue {
+        std::mutex lock;
+        std::deque<size_t> job_indices;
+    };
+    std::vector<WorkQueue> queues(num_workers);
+    for (size_t i = 0; i < jobs.size(); ++i)
+        queues[i % num_workers].job_indices.push_back(i);
+
+    auto worker = [&](const int worker_id) {
+        while (true) {
+            size_t job_index = 0;
+            bool found_job = false;
+
+            // Own queue first, then steal from the others' backs.
+            for (int offset = 0; offset < num_workers && !found_job; ++offset) {
+                WorkQueue& queue = queues[(worker_id + offset) % num_workers];
+                std::lock_guard<std::mutex> guard(queue.lock);
+                if (queue.job_indices.empty()) continue;
+                if (offset == 0) {
+                    job_index = queue.job_indices.front();
+                    queue.job_indices.pop_front();
+                } else {
+                    job_index = queue.job_indices.back();
+                    queue.job_indices.pop_back();
+                }
+                found_job = true;
+            }
+            // Nothing gets added once the workers start, so every queue being
+            // empty means we're done.
+            if (!found_job) return;
+
+            results[job_index] = run_job(jobs[job_index]);
+        }
+    };
+
+    std::vector<std::thread> workers;
+    for (int i = 1; i < num_workers; ++i) workers.emplace_back(worker, i);
+    worker(0);
+    for (std::thread& each_worker : workers) each_worker.join();
+    return results;
+}
+
+FarmResult EmulatorFarm::run_job(const FarmJob& job) {
+    const auto start_time = std::chrono::steady_clock::now();
+
+    HackComputer computer(job.rom);
+    if (job.snapshot) computer.restore(*job.snapshot);
+    if (job.keyboard_script) computer.set_keyboard_script(job.keyboard_script);
+    const uint64_t start_cycle = computer.cycles();
+    for (const RamValue& initial : job.initial_ram)
+        computer.set_ram(initial.address, initial.value);
+
+    FarmResult result;
+    result.name = job.name;
+    result.halt_reason = computer.run(job.max_cycles);
+    result.cycles = computer.cycles() - start_cycle;
+    for (const RamValue& expected : job.expected_ram) {
+        const int16_t actual = computer.ram(expected.address);
+        if (actual != expected.value) {
+            result.mismatches.push_back("RAM[" + std::to_string(expected.address) + "] = " +
+                std::to_string(actual) + ", expected " + std::to_string(expected.value));
+        }
+    }
+    if (job.expected_screen) {
+        Framebuffer screen;
+        screen.capture(computer);
+        const int num_different = screen.count_different_pixels(*job.expected_screen);
+        if (num_different > 0)
+            result.mismatches.push_back(std::to_string(num_different) + " pixels differ from the expected screen");
+    }
+
+    result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start_time).count();
+    return result;
+}
+
+std::vector<FarmJob> EmulatorFarm::parse_manifest(std::istream& manifest_in, const std::string& base_dir) {
+    std::vector<FarmJob> jobs;
+    std::unordered_map<std::string, std::shared_ptr<const Rom>> loaded_roms;
+    std::unordered_map<std::string, std::shared_ptr<const Snapshot>> loaded_snapshots;
+    std::unordered_map<std::string, std::shared_ptr<const KeyboardScript>> loaded_scripts;
+    std::unordered_map<std::string, std::shared_ptr<const Framebuffer>> loaded_screens;
+    const std::string prefix = (base_dir.empty() || base_dir.back() == '/') ? base_dir : base_dir + "/";
+
+    std::string line;
+    int line_num = 0;
+    while (std::getline(manifest_in, line)) {
+        ++line_num;
+        size_t comment_start = line.find("//");
+        if (comment_start != std::string::npos) line.erase(comment_start);
+
+        std::istringstream tokens(line);
+        std::string program, max_cycles;
+        if (!(tokens >> program)) continue;
+        if (!(tokens >> max_cycles) || max_cycles.find_first_not_of("0123456789") != std::string::npos)
+            throw HackRomError("Manifest line " + std::to_string(line_num) + ": expected a cycle budget after '" + program + "'.");
+
+        FarmJob job;
+        job.name = program + ":" + std::to_string(line_num);
+        job.max_cycles = std::stoull(max_cycles);
+        if (!loaded_roms.count(program))
+            loaded_roms[program] = std::make_shared<const Rom>(Rom::from_file(resolve(prefix, program)));
+        job.rom = loaded_roms[program];
+
+        bool is_expectation = false;
+        std::string token;
+        while (tokens >> token) {
+            if (token == ":") {
+                is_expectation = true;
+                continue;
+            }
+            if (token.rfind("FROM=", 0) == 0 && !is_expectation) {
+                const std::string snapshot_path = token.substr(5);
+                if (!loaded_snapshots.count(snapshot_path))
+                    loaded_snapshots[snapshot_path] = std::make_shared<const Snapshot>(Snapshot::load_from_file(resolve(prefix, snapshot_path)));
+                job.snapshot = loaded_snapshots[snapshot_path];
+                continue;
+            }
+            if (token.rfind("KEYS=", 0) == 0 && !is_expectation) {
+                const std::string script_path = token.substr(5);
+                if (!loaded_scripts.count(script_path))
+                    loaded_scripts[script_path] = std::make_shared<const KeyboardScript>(KeyboardScript::from_file(resolve(prefix, script_path)));
+                job.keyboard_script = loaded_scripts[script_path];
+                continue;
+            }
+            if (token.rfind("SCREEN=", 0) == 0 && is_expectation) {
+                const std::string screen_path = token.substr(7);
+                if (!loaded_screens.count(screen_path))
+                    loaded_screens[screen_path] = std::make_shared<const Framebuffer>(Framebuffer::load_from_file(resolve(prefix, screen_path)));
+                job.expected_screen = loaded_screens[screen_path];
+                continue;
+            }
+            RamValue ram_value = parse_ram_value(token, line_num);
+            (is_expectation ? job.expected_ram : job.initial_ram).push_back(ram_value);
+        }
+        jobs.push_back(job);
+    }
+    return jobs;
+}
+
+void EmulatorFarm::write_report(std::ostream& out, const std::vector<FarmResult>& results) {
+    int num_passed = 0;
+    uint64_t total_cycles = 0;
+    double total_seconds = 0;
+    for (const FarmResult& result : results) {
+        out << (result.passed() ? "PASS  " : "FAIL  ")
+            << std::left << std::setw(32) << result.name << std::right
+            << std::setw(12) << result.cycles << " cycles  "
+            << std::fixed << std::setprecision(3) << result.seconds * 1000 << " ms  "
+            << describe_halt_reason(result.halt_reason) << "\n";
+        for (const std::string& mismatch : result.mismatches)
+            out << "\t" << mismatch << "\n";
+
+        num_passed += result.passed();
+        total_cycles += result.cycles;
+        total_seconds += result.seconds;
+    }
+    out << num_passed << "/" << results.size() << " passed, "
+        << total_cycles << " cycles emulated in "
+        << std::fixed << std::setprecision(3) << total_seconds << " s of worker time.\n";
+}
+
+static RamValue parse_ram_value(const std::string& token, const int line_num) {
+    const size_t close_index = token.find("]=");
+    if (token.rfind("RAM[", 0) != 0 || close_index == std::string::npos)
+        throw HackRomError("Manifest line " + std::to_string(line_num) + ": expected RAM[i]=v, got '" + token + "'.");
+    try {
+        const int address = std::stoi(token.substr(4, close_index - 4));
+        const int value = std::stoi(token.substr(close_index + 2));
+        if (address < 0 || address >= RAM_SIZE) throw std::out_of_range(token);
+        return { address, static_cast<int16_t>(value) };
+    } catch (const std::logic_error&) {
+        throw HackRomError("Manifest line " + std::to_string(line_num) + ": invalid RAM value '" + token + "'.");
+    }
+}
+
+static std::string resolve(const std::string& prefix, const std::string& path) {
+    return std::filesystem::path(path).is_absolute() ? path : prefix + path;
+}
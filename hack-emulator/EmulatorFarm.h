@@ -0,0 +1,105 @@
+#ifndef EMULATOR_FARM_H
+#define EMULATOR_FARM_H
+
+#include "Framebuffer.h"
+#include "HackComputer.h"
+#include "Rom.h"
+#include "Snapshot.h"
+#include <cstdint>
+#include <istream>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <vector>
+
+/**
+ * A single RAM word and its value. Used both to seed RAM before a run and to
+ * check RAM after it.
+ */
+struct RamValue {
+    int address;
+    int16_t value;
+};
+
+/**
+ * One program run. Jobs that use the same program should share a Rom.
+ */
+struct FarmJob {
+    std::string name;
+    std::shared_ptr<const Rom> rom;
+    uint64_t max_cycles;
+
+    // State to start from, eg. a checkpoint taken after the OS has booted.
+    // Starts from a fresh computer if null.
+    std::shared_ptr<const Snapshot> snapshot;
+
+    // Timed input for the KBD register. The keyboard is left alone if null.
+    std::shared_ptr<const KeyboardScript> keyboard_script;
+
+    std::vector<RamValue> initial_ram;
+    std::vector<RamValue> expected_ram;
+
+    // Image the screen should match after the run. Not checked if null.
+    std::shared_ptr<const Framebuffer> expected_screen;
+};
+
+struct FarmResult {
+    std::string name;
+    HaltReason halt_reason;
+    uint64_t cycles;  // Not counting cycles before the job's snapshot.
+    double seconds;
+
+    // One message per expected RAM value that didn't match, plus one if the
+    // screen didn't match.
+    std::vector<std::string> mismatches;
+
+    bool passed() const;
+};
+
+/**
+ * Runs batches of independent Hack programs on a pool of worker threads, each
+ * in its own HackComputer, without paying for a process per program.
+ *
+ * Jobs are dealt out round-robin to per-worker queues. Workers take jobs from
+ * the front of their own queue and, once it's empty, steal from the back of
+ * other workers' queues, so a few long-running programs don't leave the
+ * other cores idle.
+ */
+class EmulatorFarm {
+public:
+    /**
+     * Creates a farm with the given number of worker threads. Uses one thread
+     * per core if `num_threads` is 0.
+     */
+    explicit EmulatorFarm(const int num_threads = 0);
+
+    /**
+     * Runs every job to completion. Results are in the same order as `jobs`.
+     */
+    std::vector<FarmResult> run(const std::vector<FarmJob>& jobs);
+
+    /**
+     * Parses a batch manifest. Each non-empty line describes one job:
+     *     <program> <max_cycles> [FROM=<snapshot>] [KEYS=<script>] [RAM[i]=v ...] [: RAM[j]=w ... [SCREEN=<image>]]
+     * The run starts from the snapshot file if one is given, and reads the
+     * keyboard from the keyboard script if one is given. RAM values before
+     * the ':' are written before the run and values after it are checked
+     * afterwards, as is the screen against a .png or .pbm image if one is
+     * given. Relative paths are relative to `base_dir`, and each distinct
+     * program, snapshot, script and image is only loaded once. `//` starts a
+     * comment.
+     */
+    static std::vector<FarmJob> parse_manifest(std::istream& manifest_in, const std::string& base_dir);
+
+    /**
+     * Writes one line per result followed by a pass/fail summary.
+     */
+    static void write_report(std::ostream& out, const std::vector<FarmResult>& results);
+
+private:
+    int _num_threads;
+
+    static FarmResult run_job(const FarmJob& job);
+};
+
+#endif
@@ -0,0 +1,64 @@
+#include "EmulatorFarm.h"
+#include <filesystem>
+#include <gtest/gtest.h>
+#include <sstream>
+
+TEST(EmulatorFarmTest, RunsJobsInParallelAndKeepsOrder) {
+    std::shared_ptr<const Rom> max_rom = std::make_shared<const Rom>(Rom::from_file("test-files/Max.asm"));
+    std::vector<FarmJob> jobs;
+    for (int i = 0; i < 100; ++i) {
+        FarmJob job;
+        job.name = "Max" + std::to_string(i);
+        job.rom = max_rom;
+        job.max_cycles = 1000;
+        job.initial_ram = { { 0, static_cast<int16_t>(i) }, { 1, 50 } };
+        job.expected_ram = { { 2, static_cast<int16_t>(std::max(i, 50)) } };
+        jobs.push_back(job);
+    }
+
+    EmulatorFarm farm(4);
+    std::vector<FarmResult> results = farm.run(jobs);
+
+    ASSERT_EQ(results.size(), jobs.size());
+    for (size_t i = 0; i < jobs.size(); ++i) {
+        EXPECT_EQ(results[i].name, jobs[i].name);
+        EXPECT_TRUE(results[i].passed());
+        EXPECT_EQ(results[i].halt_reason, HaltReason::END_OF_PROGRAM);
+    }
+}
+
+TEST(EmulatorFarmTest, ReportsRamMismatches) {
+    std::istringstream manifest("// Max of 3 and 5.\n"
+                                "Max.asm 1000 RAM[0]=3 RAM[1]=5 : RAM[2]=5\n"
+                                "\n"
+                                "Max.asm 1000 RAM[0]=3 RAM[1]=5 : RAM[2]=3\n");
+    std::vector<FarmJob> jobs = EmulatorFarm::parse_manifest(manifest, "test-files");
+    ASSERT_EQ(jobs.size(), 2);
+    EXPECT_EQ(jobs[0].rom, jobs[1].rom);
+
+    std::vector<FarmResult> results = EmulatorFarm(2).run(jobs);
+    EXPECT_TRUE(results[0].passed());
+    EXPECT_FALSE(results[1].passed());
+    ASSERT_EQ(results[1].mismatches.size(), 1);
+    EXPECT_EQ(results[1].mismatches[0], "RAM[2] = 5, expected 3");
+
+    std::ostringstream report;
+    EmulatorFarm::write_report(report, results);
+    EXPECT_NE(report.str().find("1/2 passed"), std::string::npos);
+}
+
+TEST(EmulatorFarmTest, KeepsAbsolutePathsInManifests) {
+    const std::string max_path = std::filesystem::absolute("test-files/Max.asm").string();
+    std::istringstream manifest(max_path + " 1000 RAM[0]=3 RAM[1]=5 : RAM[2]=5\n");
+    std::vector<FarmJob> jobs = EmulatorFarm::parse_manifest(manifest, "test-files");
+    ASSERT_EQ(jobs.size(), 1);
+    EXPECT_TRUE(EmulatorFarm(1).run(jobs)[0].passed());
+}
+
+TEST(EmulatorFarmTest, RejectsMalformedManifests) {
+    std::istringstream missing_budget("Max.asm\n");
+    EXPECT_THROW(EmulatorFarm::parse_manifest(missing_budget, "test-files"), HackRomError);
+
+    std::istringstream bad_ram_value("Max.asm 10 RAM[0]\n");
+    EXPECT_THROW(EmulatorFarm::parse_manifest(bad_ram_value, "test-files"), HackRomError);
+}
@@ -0,0 +1,236 @@
+#include "Framebuffer.h"
+#include <array>
+#include <cstdlib>
+#include <fstream>
+#include <zlib.h>
+
+// Every PNG starts with these bytes.
+static const uint8_t PNG_SIGNATURE[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+
+// Bytes per row of a 1-bit image.
+constexpr int ROW_BYTES = SCREEN_WIDTH / 8;
+
+// Words per row of the screen.
+constexpr int ROW_WORDS = SCREEN_WIDTH / 16;
+
+static uint8_t reverse_bits(uint8_t byte) {
+    byte = ((byte & 0xF0) >> 4) | ((byte & 0x0F) << 4);
+    byte = ((byte & 0xCC) >> 2) | ((byte & 0x33) << 2);
+    return ((byte & 0xAA) >> 1) | ((byte & 0x55) << 1);
+}
+
+// PNG integers are big-endian.
+static void put_big_endian(std::vector<uint8_t>& out, const uint32_t value) {
+    for (int shift = 24; shift >= 0; shift -= 8) out.push_back((value >> shift) & 0xFF);
+}
+
+static uint32_t get_big_endian(const uint8_t* in) {
+    return (static_cast<uint32_t>(in[0]) << 24) | (in[1] << 16) | (in[2] << 8) | in[3];
+}
+
+static void write_png_chunk(std::ostream& png_out, const char* type, const std::vector<uint8_t>& data) {
+    std::vector<uint8_t> chunk;
+    put_big_endian(chunk, data.size());
+    chunk.insert(chunk.end(), type, type + 4);
+    chunk.insert(chunk.end(), data.begin(), data.end());
+    put_big_endian(chunk, crc32(0, chunk.data() + 4, chunk.size() - 4));
+    png_out.write(reinterpret_cast<const char*>(chunk.data()), chunk.size());
+}
+
+// Undoes one of the five PNG row filters. Pixels are 1 bit, so the "previous
+// pixel" the filters refer to is the previous byte.
+static void unfilter_row(const uint8_t filter, uint8_t* row, const uint8_t* previous_row) {
+    for (int i = 0; i < ROW_BYTES; ++i) {
+        const int left = i > 0 ? row[i - 1] : 0;
+        const int up = previous_row[i];
+        const int up_left = i > 0 ? previous_row[i - 1] : 0;
+        switch (filter) {
+            case 0: break;
+            case 1: row[i] += left; break;
+            case 2: row[i] += up; break;
+            case 3: row[i] += (left + up) / 2; break;
+            case 4: {
+                const int estimate = left + up - up_left;
+                const int left_distance = std::abs(estimate - left);
+                const int up_distance = std::abs(estimate - up);
+                const int up_left_distance = std::abs(estimate - up_left);
+                if (left_distance <= up_distance && left_distance <= up_left_distance) row[i] += left;
+                else if (up_distance <= up_left_distance) row[i] += up;
+                else row[i] += up_left;
+                break;
+            }
+            default:
+                throw HackRomError("PNG has an unknown row filter " + std::to_string(filter) + ".");
+        }
+    }
+}
+
+Framebuffer::Framebuffer()
+        : _words(SCREEN_WORDS, 0) {
+}
+
+int Framebuffer::capture(HackComputer& computer) {
+    int num_changed = 0;
+    const std::array<uint64_t, SCREEN_WORDS / 64> dirty_words = computer.take_dirty_screen_words();
+    for (int group = 0; group < SCREEN_WORDS / 64; ++group) {
+        // Walk the set bits only. Most groups are usually clean.
+        for (uint64_t bits = dirty_words[group]; bits != 0; bits &= bits - 1) {
+            const int index = group * 64 + __builtin_ctzll(bits);
+            const uint16_t value = computer.ram(SCREEN_BASE + index);
+            num_changed += value != _words[index];
+            _words[index] = value;
+        }
+    }
+    return num_changed;
+}
+
+uint16_t Framebuffer::word(const int index) const {
+    return _words[index];
+}
+
+bool Framebuffer::pixel(const int x, const int y) const {
+    return (_words[y * ROW_WORDS + x / 16] >> (x % 16)) & 1;
+}
+
+int Framebuffer::count_different_pixels(const Framebuffer& other) const {
+    int num_different = 0;
+    for (int i = 0; i < SCREEN_WORDS; ++i)
+        num_different += __builtin_popcount(_words[i] ^ other._words[i]);
+    return num_different;
+}
+
+void Framebuffer::write_png(std::ostream& png_out) const {
+    // PNG's 1-bit greyscale uses 0 for black, the opposite of the screen.
+    std::vector<uint8_t> rows;
+    uint8_t row[ROW_BYTES];
+    for (int y = 0; y < SCREEN_HEIGHT; ++y) {
+        pack_row(y, row);
+        rows.push_back(0);  // No filter.
+        for (const uint8_t byte : row) rows.push_back(~byte);
+    }
+    uLongf compressed_size = compressBound(rows.size());
+    std::vector<uint8_t> compressed(compressed_size);
+    compress2(compressed.data(), &compressed_size, rows.data(), rows.size(), Z_BEST_COMPRESSION);
+    compressed.resize(compressed_size);
+
+    std::vector<uint8_t> header;
+    put_big_endian(header, SCREEN_WIDTH);
+    put_big_endian(header, SCREEN_HEIGHT);
+    header.insert(header.end(), { 1, 0, 0, 0, 0 });  // 1-bit greyscale, not interlaced.
+
+    png_out.write(reinterpret_cast<const char*>(PNG_SIGNATURE), sizeof(PNG_SIGNATURE));
+    write_png_chunk(png_out, "IHDR", header);
+    write_png_chunk(png_out, "IDAT", compressed);
+    write_png_chunk(png_out, "IEND", {});
+}
+
+void Framebuffer::write_pbm(std::ostream& pbm_out) const {
+    pbm_out << "P4\n" << SCREEN_WIDTH << " " << SCREEN_HEIGHT << "\n";
+    uint8_t row[ROW_BYTES];
+    for (int y = 0; y < SCREEN_HEIGHT; ++y) {
+        pack_row(y, row);
+        pbm_out.write(reinterpret_cast<const char*>(row), ROW_BYTES);
+    }
+}
+
+Framebuffer Framebuffer::load_png(std::istream& png_in) {
+    uint8_t signature[sizeof(PNG_SIGNATURE)];
+    png_in.read(reinterpret_cast<char*>(signature), sizeof(signature));
+    if (!png_in || !std::equal(signature, signature + sizeof(signature), PNG_SIGNATURE))
+        throw HackRomError("Not a PNG file.");
+
+    std::vector<uint8_t> compressed;
+    bool has_header = false;
+    while (true) {
+        uint8_t length_and_type[8];
+        png_in.read(reinterpret_cast<char*>(length_and_type), sizeof(length_and_type));
+        if (!png_in) throw HackRomError("PNG ends without an IEND chunk.");
+        const std::string type(reinterpret_cast<char*>(length_and_type) + 4, 4);
+        std::vector<uint8_t> data(get_big_endian(length_and_type));
+        png_in.read(reinterpret_cast<char*>(data.data()), data.size());
+        png_in.ignore(4);  // CRC.
+        if (!png_in) throw HackRomError("PNG chunk '" + type + "' is truncated.");
+
+        if (type == "IHDR") {
+            const std::vector<uint8_t> expected_format = { 1, 0, 0, 0, 0 };
+            if (data.size() != 13 || get_big_endian(&data[0]) != SCREEN_WIDTH || get_big_endian(&data[4]) != SCREEN_HEIGHT ||
+                    !std::equal(expected_format.begin(), expected_format.end(), data.begin() + 8))
+                throw HackRomError("Only 512x256 1-bit greyscale PNGs without interlacing are supported.");
+            has_header = true;
+        } else if (type == "IDAT") {
+            compressed.insert(compressed.end(), data.begin(), data.end());
+        } else if (type == "IEND") {
+            break;
+        }
+    }
+    if (!has_header) throw HackRomError("PNG has no IHDR chunk.");
+
+    std::vector<uint8_t> rows(SCREEN_HEIGHT * (ROW_BYTES + 1));
+    uLongf rows_size = rows.size();
+    if (uncompress(rows.data(), &rows_size, compressed.data(), compressed.size()) != Z_OK || rows_size != rows.size())
+        throw HackRomError("PNG image data is corrupt.");
+
+    Framebuffer framebuffer;
+    uint8_t previous_row[ROW_BYTES] = {};
+    for (int y = 0; y < SCREEN_HEIGHT; ++y) {
+        uint8_t* row = &rows[y * (ROW_BYTES + 1) + 1];
+        unfilter_row(row[-1], row, previous_row);
+        std::copy(row, row + ROW_BYTES, previous_row);
+        for (int i = 0; i < ROW_BYTES; ++i) row[i] = ~row[i];
+        framebuffer.unpack_row(y, row);
+    }
+    return framebuffer;
+}
+
+Framebuffer Framebuffer::load_pbm(std::istream& pbm_in) {
+    // The header is whitespace-separated, possibly with `#` comments, and
+    // ends with a single whitespace character.
+    std::string fields[3];
+    for (std::string& field : fields) {
+        while (pbm_in >> std::ws && pbm_in.peek() == '#') pbm_in.ignore(SIZE_MAX, '\n');
+        pbm_in >> field;
+    }
+    pbm_in.get();
+    if (!pbm_in || fields[0] != "P4") throw HackRomError("Not a binary (P4) PBM file.");
+    if (fields[1] != std::to_string(SCREEN_WIDTH) || fields[2] != std::to_string(SCREEN_HEIGHT))
+        throw HackRomError("PBM is " + fields[1] + "x" + fields[2] + ", but the screen is 512x256.");
+
+    Framebuffer framebuffer;
+    uint8_t row[ROW_BYTES];
+    for (int y = 0; y < SCREEN_HEIGHT; ++y) {
+        pbm_in.read(reinterpret_cast<char*>(row), ROW_BYTES);
+        if (!pbm_in) throw HackRomError("PBM is truncated.");
+        framebuffer.unpack_row(y, row);
+    }
+    return framebuffer;
+}
+
+void Framebuffer::save_to_file(const std::string& path) const {
+    std::ofstream image_out(path, std::ios::binary);
+    if (!image_out) throw HackRomError("Could not write '" + path + "'.");
+    if (path.size() >= 4 && path.substr(path.size() - 4) == ".png") {
+        write_png(image_out);
+    } else {
+        write_pbm(image_out);
+    }
+}
+
+Framebuffer Framebuffer::load_from_file(const std::string& path) {
+    std::ifstream image_in(path, std::ios::binary);
+    if (!image_in) throw HackRomError("Could not open '" + path + "'.");
+    if (path.size() >= 4 && path.substr(path.size() - 4) == ".png") return load_png(image_in);
+    return load_pbm(image_in);
+}
+
+void Framebuffer::pack_row(const int y, uint8_t* row_out) const {
+    for (int i = 0; i < ROW_WORDS; ++i) {
+        const uint16_t word = _words[y * ROW_WORDS + i];
+        row_out[2 * i] = reverse_bits(word & 0xFF);
+        row_out[2 * i + 1] = reverse_bits(word >> 8);
+    }
+}
+
+void Framebuffer::unpack_row(const int y, const uint8_t* row_in) {
+    for (int i = 0; i < ROW_WORDS; ++i)
+        _words[y * ROW_WORDS + i] = reverse_bits(row_in[2 * i]) | (reverse_bits(row_in[2 * i + 1]) << 8);
+}
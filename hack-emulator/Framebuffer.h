@@ -0,0 +1,86 @@
+#ifndef FRAMEBUFFER_H
+#define FRAMEBUFFER_H
+
+#include "HackComputer.h"
+#include <cstdint>
+#include <istream>
+#include <ostream>
+#include <string>
+#include <vector>
+
+// Screen geometry. Each row is 32 words, and the least significant bit of a
+// word is its leftmost pixel.
+constexpr int SCREEN_WIDTH = 512;
+constexpr int SCREEN_HEIGHT = 256;
+
+/**
+ * A copy of the screen, for capturing frames from a running program and
+ * comparing them against golden images.
+ *
+ * Capturing only looks at the screen words the computer has written since
+ * the previous capture, which it tracks in a bitmap, so capturing a frame in
+ * which little was drawn is cheap.
+ */
+class Framebuffer {
+public:
+    /**
+     * A blank (all white) screen.
+     */
+    Framebuffer();
+
+    /**
+     * Brings the framebuffer up to date with the computer's screen. Returns the
+     * number of words whose pixels changed, which is 0 if the frame is the same
+     * as the last one.
+     */
+    int capture(HackComputer& computer);
+
+    uint16_t word(const int index) const;
+
+    /**
+     * Whether the pixel is black.
+     */
+    bool pixel(const int x, const int y) const;
+
+    /**
+     * Number of pixels that differ from `other`.
+     */
+    int count_different_pixels(const Framebuffer& other) const;
+
+    /**
+     * Writes the screen as a 1-bit PNG.
+     */
+    void write_png(std::ostream& png_out) const;
+
+    /**
+     * Writes the screen as a binary (P4) PBM, the 1-bit member of the
+     * PPM family.
+     */
+    void write_pbm(std::ostream& pbm_out) const;
+
+    /**
+     * Reads a 512x256 1-bit greyscale PNG, such as one written by `write_png`.
+     */
+    static Framebuffer load_png(std::istream& png_in);
+
+    /**
+     * Reads a 512x256 binary PBM.
+     */
+    static Framebuffer load_pbm(std::istream& pbm_in);
+
+    /**
+     * Writes or reads a .png or .pbm file, determined by the file extension.
+     */
+    void save_to_file(const std::string& path) const;
+    static Framebuffer load_from_file(const std::string& path);
+
+private:
+    std::vector<uint16_t> _words;
+
+    // Packs a row into bytes with the leftmost pixel in the most significant
+    // bit and 1 meaning black, as PBM does.
+    void pack_row(const int y, uint8_t* row_out) const;
+    void unpack_row(const int y, const uint8_t* row_in);
+};
+
+#endif
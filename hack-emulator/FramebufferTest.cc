@@ -0,0 +1,83 @@
+#include "EmulatorFarm.h"
+#include "Framebuffer.h"
+#include "HackComputer.h"
+#include <gtest/gtest.h>
+#include <memory>
+#include <sstream>
+
+const std::string SCREEN_PATH = "test-files/Screen.asm";
+
+// The screen as Screen.asm leaves it.
+static Framebuffer draw_screen() {
+    HackComputer computer(std::make_shared<const Rom>(Rom::from_file(SCREEN_PATH)));
+    computer.run(100);
+    Framebuffer frame;
+    frame.capture(computer);
+    return frame;
+}
+
+TEST(FramebufferTest, CapturesChangedWords) {
+    HackComputer computer(std::make_shared<const Rom>(Rom::from_file(SCREEN_PATH)));
+    Framebuffer frame;
+    EXPECT_EQ(frame.capture(computer), 0);
+
+    computer.run(2);
+    EXPECT_EQ(frame.capture(computer), 1);
+    EXPECT_EQ(frame.word(0), static_cast<uint16_t>(-1));
+    EXPECT_TRUE(frame.pixel(0, 0));
+    EXPECT_TRUE(frame.pixel(15, 0));
+    EXPECT_FALSE(frame.pixel(16, 0));
+
+    computer.run(2);
+    EXPECT_EQ(frame.capture(computer), 1);
+    EXPECT_TRUE(frame.pixel(496, 255));
+    EXPECT_FALSE(frame.pixel(497, 255));
+
+    // Drawing the same pixels again isn't a change.
+    computer.run(2);
+    EXPECT_EQ(frame.capture(computer), 0);
+    EXPECT_EQ(frame.capture(computer), 0);
+
+    // Nor is anything after a restore that puts back the same screen.
+    computer.restore(computer.snapshot());
+    EXPECT_EQ(frame.capture(computer), 0);
+}
+
+TEST(FramebufferTest, CountsDifferentPixels) {
+    const Framebuffer drawn = draw_screen();
+    EXPECT_EQ(drawn.count_different_pixels(drawn), 0);
+    EXPECT_EQ(drawn.count_different_pixels(Framebuffer()), 17);
+}
+
+TEST(FramebufferTest, ImagesRoundTrip) {
+    const Framebuffer drawn = draw_screen();
+
+    std::stringstream png;
+    drawn.write_png(png);
+    EXPECT_EQ(Framebuffer::load_png(png).count_different_pixels(drawn), 0);
+
+    std::stringstream pbm;
+    drawn.write_pbm(pbm);
+    EXPECT_EQ(pbm.str().size(), 11 + SCREEN_WIDTH * SCREEN_HEIGHT / 8);
+    // The leftmost pixel is the first byte's most significant bit.
+    EXPECT_EQ(static_cast<uint8_t>(pbm.str()[11]), 0xFF);
+    EXPECT_EQ(Framebuffer::load_pbm(pbm).count_different_pixels(drawn), 0);
+
+    std::istringstream not_an_image("P1\n512 256\n");
+    EXPECT_THROW(Framebuffer::load_pbm(not_an_image), HackRomError);
+}
+
+TEST(FramebufferTest, FarmJobsCheckScreen) {
+    auto expected = std::make_shared<const Framebuffer>(draw_screen());
+    FarmJob job;
+    job.name = "Screen";
+    job.rom = std::make_shared<const Rom>(Rom::from_file(SCREEN_PATH));
+    job.max_cycles = 100;
+    job.expected_screen = expected;
+    EXPECT_TRUE(EmulatorFarm(1).run({ job })[0].passed());
+
+    job.expected_screen = std::make_shared<const Framebuffer>();
+    const FarmResult result = EmulatorFarm(1).run({ job })[0];
+    ASSERT_EQ(result.mismatches.size(), 1);
+    EXPECT_EQ(result.mismatches[0], "17 pixels differ from the expected screen");
+}
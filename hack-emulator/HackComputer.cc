@@ -0,0 +1,427 @@
+#include "HackComputer.h"
+#include "Profiler.h"
+#include "Trace.h"
+#include <algorithm>
+
+HackComputer::HackComputer(std::shared_ptr<const Rom> rom)
+        : _rom(rom),
+          _program(rom->decoded()),
+          _ram(RAM_SIZE, 0),
+          _a(0),
+          _d(0),
+          _pc(0),
+          _cycles(0),
+          _idle_loop_policy(IdleLoopPolicy::HALT),
+          _next_key_change(0),
+          _profiler(nullptr),
+          _trace_recorder(nullptr) {
+    _watch.active = false;
+    _dirty_pages.fill(false);
+    _dirty_screen_words.fill(~0ull);
+    _watched_pages.fill(0);
+}
+
+void HackComputer::reset() {
+    _pc = 0;
+    _watch.active = false;
+}
+
+Snapshot HackComputer::snapshot() {
+    _clean_ram = std::make_shared<const std::vector<int16_t>>(_ram);
+    _dirty_pages.fill(false);
+    return Snapshot(_pc, _a, _d, _cycles, _clean_ram, _rom->checksum());
+}
+
+void HackComputer::restore(const Snapshot& snapshot) {
+    if (snapshot.rom_checksum() != _rom->checksum())
+        throw HackRomError("The snapshot was taken with a different program.");
+
+    const std::vector<int16_t>& ram = *snapshot.ram();
+    if (_clean_ram == snapshot.ram()) {
+        for (size_t page = 0; page < _dirty_pages.size(); ++page) {
+            if (!_dirty_pages[page]) continue;
+            std::copy(ram.begin() + page * DIRTY_PAGE_SIZE, ram.begin() + (page + 1) * DIRTY_PAGE_SIZE,
+                      _ram.begin() + page * DIRTY_PAGE_SIZE);
+        }
+    } else {
+        _ram = ram;
+        _clean_ram = snapshot.ram();
+    }
+    _dirty_pages.fill(false);
+    _dirty_screen_words.fill(~0ull);
+
+    _a = snapshot.a();
+    _d = snapshot.d();
+    _pc = snapshot.pc();
+    _cycles = snapshot.cycles();
+    _watch.active = false;
+    seek_keyboard_script();
+}
+
+void HackComputer::step() {
+    // Breakpoints are only patched into `_program`.
+    const DecodedInstruction& instruction = _rom->decoded()[_pc];
+    if (instruction.op == OpCode::OUT_OF_ROM) return;
+    _watchpoint_hit.reset();
+    apply_key_changes();
+    if (_profiler) _profiler->record(_pc);
+    if (_trace_recorder) {
+        _trace_recorder->record(_pc);
+        execute<TRACED | WATCHED>(instruction);
+    } else {
+        execute<WATCHED>(instruction);
+    }
+    ++_cycles;
+}
+
+HaltReason HackComputer::run(const uint64_t max_cycles) {
+    const uint64_t end_cycle = _cycles + max_cycles;
+    _watchpoint_hit.reset();
+    if (_program[_pc].op == OpCode::BREAKPOINT && max_cycles > 0) {
+        step();
+        if (_watchpoint_hit) return HaltReason::WATCHPOINT;
+    }
+    while (true) {
+        apply_key_changes();
+        if (!_keyboard_script || _next_key_change == _keyboard_script->changes().size() ||
+                _keyboard_script->changes()[_next_key_change].cycle >= end_cycle)
+            return run_until(end_cycle, false);
+
+        const HaltReason reason = run_until(_keyboard_script->changes()[_next_key_change].cycle, true);
+        if (reason != HaltReason::CYCLE_BUDGET_EXHAUSTED) return reason;
+    }
+}
+
+HaltReason HackComputer::run_until(const uint64_t end_cycle, const bool is_waiting_for_input) {
+    const unsigned features = (_profiler ? PROFILED : 0) | (_trace_recorder ? TRACED : 0) |
+                              (_watchpoints.empty() ? 0 : WATCHED);
+    switch (features) {
+        case 0: return run_until<0>(end_cycle, is_waiting_for_input);
+        case PROFILED: return run_until<PROFILED>(end_cycle, is_waiting_for_input);
+        case TRACED: return run_until<TRACED>(end_cycle, is_waiting_for_input);
+        case PROFILED | TRACED: return run_until<PROFILED | TRACED>(end_cycle, is_waiting_for_input);
+        case WATCHED: return run_until<WATCHED>(end_cycle, is_waiting_for_input);
+        case PROFILED | WATCHED: return run_until<PROFILED | WATCHED>(end_cycle, is_waiting_for_input);
+        case TRACED | WATCHED: return run_until<TRACED | WATCHED>(end_cycle, is_waiting_for_input);
+        default: return run_until<PROFILED | TRACED | WATCHED>(end_cycle, is_waiting_for_input);
+    }
+}
+
+template<unsigned FEATURES>
+HaltReason HackComputer::run_until(const uint64_t end_cycle, const bool is_waiting_for_input) {
+    _watch.active = false;
+
+    while (_cycles < end_cycle) {
+        const DecodedInstruction& instruction = _program[_pc];
+        switch (instruction.op) {
+            case OpCode::OUT_OF_ROM:
+                return HaltReason::OUT_OF_ROM;
+            case OpCode::HALT_TRAP:
+                if (_idle_loop_policy == IdleLoopPolicy::HALT) {
+                    _a = instruction.value;
+                    return HaltReason::END_OF_PROGRAM;
+                } else {
+                    // The trap alternates between `@self` and the jump back,
+                    // so only the parity of the remaining cycles matters.
+                    const uint64_t remaining = end_cycle - _cycles;
+                    _a = instruction.value;
+                    _pc = instruction.value + (remaining % 2);
+                    _cycles = end_cycle;
+                    return HaltReason::CYCLE_BUDGET_EXHAUSTED;
+                }
+            case OpCode::BREAKPOINT:
+                return HaltReason::BREAKPOINT;
+            default:
+                break;
+        }
+
+        if constexpr (FEATURES & PROFILED) _profiler->record(_pc);
+        if constexpr (FEATURES & TRACED) _trace_recorder->record(_pc);
+        const bool jumped_backwards = execute<FEATURES>(instruction);
+        ++_cycles;
+        if constexpr (FEATURES & WATCHED) {
+            if (_watchpoint_hit) return HaltReason::WATCHPOINT;
+        }
+        if (!jumped_backwards) continue;
+
+        if (!is_idle_after_backwards_jump()) continue;
+        if (_idle_loop_policy == IdleLoopPolicy::HALT && !is_waiting_for_input) return HaltReason::IDLE_LOOP;
+
+        // Every period returns the machine to the same state, so whole periods
+        // can be skipped outright. The leftover partial period is executed.
+        // It can't contain breakpoints, or the loop would've stopped at one
+        // before being found idle, nor watched writes, for the same reason.
+        const uint64_t period = _cycles - _watch.head_cycle;
+        const uint64_t remaining = end_cycle - _cycles;
+        _cycles += remaining - (remaining % period);
+        _watch.active = false;
+        while (_cycles < end_cycle) {
+            if constexpr (FEATURES & PROFILED) _profiler->record(_pc);
+            if constexpr (FEATURES & TRACED) _trace_recorder->record(_pc);
+            execute<FEATURES>(_program[_pc]);
+            ++_cycles;
+        }
+    }
+    return HaltReason::CYCLE_BUDGET_EXHAUSTED;
+}
+
+void HackComputer::set_idle_loop_policy(const IdleLoopPolicy policy) {
+    _idle_loop_policy = policy;
+}
+
+void HackComputer::set_profiler(Profiler* profiler) {
+    _profiler = profiler;
+}
+
+void HackComputer::set_trace_recorder(TraceRecorder* recorder) {
+    _trace_recorder = recorder;
+}
+
+void HackComputer::set_keyboard_script(std::shared_ptr<const KeyboardScript> script) {
+    _keyboard_script = script;
+    seek_keyboard_script();
+}
+
+void HackComputer::add_breakpoint(const uint16_t address) {
+    if (address >= _rom->size())
+        throw HackRomError("Can't set a breakpoint at " + std::to_string(address) + ", past the end of the program.");
+    if (_patched_program.empty()) {
+        _patched_program.assign(_rom->decoded(), _rom->decoded() + ROM_SIZE + 1);
+        _program = _patched_program.data();
+    }
+    _patched_program[address].op = OpCode::BREAKPOINT;
+}
+
+void HackComputer::remove_breakpoint(const uint16_t address) {
+    if (_patched_program.empty() || address >= _rom->size()) return;
+    _patched_program[address].op = _rom->decoded()[address].op;
+}
+
+void HackComputer::add_watchpoint(const uint16_t first_address, const uint16_t last_address) {
+    const uint16_t first = first_address & 0x7FFF;
+    const uint16_t last = last_address & 0x7FFF;
+    if (first > last) return;
+    _watchpoints.push_back({ first, last });
+    for (int page = first / WATCH_PAGE_SIZE; page <= last / WATCH_PAGE_SIZE; ++page)
+        _watched_pages[page / 64] |= 1ull << (page % 64);
+}
+
+void HackComputer::clear_watchpoints() {
+    _watchpoints.clear();
+    _watched_pages.fill(0);
+}
+
+const std::optional<WatchpointHit>& HackComputer::watchpoint_hit() const {
+    return _watchpoint_hit;
+}
+
+int16_t HackComputer::ram(const int address) const {
+    return _ram[address & 0x7FFF];
+}
+
+void HackComputer::set_ram(const int address, const int16_t value) {
+    _ram[address & 0x7FFF] = value;
+    _dirty_pages[(address & 0x7FFF) / DIRTY_PAGE_SIZE] = true;
+    mark_screen_word_dirty(address & 0x7FFF);
+    _watch.active = false;
+}
+
+int16_t HackComputer::a() const {
+    return _a;
+}
+
+int16_t HackComputer::d() const {
+    return _d;
+}
+
+uint16_t HackComputer::pc() const {
+    return _pc;
+}
+
+void HackComputer::set_a(const int16_t value) {
+    _a = value;
+    _watch.active = false;
+}
+
+void HackComputer::set_d(const int16_t value) {
+    _d = value;
+    _watch.active = false;
+}
+
+void HackComputer::set_pc(const uint16_t value) {
+    _pc = value & 0x7FFF;
+    _watch.active = false;
+}
+
+std::array<uint64_t, SCREEN_WORDS / 64> HackComputer::take_dirty_screen_words() {
+    const std::array<uint64_t, SCREEN_WORDS / 64> dirty_words = _dirty_screen_words;
+    _dirty_screen_words.fill(0);
+    return dirty_words;
+}
+
+uint64_t HackComputer::cycles() const {
+    return _cycles;
+}
+
+void HackComputer::apply_key_changes() {
+    if (!_keyboard_script) return;
+    const std::vector<KeyChange>& changes = _keyboard_script->changes();
+    for (; _next_key_change < changes.size() && changes[_next_key_change].cycle <= _cycles; ++_next_key_change) {
+        _ram[KBD_ADDRESS] = changes[_next_key_change].key;
+        _dirty_pages[KBD_ADDRESS / DIRTY_PAGE_SIZE] = true;
+    }
+}
+
+void HackComputer::seek_keyboard_script() {
+    if (!_keyboard_script) return;
+    _next_key_change = _keyboard_script->first_change_after(_cycles);
+    _ram[KBD_ADDRESS] = _keyboard_script->key_at(_cycles);
+    _dirty_pages[KBD_ADDRESS / DIRTY_PAGE_SIZE] = true;
+    _watch.active = false;
+}
+
+template<unsigned FEATURES>
+bool HackComputer::execute(const DecodedInstruction& instruction) {
+    if (instruction.op != OpCode::COMPUTE) {
+        _a = instruction.value;
+        ++_pc;
+        return false;
+    }
+
+    // Everything is computed from the register values at the start of the
+    // cycle: M is addressed by the old A, and jumps go to the old A.
+    const uint16_t address = _a & 0x7FFF;
+    const int16_t m = (instruction.comp & 0x40) ? _ram[address] : 0;
+    const int16_t out = compute(instruction.comp, _d, _a, m);
+
+    if (instruction.dest & 0b001) {
+        if (_watch.active) {
+            if (_watch.num_writes < MAX_WATCHED_WRITES)
+                _watch.writes[_watch.num_writes] = { address, _ram[address] };
+            ++_watch.num_writes;
+        }
+        if constexpr (FEATURES & WATCHED) check_watchpoints(address, _ram[address], out);
+        _ram[address] = out;
+        _dirty_pages[address / DIRTY_PAGE_SIZE] = true;
+        mark_screen_word_dirty(address);
+        if constexpr (FEATURES & TRACED) _trace_recorder->record_write(address, out);
+    }
+    if (instruction.dest & 0b010) _d = out;
+
+    const bool should_jump = ((instruction.jump & 0b100) && out < 0) ||
+                             ((instruction.jump & 0b010) && out == 0) ||
+                             ((instruction.jump & 0b001) && out > 0);
+    const uint16_t old_pc = _pc;
+    _pc = should_jump ? address : _pc + 1;
+
+    if (instruction.dest & 0b100) _a = out;
+    return should_jump && _pc <= old_pc;
+}
+
+int16_t HackComputer::compute(const uint8_t comp, const int16_t d, const int16_t a, const int16_t m) {
+    switch (comp) {
+        case 0b0101010: return 0;
+        case 0b0111111: return 1;
+        case 0b0111010: return -1;
+        case 0b0001100: return d;
+        case 0b0110000: return a;
+        case 0b1110000: return m;
+        case 0b0001101: return ~d;
+        case 0b0110001: return ~a;
+        case 0b1110001: return ~m;
+        case 0b0001111: return -d;
+        case 0b0110011: return -a;
+        case 0b1110011: return -m;
+        case 0b0011111: return d + 1;
+        case 0b0110111: return a + 1;
+        case 0b1110111: return m + 1;
+        case 0b0001110: return d - 1;
+        case 0b0110010: return a - 1;
+        case 0b1110010: return m - 1;
+        case 0b0000010: return d + a;
+        case 0b1000010: return d + m;
+        case 0b0010011: return d - a;
+        case 0b1010011: return d - m;
+        case 0b0000111: return a - d;
+        case 0b1000111: return m - d;
+        case 0b0000000: return d & a;
+        case 0b1000000: return d & m;
+        case 0b0010101: return d | a;
+        case 0b1010101: return d | m;
+        default:
+            break;
+    }
+
+    // Undocumented computations fall back to the ALU's control bits.
+    int16_t x = d;
+    int16_t y = (comp & 0x40) ? m : a;
+    if (comp & 0b100000) x = 0;
+    if (comp & 0b010000) x = ~x;
+    if (comp & 0b001000) y = 0;
+    if (comp & 0b000100) y = ~y;
+    int16_t out = (comp & 0b000010) ? static_cast<int16_t>(x + y) : static_cast<int16_t>(x & y);
+    if (comp & 0b000001) out = ~out;
+    return out;
+}
+
+void HackComputer::check_watchpoints(const uint16_t address, const int16_t old_value, const int16_t new_value) {
+    const int page = address / WATCH_PAGE_SIZE;
+    if (!(_watched_pages[page / 64] & (1ull << (page % 64)))) return;
+    for (const auto& [first, last] : _watchpoints) {
+        if (address < first || address > last) continue;
+        _watchpoint_hit = WatchpointHit{ _pc, address, old_value, new_value };
+        return;
+    }
+}
+
+bool HackComputer::is_idle_after_backwards_jump() {
+    if (!_watch.active || _watch.head_pc != _pc) {
+        watch_loop_head();
+        return false;
+    }
+
+    // The loop head is reached again. Compare against the previous visit.
+    bool is_same_state = _a == _watch.a && _d == _watch.d &&
+                         _watch.num_writes <= MAX_WATCHED_WRITES;
+    for (int i = 0; is_same_state && i < _watch.num_writes; ++i) {
+        // Only the first write to each address recorded the value it had at
+        // the previous visit.
+        const auto& [address, previous_value] = _watch.writes[i];
+        bool is_first_write = true;
+        for (int j = 0; j < i && is_first_write; ++j)
+            is_first_write = _watch.writes[j].first != address;
+        if (is_first_write && _ram[address] != previous_value) is_same_state = false;
+    }
+    if (is_same_state) return true;
+
+    watch_loop_head();
+    return false;
+}
+
+void HackComputer::watch_loop_head() {
+    _watch.active = true;
+    _watch.head_pc = _pc;
+    _watch.a = _a;
+    _watch.d = _d;
+    _watch.head_cycle = _cycles;
+    _watch.num_writes = 0;
+}
+
+std::string describe_halt_reason(const HaltReason reason) {
+    switch (reason) {
+        case HaltReason::CYCLE_BUDGET_EXHAUSTED:
+            return "Cycle budget exhausted";
+        case HaltReason::END_OF_PROGRAM:
+            return "Reached the end of the program";
+        case HaltReason::IDLE_LOOP:
+            return "Halted in an idle loop";
+        case HaltReason::OUT_OF_ROM:
+            return "Ran past the end of the program";
+        case HaltReason::BREAKPOINT:
+            return "Stopped at a breakpoint";
+        case HaltReason::WATCHPOINT:
+            return "Stopped at a watchpoint";
+        default:
+            return "Stopped";
+    }
+}
@@ -0,0 +1,294 @@
+#ifndef HACK_COMPUTER_H
+#define HACK_COMPUTER_H
+
+#include "KeyboardScript.h"
+#include "Rom.h"
+#include "Snapshot.h"
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+class Profiler;
+class TraceRecorder;
+
+// Data memory layout.
+constexpr int RAM_SIZE = 32768;
+constexpr int SCREEN_BASE = 16384;
+constexpr int KBD_ADDRESS = 24576;
+constexpr int SCREEN_WORDS = KBD_ADDRESS - SCREEN_BASE;
+
+/**
+ * Why `HackComputer::run` returned.
+ */
+enum class HaltReason {
+    CYCLE_BUDGET_EXHAUSTED,  // Ran for the requested number of cycles.
+    END_OF_PROGRAM,          // Reached a HALT_TRAP, eg. the `(END_INF)` loop.
+    IDLE_LOOP,               // Stuck in a loop that can never change state.
+    OUT_OF_ROM,              // The program counter left the loaded program.
+    BREAKPOINT,              // About to execute an instruction with a breakpoint.
+    WATCHPOINT               // Just wrote to a watched RAM address.
+};
+
+/**
+ * A write that triggered a watchpoint.
+ */
+struct WatchpointHit {
+    uint16_t pc;  // Address of the instruction that did the write.
+    uint16_t address;
+    int16_t old_value;
+    int16_t new_value;
+};
+
+/**
+ * Maps a HaltReason to a human-readable description.
+ */
+std::string describe_halt_reason(const HaltReason reason);
+
+/**
+ * What to do after detecting that the program is spinning in a loop that has
+ * no observable effect.
+ */
+enum class IdleLoopPolicy {
+    // Stop immediately. Used when running a program to completion.
+    HALT,
+
+    // Skip forward to the end of the cycle budget, leaving the machine in the
+    // exact state it would've been in had every cycle been executed. Used when
+    // a caller needs the state after precisely N cycles.
+    FAST_FORWARD
+};
+
+/**
+ * The Hack computer: the CPU's A, D and PC registers, 32K words of data memory
+ * (including the memory-mapped screen and keyboard) and a ROM.
+ */
+class HackComputer {
+public:
+    /**
+     * Creates a computer with zeroed RAM that will execute the given program
+     * from address 0.
+     */
+    explicit HackComputer(std::shared_ptr<const Rom> rom);
+
+    /**
+     * Points the program counter back at address 0. RAM and the A and D
+     * registers are left untouched, just like the Hack CPU's reset pin.
+     */
+    void reset();
+
+    /**
+     * Captures the registers, cycle count and RAM.
+     */
+    Snapshot snapshot();
+
+    /**
+     * Puts the computer back in the state captured by `snapshot`, which must
+     * have been taken with the same program.
+     *
+     * RAM is copied from the snapshot in pages. When the computer was last
+     * restored from, or took, the same snapshot, only the pages written since
+     * are copied back, so forking many short runs off one checkpoint costs
+     * little more than the runs themselves.
+     */
+    void restore(const Snapshot& snapshot);
+
+    /**
+     * Executes a single instruction.
+     */
+    void step();
+
+    /**
+     * Executes up to `max_cycles` instructions, stopping early if the program
+     * halts. Halting is detected in two ways:
+     *   1. Reaching a HALT_TRAP, like the `(END_INF)` loop emitted by the VM
+     *      translator. This costs nothing since the trap is marked when the
+     *      ROM is decoded.
+     *   2. Returning to the target of a backwards jump with A, D and every
+     *      RAM word written since the previous visit unchanged. From then on
+     *      the program can only ever repeat the same iteration, since the
+     *      only state that isn't restored is RAM that was never touched.
+     * What happens next is decided by the idle loop policy. While a keyboard
+     * script still has key changes to come, idle loops are always fast-forwarded
+     * to the next change, since a program waiting for a key isn't stuck.
+     *
+     * Also stops before executing an instruction with a breakpoint, and after
+     * an instruction writes to a watched address. Running again from a
+     * breakpoint executes the instruction under it first.
+     *
+     * The loop is compiled once per combination of profiler, trace recorder
+     * and watchpoints, so a computer with none of them attached does no
+     * checks for them at all.
+     */
+    HaltReason run(const uint64_t max_cycles);
+
+    void set_idle_loop_policy(const IdleLoopPolicy policy);
+
+    /**
+     * Reports every executed instruction to `profiler`, or stops reporting if
+     * it's null. Iterations skipped by `IdleLoopPolicy::FAST_FORWARD` aren't
+     * reported.
+     */
+    void set_profiler(Profiler* profiler);
+
+    /**
+     * Streams every executed instruction and RAM write to `recorder`, or stops
+     * if it's null. Iterations skipped by `IdleLoopPolicy::FAST_FORWARD` aren't
+     * recorded.
+     */
+    void set_trace_recorder(TraceRecorder* recorder);
+
+    /**
+     * Drives the KBD register from `script`, or leaves it alone if null. The
+     * register is set to what the script says for the current cycle straight
+     * away, and again after every `restore`.
+     *
+     * The run loop stops at each key change to update the register, so reads
+     * of KBD cost the same as any other RAM read.
+     */
+    void set_keyboard_script(std::shared_ptr<const KeyboardScript> script);
+
+    /**
+     * Makes `run` stop before executing the instruction at `address`. This
+     * patches the computer's own copy of the decoded program, so checking for
+     * breakpoints costs nothing. `step` ignores breakpoints.
+     */
+    void add_breakpoint(const uint16_t address);
+    void remove_breakpoint(const uint16_t address);
+
+    /**
+     * Makes `run` and `step` stop after any write to RAM[first_address]
+     * through RAM[last_address].
+     */
+    void add_watchpoint(const uint16_t first_address, const uint16_t last_address);
+    void clear_watchpoints();
+
+    /**
+     * The write that stopped the last `run` or `step`, if a watchpoint did.
+     */
+    const std::optional<WatchpointHit>& watchpoint_hit() const;
+
+    int16_t ram(const int address) const;
+    void set_ram(const int address, const int16_t value);
+
+    int16_t a() const;
+    int16_t d() const;
+    uint16_t pc() const;
+    void set_a(const int16_t value);
+    void set_d(const int16_t value);
+    void set_pc(const uint16_t value);
+
+    /**
+     * Returns a bitmap of the screen words written since the previous call,
+     * with bit i of element j standing for word SCREEN_BASE + 64 * j + i.
+     * Everything counts as written after construction and `restore`.
+     */
+    std::array<uint64_t, SCREEN_WORDS / 64> take_dirty_screen_words();
+
+    /**
+     * Total number of instructions executed (or fast-forwarded over) since
+     * construction.
+     */
+    uint64_t cycles() const;
+
+private:
+    std::shared_ptr<const Rom> _rom;
+    const DecodedInstruction* _program;
+    std::vector<int16_t> _ram;
+
+    // A copy of the decoded program with breakpoints patched in. `_program`
+    // points into it while any breakpoints are set.
+    std::vector<DecodedInstruction> _patched_program;
+
+    // The snapshot RAM that `_ram` was last made identical to, and which of
+    // its pages have been written since.
+    static const int DIRTY_PAGE_SIZE = 256;
+    std::shared_ptr<const std::vector<int16_t>> _clean_ram;
+    std::array<bool, RAM_SIZE / DIRTY_PAGE_SIZE> _dirty_pages;
+
+    // Screen words written since `take_dirty_screen_words` was last called.
+    std::array<uint64_t, SCREEN_WORDS / 64> _dirty_screen_words;
+
+    int16_t _a;
+    int16_t _d;
+    uint16_t _pc;
+    uint64_t _cycles;
+
+    IdleLoopPolicy _idle_loop_policy;
+    std::shared_ptr<const KeyboardScript> _keyboard_script;
+    size_t _next_key_change;  // Index into `_keyboard_script->changes()`.
+    Profiler* _profiler;
+    TraceRecorder* _trace_recorder;
+
+    // Watched address ranges, and which 64-word pages any of them touch so
+    // most writes are ruled out with a single bit test.
+    static const int WATCH_PAGE_SIZE = 64;
+    std::vector<std::pair<uint16_t, uint16_t>> _watchpoints;
+    std::array<uint64_t, RAM_SIZE / WATCH_PAGE_SIZE / 64> _watched_pages;
+    std::optional<WatchpointHit> _watchpoint_hit;
+
+    // What a run loop has to check for. Each combination gets its own
+    // instantiation of `run_until` and `execute`.
+    static constexpr unsigned PROFILED = 1;
+    static constexpr unsigned TRACED = 2;
+    static constexpr unsigned WATCHED = 4;
+
+    // Bookkeeping for the idle loop detector. Each time a backwards jump is
+    // taken, the state at the jump target is compared against the state from
+    // the previous time the same target was reached.
+    static const int MAX_WATCHED_WRITES = 32;
+    struct IdleLoopWatch {
+        bool active;
+        uint16_t head_pc;
+        int16_t a;
+        int16_t d;
+        uint64_t head_cycle;
+
+        // The address and previous value of each RAM write since `head_cycle`.
+        int num_writes;
+        std::array<std::pair<uint16_t, int16_t>, MAX_WATCHED_WRITES> writes;
+    };
+    IdleLoopWatch _watch;
+
+    // Runs until `end_cycle`, the end of the cycle budget or the next key
+    // change. Idle loops are fast-forwarded regardless of the policy if
+    // `is_waiting_for_input`. Picks the `run_until` instantiation for the
+    // attached profiler, trace recorder and watchpoints.
+    HaltReason run_until(const uint64_t end_cycle, const bool is_waiting_for_input);
+    template<unsigned FEATURES>
+    HaltReason run_until(const uint64_t end_cycle, const bool is_waiting_for_input);
+
+    // Applies the keyboard script's changes up to the current cycle to KBD.
+    void apply_key_changes();
+
+    // Sets KBD and `_next_key_change` from the keyboard script for the
+    // current cycle, eg. after the cycle count jumps on `restore`.
+    void seek_keyboard_script();
+
+    // Executes one instruction. Returns true if a backwards jump was taken.
+    template<unsigned FEATURES>
+    bool execute(const DecodedInstruction& instruction);
+
+    // Records a watchpoint hit if the write to `address` is watched.
+    void check_watchpoints(const uint16_t address, const int16_t old_value, const int16_t new_value);
+
+    // Notes a write for `take_dirty_screen_words` if `address` is on screen.
+    void mark_screen_word_dirty(const uint16_t address) {
+        const uint16_t index = address - SCREEN_BASE;
+        if (index < SCREEN_WORDS) _dirty_screen_words[index / 64] |= 1ull << (index % 64);
+    }
+
+    // Evaluates the ALU for the given a-bit and control bits.
+    static int16_t compute(const uint8_t comp, const int16_t d, const int16_t a, const int16_t m);
+
+    // Checks the idle loop detector after a backwards jump. Returns true if
+    // the machine is known to be looping forever.
+    bool is_idle_after_backwards_jump();
+
+    // Restarts the idle loop detector at the current program counter.
+    void watch_loop_head();
+};
+
+#endif
@@ -0,0 +1,135 @@
+#include "HackComputer.h"
+#include <gtest/gtest.h>
+#include <memory>
+#include <sstream>
+
+const std::string TEST_SRC = "test-files";
+
+std::shared_ptr<const Rom> load_test_program(const std::string& filename) {
+    return std::make_shared<const Rom>(Rom::from_file(TEST_SRC + "/" + filename));
+}
+
+TEST(HackComputerTest, ComputesMax) {
+    HackComputer computer(load_test_program("Max.asm"));
+    computer.set_ram(0, 3);
+    computer.set_ram(1, 17);
+
+    EXPECT_EQ(computer.run(1000), HaltReason::END_OF_PROGRAM);
+    EXPECT_EQ(computer.ram(2), 17);
+}
+
+TEST(HackComputerTest, EvaluatesArithmeticAndJumps) {
+    std::istringstream asm_in("@100\n"
+                              "D=-A\n"     // D = -100
+                              "@5\n"
+                              "D=D+A\n"    // D = -95
+                              "@0\n"
+                              "M=!D\n"     // RAM[0] = 94
+                              "AM=M-1\n"   // RAM[0] = 93, A = 93
+                              "@9\n"
+                              "D;JLT\n"    // Taken.
+                              "@1\n"       // Skipped.
+                              "M=-1\n");
+    HackComputer computer(std::make_shared<const Rom>(Rom::from_asm(asm_in)));
+
+    for (int i = 0; i < 9; ++i) computer.step();
+    EXPECT_EQ(computer.ram(0), 93);
+    EXPECT_EQ(computer.d(), -95);
+    EXPECT_EQ(computer.pc(), 9);
+    EXPECT_EQ(computer.ram(1), 0);
+    EXPECT_EQ(computer.cycles(), 9);
+}
+
+TEST(HackComputerTest, DetectsIdleLoopWithRestoredWrites) {
+    HackComputer computer(load_test_program("Countdown.asm"));
+    computer.set_ram(0, 50);
+
+    EXPECT_EQ(computer.run(1000000), HaltReason::IDLE_LOOP);
+    EXPECT_EQ(computer.ram(0), 0);
+    EXPECT_LT(computer.cycles(), 1000);
+}
+
+TEST(HackComputerTest, RunsOutOfRom) {
+    std::istringstream asm_in("@1\n"
+                              "D=A\n");
+    HackComputer computer(std::make_shared<const Rom>(Rom::from_asm(asm_in)));
+
+    EXPECT_EQ(computer.run(100), HaltReason::OUT_OF_ROM);
+    EXPECT_EQ(computer.cycles(), 2);
+}
+
+// Fast-forwarding over an idle loop must leave the machine in exactly the
+// state that executing every cycle would have.
+TEST(HackComputerTest, FastForwardMatchesFullExecution) {
+    for (const char* program : { "Max.asm", "Countdown.asm" }) {
+        for (uint64_t budget : { 997, 1000, 1001, 12345 }) {
+            HackComputer fast(load_test_program(program));
+            HackComputer slow(load_test_program(program));
+            fast.set_ram(0, 7);
+            slow.set_ram(0, 7);
+
+            fast.set_idle_loop_policy(IdleLoopPolicy::FAST_FORWARD);
+            EXPECT_EQ(fast.run(budget), HaltReason::CYCLE_BUDGET_EXHAUSTED);
+            for (uint64_t i = 0; i < budget; ++i) slow.step();
+
+            EXPECT_EQ(fast.cycles(), slow.cycles());
+            EXPECT_EQ(fast.pc(), slow.pc());
+            EXPECT_EQ(fast.a(), slow.a());
+            EXPECT_EQ(fast.d(), slow.d());
+            for (int addr = 0; addr < 16; ++addr)
+                EXPECT_EQ(fast.ram(addr), slow.ram(addr));
+        }
+    }
+}
+
+TEST(HackComputerTest, StopsAtBreakpoints) {
+    HackComputer computer(load_test_program("Countdown.asm"));
+    computer.set_ram(0, 3);
+    computer.add_breakpoint(5);  // M=M-1
+
+    EXPECT_EQ(computer.run(1000), HaltReason::BREAKPOINT);
+    EXPECT_EQ(computer.pc(), 5);
+    EXPECT_EQ(computer.ram(0), 3);
+
+    // Running again executes the instruction under the breakpoint first.
+    EXPECT_EQ(computer.run(1000), HaltReason::BREAKPOINT);
+    EXPECT_EQ(computer.ram(0), 2);
+    EXPECT_EQ(computer.cycles(), 13);
+
+    computer.step();
+    EXPECT_EQ(computer.ram(0), 1);
+
+    computer.remove_breakpoint(5);
+    EXPECT_EQ(computer.run(1000), HaltReason::IDLE_LOOP);
+    EXPECT_EQ(computer.ram(0), 0);
+    EXPECT_THROW(computer.add_breakpoint(100), HackRomError);
+}
+
+TEST(HackComputerTest, StopsAtWatchpoints) {
+    HackComputer computer(load_test_program("Countdown.asm"));
+    computer.set_ram(0, 2);
+    computer.add_watchpoint(1, 1);
+    computer.add_watchpoint(20000, 20100);
+
+    EXPECT_EQ(computer.run(1000), HaltReason::WATCHPOINT);
+    ASSERT_TRUE(computer.watchpoint_hit());
+    EXPECT_EQ(computer.watchpoint_hit()->pc, 9);
+    EXPECT_EQ(computer.watchpoint_hit()->address, 1);
+    EXPECT_EQ(computer.watchpoint_hit()->new_value, 0);
+    EXPECT_EQ(computer.ram(0), 0);
+
+    EXPECT_EQ(computer.run(1000), HaltReason::WATCHPOINT);
+    EXPECT_EQ(computer.watchpoint_hit()->old_value, 0);
+    EXPECT_EQ(computer.watchpoint_hit()->new_value, 1);
+
+    computer.step();
+    EXPECT_EQ(computer.watchpoint_hit()->new_value, 0);
+    computer.step();
+    EXPECT_FALSE(computer.watchpoint_hit());
+
+    // Watched but untouched addresses don't change how the program runs.
+    computer.clear_watchpoints();
+    computer.add_watchpoint(20000, 20100);
+    EXPECT_EQ(computer.run(1000), HaltReason::IDLE_LOOP);
+    EXPECT_FALSE(computer.watchpoint_hit());
+}
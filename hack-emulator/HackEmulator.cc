@@ -0,0 +1,235 @@
+#include "EmulatorFarm.h"
+#include "Framebuffer.h"
+#include "HackComputer.h"
+#include "Profiler.h"
+#include "Rom.h"
+#include "Trace.h"
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <string>
+
+// Cycle budget used when none is given on the command line.
+constexpr uint64_t DEFAULT_MAX_CYCLES = 100000000;
+
+// Cycles between frames saved by --frames. About 60 frames a second at the
+// speed of the CPU emulator that ships with the course tools.
+constexpr uint64_t FRAME_CYCLES = 100000;
+
+// Runs a single program and prints the final machine state. Starts from the
+// snapshot at `snapshot_path`, if given, rather than a fresh computer, and
+// reads the keyboard from the script at `keys_path`, if given.
+int run_program(const std::string& program_path, const uint64_t max_cycles, const std::string& snapshot_path = "",
+                const std::string& keys_path = "");
+
+// Runs a single program for `cycles` cycles and saves the machine state to
+// `snapshot_path`, eg. to skip booting the OS in later runs.
+int save_snapshot(const std::string& snapshot_path, const std::string& program_path, const uint64_t cycles);
+
+// Runs a single program with the profiler attached, prints the flat profile
+// and call graph, and writes collapsed call stacks to `<program>.folded`.
+int profile_program(const std::string& program_path, const uint64_t max_cycles);
+
+// Runs a single program while recording a trace of it to `trace_path`.
+int trace_program(const std::string& trace_path, const std::string& program_path, const uint64_t max_cycles);
+
+// Runs a single program and writes a PNG of the screen to `frames_dir` every
+// FRAME_CYCLES cycles, skipping frames in which nothing was drawn.
+int save_frames(const std::string& frames_dir, const std::string& program_path, const uint64_t max_cycles);
+
+// Runs a single program and compares its final screen against the image at
+// `golden_path`. Returns non-zero if any pixel differs.
+int check_screen(const std::string& golden_path, const std::string& program_path, const uint64_t max_cycles);
+
+// Runs every job in a batch manifest across all cores and prints a report.
+// Returns non-zero if any job failed.
+int run_batch(const std::string& manifest_path, const int num_threads);
+
+// Returns the same path that was given, but one level back.
+// Eg. Given "/home/linus/hello.txt", `get_directory_of_file` returns "/home/linus/".
+std::string get_directory_of_file(const std::string& path);
+
+int main(int argc, char* argv[]) {
+    if (argc < 2) {
+        std::cerr << "Insufficient arguments. Please supply a path to a .hack or .asm file.\n"
+                  << "Usage: " << argv[0] << " <program> [max_cycles]\n"
+                  << "       " << argv[0] << " --profile <program> [max_cycles]\n"
+                  << "       " << argv[0] << " --trace <trace_file> <program> [max_cycles]\n"
+                  << "       " << argv[0] << " --snapshot <snapshot_file> <program> <cycles>\n"
+                  << "       " << argv[0] << " --resume <snapshot_file> <program> [max_cycles]\n"
+                  << "       " << argv[0] << " --keys <keyboard_script> <program> [max_cycles]\n"
+                  << "       " << argv[0] << " --frames <out_dir> <program> [max_cycles]\n"
+                  << "       " << argv[0] << " --screen-check <golden_image> <program> [max_cycles]\n"
+                  << "       " << argv[0] << " --batch <manifest> [num_threads]\n";
+        exit(1);
+    }
+    const std::string mode = argv[1];
+    const bool takes_two_paths = mode == "--trace" || mode == "--snapshot" || mode == "--resume" ||
+                                 mode == "--keys" || mode == "--frames" || mode == "--screen-check";
+    if (argc > 5 || (argc > 4 && !takes_two_paths) || (argc > 3 && mode.rfind("--", 0) != 0)) {
+        std::cerr << "Too many arguments.\n";
+        exit(1);
+    } else if (takes_two_paths && argc < (mode == "--snapshot" ? 5 : 4)) {
+        std::cerr << "Insufficient arguments for " << mode << ".\n";
+        exit(1);
+    }
+
+    try {
+        if (mode == "--batch") {
+            if (argc < 3) {
+                std::cerr << "Please supply a path to the batch manifest.\n";
+                exit(1);
+            }
+            return run_batch(argv[2], argc == 4 ? std::stoi(argv[3]) : 0);
+        }
+        if (mode == "--profile") {
+            if (argc < 3) {
+                std::cerr << "Please supply a path to the program to profile.\n";
+                exit(1);
+            }
+            return profile_program(argv[2], argc == 4 ? std::stoull(argv[3]) : DEFAULT_MAX_CYCLES);
+        }
+        if (mode == "--trace")
+            return trace_program(argv[2], argv[3], argc == 5 ? std::stoull(argv[4]) : DEFAULT_MAX_CYCLES);
+        if (mode == "--snapshot")
+            return save_snapshot(argv[2], argv[3], std::stoull(argv[4]));
+        if (mode == "--keys")
+            return run_program(argv[3], argc == 5 ? std::stoull(argv[4]) : DEFAULT_MAX_CYCLES, "", argv[2]);
+        if (mode == "--frames")
+            return save_frames(argv[2], argv[3], argc == 5 ? std::stoull(argv[4]) : DEFAULT_MAX_CYCLES);
+        if (mode == "--screen-check")
+            return check_screen(argv[2], argv[3], argc == 5 ? std::stoull(argv[4]) : DEFAULT_MAX_CYCLES);
+        if (mode == "--resume")
+            return run_program(argv[3], argc == 5 ? std::stoull(argv[4]) : DEFAULT_MAX_CYCLES, argv[2]);
+        return run_program(argv[1], argc == 3 ? std::stoull(argv[2]) : DEFAULT_MAX_CYCLES);
+    } catch (const HackRomError& e) {
+        std::cerr << argv[0] << ": " << e.what() << "\n";
+        exit(1);
+    }
+}
+
+int run_program(const std::string& program_path, const uint64_t max_cycles, const std::string& snapshot_path,
+                const std::string& keys_path) {
+    std::shared_ptr<const Rom> rom = std::make_shared<const Rom>(Rom::from_file(program_path));
+    HackComputer computer(rom);
+    if (!snapshot_path.empty()) computer.restore(Snapshot::load_from_file(snapshot_path));
+    if (!keys_path.empty())
+        computer.set_keyboard_script(std::make_shared<const KeyboardScript>(KeyboardScript::from_file(keys_path)));
+    const HaltReason reason = computer.run(max_cycles);
+
+    std::cout << program_path << ": " << describe_halt_reason(reason)
+              << " after " << computer.cycles() << " cycles.\n";
+    std::cout << "\tPC: " << computer.pc()
+              << "\tA: " << computer.a()
+              << "\tD: " << computer.d() << "\n";
+    for (int i = 0; i < 16; ++i)
+        std::cout << "\tRAM[" << i << "]: " << computer.ram(i) << (i % 4 == 3 ? "\n" : "");
+    return 0;
+}
+
+int save_snapshot(const std::string& snapshot_path, const std::string& program_path, const uint64_t cycles) {
+    std::shared_ptr<const Rom> rom = std::make_shared<const Rom>(Rom::from_file(program_path));
+    HackComputer computer(rom);
+    computer.set_idle_loop_policy(IdleLoopPolicy::FAST_FORWARD);
+    computer.run(cycles);
+    computer.snapshot().save_to_file(snapshot_path);
+
+    std::cout << program_path << ": Saved the state after " << computer.cycles()
+              << " cycles to " << snapshot_path << "\n";
+    return 0;
+}
+
+int profile_program(const std::string& program_path, const uint64_t max_cycles) {
+    std::shared_ptr<const Rom> rom = std::make_shared<const Rom>(Rom::from_file(program_path));
+    HackComputer computer(rom);
+    Profiler profiler(rom);
+    computer.set_profiler(&profiler);
+    const HaltReason reason = computer.run(max_cycles);
+
+    std::cout << program_path << ": " << describe_halt_reason(reason)
+              << " after " << computer.cycles() << " cycles.\n\n";
+    profiler.write_flat_profile(std::cout);
+    std::cout << "\n";
+    profiler.write_call_graph(std::cout);
+
+    const std::string stacks_path = program_path.substr(0, program_path.find_last_of('.')) + ".folded";
+    std::ofstream stacks_out(stacks_path);
+    if (!stacks_out) throw HackRomError("Could not write '" + stacks_path + "'.");
+    profiler.write_collapsed_stacks(stacks_out);
+    std::cout << "\nCollapsed call stacks written to " << stacks_path << "\n";
+    return 0;
+}
+
+int trace_program(const std::string& trace_path, const std::string& program_path, const uint64_t max_cycles) {
+    std::shared_ptr<const Rom> rom = std::make_shared<const Rom>(Rom::from_file(program_path));
+    HackComputer computer(rom);
+    TraceRecorder recorder(trace_path);
+    computer.set_trace_recorder(&recorder);
+    const HaltReason reason = computer.run(max_cycles);
+    recorder.close();
+
+    std::cout << program_path << ": " << describe_halt_reason(reason)
+              << " after " << computer.cycles() << " cycles.\n"
+              << "Trace written to " << trace_path << "\n";
+    return 0;
+}
+
+int save_frames(const std::string& frames_dir, const std::string& program_path, const uint64_t max_cycles) {
+    std::shared_ptr<const Rom> rom = std::make_shared<const Rom>(Rom::from_file(program_path));
+    HackComputer computer(rom);
+    Framebuffer frame;
+    const std::string prefix = (frames_dir.empty() || frames_dir.back() == '/') ? frames_dir : frames_dir + "/";
+    int num_frames = 0;
+    HaltReason reason = HaltReason::CYCLE_BUDGET_EXHAUSTED;
+    while (reason == HaltReason::CYCLE_BUDGET_EXHAUSTED && computer.cycles() < max_cycles) {
+        reason = computer.run(std::min(FRAME_CYCLES, max_cycles - computer.cycles()));
+        if (frame.capture(computer) == 0) continue;
+        frame.save_to_file(prefix + "frame_" + std::to_string(computer.cycles()) + ".png");
+        ++num_frames;
+    }
+
+    std::cout << program_path << ": " << describe_halt_reason(reason)
+              << " after " << computer.cycles() << " cycles.\n"
+              << num_frames << " frames written to " << frames_dir << "\n";
+    return 0;
+}
+
+int check_screen(const std::string& golden_path, const std::string& program_path, const uint64_t max_cycles) {
+    const Framebuffer golden = Framebuffer::load_from_file(golden_path);
+    std::shared_ptr<const Rom> rom = std::make_shared<const Rom>(Rom::from_file(program_path));
+    HackComputer computer(rom);
+    const HaltReason reason = computer.run(max_cycles);
+    Framebuffer screen;
+    screen.capture(computer);
+    const int num_different = screen.count_different_pixels(golden);
+
+    std::cout << program_path << ": " << describe_halt_reason(reason)
+              << " after " << computer.cycles() << " cycles.\n";
+    if (num_different > 0) {
+        std::cout << num_different << " pixels differ from " << golden_path << "\n";
+        return 1;
+    }
+    std::cout << "Screen matches " << golden_path << "\n";
+    return 0;
+}
+
+int run_batch(const std::string& manifest_path, const int num_threads) {
+    std::ifstream manifest_in(manifest_path);
+    if (!manifest_in) throw HackRomError("Could not open '" + manifest_path + "'.");
+
+    std::vector<FarmJob> jobs = EmulatorFarm::parse_manifest(manifest_in, get_directory_of_file(manifest_path));
+    EmulatorFarm farm(num_threads);
+    std::vector<FarmResult> results = farm.run(jobs);
+    EmulatorFarm::write_report(std::cout, results);
+
+    for (const FarmResult& result : results)
+        if (!result.passed()) return 1;
+    return 0;
+}
+
+std::string get_directory_of_file(const std::string& path) {
+    const size_t last_slash_index = path.find_last_of('/');
+    if (last_slash_index == std::string::npos) return "";
+    return path.substr(0, last_slash_index + 1);
+}
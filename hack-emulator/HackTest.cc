@@ -0,0 +1,81 @@
+#include "KeyboardScript.h"
+#include "Rom.h"
+#include "TestScript.h"
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+int main(int argc, char* argv[]) {
+    if (argc < 2) {
+        std::cerr << "Insufficient arguments. Please supply one or more .tst files or directories.\n"
+                  << "Usage: " << argv[0]
+                  << " [-j num_threads] [--keys <keyboard_script>] [--junit <report.xml>] <test.tst | dir>...\n"
+                  << "Directories are searched for every chip with a .tst and .cmp file.\n";
+        exit(1);
+    }
+
+    int num_threads = 0;
+    std::shared_ptr<const KeyboardScript> keys;
+    std::string junit_path;
+    std::vector<std::string> paths;
+    try {
+        for (int i = 1; i < argc; ++i) {
+            const std::string arg = argv[i];
+            if ((arg == "-j" || arg == "--keys" || arg == "--junit") && i + 1 == argc) {
+                std::cerr << "Missing value for " << arg << ".\n";
+                exit(1);
+            } else if (arg == "-j") {
+                num_threads = std::stoi(argv[++i]);
+            } else if (arg == "--keys") {
+                keys = std::make_shared<const KeyboardScript>(KeyboardScript::from_file(argv[++i]));
+            } else if (arg == "--junit") {
+                junit_path = argv[++i];
+            } else if (std::filesystem::is_directory(arg)) {
+                for (const std::string& path : TestScript::find_chip_tests(arg)) paths.push_back(path);
+            } else {
+                paths.push_back(arg);
+            }
+        }
+    } catch (const HackRomError& e) {
+        std::cerr << argv[0] << ": " << e.what() << "\n";
+        exit(1);
+    }
+
+    const auto start_time = std::chrono::steady_clock::now();
+    const std::vector<TestScriptResult> results = TestScript::run_all(paths, num_threads, keys);
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start_time).count();
+
+    int num_passed = 0;
+    double total_seconds = 0;
+    for (const TestScriptResult& result : results) {
+        std::cout << (result.passed ? "PASS  " : "FAIL  ")
+                  << std::left << std::setw(48) << result.path << std::right << "  "
+                  << std::fixed << std::setprecision(3) << result.seconds * 1000 << " ms\n";
+        if (!result.passed) std::cout << "\t" << result.message << "\n";
+
+        // Like the course tools, leave the output next to the script.
+        if (!result.output_path.empty()) {
+            std::ofstream output_out(result.output_path);
+            output_out << result.output;
+        }
+        num_passed += result.passed;
+        total_seconds += result.seconds;
+    }
+    std::cout << num_passed << "/" << paths.size() << " passed in "
+              << std::fixed << std::setprecision(3) << seconds << " s (" << total_seconds << " s of worker time).\n";
+
+    if (!junit_path.empty()) {
+        std::ofstream junit_out(junit_path);
+        if (!junit_out) {
+            std::cerr << argv[0] << ": Could not write '" << junit_path << "'.\n";
+            return 1;
+        }
+        TestScript::write_junit_report(results, junit_out);
+    }
+    return num_passed == static_cast<int>(paths.size()) ? 0 : 1;
+}
@@ -0,0 +1,53 @@
+#include "Rom.h"
+#include "Trace.h"
+#include <iostream>
+#include <optional>
+#include <string>
+
+// Prints one traced instruction.
+void print_event(const TraceEvent& event);
+
+int main(int argc, char* argv[]) {
+    if (argc < 3) {
+        std::cerr << "Insufficient arguments. Please supply a trace file and a query.\n"
+                  << "Usage: " << argv[0] << " <trace_file> info\n"
+                  << "       " << argv[0] << " <trace_file> pc <cycle>\n"
+                  << "       " << argv[0] << " <trace_file> last-write <address> <before_cycle>\n"
+                  << "       " << argv[0] << " <trace_file> replay <from_cycle> <to_cycle>\n";
+        exit(1);
+    }
+
+    try {
+        TraceReader trace(argv[1]);
+        const std::string query = argv[2];
+        if (query == "info" && argc == 3) {
+            std::cout << argv[1] << ": " << trace.num_cycles() << " cycles in blocks of "
+                      << trace.block_cycles() << " cycles.\n";
+        } else if (query == "pc" && argc == 4) {
+            print_event(trace.event_at(std::stoull(argv[3])));
+        } else if (query == "last-write" && argc == 5) {
+            const std::optional<TraceEvent> write = trace.last_write_before(std::stoi(argv[3]), std::stoull(argv[4]));
+            if (write) {
+                print_event(*write);
+            } else {
+                std::cout << "RAM[" << argv[3] << "] was not written before cycle " << argv[4] << ".\n";
+            }
+        } else if (query == "replay" && argc == 5) {
+            for (const TraceEvent& event : trace.events(std::stoull(argv[3]), std::stoull(argv[4])))
+                print_event(event);
+        } else {
+            std::cerr << "Unknown query or wrong number of arguments for '" << query << "'.\n";
+            exit(1);
+        }
+    } catch (const HackRomError& e) {
+        std::cerr << argv[0] << ": " << e.what() << "\n";
+        exit(1);
+    }
+    return 0;
+}
+
+void print_event(const TraceEvent& event) {
+    std::cout << "cycle " << event.cycle << "\tPC: " << event.pc;
+    if (event.wrote_ram) std::cout << "\tRAM[" << event.address << "] = " << event.value;
+    std::cout << "\n";
+}
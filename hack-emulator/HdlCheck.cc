@@ -0,0 +1,74 @@
+#include "ChipChecker.h"
+#include "Netlist.h"
+#include "NetlistOptimiser.h"
+#include "Rom.h"
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Enough to try every input of a chip with up to 26 input bits, like
+// DMux8Way or Or8Way. Chips with wider inputs get this many random vectors.
+constexpr uint64_t DEFAULT_MAX_VECTORS = 1ull << 26;
+
+static void print_pins(const std::string& label, const std::vector<std::pair<std::string, int16_t>>& pins) {
+    std::cout << "\t" << std::left << std::setw(10) << label << std::right;
+    for (const auto& [name, value] : pins) std::cout << " " << name << "=" << value;
+    std::cout << "\n";
+}
+
+int main(int argc, char* argv[]) {
+    if (argc < 2) {
+        std::cerr << "Insufficient arguments. Please supply one or more .hdl files.\n"
+                  << "Usage: " << argv[0] << " [-j num_threads] [--vectors <max_vectors>] <chip.hdl>...\n";
+        exit(1);
+    }
+
+    int num_threads = 0;
+    uint64_t max_vectors = DEFAULT_MAX_VECTORS;
+    std::vector<std::string> paths;
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        if ((arg == "-j" || arg == "--vectors") && i + 1 == argc) {
+            std::cerr << "Missing value for " << arg << ".\n";
+            exit(1);
+        } else if (arg == "-j") {
+            num_threads = std::stoi(argv[++i]);
+        } else if (arg == "--vectors") {
+            max_vectors = std::stoull(argv[++i]);
+        } else {
+            paths.push_back(arg);
+        }
+    }
+
+    // Each chip is checked against the built-in chip of the same name.
+    int num_passed = 0;
+    for (const std::string& path : paths) {
+        std::cout << std::left << std::setw(40) << path << std::right << std::flush;
+        try {
+            const auto start_time = std::chrono::steady_clock::now();
+            auto chip = std::make_shared<const Netlist>(NetlistOptimiser::optimise(Netlist::from_file(path)));
+            auto reference =
+                std::make_shared<const Netlist>(NetlistOptimiser::optimise(Netlist::from_built_in(chip->name())));
+            const ChipCheckResult result = ChipChecker(chip, reference).check(max_vectors, num_threads);
+            const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start_time).count();
+
+            std::cout << (result.counterexample ? "FAIL  " : "PASS  ") << result.num_vectors
+                      << (result.is_exhaustive ? " vectors (every input)  " : " random vectors  ")
+                      << std::fixed << std::setprecision(3) << seconds << " s\n";
+            if (result.counterexample) {
+                print_pins("inputs", result.counterexample->inputs);
+                print_pins("expected", result.counterexample->expected_outputs);
+                print_pins("actual", result.counterexample->actual_outputs);
+            } else {
+                ++num_passed;
+            }
+        } catch (const HackRomError& e) {
+            std::cout << "FAIL\n\t" << e.what() << "\n";
+        }
+    }
+    std::cout << num_passed << "/" << paths.size() << " passed.\n";
+    return num_passed == static_cast<int>(paths.size()) ? 0 : 1;
+}
@@ -0,0 +1,195 @@
+#include "HdlChip.h"
+#include "Rom.h"
+#include <algorithm>
+#include <cctype>
+#include <filesystem>
+#include <fstream>
+
+struct HdlToken {
+    std::string text;
+    int line_num;
+};
+
+// Splits HDL into names, numbers, `..` and single-character punctuation,
+// dropping comments.
+static std::vector<HdlToken> tokenize(std::istream& hdl_in, const std::string& file_name) {
+    std::vector<HdlToken> tokens;
+    const std::string source((std::istreambuf_iterator<char>(hdl_in)), std::istreambuf_iterator<char>());
+    int line_num = 1;
+    for (size_t i = 0; i < source.size(); ) {
+        const char c = source[i];
+        if (c == '\n') {
+            ++line_num;
+            ++i;
+        } else if (std::isspace(static_cast<unsigned char>(c))) {
+            ++i;
+        } else if (source.compare(i, 2, "//") == 0) {
+            i = source.find('\n', i);
+            if (i == std::string::npos) i = source.size();
+        } else if (source.compare(i, 2, "/*") == 0) {
+            const size_t end = source.find("*/", i + 2);
+            const size_t comment_end = end == std::string::npos ? source.size() : end + 2;
+            line_num += std::count(source.begin() + i, source.begin() + comment_end, '\n');
+            i = comment_end;
+        } else if (std::isalnum(static_cast<unsigned char>(c)) || c == '_') {
+            const size_t start = i;
+            while (i < source.size() && (std::isalnum(static_cast<unsigned char>(source[i])) || source[i] == '_')) ++i;
+            tokens.push_back({ source.substr(start, i - start), line_num });
+        } else if (source.compare(i, 2, "..") == 0) {
+            tokens.push_back({ "..", line_num });
+            i += 2;
+        } else if (std::string("{}()[];:,=").find(c) != std::string::npos) {
+            tokens.push_back({ std::string(1, c), line_num });
+            ++i;
+        } else {
+            throw HackRomError(file_name + " line " + std::to_string(line_num) + ": unexpected '" + std::string(1, c) + "'.");
+        }
+    }
+    return tokens;
+}
+
+/**
+ * Walks the tokens of one chip definition.
+ */
+class HdlParser {
+public:
+    HdlParser(const std::vector<HdlToken>& tokens, const std::string& file_name)
+            : _tokens(tokens), _file_name(file_name), _position(0) {
+    }
+
+    HdlChip parse() {
+        HdlChip chip;
+        chip.file_name = _file_name;
+        expect("CHIP");
+        chip.name = take_name();
+        expect("{");
+        if (peek() == "IN") {
+            ++_position;
+            chip.inputs = take_pins();
+        }
+        if (peek() == "OUT") {
+            ++_position;
+            chip.outputs = take_pins();
+        }
+        if (peek() == "BUILTIN" || peek() == "CLOCKED")
+            fail("'" + peek() + "' chips are implemented in Java, so they can't be simulated from their HDL.");
+        expect("PARTS");
+        expect(":");
+        while (peek() != "}") chip.parts.push_back(take_part());
+        expect("}");
+        if (_position != _tokens.size()) fail("unexpected '" + peek() + "' after the chip.");
+        return chip;
+    }
+
+private:
+    const std::vector<HdlToken>& _tokens;
+    const std::string& _file_name;
+    size_t _position;
+
+    const std::string& peek() const {
+        static const std::string END_OF_FILE = "end of file";
+        return _position < _tokens.size() ? _tokens[_position].text : END_OF_FILE;
+    }
+
+    int line_num() const {
+        if (_tokens.empty()) return 1;
+        return _tokens[std::min(_position, _tokens.size() - 1)].line_num;
+    }
+
+    [[noreturn]] void fail(const std::string& message) const {
+        throw HackRomError(_file_name + " line " + std::to_string(line_num()) + ": " + message);
+    }
+
+    void expect(const std::string& text) {
+        if (peek() != text) fail("expected '" + text + "' but found '" + peek() + "'.");
+        ++_position;
+    }
+
+    std::string take_name() {
+        const std::string& name = peek();
+        if (_position >= _tokens.size() || !(std::isalpha(static_cast<unsigned char>(name[0])) || name[0] == '_'))
+            fail("expected a name but found '" + name + "'.");
+        ++_position;
+        return name;
+    }
+
+    int take_number() {
+        const std::string& number = peek();
+        if (_position >= _tokens.size() || !std::all_of(number.begin(), number.end(), ::isdigit) || number.size() > 4)
+            fail("expected a number but found '" + number + "'.");
+        ++_position;
+        return std::stoi(number);
+    }
+
+    // Parses `a, b[16], c;`.
+    std::vector<HdlPin> take_pins() {
+        std::vector<HdlPin> pins;
+        do {
+            HdlPin pin = { take_name(), 1 };
+            if (peek() == "[") {
+                ++_position;
+                pin.width = take_number();
+                expect("]");
+                if (pin.width < 1 || pin.width > 16) fail("pin '" + pin.name + "' must be 1 to 16 bits wide.");
+            }
+            pins.push_back(pin);
+        } while (peek() == "," && ++_position);
+        expect(";");
+        return pins;
+    }
+
+    // Parses an optional `[i]` or `[i..j]` into `first` and `last`.
+    void take_range(int& first, int& last) {
+        first = last = -1;
+        if (peek() != "[") return;
+        ++_position;
+        first = last = take_number();
+        if (peek() == "..") {
+            ++_position;
+            last = take_number();
+        }
+        expect("]");
+        if (last < first) fail("the range [" + std::to_string(first) + ".." + std::to_string(last) + "] is backwards.");
+    }
+
+    HdlPart take_part() {
+        HdlPart part;
+        part.line_num = line_num();
+        part.chip = take_name();
+        expect("(");
+        do {
+            HdlConnection connection;
+            connection.pin = take_name();
+            take_range(connection.first, connection.last);
+            expect("=");
+            connection.value = take_name();
+            take_range(connection.value_first, connection.value_last);
+            part.connections.push_back(connection);
+        } while (peek() == "," && ++_position);
+        expect(")");
+        expect(";");
+        return part;
+    }
+};
+
+HdlChip HdlChip::parse(std::istream& hdl_in, const std::string& file_name) {
+    return HdlParser(tokenize(hdl_in, file_name), file_name).parse();
+}
+
+HdlChip HdlChip::from_file(const std::string& path) {
+    // A directory opens fine, but fails with an exception once it's read.
+    std::ifstream hdl_in(path);
+    if (!hdl_in || !std::filesystem::is_regular_file(path)) throw HackRomError("Could not open '" + path + "'.");
+    return parse(hdl_in, path.substr(path.find_last_of('/') + 1));
+}
+
+const HdlPin* HdlChip::find_pin(const std::string& name) const {
+    for (const std::vector<HdlPin>* pins : { &inputs, &outputs })
+        for (const HdlPin& pin : *pins)
+            if (pin.name == name) return &pin;
+    return nullptr;
+}
+
+bool HdlChip::is_input(const std::string& name) const {
+    return std::any_of(inputs.begin(), inputs.end(), [&](const HdlPin& pin) { return pin.name == name; });
+}
@@ -0,0 +1,78 @@
+#ifndef HDL_CHIP_H
+#define HDL_CHIP_H
+
+#include <istream>
+#include <string>
+#include <vector>
+
+/**
+ * An input or output pin of a chip, `width` bits wide.
+ */
+struct HdlPin {
+    std::string name;
+    int width;
+};
+
+/**
+ * One `pin=value` connection of a part, eg. `a[0..7]=in[8..15]`. The pin is a
+ * pin of the part and the value is `true`, `false`, a pin of the chip being
+ * defined or an internal pin. Ranges are -1 when the whole pin is meant.
+ */
+struct HdlConnection {
+    std::string pin;
+    int first;
+    int last;
+    std::string value;
+    int value_first;
+    int value_last;
+};
+
+/**
+ * One line of the PARTS section, eg. `Mux16(a=x, b=y, sel=s, out=z);`.
+ */
+struct HdlPart {
+    std::string chip;
+    int line_num;
+    std::vector<HdlConnection> connections;
+};
+
+/**
+ * A chip definition written in the course's HDL:
+ *
+ *     CHIP Name {
+ *         IN a, b[16];
+ *         OUT out[16];
+ *         PARTS:
+ *         Part(pin=value, pin[i..j]=value[k], ...);
+ *     }
+ *
+ * Only the syntax is checked here. Whether the parts exist and are wired up
+ * correctly is checked when the chip is flattened into a Netlist.
+ */
+struct HdlChip {
+    std::string name;
+
+    // Where the definition was read from, for error messages.
+    std::string file_name;
+
+    std::vector<HdlPin> inputs;
+    std::vector<HdlPin> outputs;
+    std::vector<HdlPart> parts;
+
+    /**
+     * Parses a chip definition. `file_name` is only used in error messages.
+     */
+    static HdlChip parse(std::istream& hdl_in, const std::string& file_name);
+
+    static HdlChip from_file(const std::string& path);
+
+    /**
+     * Returns the input or output pin called `name`, or null if there isn't
+     * one.
+     */
+    const HdlPin* find_pin(const std::string& name) const;
+
+    bool is_input(const std::string& name) const;
+};
+
+#endif
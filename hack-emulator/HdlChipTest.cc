@@ -0,0 +1,76 @@
+#include "HdlChip.h"
+#include "Rom.h"
+#include <gtest/gtest.h>
+#include <sstream>
+
+TEST(HdlChipTest, ParsesPinsAndParts) {
+    std::istringstream hdl_in("/** Docs. */\n"
+                              "CHIP Pick {\n"
+                              "    IN in[16], sel;  // Inputs.\n"
+                              "    OUT out[8], low;\n"
+                              "    PARTS:\n"
+                              "    Mux(a=in[0], b=true, sel=sel, out=low);\n"
+                              "    Or8Way(in=in[8..15], out=any);\n"
+                              "    Foo(a[2..3]=any, out=out);\n"
+                              "}\n");
+    const HdlChip chip = HdlChip::parse(hdl_in, "Pick.hdl");
+    EXPECT_EQ(chip.name, "Pick");
+    ASSERT_EQ(chip.inputs.size(), 2);
+    EXPECT_EQ(chip.inputs[0].name, "in");
+    EXPECT_EQ(chip.inputs[0].width, 16);
+    EXPECT_EQ(chip.inputs[1].width, 1);
+    ASSERT_EQ(chip.outputs.size(), 2);
+    EXPECT_EQ(chip.outputs[0].width, 8);
+    EXPECT_TRUE(chip.is_input("sel"));
+    EXPECT_FALSE(chip.is_input("low"));
+    EXPECT_EQ(chip.find_pin("missing"), nullptr);
+
+    ASSERT_EQ(chip.parts.size(), 3);
+    EXPECT_EQ(chip.parts[0].chip, "Mux");
+    EXPECT_EQ(chip.parts[0].line_num, 6);
+    ASSERT_EQ(chip.parts[0].connections.size(), 4);
+    const HdlConnection& a = chip.parts[0].connections[0];
+    EXPECT_EQ(a.pin, "a");
+    EXPECT_EQ(a.first, -1);
+    EXPECT_EQ(a.value, "in");
+    EXPECT_EQ(a.value_first, 0);
+    EXPECT_EQ(a.value_last, 0);
+    const HdlConnection& high = chip.parts[1].connections[0];
+    EXPECT_EQ(high.value_first, 8);
+    EXPECT_EQ(high.value_last, 15);
+    const HdlConnection& foo = chip.parts[2].connections[0];
+    EXPECT_EQ(foo.first, 2);
+    EXPECT_EQ(foo.last, 3);
+    EXPECT_EQ(foo.value_first, -1);
+}
+
+TEST(HdlChipTest, ParsesCourseChips) {
+    const HdlChip chip = HdlChip::from_file("../nand2tetris-exercises/05/CPU.hdl");
+    EXPECT_EQ(chip.name, "CPU");
+    EXPECT_EQ(chip.inputs.size(), 3);
+    EXPECT_EQ(chip.outputs.size(), 4);
+    EXPECT_EQ(chip.parts.size(), 19);
+}
+
+TEST(HdlChipTest, ReportsSyntaxErrors) {
+    for (const std::string hdl : { "CHIP A { IN a; OUT b; PARTS: Not(in=a out=b); }",
+                                   "CHIP A { IN a[17]; OUT b; PARTS: }",
+                                   "CHIP A { IN a; OUT b; PARTS: Not(in=a[3..1], out=b); }",
+                                   "CHIP A { IN a; OUT b; BUILTIN A; }",
+                                   "CHIP A { IN a; OUT b; PARTS: Not(in=a, out=b);" }) {
+        std::istringstream hdl_in(hdl);
+        EXPECT_THROW(HdlChip::parse(hdl_in, "A.hdl"), HackRomError) << hdl;
+    }
+
+    std::istringstream hdl_in("CHIP A {\n IN a;\n OUT b;\n PARTS:\n Not(in=a, out=b) }");
+    try {
+        HdlChip::parse(hdl_in, "A.hdl");
+        FAIL();
+    } catch (const HackRomError& e) {
+        EXPECT_STREQ(e.what(), "A.hdl line 5: expected ';' but found '}'.");
+    }
+}
+
+TEST(HdlChipTest, ReportsDirectoriesAsUnreadable) {
+    EXPECT_THROW(HdlChip::from_file("../nand2tetris-exercises/01"), HackRomError);
+}
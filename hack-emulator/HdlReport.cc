@@ -0,0 +1,52 @@
+#include "BuiltInChips.h"
+#include "Netlist.h"
+#include "NetlistOptimiser.h"
+#include "NetlistReport.h"
+#include "Rom.h"
+#include <iomanip>
+#include <iostream>
+#include <string>
+
+static void print_sizes(const NetlistReport& report) {
+    std::cout << std::setw(9) << report.num_nands << std::setw(7) << report.num_dffs << std::setw(7) << report.depth;
+}
+
+int main(int argc, char* argv[]) {
+    if (argc < 2) {
+        std::cerr << "Insufficient arguments. Please supply one or more .hdl files.\n"
+                  << "Usage: " << argv[0] << " <chip.hdl>...\n";
+        exit(1);
+    }
+
+    // Each chip is shown as flattened, then optimised, then next to the
+    // optimised built-in chip of the same name if there is one.
+    std::cout << std::left << std::setw(32) << "Chip" << std::right
+              << std::setw(9) << "NANDs" << std::setw(7) << "DFFs" << std::setw(7) << "Depth" << "  |"
+              << std::setw(9) << "NANDs" << std::setw(7) << "DFFs" << std::setw(7) << "Depth" << "  |"
+              << std::setw(9) << "Built-in" << "\n";
+    int num_failed = 0;
+    for (int i = 1; i < argc; ++i) {
+        const std::string path = argv[i];
+        try {
+            const Netlist netlist = Netlist::from_file(path);
+            const NetlistReport report = NetlistReport::of(NetlistOptimiser::optimise(netlist));
+            std::cout << std::left << std::setw(32) << path << std::right;
+            print_sizes(NetlistReport::of(netlist));
+            std::cout << "  |";
+            print_sizes(report);
+            std::cout << "  |";
+            // The built-in memories aren't made of gates, so there's nothing
+            // to compare them with.
+            if (built_in_chip_hdl(netlist.name()) && !is_built_in_memory(netlist.name()))
+                std::cout << std::setw(9) << NetlistOptimiser::optimise(Netlist::from_built_in(netlist.name())).nands().size();
+            std::cout << "\n    fan-out";
+            for (size_t bucket = 0; bucket < report.fanout_histogram.size(); ++bucket)
+                std::cout << "  " << NetlistReport::FANOUT_BUCKETS[bucket] << ": " << report.fanout_histogram[bucket];
+            std::cout << "  (max " << report.max_fanout << ")\n";
+        } catch (const HackRomError& e) {
+            std::cout << path << "\n    " << e.what() << "\n";
+            ++num_failed;
+        }
+    }
+    return num_failed ? 1 : 0;
+}
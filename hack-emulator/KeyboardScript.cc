@@ -0,0 +1,110 @@
+#include "KeyboardScript.h"
+#include "Rom.h"
+#include <algorithm>
+#include <fstream>
+#include <set>
+#include <sstream>
+#include <tuple>
+#include <unordered_map>
+
+// Codes of the keys that don't have a printable character, as listed in the
+// Hack keyboard's specification.
+static const std::unordered_map<std::string, int16_t> KEY_NAMES = {
+    {"SPACE", 32},
+    {"NEWLINE", 128},
+    {"BACKSPACE", 129},
+    {"LEFT", 130},
+    {"UP", 131},
+    {"RIGHT", 132},
+    {"DOWN", 133},
+    {"HOME", 134},
+    {"END", 135},
+    {"PAGEUP", 136},
+    {"PAGEDOWN", 137},
+    {"INSERT", 138},
+    {"DELETE", 139},
+    {"ESC", 140},
+    {"F1", 141}, {"F2", 142}, {"F3", 143}, {"F4", 144}, {"F5", 145}, {"F6", 146},
+    {"F7", 147}, {"F8", 148}, {"F9", 149}, {"F10", 150}, {"F11", 151}, {"F12", 152}
+};
+
+// Parses a key token as described in `KeyboardScript::parse`.
+static int16_t parse_key(const std::string& token, const int line_num);
+
+KeyboardScript::KeyboardScript(const std::vector<KeyPress>& presses) {
+    // Sweep over the cycles at which any press starts or ends, keeping the
+    // held presses ordered by when they started. Ties go to the press listed
+    // later.
+    std::vector<std::pair<uint64_t, size_t>> boundaries;
+    for (size_t i = 0; i < presses.size(); ++i) {
+        if (presses[i].hold_cycles == 0) continue;
+        boundaries.push_back({ presses[i].cycle, i });
+        boundaries.push_back({ presses[i].cycle + presses[i].hold_cycles, i });
+    }
+    std::sort(boundaries.begin(), boundaries.end());
+
+    std::set<std::tuple<uint64_t, size_t>> held;
+    int16_t key = 0;
+    for (size_t i = 0; i < boundaries.size(); ) {
+        const uint64_t cycle = boundaries[i].first;
+        for (; i < boundaries.size() && boundaries[i].first == cycle; ++i) {
+            const KeyPress& press = presses[boundaries[i].second];
+            const std::tuple<uint64_t, size_t> entry = { press.cycle, boundaries[i].second };
+            if (press.cycle == cycle) held.insert(entry);
+            else held.erase(entry);
+        }
+        const int16_t held_key = held.empty() ? 0 : presses[std::get<1>(*held.rbegin())].key;
+        if (held_key != key) _changes.push_back({ cycle, held_key });
+        key = held_key;
+    }
+}
+
+KeyboardScript KeyboardScript::parse(std::istream& script_in) {
+    std::vector<KeyPress> presses;
+    std::string line;
+    int line_num = 0;
+    while (std::getline(script_in, line)) {
+        ++line_num;
+        size_t comment_start = line.find("//");
+        if (comment_start != std::string::npos) line.erase(comment_start);
+
+        std::istringstream tokens(line);
+        std::string cycle, key, hold_cycles, extra;
+        if (!(tokens >> cycle)) continue;
+        if (!(tokens >> key >> hold_cycles) || (tokens >> extra) ||
+                cycle.find_first_not_of("0123456789") != std::string::npos ||
+                hold_cycles.find_first_not_of("0123456789") != std::string::npos)
+            throw HackRomError("Keyboard script line " + std::to_string(line_num) + ": expected <cycle> <key> <hold_cycles>.");
+        presses.push_back({ std::stoull(cycle), std::stoull(hold_cycles), parse_key(key, line_num) });
+    }
+    return KeyboardScript(presses);
+}
+
+KeyboardScript KeyboardScript::from_file(const std::string& path) {
+    std::ifstream script_in(path);
+    if (!script_in) throw HackRomError("Could not open '" + path + "'.");
+    return parse(script_in);
+}
+
+const std::vector<KeyChange>& KeyboardScript::changes() const {
+    return _changes;
+}
+
+size_t KeyboardScript::first_change_after(const uint64_t cycle) const {
+    return std::upper_bound(_changes.begin(), _changes.end(), cycle,
+                            [](const uint64_t cycle, const KeyChange& change) { return cycle < change.cycle; }) -
+           _changes.begin();
+}
+
+int16_t KeyboardScript::key_at(const uint64_t cycle) const {
+    const size_t next_change = first_change_after(cycle);
+    return next_change == 0 ? 0 : _changes[next_change - 1].key;
+}
+
+static int16_t parse_key(const std::string& token, const int line_num) {
+    if (token.size() == 1) return token[0];
+    if (KEY_NAMES.count(token)) return KEY_NAMES.at(token);
+    if (token.find_first_not_of("0123456789") == std::string::npos && token.size() <= 5)
+        return static_cast<int16_t>(std::stoi(token));
+    throw HackRomError("Keyboard script line " + std::to_string(line_num) + ": unknown key '" + token + "'.");
+}
@@ -0,0 +1,73 @@
+#ifndef KEYBOARD_SCRIPT_H
+#define KEYBOARD_SCRIPT_H
+
+#include <cstdint>
+#include <istream>
+#include <string>
+#include <vector>
+
+/**
+ * One key held down for `hold_cycles` cycles, starting at cycle `cycle`.
+ */
+struct KeyPress {
+    uint64_t cycle;
+    uint64_t hold_cycles;
+    int16_t key;
+};
+
+/**
+ * From cycle `cycle` on, the keyboard register reads `key`, or 0 if no key is
+ * held.
+ */
+struct KeyChange {
+    uint64_t cycle;
+    int16_t key;
+};
+
+/**
+ * Timed keyboard input for running interactive programs without a user, eg.
+ * to benchmark a game or check what it draws after a sequence of moves.
+ *
+ * The presses are turned into a timeline of changes to the KBD register up
+ * front. When presses overlap, the keyboard reads the most recently pressed
+ * key that is still held, and goes back to the earlier key once it's
+ * released. The same script always produces the same cycle-by-cycle input.
+ */
+class KeyboardScript {
+public:
+    explicit KeyboardScript(const std::vector<KeyPress>& presses);
+
+    /**
+     * Parses a script. Each non-empty line is one key press:
+     *     <cycle> <key> <hold_cycles>
+     * A key is either a single character, which stands for its ASCII code, a
+     * name from the Hack keyboard's special keys (NEWLINE, BACKSPACE, LEFT,
+     * UP, RIGHT, DOWN, HOME, END, PAGEUP, PAGEDOWN, INSERT, DELETE, ESC,
+     * F1-F12 and SPACE) or a decimal key code. `//` starts a comment.
+     */
+    static KeyboardScript parse(std::istream& script_in);
+
+    static KeyboardScript from_file(const std::string& path);
+
+    /**
+     * The timeline of KBD values, in cycle order. Consecutive changes always
+     * have different keys.
+     */
+    const std::vector<KeyChange>& changes() const;
+
+    /**
+     * Index of the first change after `cycle`, or `changes().size()` if there
+     * are none.
+     */
+    size_t first_change_after(const uint64_t cycle) const;
+
+    /**
+     * What the KBD register reads at `cycle`.
+     */
+    int16_t key_at(const uint64_t cycle) const;
+
+private:
+    std::vector<KeyChange> _changes;
+};
+
+#endif
@@ -0,0 +1,108 @@
+#include "HackComputer.h"
+#include "KeyboardScript.h"
+#include <gtest/gtest.h>
+#include <memory>
+#include <sstream>
+
+const std::string KEYS_PATH = "test-files/Keys.asm";
+const std::string KEYS_SCRIPT_PATH = "test-files/Keys.txt";
+
+TEST(KeyboardScriptTest, OverlappingPressesGoBackToEarlierKey) {
+    const KeyboardScript script({ { 10, 20, 'A' }, { 15, 10, 'B' }, { 40, 0, 'C' }, { 50, 5, 'D' }, { 52, 5, 'D' } });
+    const std::vector<KeyChange>& changes = script.changes();
+    ASSERT_EQ(changes.size(), 6);
+    EXPECT_EQ(changes[0].cycle, 10);
+    EXPECT_EQ(changes[0].key, 'A');
+    EXPECT_EQ(changes[1].cycle, 15);
+    EXPECT_EQ(changes[1].key, 'B');
+    EXPECT_EQ(changes[2].cycle, 25);
+    EXPECT_EQ(changes[2].key, 'A');
+    EXPECT_EQ(changes[3].cycle, 30);
+    EXPECT_EQ(changes[3].key, 0);
+    EXPECT_EQ(changes[4].cycle, 50);
+    EXPECT_EQ(changes[4].key, 'D');
+    EXPECT_EQ(changes[5].cycle, 57);
+    EXPECT_EQ(changes[5].key, 0);
+
+    EXPECT_EQ(script.key_at(0), 0);
+    EXPECT_EQ(script.key_at(10), 'A');
+    EXPECT_EQ(script.key_at(24), 'B');
+    EXPECT_EQ(script.key_at(29), 'A');
+    EXPECT_EQ(script.key_at(45), 0);
+    EXPECT_EQ(script.key_at(1000), 0);
+    EXPECT_EQ(script.first_change_after(9), 0);
+    EXPECT_EQ(script.first_change_after(10), 1);
+    EXPECT_EQ(script.first_change_after(57), 6);
+}
+
+TEST(KeyboardScriptTest, ParsesKeyNames) {
+    std::istringstream script_in("// Comment\n"
+                                 "0 a 1\n"
+                                 "\n"
+                                 "2 LEFT 1  // Arrow\n"
+                                 "4 F12 1\n"
+                                 "6 SPACE 1\n"
+                                 "8 1000 1\n");
+    const KeyboardScript script = KeyboardScript::parse(script_in);
+    const std::vector<KeyChange>& changes = script.changes();
+    ASSERT_EQ(changes.size(), 10);
+    EXPECT_EQ(changes[0].key, 'a');
+    EXPECT_EQ(changes[2].key, 130);
+    EXPECT_EQ(changes[4].key, 152);
+    EXPECT_EQ(changes[6].key, ' ');
+    EXPECT_EQ(changes[8].key, 1000);
+
+    std::istringstream unknown_key("0 SHIFT 10\n");
+    EXPECT_THROW(KeyboardScript::parse(unknown_key), HackRomError);
+    std::istringstream missing_hold("0 A\n");
+    EXPECT_THROW(KeyboardScript::parse(missing_hold), HackRomError);
+}
+
+TEST(KeyboardScriptTest, ProgramWaitsForScriptedKeys) {
+    std::shared_ptr<const Rom> rom = std::make_shared<const Rom>(Rom::from_file(KEYS_PATH));
+    auto script = std::make_shared<const KeyboardScript>(KeyboardScript::from_file(KEYS_SCRIPT_PATH));
+
+    // With nothing to press, the wait is an idle loop.
+    HackComputer idle(rom);
+    EXPECT_EQ(idle.run(10000000), HaltReason::IDLE_LOOP);
+
+    HackComputer computer(rom);
+    computer.set_keyboard_script(script);
+    ASSERT_EQ(computer.run(10000000), HaltReason::END_OF_PROGRAM);
+    EXPECT_EQ(computer.ram(0), 140);
+    EXPECT_EQ(computer.ram(1), 3);
+    EXPECT_EQ(computer.ram(KBD_ADDRESS), 0);
+    EXPECT_GT(computer.cycles(), 2000300);
+    EXPECT_LT(computer.cycles(), 2000400);
+
+    // Skipping idle iterations doesn't change the outcome of any cycle.
+    HackComputer stepped(rom);
+    stepped.set_keyboard_script(script);
+    while (stepped.cycles() < computer.cycles()) stepped.step();
+    EXPECT_EQ(stepped.pc(), computer.pc());
+    EXPECT_EQ(stepped.d(), computer.d());
+    EXPECT_EQ(stepped.ram(1), 3);
+}
+
+TEST(KeyboardScriptTest, RestoreSeeksToSnapshotCycle) {
+    std::shared_ptr<const Rom> rom = std::make_shared<const Rom>(Rom::from_file(KEYS_PATH));
+    HackComputer computer(rom);
+    computer.set_keyboard_script(std::make_shared<const KeyboardScript>(KeyboardScript::from_file(KEYS_SCRIPT_PATH)));
+    const Snapshot start = computer.snapshot();
+    computer.run(1500);
+    EXPECT_EQ(computer.ram(KBD_ADDRESS), 'A');
+    const Snapshot holding_a = computer.snapshot();
+
+    computer.restore(start);
+    EXPECT_EQ(computer.ram(KBD_ADDRESS), 0);
+    computer.run(1500);
+    EXPECT_EQ(computer.ram(1), 1);
+
+    computer.run(200000);
+    EXPECT_EQ(computer.ram(0), 130);
+    computer.restore(holding_a);
+    EXPECT_EQ(computer.ram(KBD_ADDRESS), 'A');
+    EXPECT_EQ(computer.ram(0), 'A');
+    ASSERT_EQ(computer.run(10000000), HaltReason::END_OF_PROGRAM);
+    EXPECT_EQ(computer.ram(1), 3);
+}
@@ -0,0 +1,239 @@
+#include "LockstepComputer.h"
+#include <algorithm>
+#include <cstring>
+
+// `_recent_cycles` holds at most 32767 per lane, so it's folded into the 64-bit
+// totals at least this often.
+constexpr uint64_t MAX_ISSUES_BETWEEN_FLUSHES = 16384;
+
+template <int LANES>
+LockstepComputer<LANES>::LockstepComputer(std::shared_ptr<const Rom> rom)
+        : _rom(rom),
+          _program(rom->decoded()),
+          _ram(static_cast<size_t>(RAM_SIZE) * LANES, 0),
+          _a(),
+          _d(),
+          _pc(),
+          _running(),
+          _active(),
+          _recent_cycles(),
+          _issued_instructions(0),
+          _divergent_instructions(0) {
+    for (int l = 0; l < LANES; ++l) {
+        _cycles[l] = 0;
+        _halt_reason[l] = HaltReason::CYCLE_BUDGET_EXHAUSTED;
+    }
+}
+
+template <int LANES>
+int16_t LockstepComputer<LANES>::ram(const int lane, const int address) const {
+    return _ram[(address & 0x7FFF) * LANES + lane];
+}
+
+template <int LANES>
+void LockstepComputer<LANES>::set_ram(const int lane, const int address, const int16_t value) {
+    _ram[(address & 0x7FFF) * LANES + lane] = value;
+}
+
+template <int LANES>
+void LockstepComputer<LANES>::run(const uint64_t max_cycles) {
+    uint64_t end_cycle[LANES];
+    for (int l = 0; l < LANES; ++l) {
+        end_cycle[l] = _cycles[l] + max_cycles;
+        _running[l] = -1;
+    }
+
+    // A lane executes at most one instruction per issued instruction, so no
+    // lane can run out of cycles before this many have been issued.
+    uint64_t issues_until_budget_check = 0;
+
+    // While every running lane is at the same program counter, the next
+    // instruction is known without searching for the lowest one.
+    bool is_converged = false;
+    uint16_t next_pc = 0;
+    int first_running_lane = 0;
+
+    while (true) {
+        if (issues_until_budget_check == 0) {
+            flush_cycles();
+            issues_until_budget_check = MAX_ISSUES_BETWEEN_FLUSHES;
+            for (int l = 0; l < LANES; ++l) {
+                if (!_running[l]) continue;
+                if (_cycles[l] >= end_cycle[l]) {
+                    _running[l] = 0;
+                    _halt_reason[l] = HaltReason::CYCLE_BUDGET_EXHAUSTED;
+                } else {
+                    issues_until_budget_check = std::min(issues_until_budget_check, end_cycle[l] - _cycles[l]);
+                }
+            }
+            is_converged = false;
+        }
+
+        // Lanes at the lowest program counter go next. Lanes that jumped ahead
+        // wait for the others to catch up.
+        if (!is_converged) {
+            next_pc = UINT16_MAX;
+            for (int l = LANES - 1; l >= 0; --l) {
+                if (!_running[l]) continue;
+                next_pc = std::min(next_pc, static_cast<uint16_t>(_pc[l]));
+                first_running_lane = l;
+            }
+            if (next_pc == UINT16_MAX) break;
+        }
+
+        const DecodedInstruction& instruction = _program[next_pc];
+        if (instruction.op == OpCode::HALT_TRAP || instruction.op == OpCode::OUT_OF_ROM) {
+            for (int l = 0; l < LANES; ++l) {
+                if (!_running[l] || static_cast<uint16_t>(_pc[l]) != next_pc) continue;
+                _running[l] = 0;
+                if (instruction.op == OpCode::HALT_TRAP) {
+                    _a[l] = instruction.value;
+                    _halt_reason[l] = HaltReason::END_OF_PROGRAM;
+                } else {
+                    _halt_reason[l] = HaltReason::OUT_OF_ROM;
+                }
+            }
+            is_converged = false;
+            continue;
+        }
+
+        _active = _running & ~nonzero(_pc ^ static_cast<int16_t>(next_pc));
+        execute(instruction);
+        _recent_cycles -= _active;
+
+        ++_issued_instructions;
+        _divergent_instructions += any(_active ^ _running);
+        --issues_until_budget_check;
+
+        next_pc = _pc[first_running_lane];
+        is_converged = !any(_running & (_pc ^ static_cast<int16_t>(next_pc)));
+    }
+    flush_cycles();
+}
+
+template <int LANES>
+void LockstepComputer<LANES>::execute(const DecodedInstruction& instruction) {
+    if (instruction.op != OpCode::COMPUTE) {
+        _a = (_a & ~_active) | (static_cast<int16_t>(instruction.value) & _active);
+        _pc -= _active;
+        return;
+    }
+
+    // The ALU's control bits are the same for every lane, so they're turned
+    // into masks once and every lane goes through the same branch-free path.
+    const uint8_t comp = instruction.comp;
+    const int16_t keep_x = (comp & 0b100000) ? 0 : -1;
+    const int16_t negate_x = (comp & 0b010000) ? -1 : 0;
+    const int16_t keep_y = (comp & 0b001000) ? 0 : -1;
+    const int16_t negate_y = (comp & 0b000100) ? -1 : 0;
+    const int16_t add = (comp & 0b000010) ? -1 : 0;
+    const int16_t conjoin = (comp & 0b000010) ? 0 : -1;
+    const int16_t negate_out = (comp & 0b000001) ? -1 : 0;
+
+    // Lanes usually agree on A, eg. after `@i`, in which case M is one
+    // contiguous vector rather than a gather/scatter.
+    const Lanes address = _a & 0x7FFF;
+    const bool is_uniform_address = !any(address ^ address[0]);
+    int16_t* const uniform_m = &_ram[address[0] * LANES];
+
+    Lanes y = _a;
+    if ((comp & 0x40) && is_uniform_address) {
+        std::memcpy(&y, uniform_m, sizeof(Lanes));
+    } else if (comp & 0x40) {
+        for (int l = 0; l < LANES; ++l) y[l] = _ram[address[l] * LANES + l];
+    }
+
+    const Lanes x_in = (_d & keep_x) ^ negate_x;
+    const Lanes y_in = (y & keep_y) ^ negate_y;
+    const Lanes out = (((x_in + y_in) & add) | ((x_in & y_in) & conjoin)) ^ negate_out;
+
+    if ((instruction.dest & 0b001) && is_uniform_address) {
+        Lanes m;
+        std::memcpy(&m, uniform_m, sizeof(Lanes));
+        m = (m & ~_active) | (out & _active);
+        std::memcpy(uniform_m, &m, sizeof(Lanes));
+    } else if (instruction.dest & 0b001) {
+        for (int l = 0; l < LANES; ++l)
+            if (_active[l]) _ram[address[l] * LANES + l] = out[l];
+    }
+    if (instruction.dest & 0b010) _d = (_d & ~_active) | (out & _active);
+
+    if (instruction.jump == 0) {
+        _pc -= _active;
+    } else {
+        const int16_t jump_if_negative = (instruction.jump & 0b100) ? -1 : 0;
+        const int16_t jump_if_zero = (instruction.jump & 0b010) ? -1 : 0;
+        const int16_t jump_if_positive = (instruction.jump & 0b001) ? -1 : 0;
+        const Lanes is_negative = out >> 15;
+        const Lanes is_zero = ~nonzero(out);
+        const Lanes is_positive = ~(is_negative | is_zero);
+        const Lanes taken = _active & ((is_negative & jump_if_negative) |
+                                       (is_zero & jump_if_zero) |
+                                       (is_positive & jump_if_positive));
+        _pc = ((_pc - _active) & ~taken) | (address & taken);
+    }
+
+    if (instruction.dest & 0b100) _a = (_a & ~_active) | (out & _active);
+}
+
+template <int LANES>
+void LockstepComputer<LANES>::flush_cycles() {
+    for (int l = 0; l < LANES; ++l) _cycles[l] += static_cast<uint16_t>(_recent_cycles[l]);
+    _recent_cycles = Lanes();
+}
+
+template <int LANES>
+inline bool LockstepComputer<LANES>::any(const Lanes& mask) {
+    uint64_t words[sizeof(Lanes) / sizeof(uint64_t)];
+    std::memcpy(words, &mask, sizeof(Lanes));
+    uint64_t combined = 0;
+    for (const uint64_t word : words) combined |= word;
+    return combined != 0;
+}
+
+template <int LANES>
+inline typename LockstepComputer<LANES>::Lanes LockstepComputer<LANES>::nonzero(const Lanes& values) {
+    // Either x or -x is negative unless x is 0, and an arithmetic shift
+    // smears the sign bit across the lane.
+    return (values | -values) >> 15;
+}
+
+template <int LANES>
+HaltReason LockstepComputer<LANES>::halt_reason(const int lane) const {
+    return _halt_reason[lane];
+}
+
+template <int LANES>
+uint64_t LockstepComputer<LANES>::cycles(const int lane) const {
+    return _cycles[lane];
+}
+
+template <int LANES>
+int16_t LockstepComputer<LANES>::a(const int lane) const {
+    return _a[lane];
+}
+
+template <int LANES>
+int16_t LockstepComputer<LANES>::d(const int lane) const {
+    return _d[lane];
+}
+
+template <int LANES>
+uint16_t LockstepComputer<LANES>::pc(const int lane) const {
+    return _pc[lane];
+}
+
+template <int LANES>
+uint64_t LockstepComputer<LANES>::issued_instructions() const {
+    return _issued_instructions;
+}
+
+template <int LANES>
+uint64_t LockstepComputer<LANES>::divergent_instructions() const {
+    return _divergent_instructions;
+}
+
+// Supported lane counts.
+template class LockstepComputer<8>;
+template class LockstepComputer<16>;
+template class LockstepComputer<32>;
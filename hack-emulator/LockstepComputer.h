@@ -0,0 +1,120 @@
+#ifndef LOCKSTEP_COMPUTER_H
+#define LOCKSTEP_COMPUTER_H
+
+#include "HackComputer.h"
+#include "Rom.h"
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+// One 16-bit value per lane, as a GCC vector. GCC can't size a vector from a
+// template parameter, so each supported lane count is spelled out.
+template <int LANES>
+struct LaneVector;
+template <>
+struct LaneVector<8> { typedef int16_t type __attribute__((vector_size(16))); };
+template <>
+struct LaneVector<16> { typedef int16_t type __attribute__((vector_size(32))); };
+template <>
+struct LaneVector<32> { typedef int16_t type __attribute__((vector_size(64))); };
+
+/**
+ * Runs one program on LANES Hack computers at once, each with its own A, D, PC
+ * and RAM. Intended for fuzzing and exhaustive testing, where the same ROM is
+ * run over and over with different initial RAM.
+ *
+ * A, D and PC are held in vector registers with one 16-bit lane per computer,
+ * and RAM is interleaved so that the same address across all lanes is one
+ * contiguous vector. Instructions are decoded once and then applied to every
+ * lane with branch-free vector operations (16 lanes per instruction with
+ * AVX2, see HACK_EMULATOR_AVX2).
+ *
+ * Lanes run in lockstep for as long as they agree on the program counter. When
+ * a conditional jump sends them different ways, only the lanes at the lowest
+ * program counter are stepped, with the rest masked off until they catch up.
+ * This way lanes reconverge at the first instruction they share, such as the
+ * head of a loop that some lanes have left and others haven't.
+ */
+template <int LANES>
+class LockstepComputer {
+public:
+    /**
+     * Creates LANES computers with zeroed RAM, all starting at address 0.
+     */
+    explicit LockstepComputer(std::shared_ptr<const Rom> rom);
+
+    int16_t ram(const int lane, const int address) const;
+    void set_ram(const int lane, const int address, const int16_t value);
+
+    /**
+     * Runs every lane until it halts or has executed `max_cycles` instructions.
+     * Lanes halt when they reach a HALT_TRAP or leave the loaded program.
+     */
+    void run(const uint64_t max_cycles);
+
+    HaltReason halt_reason(const int lane) const;
+    uint64_t cycles(const int lane) const;
+    int16_t a(const int lane) const;
+    int16_t d(const int lane) const;
+    uint16_t pc(const int lane) const;
+
+    /**
+     * Number of instructions issued, counting each lockstep instruction once
+     * however many lanes executed it.
+     */
+    uint64_t issued_instructions() const;
+
+    /**
+     * Number of issued instructions that only some of the running lanes
+     * executed because control flow had diverged.
+     */
+    uint64_t divergent_instructions() const;
+
+private:
+    // Masks hold -1 in selected lanes and 0 in the others, which is also what
+    // vector comparisons produce.
+    typedef typename LaneVector<LANES>::type Lanes;
+
+    std::shared_ptr<const Rom> _rom;
+    const DecodedInstruction* _program;
+
+    // RAM word `address` of lane `l` lives at `_ram[address * LANES + l]`.
+    std::vector<int16_t> _ram;
+
+    Lanes _a;
+    Lanes _d;
+    Lanes _pc;
+
+    // Lanes that haven't halted.
+    Lanes _running;
+
+    // Lanes taking part in the current instruction.
+    Lanes _active;
+
+    // Instructions executed per lane, split into a 16-bit vector that's
+    // cheap to bump on every instruction and a total it's regularly folded
+    // into.
+    Lanes _recent_cycles;
+    uint64_t _cycles[LANES];
+
+    HaltReason _halt_reason[LANES];
+    uint64_t _issued_instructions;
+    uint64_t _divergent_instructions;
+
+    // Applies `instruction` to every active lane.
+    void execute(const DecodedInstruction& instruction);
+
+    // Adds `_recent_cycles` to `_cycles` and clears it.
+    void flush_cycles();
+
+    // Whether any lane of the mask is set.
+    static bool any(const Lanes& mask);
+
+    // A mask of the lanes that aren't 0. Masks are built with shifts rather
+    // than vector comparisons, which GCC splits into one compare per lane
+    // when the vector is wider than the target's registers, eg. 32 lanes
+    // with AVX2.
+    static Lanes nonzero(const Lanes& values);
+};
+
+#endif
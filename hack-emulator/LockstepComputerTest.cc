@@ -0,0 +1,68 @@
+#include "LockstepComputer.h"
+#include <gtest/gtest.h>
+#include <memory>
+
+// Runs Mult.asm on every pair of inputs in [0, 16) x [0, 16), LANES pairs at a
+// time, and checks each lane against the scalar emulator.
+template <int LANES>
+void check_mult_exhaustively() {
+    std::shared_ptr<const Rom> rom = std::make_shared<const Rom>(Rom::from_file("test-files/Mult.asm"));
+
+    for (int first_input = 0; first_input < 256; first_input += LANES) {
+        LockstepComputer<LANES> lockstep(rom);
+        for (int l = 0; l < LANES; ++l) {
+            lockstep.set_ram(l, 0, (first_input + l) / 16);
+            lockstep.set_ram(l, 1, (first_input + l) % 16);
+        }
+        lockstep.run(10000);
+
+        for (int l = 0; l < LANES; ++l) {
+            HackComputer scalar(rom);
+            scalar.set_ram(0, (first_input + l) / 16);
+            scalar.set_ram(1, (first_input + l) % 16);
+            ASSERT_EQ(scalar.run(10000), HaltReason::END_OF_PROGRAM);
+
+            EXPECT_EQ(lockstep.halt_reason(l), HaltReason::END_OF_PROGRAM);
+            EXPECT_EQ(lockstep.ram(l, 2), ((first_input + l) / 16) * ((first_input + l) % 16));
+            EXPECT_EQ(lockstep.cycles(l), scalar.cycles());
+            EXPECT_EQ(lockstep.pc(l), scalar.pc());
+            EXPECT_EQ(lockstep.a(l), scalar.a());
+            EXPECT_EQ(lockstep.d(l), scalar.d());
+        }
+    }
+}
+
+TEST(LockstepComputerTest, MatchesScalarEmulatorWith8Lanes) {
+    check_mult_exhaustively<8>();
+}
+
+TEST(LockstepComputerTest, MatchesScalarEmulatorWith32Lanes) {
+    check_mult_exhaustively<32>();
+}
+
+TEST(LockstepComputerTest, StaysConvergedOnIdenticalControlFlow) {
+    std::shared_ptr<const Rom> rom = std::make_shared<const Rom>(Rom::from_file("test-files/Mult.asm"));
+    LockstepComputer<16> lockstep(rom);
+    for (int l = 0; l < 16; ++l) {
+        lockstep.set_ram(l, 0, 5);
+        lockstep.set_ram(l, 1, l);
+    }
+    lockstep.run(10000);
+
+    EXPECT_EQ(lockstep.divergent_instructions(), 0);
+    EXPECT_EQ(lockstep.issued_instructions(), lockstep.cycles(0));
+    for (int l = 0; l < 16; ++l) EXPECT_EQ(lockstep.ram(l, 2), 5 * l);
+}
+
+TEST(LockstepComputerTest, StopsAtCycleBudget) {
+    std::shared_ptr<const Rom> rom = std::make_shared<const Rom>(Rom::from_file("test-files/Mult.asm"));
+    LockstepComputer<8> lockstep(rom);
+    for (int l = 0; l < 8; ++l) lockstep.set_ram(l, 0, 1000 * l);
+    lockstep.run(100);
+
+    EXPECT_EQ(lockstep.halt_reason(0), HaltReason::END_OF_PROGRAM);
+    for (int l = 1; l < 8; ++l) {
+        EXPECT_EQ(lockstep.halt_reason(l), HaltReason::CYCLE_BUDGET_EXHAUSTED);
+        EXPECT_EQ(lockstep.cycles(l), 100);
+    }
+}
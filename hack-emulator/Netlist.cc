@@ -0,0 +1,504 @@
+#include "Netlist.h"
+#include "BuiltInChips.h"
+#include "Rom.h"
+#include <fstream>
+#include <memory>
+#include <numeric>
+#include <optional>
+#include <sstream>
+#include <unordered_map>
+
+// Special values of `PartTemplate::bindings`.
+static const int32_t UNCONNECTED = -1;
+static const int32_t CONNECTED_TO_FALSE = -2;
+static const int32_t CONNECTED_TO_TRUE = -3;
+
+enum class Primitive {
+    NONE,
+    NAND,
+    DFF,
+    MEMORY
+};
+
+struct ChipTemplate;
+
+/**
+ * A part of a chip, with each bit of the part's pins (inputs first, in the
+ * order they're declared) bound to one of the chip's local nets.
+ */
+struct PartTemplate {
+    const ChipTemplate* chip;
+    std::vector<int32_t> bindings;
+
+    // Local nets that are the same net because one output bit of the part is
+    // connected to both, as in `out=x, out=y`.
+    std::vector<std::pair<int32_t, int32_t>> aliases;
+
+    // The name test scripts use for the part's state, eg. "DRegister", if
+    // it's a built-in register.
+    std::string register_name;
+};
+
+/**
+ * A chip definition resolved into nets, ready to be stamped out once for
+ * every instance of the chip. The chip's local nets are the bits of its own
+ * pins (inputs first) followed by the bits of its internal pins.
+ */
+struct ChipTemplate {
+    const HdlChip* chip;
+    Primitive primitive;
+    int num_input_bits;
+    int num_pin_bits;
+    int num_local_nets;
+    std::vector<PartTemplate> parts;
+};
+
+// Returns the offset of the first bit of the pin called `name` among the
+// chip's pin bits.
+static int pin_offset(const HdlChip& chip, const std::string& name) {
+    int offset = 0;
+    for (const std::vector<HdlPin>* pins : { &chip.inputs, &chip.outputs }) {
+        for (const HdlPin& pin : *pins) {
+            if (pin.name == name) return offset;
+            offset += pin.width;
+        }
+    }
+    return -1;
+}
+
+static int num_bits(const std::vector<HdlPin>& pins) {
+    return std::accumulate(pins.begin(), pins.end(), 0, [](const int sum, const HdlPin& pin) { return sum + pin.width; });
+}
+
+static HdlChip parse_chip(const std::string& hdl, const std::string& file_name) {
+    std::istringstream hdl_in(hdl);
+    return HdlChip::parse(hdl_in, file_name);
+}
+
+/**
+ * Flattens a chip by stamping out its parts recursively, joining the nets of
+ * connected pins with a union-find, and then sorts the resulting gates.
+ */
+class NetlistBuilder {
+public:
+    // Parts are looked up in `dir` before the built-in chips, unless it's
+    // std::nullopt.
+    explicit NetlistBuilder(const std::optional<std::string>& dir)
+            : _dir(dir) {
+        _chips["Nand"] = std::make_unique<HdlChip>(parse_chip("CHIP Nand { IN a, b; OUT out; PARTS: }", "Nand.hdl"));
+        _chips["DFF"] = std::make_unique<HdlChip>(parse_chip("CHIP DFF { IN in; OUT out; PARTS: }", "DFF.hdl"));
+    }
+
+    Netlist build(const HdlChip& top) {
+        const ChipTemplate& top_template = template_for(top);
+        _false_net = new_net();
+        _true_net = new_net();
+        std::vector<uint32_t> top_nets(top_template.num_pin_bits);
+        for (uint32_t& net : top_nets) net = new_net();
+        instantiate(top_template, top_nets.data());
+        return sort_gates(top, top_nets);
+    }
+
+private:
+    std::optional<std::string> _dir;
+    std::unordered_map<std::string, std::unique_ptr<HdlChip>> _chips;
+    std::unordered_map<std::string, bool> _is_built_in;
+    std::unordered_map<const HdlChip*, std::unique_ptr<ChipTemplate>> _templates;
+
+    // The union-find over every net of the flattened chip.
+    std::vector<uint32_t> _parent;
+    uint32_t _false_net;
+    uint32_t _true_net;
+
+    // Gates in terms of nets.
+    struct NetNand {
+        uint32_t a;
+        uint32_t b;
+        uint32_t out;
+    };
+    std::vector<NetNand> _nands;
+    std::vector<DffGate> _dffs;
+    std::vector<NetlistMemory> _memories;
+    std::vector<std::pair<std::string, std::vector<uint32_t>>> _register_nets;
+
+    uint32_t new_net() {
+        _parent.push_back(_parent.size());
+        return _parent.size() - 1;
+    }
+
+    uint32_t find(uint32_t net) {
+        while (_parent[net] != net) {
+            _parent[net] = _parent[_parent[net]];
+            net = _parent[net];
+        }
+        return net;
+    }
+
+    void unite(const uint32_t a, const uint32_t b) {
+        _parent[find(a)] = find(b);
+    }
+
+    // Finds the definition of the part `name` used on `line_num` of `parent`.
+    const HdlChip& chip_named(const std::string& name, const HdlChip& parent, const int line_num) {
+        const auto loaded = _chips.find(name);
+        if (loaded != _chips.end()) return *loaded->second;
+
+        const std::string path = _dir.value_or("") + name + ".hdl";
+        std::unique_ptr<HdlChip> chip;
+        if (_dir && std::ifstream(path)) {
+            chip = std::make_unique<HdlChip>(HdlChip::from_file(path));
+        } else if (const std::optional<std::string> hdl = built_in_chip_hdl(name)) {
+            chip = std::make_unique<HdlChip>(parse_chip(*hdl, name + ".hdl (built-in)"));
+            _is_built_in[name] = true;
+        } else {
+            throw HackRomError(parent.file_name + " line " + std::to_string(line_num) + ": there's no chip called '" + name + "'.");
+        }
+        if (chip->name != name)
+            throw HackRomError(chip->file_name + " defines '" + chip->name + "' rather than '" + name + "'.");
+        return *(_chips[name] = std::move(chip));
+    }
+
+    const ChipTemplate& template_for(const HdlChip& chip) {
+        const auto existing = _templates.find(&chip);
+        if (existing != _templates.end()) {
+            if (!existing->second) throw HackRomError(chip.file_name + ": '" + chip.name + "' is built out of itself.");
+            return *existing->second;
+        }
+        _templates[&chip] = nullptr;
+
+        auto chip_template = std::make_unique<ChipTemplate>();
+        chip_template->chip = &chip;
+        chip_template->primitive = chip.name == "Nand" && chip.parts.empty() ? Primitive::NAND
+                                 : chip.name == "DFF" && chip.parts.empty() ? Primitive::DFF
+                                 : _is_built_in.count(chip.name) && is_built_in_memory(chip.name) ? Primitive::MEMORY
+                                 : Primitive::NONE;
+        chip_template->num_input_bits = num_bits(chip.inputs);
+        chip_template->num_pin_bits = chip_template->num_input_bits + num_bits(chip.outputs);
+        chip_template->num_local_nets = chip_template->num_pin_bits;
+        resolve_parts(*chip_template);
+        return *(_templates[&chip] = std::move(chip_template));
+    }
+
+    // An internal pin of the chip being resolved.
+    struct InternalPin {
+        int offset;
+        int width;
+        bool is_driven;
+        int first_read_line_num;
+    };
+
+    // Binds every part's pins to the chip's local nets, checking that the
+    // parts exist and are wired up sensibly.
+    void resolve_parts(ChipTemplate& chip_template) {
+        const HdlChip& chip = *chip_template.chip;
+        std::unordered_map<std::string, InternalPin> internal_pins;
+        std::vector<bool> is_driven(chip_template.num_pin_bits, false);
+
+        for (const HdlPart& hdl_part : chip.parts) {
+            auto fail = [&](const std::string& message) {
+                throw HackRomError(chip.file_name + " line " + std::to_string(hdl_part.line_num) + ": " + message);
+            };
+            const HdlChip& part_chip = chip_named(hdl_part.chip, chip, hdl_part.line_num);
+            PartTemplate part;
+            part.chip = &template_for(part_chip);
+            part.bindings.assign(part.chip->num_pin_bits, UNCONNECTED);
+            const auto built_in = _is_built_in.find(part_chip.name);
+            if (built_in != _is_built_in.end() && is_built_in_register(part_chip.name)) part.register_name = part_chip.name;
+
+            for (const HdlConnection& connection : hdl_part.connections) {
+                const HdlPin* pin = part_chip.find_pin(connection.pin);
+                if (!pin) fail("'" + part_chip.name + "' has no pin called '" + connection.pin + "'.");
+                const bool is_output = !part_chip.is_input(pin->name);
+                const int first = connection.first < 0 ? 0 : connection.first;
+                const int last = connection.first < 0 ? pin->width - 1 : connection.last;
+                if (last >= pin->width) fail("'" + pin->name + "' only has " + std::to_string(pin->width) + " bits.");
+                const int width = last - first + 1;
+                const int part_offset = pin_offset(part_chip, pin->name) + first;
+
+                // Work out the local net of each bit of the value.
+                std::vector<int32_t> value_nets(width);
+                InternalPin* internal_pin = nullptr;
+                if (connection.value == "true" || connection.value == "false") {
+                    if (is_output) fail("the output '" + pin->name + "' can't be connected to " + connection.value + ".");
+                    if (connection.value_first >= 0) fail("'" + connection.value + "' can't have a subscript.");
+                    value_nets.assign(width, connection.value == "true" ? CONNECTED_TO_TRUE : CONNECTED_TO_FALSE);
+                } else if (const HdlPin* chip_pin = chip.find_pin(connection.value)) {
+                    if (is_output && chip.is_input(chip_pin->name))
+                        fail("the output '" + pin->name + "' can't drive the chip's input '" + chip_pin->name + "'.");
+                    const int value_first = connection.value_first < 0 ? 0 : connection.value_first;
+                    const int value_last = connection.value_first < 0 ? chip_pin->width - 1 : connection.value_last;
+                    if (value_last >= chip_pin->width)
+                        fail("'" + chip_pin->name + "' only has " + std::to_string(chip_pin->width) + " bits.");
+                    if (value_last - value_first + 1 != width)
+                        fail("'" + pin->name + "' and '" + chip_pin->name + "' have different widths.");
+                    std::iota(value_nets.begin(), value_nets.end(), pin_offset(chip, chip_pin->name) + value_first);
+                } else {
+                    if (connection.value_first >= 0)
+                        fail("the internal pin '" + connection.value + "' can't have a subscript.");
+                    auto inserted = internal_pins.insert({ connection.value, { chip_template.num_local_nets, width, false, 0 } });
+                    internal_pin = &inserted.first->second;
+                    if (inserted.second) {
+                        chip_template.num_local_nets += width;
+                        is_driven.resize(chip_template.num_local_nets, false);
+                    } else if (internal_pin->width != width) {
+                        fail("the internal pin '" + connection.value + "' is " + std::to_string(internal_pin->width) +
+                             " bits wide, but '" + pin->name + "' is " + std::to_string(width) + ".");
+                    }
+                    std::iota(value_nets.begin(), value_nets.end(), internal_pin->offset);
+                }
+
+                if (internal_pin && is_output) internal_pin->is_driven = true;
+                if (internal_pin && !is_output && !internal_pin->first_read_line_num)
+                    internal_pin->first_read_line_num = hdl_part.line_num;
+
+                for (int i = 0; i < width; ++i) {
+                    int32_t& binding = part.bindings[part_offset + i];
+                    if (is_output) {
+                        if (is_driven[value_nets[i]]) fail("'" + connection.value + "' is driven by more than one part.");
+                        is_driven[value_nets[i]] = true;
+                        if (binding == UNCONNECTED) binding = value_nets[i];
+                        else part.aliases.push_back({ binding, value_nets[i] });
+                    } else {
+                        if (binding != UNCONNECTED) fail("'" + pin->name + "' is connected more than once.");
+                        binding = value_nets[i];
+                    }
+                }
+            }
+            chip_template.parts.push_back(std::move(part));
+        }
+
+        for (const auto& [name, internal_pin] : internal_pins) {
+            if (!internal_pin.is_driven)
+                throw HackRomError(chip.file_name + " line " + std::to_string(internal_pin.first_read_line_num) +
+                                   ": no part drives the internal pin '" + name + "'.");
+        }
+    }
+
+    // Stamps out an instance of the chip with its pins on the given nets.
+    void instantiate(const ChipTemplate& chip_template, const uint32_t* pin_nets) {
+        std::vector<uint32_t> local_nets(pin_nets, pin_nets + chip_template.num_pin_bits);
+        for (int i = chip_template.num_pin_bits; i < chip_template.num_local_nets; ++i) local_nets.push_back(new_net());
+
+        std::vector<uint32_t> part_nets;
+        for (const PartTemplate& part : chip_template.parts) {
+            part_nets.resize(part.chip->num_pin_bits);
+            for (int i = 0; i < part.chip->num_pin_bits; ++i) {
+                const int32_t binding = part.bindings[i];
+                if (binding >= 0) part_nets[i] = local_nets[binding];
+                else if (binding == CONNECTED_TO_TRUE) part_nets[i] = _true_net;
+                else if (binding == CONNECTED_TO_FALSE || i < part.chip->num_input_bits) part_nets[i] = _false_net;
+                else part_nets[i] = new_net();
+            }
+            for (const auto& [a, b] : part.aliases) unite(local_nets[a], local_nets[b]);
+
+            if (part.chip->primitive == Primitive::NAND) _nands.push_back({ part_nets[0], part_nets[1], part_nets[2] });
+            else if (part.chip->primitive == Primitive::DFF) _dffs.push_back({ part_nets[0], part_nets[1] });
+            else if (part.chip->primitive == Primitive::MEMORY) add_memory(*part.chip->chip, part_nets);
+            else instantiate(*part.chip, part_nets.data());
+
+            if (!part.register_name.empty() && !is_register_recorded(part.register_name)) {
+                const int out_offset = pin_offset(*part.chip->chip, "out");
+                _register_nets.push_back({ part.register_name,
+                                           std::vector<uint32_t>(part_nets.begin() + out_offset, part_nets.end()) });
+            }
+        }
+    }
+
+    // Records a built-in memory, in terms of nets, with its pins on
+    // `pin_nets`.
+    void add_memory(const HdlChip& chip, const std::vector<uint32_t>& pin_nets) {
+        auto nets_of = [&](const std::string& name) {
+            const HdlPin* pin = chip.find_pin(name);
+            if (!pin) return std::vector<uint32_t>();
+            const auto first = pin_nets.begin() + pin_offset(chip, name);
+            return std::vector<uint32_t>(first, first + pin->width);
+        };
+        const std::vector<uint32_t> load = nets_of("load");
+        _memories.push_back({ chip.name, nets_of("in"), load.empty() ? _false_net : load[0], nets_of("address"),
+                              nets_of("out"), 0 });
+    }
+
+    bool is_register_recorded(const std::string& name) const {
+        for (const auto& each_register : _register_nets)
+            if (each_register.first == name) return true;
+        return false;
+    }
+
+    // Numbers the wires and sorts the NAND gates and memory reads so that each
+    // comes after the gates driving its inputs.
+    Netlist sort_gates(const HdlChip& top, const std::vector<uint32_t>& top_nets) {
+        static const uint32_t NO_WIRE = UINT32_MAX;
+        const size_t num_nets = _parent.size();
+        std::vector<uint32_t> wire_of_root(num_nets, NO_WIRE);
+        auto drive = [&](const uint32_t net, const uint32_t wire) {
+            uint32_t& root_wire = wire_of_root[find(net)];
+            if (root_wire != NO_WIRE) throw HackRomError(top.file_name + ": a wire is driven by more than one gate.");
+            root_wire = wire;
+        };
+        auto wire_of = [&](const uint32_t net) {
+            const uint32_t wire = wire_of_root[find(net)];
+            return wire == NO_WIRE ? Netlist::FALSE_WIRE : wire;
+        };
+
+        Netlist netlist;
+        netlist._name = top.name;
+        drive(_false_net, Netlist::FALSE_WIRE);
+        drive(_true_net, Netlist::TRUE_WIRE);
+        uint32_t next_wire = 2;
+        for (int i = 0; i < num_bits(top.inputs); ++i) drive(top_nets[i], next_wire++);
+        for (const DffGate& dff : _dffs) drive(dff.out, next_wire++);
+        for (const NetlistMemory& memory : _memories)
+            for (const uint32_t out : memory.out) drive(out, next_wire++);
+        netlist._first_nand_wire = next_wire;
+
+        // Kahn's algorithm, over the gates fed by each gate. The NAND gates
+        // are nodes 0 to _nands.size() - 1, and reading memory i is node
+        // _nands.size() + i.
+        const size_t num_nodes = _nands.size() + _memories.size();
+        std::vector<int32_t> node_of_root(num_nets, -1);
+        for (size_t i = 0; i < _memories.size(); ++i)
+            for (const uint32_t out : _memories[i].out) node_of_root[find(out)] = _nands.size() + i;
+        for (size_t i = 0; i < _nands.size(); ++i) {
+            int32_t& node = node_of_root[find(_nands[i].out)];
+            if (node >= 0 || wire_of_root[find(_nands[i].out)] != NO_WIRE)
+                throw HackRomError(top.file_name + ": a wire is driven by more than one gate.");
+            node = i;
+        }
+        // A memory's output only depends on its address. Its other inputs are
+        // only read on the tick.
+        auto for_each_input = [&](const size_t node, auto&& visit) {
+            if (node < _nands.size()) {
+                visit(_nands[node].a);
+                visit(_nands[node].b);
+            } else {
+                for (const uint32_t input : _memories[node - _nands.size()].address) visit(input);
+            }
+        };
+        std::vector<uint32_t> num_waiting_inputs(num_nodes, 0);
+        std::vector<uint32_t> fanout_start(num_nodes + 1, 0);
+        for (size_t i = 0; i < num_nodes; ++i) {
+            for_each_input(i, [&](const uint32_t input) {
+                const int32_t driver = node_of_root[find(input)];
+                if (driver >= 0) ++fanout_start[driver + 1];
+            });
+        }
+        std::partial_sum(fanout_start.begin(), fanout_start.end(), fanout_start.begin());
+        std::vector<uint32_t> fanout(fanout_start.back());
+        std::vector<uint32_t> fanout_end(fanout_start.begin(), fanout_start.end() - 1);
+        for (size_t i = 0; i < num_nodes; ++i) {
+            for_each_input(i, [&](const uint32_t input) {
+                const int32_t driver = node_of_root[find(input)];
+                if (driver < 0) return;
+                fanout[fanout_end[driver]++] = i;
+                ++num_waiting_inputs[i];
+            });
+        }
+
+        std::vector<uint32_t> order;
+        order.reserve(num_nodes);
+        for (size_t i = 0; i < num_nodes; ++i)
+            if (!num_waiting_inputs[i]) order.push_back(i);
+        for (size_t i = 0; i < order.size(); ++i) {
+            const uint32_t node = order[i];
+            for (uint32_t j = fanout_start[node]; j < fanout_start[node + 1]; ++j)
+                if (!--num_waiting_inputs[fanout[j]]) order.push_back(fanout[j]);
+        }
+        if (order.size() != num_nodes)
+            throw HackRomError(top.file_name + ": the chip has a combinational loop, a path from a gate's output back to "
+                               "its own input that doesn't go through a DFF.");
+
+        for (const uint32_t node : order)
+            if (node < _nands.size()) drive(_nands[node].out, next_wire++);
+        for (const uint32_t node : order) {
+            if (node < _nands.size()) {
+                netlist._nands.push_back({ wire_of(_nands[node].a), wire_of(_nands[node].b) });
+                continue;
+            }
+            const NetlistMemory& memory = _memories[node - _nands.size()];
+            NetlistMemory netlist_memory = { memory.name, {}, wire_of(memory.load), {}, {},
+                                             static_cast<uint32_t>(netlist._nands.size()) };
+            for (auto [nets, wires] : { std::make_pair(&memory.in, &netlist_memory.in),
+                                        std::make_pair(&memory.address, &netlist_memory.address),
+                                        std::make_pair(&memory.out, &netlist_memory.out) })
+                for (const uint32_t net : *nets) wires->push_back(wire_of(net));
+            netlist._memories.push_back(netlist_memory);
+        }
+        for (const DffGate& dff : _dffs) netlist._dffs.push_back({ wire_of(dff.in), wire_of(dff.out) });
+        netlist._num_wires = next_wire;
+
+        int bit = 0;
+        for (auto [pins, netlist_pins] : { std::make_pair(&top.inputs, &netlist._inputs),
+                                           std::make_pair(&top.outputs, &netlist._outputs) }) {
+            for (const HdlPin& pin : *pins) {
+                NetlistPin netlist_pin = { pin.name, {} };
+                for (int i = 0; i < pin.width; ++i) netlist_pin.wires.push_back(wire_of(top_nets[bit++]));
+                netlist_pins->push_back(netlist_pin);
+            }
+        }
+
+        // A register's bits are the outputs of its DFFs.
+        std::unordered_map<uint32_t, uint32_t> dff_of_wire;
+        for (size_t i = 0; i < netlist._dffs.size(); ++i) dff_of_wire[netlist._dffs[i].out] = i;
+        for (const auto& [name, nets] : _register_nets) {
+            NetlistRegister netlist_register = { name, {} };
+            for (const uint32_t net : nets) {
+                const auto dff = dff_of_wire.find(wire_of(net));
+                if (dff == dff_of_wire.end()) break;
+                netlist_register.dffs.push_back(dff->second);
+            }
+            if (netlist_register.dffs.size() == nets.size()) netlist._registers.push_back(netlist_register);
+        }
+        return netlist;
+    }
+};
+
+Netlist Netlist::from_file(const std::string& path) {
+    const size_t last_slash_index = path.find_last_of('/');
+    return from_chip(HdlChip::from_file(path), last_slash_index == std::string::npos ? "" : path.substr(0, last_slash_index + 1));
+}
+
+Netlist Netlist::from_chip(const HdlChip& chip, const std::string& dir) {
+    return NetlistBuilder(dir).build(chip);
+}
+
+Netlist Netlist::from_built_in(const std::string& name) {
+    const std::optional<std::string> hdl = built_in_chip_hdl(name);
+    if (!hdl) throw HackRomError("There's no built-in chip called '" + name + "'.");
+    return NetlistBuilder(std::nullopt).build(parse_chip(*hdl, name + ".hdl (built-in)"));
+}
+
+const std::string& Netlist::name() const {
+    return _name;
+}
+
+uint32_t Netlist::num_wires() const {
+    return _num_wires;
+}
+
+uint32_t Netlist::first_nand_wire() const {
+    return _first_nand_wire;
+}
+
+const std::vector<NandGate>& Netlist::nands() const {
+    return _nands;
+}
+
+const std::vector<DffGate>& Netlist::dffs() const {
+    return _dffs;
+}
+
+const std::vector<NetlistMemory>& Netlist::memories() const {
+    return _memories;
+}
+
+const std::vector<NetlistPin>& Netlist::inputs() const {
+    return _inputs;
+}
+
+const std::vector<NetlistPin>& Netlist::outputs() const {
+    return _outputs;
+}
+
+const std::vector<NetlistRegister>& Netlist::registers() const {
+    return _registers;
+}
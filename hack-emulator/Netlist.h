@@ -0,0 +1,137 @@
+#ifndef NETLIST_H
+#define NETLIST_H
+
+#include "HdlChip.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * A NAND gate. Its output is a wire of its own, given by its position in
+ * `Netlist::nands()`.
+ */
+struct NandGate {
+    uint32_t a;
+    uint32_t b;
+};
+
+/**
+ * A data flip-flop: `out` takes the value `in` had on the previous clock
+ * cycle.
+ */
+struct DffGate {
+    uint32_t in;
+    uint32_t out;
+};
+
+/**
+ * A pin of the chip, with the wire for each of its bits, least significant
+ * first.
+ */
+struct NetlistPin {
+    std::string name;
+    std::vector<uint32_t> wires;
+};
+
+/**
+ * A built-in register that test scripts can read and write as `<name>[]`,
+ * with the DFF that holds each of its bits.
+ */
+struct NetlistRegister {
+    std::string name;
+    std::vector<uint32_t> dffs;
+};
+
+/**
+ * A built-in memory chip, eg. `RAM16K`, `Screen` or `ROM32K`, kept as an
+ * array of 2^address.size() words rather than built from gates. `out` is the
+ * word at `address`, and `in` is written there on the tick if `load` is 1.
+ * `ROM32K` and `Keyboard` have no `in` and never load, so only test scripts
+ * write to them, as `<name>[i]`.
+ */
+struct NetlistMemory {
+    std::string name;
+    std::vector<uint32_t> in;
+    uint32_t load;
+    std::vector<uint32_t> address;
+    std::vector<uint32_t> out;
+
+    // How many of the NAND gates are evaluated before the memory is read. All
+    // of the gates its address depends on are among them, and none of the
+    // gates that read its output are.
+    uint32_t num_nands_before;
+};
+
+/**
+ * A chip flattened down to Nand and DFF gates and built-in memories, ready
+ * to simulate.
+ *
+ * Every wire has an index. Wires 0 and 1 are the constants false and true,
+ * followed by the chip's input bits, the DFFs' outputs, the memories' outputs
+ * and then the NAND gates' outputs. The NAND gates are sorted so each one
+ * comes after the gates that feed it, and each memory is read between the
+ * gates that drive its address and the gates that read it. Evaluating them in
+ * that order, once each, settles every wire.
+ */
+class Netlist {
+public:
+    static constexpr uint32_t FALSE_WIRE = 0;
+    static constexpr uint32_t TRUE_WIRE = 1;
+
+    /**
+     * Reads the chip at `path` and flattens it. Parts are looked up in the
+     * chip's directory first, as `<part>.hdl`, and then among the built-in
+     * chips.
+     */
+    static Netlist from_file(const std::string& path);
+
+    /**
+     * Flattens `chip`, looking up parts in `dir` and then among the built-in
+     * chips.
+     */
+    static Netlist from_chip(const HdlChip& chip, const std::string& dir);
+
+    /**
+     * Flattens the built-in chip called `name`, eg. to check a chip written
+     * for the course against it. Throws if there's no such chip.
+     */
+    static Netlist from_built_in(const std::string& name);
+
+    const std::string& name() const;
+
+    uint32_t num_wires() const;
+
+    /**
+     * The wire driven by `nands()[0]`. NAND i drives wire
+     * `first_nand_wire() + i`.
+     */
+    uint32_t first_nand_wire() const;
+
+    const std::vector<NandGate>& nands() const;
+    const std::vector<DffGate>& dffs() const;
+
+    /**
+     * The memories, in the order they're read in, ie. by `num_nands_before`.
+     */
+    const std::vector<NetlistMemory>& memories() const;
+
+    const std::vector<NetlistPin>& inputs() const;
+    const std::vector<NetlistPin>& outputs() const;
+    const std::vector<NetlistRegister>& registers() const;
+
+private:
+    std::string _name;
+    uint32_t _num_wires;
+    uint32_t _first_nand_wire;
+    std::vector<NandGate> _nands;
+    std::vector<DffGate> _dffs;
+    std::vector<NetlistMemory> _memories;
+    std::vector<NetlistPin> _inputs;
+    std::vector<NetlistPin> _outputs;
+    std::vector<NetlistRegister> _registers;
+
+    friend class NetlistBuilder;
+    friend class NetlistOptimiser;
+};
+
+#endif
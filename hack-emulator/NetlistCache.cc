@@ -0,0 +1,73 @@
+#include "NetlistCache.h"
+#include "NetlistOptimiser.h"
+#include "Rom.h"
+#include <fstream>
+#include <sstream>
+#include <unordered_set>
+#include <vector>
+
+constexpr uint64_t FNV_OFFSET_BASIS = 14695981039346656037ull;
+constexpr uint64_t FNV_PRIME = 1099511628211ull;
+
+static void hash_bytes(uint64_t& hash, const std::string& bytes) {
+    for (const char c : bytes) {
+        hash ^= static_cast<uint8_t>(c);
+        hash *= FNV_PRIME;
+    }
+    // Ends each piece, so that eg. "ab" + "c" and "a" + "bc" differ.
+    hash ^= 0xFF;
+    hash *= FNV_PRIME;
+}
+
+std::shared_ptr<const Netlist> NetlistCache::get(const std::string& path) {
+    const uint64_t hash = content_hash(path);
+    std::promise<std::shared_ptr<const Netlist>> promise;
+    std::shared_future<std::shared_ptr<const Netlist>> netlist;
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        const auto inserted = _netlists.insert({ hash, promise.get_future().share() });
+        netlist = inserted.first->second;
+        if (!inserted.second) return netlist.get();
+    }
+
+    // Flatten outside the lock, so that other chips can be flattened at the
+    // same time.
+    try {
+        promise.set_value(std::make_shared<const Netlist>(NetlistOptimiser::optimise(Netlist::from_file(path))));
+    } catch (...) {
+        promise.set_exception(std::current_exception());
+    }
+    return netlist.get();
+}
+
+size_t NetlistCache::size() const {
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _netlists.size();
+}
+
+uint64_t NetlistCache::content_hash(const std::string& path) {
+    const size_t last_slash_index = path.find_last_of('/');
+    const std::string dir = last_slash_index == std::string::npos ? "" : path.substr(0, last_slash_index + 1);
+
+    uint64_t hash = FNV_OFFSET_BASIS;
+    std::unordered_set<std::string> seen;
+    std::vector<std::string> to_visit = { path.substr(dir.size()) };
+    // Parts are visited in the order they're first used, so the hash doesn't
+    // depend on anything but the files' contents.
+    for (size_t i = 0; i < to_visit.size(); ++i) {
+        const std::string& file_name = to_visit[i];
+        std::ifstream hdl_in(dir + file_name);
+        hash_bytes(hash, file_name);
+        if (!hdl_in) {
+            // A built-in chip, or a missing one, which flattening reports.
+            if (i == 0) throw HackRomError("Could not open '" + path + "'.");
+            continue;
+        }
+        std::stringstream hdl;
+        hdl << hdl_in.rdbuf();
+        hash_bytes(hash, hdl.str());
+        for (const HdlPart& part : HdlChip::parse(hdl, dir + file_name).parts)
+            if (seen.insert(part.chip).second) to_visit.push_back(part.chip + ".hdl");
+    }
+    return hash;
+}
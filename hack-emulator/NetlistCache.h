@@ -0,0 +1,45 @@
+#ifndef NETLIST_CACHE_H
+#define NETLIST_CACHE_H
+
+#include "Netlist.h"
+#include <cstdint>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+/**
+ * Optimised netlists of chips, shared by test scripts running on several
+ * threads, so that each chip is only flattened once. Chips are keyed by
+ * content_hash() rather than by path: editing a part gives every chip built
+ * from it a new key, and identical copies of a chip share one netlist.
+ */
+class NetlistCache {
+public:
+    /**
+     * Returns the optimised netlist of the chip at `path`, flattening it if
+     * no chip with the same content has been. If another thread is already
+     * flattening it, waits for that thread. Throws if the chip can't be
+     * flattened.
+     */
+    std::shared_ptr<const Netlist> get(const std::string& path);
+
+    /**
+     * How many chips have been flattened so far.
+     */
+    size_t size() const;
+
+    /**
+     * A 64-bit FNV-1a hash of the chip at `path` and every part it uses from
+     * its directory, recursively. Parts that come from the built-in chips
+     * only contribute their names.
+     */
+    static uint64_t content_hash(const std::string& path);
+
+private:
+    mutable std::mutex _mutex;
+    std::unordered_map<uint64_t, std::shared_future<std::shared_ptr<const Netlist>>> _netlists;
+};
+
+#endif
@@ -0,0 +1,91 @@
+#include "NetlistCache.h"
+#include "Rom.h"
+#include <filesystem>
+#include <fstream>
+#include <gtest/gtest.h>
+#include <thread>
+#include <vector>
+
+const std::string COURSE_SRC = "../nand2tetris-exercises";
+
+static void write_file(const std::filesystem::path& path, const std::string& contents) {
+    std::ofstream file_out(path);
+    file_out << contents;
+}
+
+// A scratch directory of the running test's own, since ctest runs the tests as
+// separate processes at once.
+static std::filesystem::path test_directory() {
+    const ::testing::TestInfo* test = ::testing::UnitTest::GetInstance()->current_test_info();
+    return std::filesystem::temp_directory_path() / (std::string("NetlistCacheTest.") + test->name());
+}
+
+TEST(NetlistCacheTest, FlattensEachChipOnce) {
+    NetlistCache netlists;
+    const auto first = netlists.get(COURSE_SRC + "/01/Xor.hdl");
+    EXPECT_EQ(netlists.get(COURSE_SRC + "/01/Xor.hdl"), first);
+    EXPECT_EQ(first->name(), "Xor");
+    EXPECT_NE(netlists.get(COURSE_SRC + "/01/Mux.hdl"), first);
+    EXPECT_EQ(netlists.size(), 2);
+}
+
+TEST(NetlistCacheTest, HashesPartsTheChipUses) {
+    const std::filesystem::path dir = test_directory();
+    std::filesystem::create_directories(dir);
+    const std::string chip_path = (dir / "Twice.hdl").string();
+    write_file(chip_path, "CHIP Twice { IN in; OUT out; PARTS: Inv(in=in, out=x); Inv(in=x, out=out); }");
+    write_file(dir / "Inv.hdl", "CHIP Inv { IN in; OUT out; PARTS: Nand(a=in, b=in, out=out); }");
+    const uint64_t hash = NetlistCache::content_hash(chip_path);
+    EXPECT_EQ(NetlistCache::content_hash(chip_path), hash);
+
+    // Changing a part changes the hash of every chip using it.
+    write_file(dir / "Inv.hdl", "CHIP Inv { IN in; OUT out; PARTS: Not(in=in, out=out); }");
+    EXPECT_NE(NetlistCache::content_hash(chip_path), hash);
+
+    // So does replacing it with the built-in chip.
+    const uint64_t hash_with_not = NetlistCache::content_hash(chip_path);
+    std::filesystem::remove(dir / "Inv.hdl");
+    EXPECT_NE(NetlistCache::content_hash(chip_path), hash_with_not);
+
+    std::filesystem::remove_all(dir);
+    EXPECT_THROW(NetlistCache::content_hash(chip_path), HackRomError);
+}
+
+TEST(NetlistCacheTest, SharesIdenticalChips) {
+    // Copies of a chip in different directories share a netlist.
+    const std::filesystem::path dir = test_directory();
+    for (const std::string copy : { "a", "b" }) {
+        std::filesystem::create_directories(dir / copy);
+        std::filesystem::copy_file(COURSE_SRC + "/01/Xor.hdl", dir / copy / "Xor.hdl",
+                                   std::filesystem::copy_options::overwrite_existing);
+    }
+    NetlistCache netlists;
+    EXPECT_EQ(netlists.get((dir / "a" / "Xor.hdl").string()), netlists.get((dir / "b" / "Xor.hdl").string()));
+    EXPECT_EQ(netlists.size(), 1);
+    std::filesystem::remove_all(dir);
+}
+
+TEST(NetlistCacheTest, FlattensOnceAcrossThreads) {
+    NetlistCache netlists;
+    std::vector<std::shared_ptr<const Netlist>> results(8);
+    std::vector<std::thread> threads;
+    for (size_t i = 0; i < results.size(); ++i)
+        threads.emplace_back([&, i]() { results[i] = netlists.get(COURSE_SRC + "/05/CPU.hdl"); });
+    for (std::thread& thread : threads) thread.join();
+    for (const auto& result : results) EXPECT_EQ(result, results[0]);
+    EXPECT_EQ(netlists.size(), 1);
+}
+
+TEST(NetlistCacheTest, ReportsChipErrors) {
+    NetlistCache netlists;
+    EXPECT_THROW(netlists.get("test-files/Missing.hdl"), HackRomError);
+
+    const std::string unknown_part = "CHIP Broken { IN in; OUT out; PARTS: Missing(in=in, out=out); }";
+    const std::filesystem::path path = std::filesystem::temp_directory_path() / "Broken.hdl";
+    write_file(path, unknown_part);
+    EXPECT_THROW(netlists.get(path.string()), HackRomError);
+    // Every script loading it gets the error, without flattening it again.
+    EXPECT_THROW(netlists.get(path.string()), HackRomError);
+    EXPECT_EQ(netlists.size(), 1);
+    std::filesystem::remove(path);
+}
@@ -0,0 +1,169 @@
+#include "NetlistOptimiser.h"
+#include <unordered_map>
+
+Netlist NetlistOptimiser::optimise(const Netlist& netlist) {
+    const uint32_t first_nand_wire = netlist.first_nand_wire();
+    std::vector<NandGate> nands = netlist.nands();
+    std::vector<DffGate> dffs = netlist.dffs();
+    std::vector<bool> is_register_dff(dffs.size(), false);
+    for (const NetlistRegister& chip_register : netlist.registers())
+        for (const uint32_t dff : chip_register.dffs) is_register_dff[dff] = true;
+
+    // The wire each wire has been found to always equal. Wires are only ever
+    // replaced by wires that come before them.
+    std::vector<uint32_t> replacement(netlist.num_wires());
+    for (uint32_t wire = 0; wire < replacement.size(); ++wire) replacement[wire] = wire;
+    auto resolve = [&](uint32_t wire) {
+        while (replacement[wire] != wire) wire = replacement[wire] = replacement[replacement[wire]];
+        return wire;
+    };
+    // Whether `wire` is a NAND gate wired up as a NOT, and if so of what.
+    auto is_not = [&](const uint32_t wire, uint32_t& of) {
+        if (wire < first_nand_wire || replacement[wire] != wire) return false;
+        const NandGate& nand = nands[wire - first_nand_wire];
+        of = nand.a;
+        return nand.a == nand.b;
+    };
+
+    for (bool is_changed = true; is_changed; ) {
+        is_changed = false;
+        std::unordered_map<uint64_t, uint32_t> gate_with_inputs;
+        gate_with_inputs.reserve(nands.size());
+        for (size_t i = 0; i < nands.size(); ++i) {
+            const uint32_t out = first_nand_wire + i;
+            if (replacement[out] != out) continue;
+            uint32_t a = resolve(nands[i].a);
+            uint32_t b = resolve(nands[i].b);
+            if (a > b) std::swap(a, b);
+
+            uint32_t equivalent = out;
+            uint32_t of = 0;
+            if (a == Netlist::FALSE_WIRE) {
+                equivalent = Netlist::TRUE_WIRE;
+            } else if (a == Netlist::TRUE_WIRE && b == Netlist::TRUE_WIRE) {
+                equivalent = Netlist::FALSE_WIRE;
+            } else if (a == Netlist::TRUE_WIRE) {
+                // NOT b.
+                if (is_not(b, of)) equivalent = of;
+                a = b;
+            } else if (a == b && is_not(a, of)) {
+                equivalent = of;
+            } else if ((is_not(a, of) && of == b) || (is_not(b, of) && of == a)) {
+                equivalent = Netlist::TRUE_WIRE;
+            }
+            nands[i] = { a, b };
+
+            if (equivalent == out) {
+                const auto inserted = gate_with_inputs.insert({ static_cast<uint64_t>(a) << 32 | b, out });
+                equivalent = inserted.first->second;
+            }
+            if (equivalent != out) {
+                replacement[out] = equivalent;
+                is_changed = true;
+            }
+        }
+
+        // DFFs start at 0, so one fed 0, or only itself, stays at 0, and two
+        // fed the same wire always agree. Registers are left alone, since
+        // scripts can set them.
+        std::unordered_map<uint32_t, uint32_t> dff_with_input;
+        dff_with_input.reserve(dffs.size());
+        for (DffGate& dff : dffs) {
+            dff.in = resolve(dff.in);
+            const size_t index = &dff - dffs.data();
+            if (is_register_dff[index] || replacement[dff.out] != dff.out) continue;
+            uint32_t equivalent = dff.out;
+            if (dff.in == Netlist::FALSE_WIRE || dff.in == dff.out) equivalent = Netlist::FALSE_WIRE;
+            else equivalent = dff_with_input.insert({ dff.in, dff.out }).first->second;
+            if (equivalent != dff.out) {
+                replacement[dff.out] = equivalent;
+                is_changed = true;
+            }
+        }
+    }
+
+    // Mark what the outputs and registers depend on. DFFs can feed gates
+    // before them, so this repeats until no more DFFs come alive.
+    std::vector<bool> is_live(netlist.num_wires(), false);
+    std::vector<bool> is_live_dff = is_register_dff;
+    for (const NetlistPin& pin : netlist.outputs())
+        for (const uint32_t wire : pin.wires) is_live[resolve(wire)] = true;
+    // Memories are always kept, since scripts can read them.
+    std::vector<NetlistMemory> memories = netlist.memories();
+    for (NetlistMemory& memory : memories) {
+        memory.load = resolve(memory.load);
+        is_live[memory.load] = true;
+        for (std::vector<uint32_t>* wires : { &memory.in, &memory.address }) {
+            for (uint32_t& wire : *wires) {
+                wire = resolve(wire);
+                is_live[wire] = true;
+            }
+        }
+    }
+    for (bool is_changed = true; is_changed; ) {
+        is_changed = false;
+        for (size_t i = 0; i < dffs.size(); ++i)
+            if (is_live_dff[i]) is_live[dffs[i].in] = true;
+        for (size_t i = nands.size(); i-- > 0; ) {
+            if (!is_live[first_nand_wire + i] || replacement[first_nand_wire + i] != first_nand_wire + i) continue;
+            is_live[nands[i].a] = true;
+            is_live[nands[i].b] = true;
+        }
+        for (size_t i = 0; i < dffs.size(); ++i) {
+            if (!is_live_dff[i] && is_live[dffs[i].out] && replacement[dffs[i].out] == dffs[i].out) {
+                is_live_dff[i] = true;
+                is_changed = true;
+            }
+        }
+    }
+
+    // Renumber the wires that are left.
+    Netlist optimised;
+    optimised._name = netlist.name();
+    std::vector<uint32_t> new_wire(netlist.num_wires(), Netlist::FALSE_WIRE);
+    uint32_t num_memory_wires = 0;
+    for (const NetlistMemory& memory : memories) num_memory_wires += memory.out.size();
+    uint32_t next_wire = 0;
+    for (; next_wire < first_nand_wire - dffs.size() - num_memory_wires; ++next_wire) new_wire[next_wire] = next_wire;
+    std::vector<uint32_t> new_dff(dffs.size());
+    for (size_t i = 0; i < dffs.size(); ++i) {
+        if (!is_live_dff[i]) continue;
+        new_dff[i] = optimised._dffs.size();
+        new_wire[dffs[i].out] = next_wire++;
+        optimised._dffs.push_back(dffs[i]);
+    }
+    for (const NetlistMemory& memory : memories)
+        for (const uint32_t wire : memory.out) new_wire[wire] = next_wire++;
+    optimised._first_nand_wire = next_wire;
+    auto memory = memories.begin();
+    for (size_t i = 0; i < nands.size(); ++i) {
+        for (; memory != memories.end() && memory->num_nands_before == i; ++memory)
+            memory->num_nands_before = optimised._nands.size();
+        const uint32_t out = first_nand_wire + i;
+        if (!is_live[out] || replacement[out] != out) continue;
+        new_wire[out] = next_wire++;
+        optimised._nands.push_back({ new_wire[nands[i].a], new_wire[nands[i].b] });
+    }
+    for (; memory != memories.end(); ++memory) memory->num_nands_before = optimised._nands.size();
+    optimised._num_wires = next_wire;
+    for (DffGate& dff : optimised._dffs) dff = { new_wire[dff.in], new_wire[dff.out] };
+    for (NetlistMemory& memory : memories) {
+        memory.load = new_wire[memory.load];
+        for (std::vector<uint32_t>* wires : { &memory.in, &memory.address, &memory.out })
+            for (uint32_t& wire : *wires) wire = new_wire[wire];
+    }
+    optimised._memories = memories;
+
+    optimised._inputs = netlist.inputs();
+    for (const NetlistPin& pin : netlist.outputs()) {
+        NetlistPin optimised_pin = { pin.name, {} };
+        for (const uint32_t wire : pin.wires) optimised_pin.wires.push_back(new_wire[resolve(wire)]);
+        optimised._outputs.push_back(optimised_pin);
+    }
+    for (const NetlistRegister& chip_register : netlist.registers()) {
+        NetlistRegister optimised_register = { chip_register.name, {} };
+        for (const uint32_t dff : chip_register.dffs) optimised_register.dffs.push_back(new_dff[dff]);
+        optimised._registers.push_back(optimised_register);
+    }
+    return optimised;
+}
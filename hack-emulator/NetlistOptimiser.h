@@ -0,0 +1,27 @@
+#ifndef NETLIST_OPTIMISER_H
+#define NETLIST_OPTIMISER_H
+
+#include "Netlist.h"
+
+/**
+ * Shrinks a flattened netlist without changing anything a test script can
+ * see: its pins, its built-in registers and memories, and its timing.
+ *
+ * Flattening leaves behind a lot of logic that does nothing, eg. the Or gates
+ * in `Or16To15(a=x, b=false, ...)` or the two inverters in a `Not16` of a
+ * `Not16`. The optimiser repeats these passes until none of them changes
+ * anything:
+ *   - Constant propagation, through NAND gates and through DFFs that can only
+ *     ever hold 0.
+ *   - Double negation and `x NAND NOT x` removal.
+ *   - Structural hashing, which merges NAND gates with the same inputs in
+ *     either order, and DFFs with the same input.
+ *   - Dead gate elimination, which removes gates that nothing observable
+ *     depends on.
+ */
+class NetlistOptimiser {
+public:
+    static Netlist optimise(const Netlist& netlist);
+};
+
+#endif
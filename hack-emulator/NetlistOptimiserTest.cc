@@ -0,0 +1,73 @@
+#include "ChipChecker.h"
+#include "ChipSimulator.h"
+#include "NetlistOptimiser.h"
+#include <gtest/gtest.h>
+#include <memory>
+#include <sstream>
+
+static Netlist optimised_netlist_of(const std::string& hdl) {
+    std::istringstream hdl_in(hdl);
+    return NetlistOptimiser::optimise(Netlist::from_chip(HdlChip::parse(hdl_in, "Test.hdl"), ""));
+}
+
+TEST(NetlistOptimiserTest, KeepsCombinationalBehaviour) {
+    for (const std::string path : { "../nand2tetris-exercises/01/Mux8Way16.hdl", "../nand2tetris-exercises/02/ALU.hdl" }) {
+        auto netlist = std::make_shared<const Netlist>(Netlist::from_file(path));
+        auto optimised = std::make_shared<const Netlist>(NetlistOptimiser::optimise(*netlist));
+        EXPECT_LT(optimised->nands().size(), netlist->nands().size()) << path;
+        EXPECT_FALSE(ChipChecker(optimised, netlist).check(1 << 16, 1).counterexample) << path;
+    }
+}
+
+TEST(NetlistOptimiserTest, FoldsConstants) {
+    // The Or with false is just a copy of `a`, and the And with true of it is
+    // too.
+    const Netlist netlist = optimised_netlist_of("CHIP Test { IN a; OUT out, one; PARTS:"
+                                                 "Or(a=a, b=false, out=x); And(a=x, b=true, out=out);"
+                                                 "Not(in=false, out=one); }");
+    EXPECT_TRUE(netlist.nands().empty());
+    EXPECT_EQ(netlist.outputs()[0].wires[0], netlist.inputs()[0].wires[0]);
+    EXPECT_EQ(netlist.outputs()[1].wires[0], Netlist::TRUE_WIRE);
+}
+
+TEST(NetlistOptimiserTest, MergesDuplicateGates) {
+    // Both Ands compute the same thing, with their inputs swapped. Each needs
+    // a NAND and a NOT, and the Xor of two equal wires is always false.
+    const Netlist netlist = optimised_netlist_of("CHIP Test { IN a, b; OUT out[2], same; PARTS:"
+                                                 "And(a=a, b=b, out=out[0], out=x); And(a=b, b=a, out=out[1], out=y);"
+                                                 "Xor(a=x, b=y, out=same); }");
+    EXPECT_EQ(netlist.nands().size(), 2);
+    EXPECT_EQ(netlist.outputs()[0].wires[0], netlist.outputs()[0].wires[1]);
+    EXPECT_EQ(netlist.outputs()[1].wires[0], Netlist::FALSE_WIRE);
+}
+
+TEST(NetlistOptimiserTest, RemovesDeadGates) {
+    const Netlist netlist = optimised_netlist_of("CHIP Test { IN a, b; OUT out; PARTS:"
+                                                 "Xor(a=a, b=b, out=unused); Bit(in=a, load=b, out=unused2);"
+                                                 "Not(in=a, out=out); }");
+    EXPECT_EQ(netlist.nands().size(), 1);
+    EXPECT_TRUE(netlist.dffs().empty());
+    EXPECT_EQ(netlist.inputs().size(), 2);
+}
+
+TEST(NetlistOptimiserTest, KeepsRegistersAndTiming) {
+    const Netlist netlist = Netlist::from_file("../nand2tetris-exercises/05/CPU.hdl");
+    const Netlist optimised = NetlistOptimiser::optimise(netlist);
+    EXPECT_LT(optimised.nands().size(), netlist.nands().size());
+    EXPECT_EQ(optimised.dffs().size(), netlist.dffs().size());
+    ASSERT_EQ(optimised.registers().size(), netlist.registers().size());
+    for (size_t i = 0; i < netlist.registers().size(); ++i)
+        EXPECT_EQ(optimised.registers()[i].name, netlist.registers()[i].name);
+
+    // Same as ChipSimulatorTest: the registers still latch on the tick and
+    // drive the outputs on the tock.
+    ChipSimulator cpu(std::make_shared<const Netlist>(optimised));
+    ASSERT_TRUE(cpu.set("DRegister[]", 5));
+    cpu.set("instruction", static_cast<int16_t>(0b1110011111010000));  // D=D+1
+    cpu.tick();
+    EXPECT_EQ(cpu.get("DRegister[]"), 6);
+    EXPECT_EQ(cpu.get("outM"), 6);
+    cpu.tock();
+    EXPECT_EQ(cpu.get("outM"), 7);
+    EXPECT_EQ(cpu.get("PC[]"), 1);
+}
@@ -0,0 +1,55 @@
+#include "NetlistReport.h"
+#include <algorithm>
+
+const std::array<std::string, 8> NetlistReport::FANOUT_BUCKETS = { "0", "1", "2", "3-4", "5-8", "9-16", "17-32", "33+" };
+
+// The bucket of `fanout_histogram` that a fan-out falls in.
+static int fanout_bucket(const size_t fanout) {
+    if (fanout <= 2) return fanout;
+    int bucket = 3;
+    for (size_t limit = 4; fanout > limit && bucket < 7; limit *= 2) ++bucket;
+    return bucket;
+}
+
+NetlistReport NetlistReport::of(const Netlist& netlist) {
+    NetlistReport report = { netlist.name(), netlist.nands().size(), netlist.dffs().size(), 0, {}, 0 };
+    const uint32_t first_nand_wire = netlist.first_nand_wire();
+
+    // Gates are in order, so each one's depth is known by the time it's
+    // reached.
+    std::vector<int> depth(netlist.num_wires(), 0);
+    std::vector<size_t> fanout(netlist.num_wires(), 0);
+    for (size_t i = 0; i < netlist.nands().size(); ++i) {
+        const NandGate& nand = netlist.nands()[i];
+        depth[first_nand_wire + i] = 1 + std::max(depth[nand.a], depth[nand.b]);
+        ++fanout[nand.a];
+        ++fanout[nand.b];
+    }
+    for (const DffGate& dff : netlist.dffs()) {
+        report.depth = std::max(report.depth, depth[dff.in]);
+        ++fanout[dff.in];
+    }
+    for (const NetlistMemory& memory : netlist.memories()) {
+        for (const std::vector<uint32_t>* wires : { &memory.in, &memory.address }) {
+            for (const uint32_t wire : *wires) {
+                report.depth = std::max(report.depth, depth[wire]);
+                ++fanout[wire];
+            }
+        }
+        report.depth = std::max(report.depth, depth[memory.load]);
+        ++fanout[memory.load];
+    }
+    for (const NetlistPin& pin : netlist.outputs()) {
+        for (const uint32_t wire : pin.wires) {
+            report.depth = std::max(report.depth, depth[wire]);
+            ++fanout[wire];
+        }
+    }
+
+    // Constants aren't gates, so they're left out.
+    for (uint32_t wire = Netlist::TRUE_WIRE + 1; wire < netlist.num_wires(); ++wire) {
+        ++report.fanout_histogram[fanout_bucket(fanout[wire])];
+        report.max_fanout = std::max(report.max_fanout, fanout[wire]);
+    }
+    return report;
+}
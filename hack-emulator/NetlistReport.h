@@ -0,0 +1,38 @@
+#ifndef NETLIST_REPORT_H
+#define NETLIST_REPORT_H
+
+#include "Netlist.h"
+#include <array>
+#include <cstddef>
+#include <string>
+#include <vector>
+
+/**
+ * Size and speed figures for a netlist, for seeing where a chip spends its
+ * gates.
+ */
+struct NetlistReport {
+    std::string name;
+    size_t num_nands;
+    size_t num_dffs;
+
+    // The most NAND gates any signal passes through between an input, DFF or
+    // memory and an output, DFF or memory, which sets how fast the chip could
+    // be clocked.
+    int depth;
+
+    // How many gates, DFFs, memory inputs and output bits each gate, DFF,
+    // memory output and input bit drives, counted into the buckets 0, 1, 2,
+    // 3-4, 5-8, 9-16, 17-32 and 33 or more.
+    std::array<size_t, 8> fanout_histogram;
+    size_t max_fanout;
+
+    static NetlistReport of(const Netlist& netlist);
+
+    /**
+     * Labels for the buckets of `fanout_histogram`.
+     */
+    static const std::array<std::string, 8> FANOUT_BUCKETS;
+};
+
+#endif
@@ -0,0 +1,29 @@
+#include "NetlistReport.h"
+#include <gtest/gtest.h>
+#include <sstream>
+
+TEST(NetlistReportTest, MeasuresDepthAndFanout) {
+    // Not(a) feeds both Nands, so it has a fan-out of 2, and `out` is 3 NANDs
+    // deep.
+    std::istringstream hdl_in("CHIP Test { IN a, b; OUT out; PARTS:"
+                              "Not(in=a, out=na); Nand(a=na, b=b, out=x); Nand(a=x, b=na, out=out); }");
+    const NetlistReport report = NetlistReport::of(Netlist::from_chip(HdlChip::parse(hdl_in, "Test.hdl"), ""));
+    EXPECT_EQ(report.name, "Test");
+    EXPECT_EQ(report.num_nands, 3);
+    EXPECT_EQ(report.num_dffs, 0);
+    EXPECT_EQ(report.depth, 3);
+    // `a` feeds the Not's NAND twice.
+    const std::array<size_t, 8> histogram = { 0, 3, 2, 0, 0, 0, 0, 0 };
+    EXPECT_EQ(report.fanout_histogram, histogram);
+    EXPECT_EQ(report.max_fanout, 2);
+}
+
+TEST(NetlistReportTest, CountsRegisteredChips) {
+    const NetlistReport report = NetlistReport::of(Netlist::from_file("../nand2tetris-exercises/03/a/PC.hdl"));
+    EXPECT_EQ(report.num_dffs, 16);
+    EXPECT_GT(report.depth, 0);
+    size_t num_wires = 0;
+    for (const size_t count : report.fanout_histogram) num_wires += count;
+    // in[16], load, inc and reset, then the DFFs and NANDs.
+    EXPECT_EQ(num_wires, 19 + report.num_dffs + report.num_nands);
+}
@@ -0,0 +1,112 @@
+#include "Netlist.h"
+#include "Rom.h"
+#include <gtest/gtest.h>
+#include <sstream>
+
+const std::string PROJECT_01 = "../nand2tetris-exercises/01/";
+
+static Netlist netlist_of(const std::string& hdl, const std::string& dir = "") {
+    std::istringstream hdl_in(hdl);
+    return Netlist::from_chip(HdlChip::parse(hdl_in, "Test.hdl"), dir);
+}
+
+TEST(NetlistTest, FlattensToNandGates) {
+    // The course's Xor is built from And, Or and Not, which are built from
+    // Nand.
+    const Netlist netlist = Netlist::from_file(PROJECT_01 + "Xor.hdl");
+    EXPECT_EQ(netlist.name(), "Xor");
+    ASSERT_EQ(netlist.inputs().size(), 2);
+    ASSERT_EQ(netlist.outputs().size(), 1);
+    EXPECT_EQ(netlist.inputs()[0].wires, std::vector<uint32_t>{ 2 });
+    EXPECT_EQ(netlist.inputs()[1].wires, std::vector<uint32_t>{ 3 });
+    EXPECT_EQ(netlist.first_nand_wire(), 4);
+    EXPECT_TRUE(netlist.dffs().empty());
+    EXPECT_EQ(netlist.num_wires(), netlist.first_nand_wire() + netlist.nands().size());
+
+    // Every gate only reads wires that come before it.
+    for (size_t i = 0; i < netlist.nands().size(); ++i) {
+        EXPECT_LT(netlist.nands()[i].a, netlist.first_nand_wire() + i);
+        EXPECT_LT(netlist.nands()[i].b, netlist.first_nand_wire() + i);
+    }
+}
+
+TEST(NetlistTest, UsesBuiltInChipsForMissingParts) {
+    const Netlist netlist = netlist_of("CHIP Test { IN a[16], b[16]; OUT out[16]; PARTS: Add16(a=a, b=b, out=out); }");
+    // A half adder and 15 full adders.
+    EXPECT_EQ(netlist.nands().size(), 6 + 15 * 15);
+}
+
+TEST(NetlistTest, ConnectsConstantsAndSubBuses) {
+    const Netlist netlist = netlist_of("CHIP Test { IN in[4]; OUT out[4], high; PARTS:"
+                                       "Nand(a=in[3], b=true, out=out[0], out=high); Nand(a=false, b=in[0], out=out[3]); }");
+    ASSERT_EQ(netlist.nands().size(), 2);
+    const std::vector<uint32_t>& in = netlist.inputs()[0].wires;
+    const std::vector<uint32_t>& out = netlist.outputs()[0].wires;
+    EXPECT_EQ(netlist.nands()[0].a, in[3]);
+    EXPECT_EQ(netlist.nands()[0].b, Netlist::TRUE_WIRE);
+    EXPECT_EQ(netlist.outputs()[1].wires[0], out[0]);
+    EXPECT_EQ(out[1], Netlist::FALSE_WIRE);
+}
+
+TEST(NetlistTest, FindsBuiltInRegisters) {
+    const Netlist netlist = Netlist::from_file("../nand2tetris-exercises/05/CPU.hdl");
+    EXPECT_EQ(netlist.dffs().size(), 3 * 16);
+    ASSERT_EQ(netlist.registers().size(), 3);
+    for (const NetlistRegister& chip_register : netlist.registers()) EXPECT_EQ(chip_register.dffs.size(), 16);
+}
+
+TEST(NetlistTest, ReportsWiringErrors) {
+    const std::vector<std::pair<std::string, std::string>> cases = {
+        { "CHIP Test { IN a; OUT out; PARTS: Nand(a=a, b=x, out=y); Nand(a=y, b=y, out=x, out=out); }",
+          "Test.hdl: the chip has a combinational loop, a path from a gate's output back to its own input that doesn't "
+          "go through a DFF." },
+        { "CHIP Test { IN a; OUT out; PARTS: Nand(a=a, b=x, out=out); }",
+          "Test.hdl line 1: no part drives the internal pin 'x'." },
+        { "CHIP Test { IN a; OUT out; PARTS: Nand(a=a, b=a, out=x); Nand(a=a, b=a, out=x); }",
+          "Test.hdl line 1: 'x' is driven by more than one part." },
+        { "CHIP Test { IN a; OUT out; PARTS: Nand(a=a, b=a, c=a, out=out); }",
+          "Test.hdl line 1: 'Nand' has no pin called 'c'." },
+        { "CHIP Test { IN a[2]; OUT out; PARTS: Nand(a=a, b=a, out=out); }",
+          "Test.hdl line 1: 'a' and 'a' have different widths." },
+        { "CHIP Test { IN a; OUT out; PARTS: Nand(a=a, b=a, out=a); }",
+          "Test.hdl line 1: the output 'out' can't drive the chip's input 'a'." },
+        { "CHIP Test { IN a; OUT out; PARTS: Nope(a=a, out=out); }",
+          "Test.hdl line 1: there's no chip called 'Nope'." },
+    };
+    for (const auto& [hdl, message] : cases) {
+        try {
+            netlist_of(hdl);
+            ADD_FAILURE() << hdl;
+        } catch (const HackRomError& e) {
+            EXPECT_EQ(e.what(), message);
+        }
+    }
+}
+
+TEST(NetlistTest, KeepsBuiltInMemoriesWhole) {
+    const Netlist netlist = Netlist::from_file("../nand2tetris-exercises/05/Memory.hdl");
+    ASSERT_EQ(netlist.memories().size(), 3);
+    for (const NetlistMemory& memory : netlist.memories()) {
+        EXPECT_EQ(memory.out.size(), 16);
+        const size_t address_bits = memory.name == "RAM16K" ? 14 : memory.name == "Screen" ? 13 : 0;
+        EXPECT_EQ(memory.address.size(), address_bits) << memory.name;
+        EXPECT_EQ(memory.in.size(), memory.name == "Keyboard" ? 0 : 16) << memory.name;
+
+        // The memory is read after the gates driving its address and before
+        // the gates reading it.
+        for (const uint32_t wire : memory.address) EXPECT_LT(wire, netlist.first_nand_wire() + memory.num_nands_before);
+        for (size_t i = 0; i < memory.num_nands_before; ++i) {
+            for (const uint32_t out : memory.out) {
+                EXPECT_NE(netlist.nands()[i].a, out);
+                EXPECT_NE(netlist.nands()[i].b, out);
+            }
+        }
+    }
+    EXPECT_TRUE(netlist.dffs().empty());
+}
+
+TEST(NetlistTest, FindsLoopsThroughMemories) {
+    EXPECT_THROW(netlist_of("CHIP Test { IN in[16]; OUT out[16]; PARTS:"
+                            "RAM8(in=in, load=true, address=a, out=out, out[0..2]=a); }"),
+                 HackRomError);
+}
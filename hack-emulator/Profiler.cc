@@ -0,0 +1,301 @@
+#include "Profiler.h"
+#include <algorithm>
+#include <iomanip>
+#include <sstream>
+#include <utility>
+
+// Name of the pseudo-function for code outside any VM function.
+static const std::string TOP_NAME = "<top>";
+
+// Name of the pseudo-function for calls past `Profiler::MAX_STACK_DEPTH`.
+static const std::string DEEP_NAME = "<deep>";
+
+// Writes `count` as a percentage of `total`.
+static std::string format_percent(const uint64_t count, const uint64_t total) {
+    std::ostringstream out;
+    out << std::fixed << std::setprecision(2) << (total == 0 ? 0.0 : 100.0 * count / total) << "%";
+    return out.str();
+}
+
+// Given the (address, index) pairs where each range starts, in address order,
+// sets `owner[address]` to the index of the range it falls in.
+static void assign_ranges(const std::vector<std::pair<uint16_t, int>>& starts, std::vector<int>& owner) {
+    for (size_t i = 0; i < starts.size(); ++i) {
+        const size_t end = (i + 1 < starts.size()) ? starts[i + 1].first : owner.size();
+        std::fill(owner.begin() + starts[i].first, owner.begin() + end, starts[i].second);
+    }
+}
+
+// Sorts (name, cycles) pairs with the most cycles first.
+static std::vector<std::pair<std::string, uint64_t>> sort_by_cycles(const std::unordered_map<std::string, uint64_t>& cycles) {
+    std::vector<std::pair<std::string, uint64_t>> sorted(cycles.begin(), cycles.end());
+    std::sort(sorted.begin(), sorted.end(), [](const auto& lhs, const auto& rhs) {
+        return lhs.second != rhs.second ? lhs.second > rhs.second : lhs.first < rhs.first;
+    });
+    return sorted;
+}
+
+Profiler::Profiler(std::shared_ptr<const Rom> rom)
+        : _rom(rom),
+          _counts(ROM_SIZE + 1, 0),
+          _boundaries(ROM_SIZE + 1, Boundary::NONE),
+          _num_recorded(0),
+          _functions({ TOP_NAME }),
+          _function_of(ROM_SIZE + 1, 0),
+          _label_of(ROM_SIZE + 1, -1),
+          _current_node(0),
+          _current_node_since(0),
+          _last_call_cycle(0),
+          _num_deep_calls(0) {
+    std::vector<std::pair<uint16_t, std::string>> labels;
+    for (const auto& [name, address] : rom->labels()) labels.push_back({ address, name });
+    std::sort(labels.begin(), labels.end());
+
+    std::vector<std::pair<uint16_t, int>> label_starts;
+    std::vector<std::pair<uint16_t, int>> function_starts;
+    std::vector<std::pair<uint16_t, std::string>> return_labels;
+    for (const auto& [address, name] : labels) {
+        _labels.push_back(name);
+        label_starts.push_back({ address, _labels.size() - 1 });
+
+        // `(Unit.Class.func$ret.N)`.
+        if (name.find("$ret.") != std::string::npos) {
+            return_labels.push_back({ address, name });
+            continue;
+        }
+        // `(Class.func)`. Other labels the translator emits either contain a
+        // `$`, like `(Unit.Class.func$LOOP)`, or no `.`, like `(COMP_0)`.
+        if (name.find('$') != std::string::npos || name.find('.') == std::string::npos) continue;
+        _functions.push_back(name);
+        function_starts.push_back({ address, _functions.size() - 1 });
+        _boundaries[address] = Boundary::FUNCTION_ENTRY;
+    }
+    assign_ranges(label_starts, _label_of);
+    assign_ranges(function_starts, _function_of);
+
+    for (const auto& [address, name] : return_labels) {
+        if (address == 0) continue;
+        const size_t unit_end = name.find('.');
+        const size_t callee_end = name.rfind("$ret.");
+        const int callee = function_index(name.substr(unit_end + 1, callee_end - unit_end - 1));
+        const uint16_t call_address = address - 1;
+
+        _call_sites.push_back({ call_address, _function_of[call_address], callee });
+        _callee_at[call_address] = callee;
+        _boundaries[call_address] = Boundary::CALL;
+        _boundaries[address] = Boundary::RETURN;
+    }
+
+    _deep_function = function_index(DEEP_NAME);
+    _stack_nodes.push_back({ 0, -1, 0, 0, {} });
+}
+
+uint64_t Profiler::count(const uint16_t address) const {
+    return _counts[address & 0x7FFF];
+}
+
+uint64_t Profiler::total_cycles() const {
+    return _num_recorded;
+}
+
+std::unordered_map<std::string, uint64_t> Profiler::function_self_cycles() const {
+    std::vector<uint64_t> cycles(_functions.size(), 0);
+    for (int address = 0; address < _rom->size(); ++address)
+        cycles[_function_of[address]] += _counts[address];
+
+    std::unordered_map<std::string, uint64_t> cycles_by_name;
+    for (size_t i = 0; i < _functions.size(); ++i)
+        if (cycles[i] > 0) cycles_by_name[_functions[i]] = cycles[i];
+    return cycles_by_name;
+}
+
+std::unordered_map<std::string, uint64_t> Profiler::function_total_cycles() const {
+    // Children are always created after their parents, so a reverse sweep
+    // sees every subtree before its root.
+    std::vector<uint64_t> subtree_cycles = node_self_cycles();
+    for (int node = _stack_nodes.size() - 1; node > 0; --node)
+        subtree_cycles[_stack_nodes[node].parent] += subtree_cycles[node];
+
+    // A recursive call's cycles are already part of its outermost call, so
+    // only nodes whose function isn't already on the stack count.
+    std::unordered_map<std::string, uint64_t> cycles_by_name;
+    std::vector<int> num_active(_functions.size(), 0);
+    walk_stack_nodes([&](const int node) {
+        const int function = _stack_nodes[node].function;
+        if (num_active[function]++ == 0 && subtree_cycles[node] > 0) cycles_by_name[_functions[function]] += subtree_cycles[node];
+    }, [&](const int node) {
+        --num_active[_stack_nodes[node].function];
+    });
+    return cycles_by_name;
+}
+
+std::unordered_map<std::string, uint64_t> Profiler::label_cycles() const {
+    std::vector<uint64_t> cycles(_labels.size(), 0);
+    for (int address = 0; address < _rom->size(); ++address)
+        if (_label_of[address] != -1) cycles[_label_of[address]] += _counts[address];
+
+    std::unordered_map<std::string, uint64_t> cycles_by_name;
+    for (size_t i = 0; i < _labels.size(); ++i)
+        if (cycles[i] > 0) cycles_by_name[_labels[i]] = cycles[i];
+    return cycles_by_name;
+}
+
+void Profiler::write_flat_profile(std::ostream& out) const {
+    const std::unordered_map<std::string, uint64_t> total_cycles = function_total_cycles();
+    out << "Flat profile over " << _num_recorded << " cycles:\n"
+        << std::setw(10) << "self %" << std::setw(16) << "self cycles" << std::setw(16) << "total cycles" << "  function\n";
+    for (const auto& [name, cycles] : sort_by_cycles(function_self_cycles())) {
+        const auto total = total_cycles.find(name);
+        out << std::setw(10) << format_percent(cycles, _num_recorded)
+            << std::setw(16) << cycles
+            << std::setw(16) << (total == total_cycles.end() ? cycles : total->second)
+            << "  " << name << "\n";
+    }
+
+    out << "\nBy label:\n"
+        << std::setw(10) << "self %" << std::setw(16) << "self cycles" << "  label\n";
+    for (const auto& [name, cycles] : sort_by_cycles(label_cycles()))
+        out << std::setw(10) << format_percent(cycles, _num_recorded) << std::setw(16) << cycles << "  " << name << "\n";
+}
+
+void Profiler::write_call_graph(std::ostream& out) const {
+    // Calls per (caller, callee) pair, summed over every call site.
+    std::vector<std::unordered_map<int, uint64_t>> callees(_functions.size());
+    std::vector<std::unordered_map<int, uint64_t>> callers(_functions.size());
+    for (const CallSite& call_site : _call_sites) {
+        const uint64_t calls = _counts[call_site.address];
+        if (calls == 0) continue;
+        callees[call_site.caller][call_site.callee] += calls;
+        callers[call_site.callee][call_site.caller] += calls;
+    }
+
+    const std::unordered_map<std::string, uint64_t> self_cycles = function_self_cycles();
+    const std::unordered_map<std::string, uint64_t> total_cycles = function_total_cycles();
+    const auto write_calls = [&](const char* direction, const std::unordered_map<int, uint64_t>& calls) {
+        std::vector<std::pair<int, uint64_t>> sorted(calls.begin(), calls.end());
+        std::sort(sorted.begin(), sorted.end(), [&](const auto& lhs, const auto& rhs) {
+            return lhs.second != rhs.second ? lhs.second > rhs.second : _functions[lhs.first] < _functions[rhs.first];
+        });
+        for (const auto& [function, num_calls] : sorted)
+            out << "\t" << direction << " " << _functions[function] << " (" << num_calls << (num_calls == 1 ? " call)\n" : " calls)\n");
+    };
+
+    out << "Call graph:\n";
+    for (const auto& [name, cycles] : sort_by_cycles(total_cycles)) {
+        const auto self = self_cycles.find(name);
+        const int function = std::find(_functions.begin(), _functions.end(), name) - _functions.begin();
+        out << name << ": " << (self == self_cycles.end() ? 0 : self->second) << " self, "
+            << cycles << " total (" << format_percent(cycles, _num_recorded) << ")\n";
+        write_calls("called by", callers[function]);
+        write_calls("calls", callees[function]);
+    }
+}
+
+void Profiler::write_collapsed_stacks(std::ostream& out) const {
+    const std::vector<uint64_t> self_cycles = node_self_cycles();
+    std::vector<std::string> lines;
+
+    // `<top>` is left off the stacks of anything called from it.
+    std::string stack;
+    std::vector<size_t> stack_lengths;
+    walk_stack_nodes([&](const int node) {
+        stack_lengths.push_back(stack.size());
+        const std::string& function = _functions[_stack_nodes[node].function];
+        if (node == 0) {
+            if (self_cycles[node] > 0) lines.push_back(function + " " + std::to_string(self_cycles[node]));
+            return;
+        }
+        if (!stack.empty()) stack += ";";
+        stack += function;
+        if (self_cycles[node] > 0) lines.push_back(stack + " " + std::to_string(self_cycles[node]));
+    }, [&](const int) {
+        stack.resize(stack_lengths.back());
+        stack_lengths.pop_back();
+    });
+    std::sort(lines.begin(), lines.end());
+    for (const std::string& line : lines) out << line << "\n";
+}
+
+void Profiler::cross_boundary(const uint16_t pc) {
+    // The call's jump still belongs to the caller, whereas the instruction at
+    // a return label or function entry belongs to where it leads.
+    int next_node = _current_node;
+    uint64_t next_node_since = _num_recorded - 1;
+    switch (_boundaries[pc]) {
+        case Boundary::CALL:
+            _last_call_cycle = _num_recorded;
+            if (_stack_nodes[_current_node].function == _deep_function) {
+                ++_num_deep_calls;
+                return;
+            }
+            next_node = _callee_at[pc];
+            if (_stack_nodes[_current_node].depth >= MAX_STACK_DEPTH) {
+                next_node = _deep_function;
+                _num_deep_calls = 1;
+            }
+            next_node_since = _num_recorded;
+            break;
+        case Boundary::RETURN:
+            if (_current_node == 0 || _num_recorded == _last_call_cycle + 1) return;
+            if (_stack_nodes[_current_node].function == _deep_function && --_num_deep_calls > 0) return;
+            next_node = -1;
+            break;
+        case Boundary::FUNCTION_ENTRY:
+            // Functions are otherwise only entered through calls. Jumping back
+            // to a label at the very start of the current function mustn't
+            // look like a recursive call.
+            if (_current_node != 0) return;
+            next_node = _function_of[pc];
+            break;
+        default:
+            return;
+    }
+
+    _stack_nodes[_current_node].self_cycles += next_node_since - _current_node_since;
+    _current_node_since = next_node_since;
+    if (next_node == -1) {
+        _current_node = _stack_nodes[_current_node].parent;
+        return;
+    }
+
+    // `next_node` is a function so far. Find or create the child for it.
+    const auto child = _stack_nodes[_current_node].children.find(next_node);
+    if (child != _stack_nodes[_current_node].children.end()) {
+        _current_node = child->second;
+    } else {
+        _stack_nodes.push_back({ next_node, _current_node, _stack_nodes[_current_node].depth + 1, 0, {} });
+        _stack_nodes[_current_node].children[next_node] = _stack_nodes.size() - 1;
+        _current_node = _stack_nodes.size() - 1;
+    }
+}
+
+int Profiler::function_index(const std::string& name) {
+    const auto function = std::find(_functions.begin(), _functions.end(), name);
+    if (function != _functions.end()) return function - _functions.begin();
+    _functions.push_back(name);
+    return _functions.size() - 1;
+}
+
+std::vector<uint64_t> Profiler::node_self_cycles() const {
+    std::vector<uint64_t> self_cycles;
+    for (const StackNode& node : _stack_nodes) self_cycles.push_back(node.self_cycles);
+    self_cycles[_current_node] += _num_recorded - _current_node_since;
+    return self_cycles;
+}
+
+void Profiler::walk_stack_nodes(const std::function<void(int)>& enter, const std::function<void(int)>& leave) const {
+    // Each node is pushed twice: once to enter it, and once underneath its
+    // children to leave it after them.
+    std::vector<std::pair<int, bool>> pending = { { 0, false } };
+    while (!pending.empty()) {
+        const auto [node, is_leaving] = pending.back();
+        pending.pop_back();
+        if (is_leaving) {
+            leave(node);
+            continue;
+        }
+        enter(node);
+        pending.push_back({ node, true });
+        for (const auto& [function, child] : _stack_nodes[node].children) pending.push_back({ child, false });
+    }
+}
@@ -0,0 +1,162 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include "Rom.h"
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * Counts how many times each ROM address is executed and folds the counts
+ * into per-label and per-function totals. Attach it to a HackComputer with
+ * `HackComputer::set_profiler`.
+ *
+ * Functions are recognised from the labels the VM translator emits:
+ *   - `(Class.func)` marks the entry of a VM function. Every address up to the
+ *     next function's entry belongs to it.
+ *   - `(Unit.Class.func$ret.N)` follows each call to `Class.func`. The
+ *     `0;JMP` just before it is the call itself.
+ * Code before the first function, eg. the bootstrap, is attributed to `<top>`.
+ *
+ * On top of the flat counts, a shadow call stack is kept by watching for
+ * calls and return labels, which gives inclusive cycles and full call stacks.
+ * The run loop only pays for a counter increment and a table lookup unless
+ * the instruction is a call or return. Calls more than `MAX_STACK_DEPTH` deep,
+ * eg. from runaway recursion, are folded into a single `<deep>` frame.
+ */
+class Profiler {
+public:
+    static constexpr int MAX_STACK_DEPTH = 256;
+
+    explicit Profiler(std::shared_ptr<const Rom> rom);
+
+    /**
+     * Records that the instruction at `pc` is about to be executed.
+     */
+    void record(const uint16_t pc) {
+        ++_counts[pc];
+        ++_num_recorded;
+        if (_boundaries[pc] != Boundary::NONE) cross_boundary(pc);
+    }
+
+    /**
+     * Number of times the instruction at `address` was executed.
+     */
+    uint64_t count(const uint16_t address) const;
+
+    /**
+     * Total instructions executed while profiling.
+     */
+    uint64_t total_cycles() const;
+
+    /**
+     * Cycles spent in each function's own instructions, excluding callees.
+     */
+    std::unordered_map<std::string, uint64_t> function_self_cycles() const;
+
+    /**
+     * Cycles spent in each function including everything it called. Recursive
+     * calls are only counted once.
+     */
+    std::unordered_map<std::string, uint64_t> function_total_cycles() const;
+
+    /**
+     * Instructions executed under each label, up to the next label.
+     */
+    std::unordered_map<std::string, uint64_t> label_cycles() const;
+
+    /**
+     * Functions sorted by self cycles, with their share of the total.
+     */
+    void write_flat_profile(std::ostream& out) const;
+
+    /**
+     * Each function's self and total cycles, followed by the functions that
+     * call it and the functions it calls, with call counts.
+     */
+    void write_call_graph(std::ostream& out) const;
+
+    /**
+     * One line per distinct call stack, eg. `Sys.init;Main.main;Math.multiply 1234`,
+     * in the collapsed format read by flamegraph.pl and speedscope.
+     */
+    void write_collapsed_stacks(std::ostream& out) const;
+
+private:
+    enum class Boundary : uint8_t {
+        NONE,
+        CALL,            // The `0;JMP` that enters a callee.
+        RETURN,          // A `$ret.N` label, reached when a callee returns.
+        FUNCTION_ENTRY   // Only matters when falling into the first function.
+    };
+
+    // A call site found in the ROM.
+    struct CallSite {
+        uint16_t address;
+        int caller;
+        int callee;
+    };
+
+    // A node of the call tree, one per distinct call stack.
+    struct StackNode {
+        int function;
+        int parent;
+        int depth;
+        uint64_t self_cycles;
+        std::unordered_map<int, int> children;
+    };
+
+    std::shared_ptr<const Rom> _rom;
+
+    // Per-address execution counts and what kind of control transfer, if
+    // any, happens at that address. Both are ROM_SIZE + 1 long like the
+    // decoded program.
+    std::vector<uint64_t> _counts;
+    std::vector<Boundary> _boundaries;
+    uint64_t _num_recorded;
+
+    // Function names, with `<top>` first. `_function_of[address]` indexes into
+    // `_functions`.
+    std::vector<std::string> _functions;
+    std::vector<int> _function_of;
+
+    // Label names, and the label each address falls under, or -1.
+    std::vector<std::string> _labels;
+    std::vector<int> _label_of;
+
+    std::vector<CallSite> _call_sites;
+    std::unordered_map<uint16_t, int> _callee_at;
+
+    // The call tree. Node 0 is `<top>`.
+    std::vector<StackNode> _stack_nodes;
+    int _current_node;
+    uint64_t _current_node_since;
+
+    // When the last call was made. The bootstrap's return label can share
+    // its address with the first function, which a call may land on.
+    uint64_t _last_call_cycle;
+
+    // The `<deep>` pseudo-function, and how many calls deep the current
+    // `<deep>` node is.
+    int _deep_function;
+    uint64_t _num_deep_calls;
+
+    // Moves the shadow call stack across a call or return.
+    void cross_boundary(const uint16_t pc);
+
+    // Looks up a function by name, adding it if it isn't in the ROM.
+    int function_index(const std::string& name);
+
+    // Self cycles per call tree node, including the still-open last stretch.
+    std::vector<uint64_t> node_self_cycles() const;
+
+    // Walks the call tree depth first, calling `enter` on the way down to
+    // each node and `leave` on the way back up.
+    void walk_stack_nodes(const std::function<void(int)>& enter, const std::function<void(int)>& leave) const;
+};
+
+#endif
@@ -0,0 +1,100 @@
+#include "HackComputer.h"
+#include "Profiler.h"
+#include <algorithm>
+#include <gtest/gtest.h>
+#include <memory>
+#include <sstream>
+
+// Calls.asm is the VM translator's output for:
+//     Sys.init -> Main.main -> Main.square(3), Main.square(4)
+//     Main.square(x) -> Math.multiply(x, x)
+// where Math.multiply loops once per unit of its second argument.
+class ProfilerTest : public ::testing::Test {
+protected:
+    std::shared_ptr<const Rom> rom = std::make_shared<const Rom>(Rom::from_file("test-files/Calls.asm"));
+    HackComputer computer { rom };
+    Profiler profiler { rom };
+
+    void SetUp() override {
+        computer.set_profiler(&profiler);
+        ASSERT_EQ(computer.run(100000), HaltReason::END_OF_PROGRAM);
+        ASSERT_EQ(computer.ram(5), 25);
+    }
+};
+
+TEST_F(ProfilerTest, CountsEveryExecutedInstruction) {
+    EXPECT_EQ(profiler.total_cycles(), computer.cycles());
+    EXPECT_EQ(profiler.count(0), 1);
+
+    uint64_t total = 0;
+    for (const auto& [name, cycles] : profiler.function_self_cycles()) total += cycles;
+    EXPECT_EQ(total, computer.cycles());
+}
+
+TEST_F(ProfilerTest, FoldsCountsIntoFunctions) {
+    const std::unordered_map<std::string, uint64_t> self_cycles = profiler.function_self_cycles();
+    const std::unordered_map<std::string, uint64_t> total_cycles = profiler.function_total_cycles();
+
+    // Math.multiply loops 3 + 4 times in total, so it dominates.
+    EXPECT_GT(self_cycles.at("Math.multiply"), self_cycles.at("Main.square"));
+    EXPECT_EQ(total_cycles.at("Math.multiply"), self_cycles.at("Math.multiply"));
+    EXPECT_EQ(total_cycles.at("Main.square"), self_cycles.at("Main.square") + self_cycles.at("Math.multiply"));
+    EXPECT_EQ(total_cycles.at("Sys.init"), computer.cycles() - self_cycles.at("<top>"));
+
+    EXPECT_GT(profiler.label_cycles().at("Calls.Math.multiply$LOOP"), 0);
+}
+
+TEST_F(ProfilerTest, WritesCallGraph) {
+    std::ostringstream out;
+    profiler.write_call_graph(out);
+    EXPECT_NE(out.str().find("\tcalled by Main.main (2 calls)\n"), std::string::npos);
+    EXPECT_NE(out.str().find("\tcalls Math.multiply (2 calls)\n"), std::string::npos);
+    EXPECT_NE(out.str().find("\tcalls Main.main (1 call)\n"), std::string::npos);
+}
+
+TEST_F(ProfilerTest, WritesCollapsedStacks) {
+    const std::unordered_map<std::string, uint64_t> self_cycles = profiler.function_self_cycles();
+    std::ostringstream out;
+    profiler.write_collapsed_stacks(out);
+
+    EXPECT_NE(out.str().find("Sys.init;Main.main;Main.square;Math.multiply " +
+                             std::to_string(self_cycles.at("Math.multiply")) + "\n"),
+              std::string::npos);
+    EXPECT_NE(out.str().find("<top> " + std::to_string(self_cycles.at("<top>")) + "\n"), std::string::npos);
+}
+
+// Deep.asm is the VM translator's output for:
+//     Sys.init -> Main.down(300)
+//     Main.down(n) -> Main.down(n - 1), until n is 0
+// after which Sys.init loops forever. Its bootstrap calls Sys.init, and the
+// return label for that call is also where Main.down starts.
+class DeepProfilerTest : public ::testing::Test {
+protected:
+    std::shared_ptr<const Rom> rom = std::make_shared<const Rom>(Rom::from_file("test-files/Deep.asm"));
+    HackComputer computer { rom };
+    Profiler profiler { rom };
+
+    void SetUp() override {
+        computer.set_profiler(&profiler);
+        computer.run(100000);
+    }
+};
+
+TEST_F(DeepProfilerTest, TellsCallsFromReturnsAtTheSameAddress) {
+    const std::unordered_map<std::string, uint64_t> self_cycles = profiler.function_self_cycles();
+    EXPECT_EQ(profiler.function_total_cycles().at("Main.down"),
+              computer.cycles() - self_cycles.at("<top>") - self_cycles.at("Sys.init"));
+    EXPECT_EQ(profiler.function_total_cycles().at("Sys.init"), computer.cycles() - self_cycles.at("<top>"));
+}
+
+TEST_F(DeepProfilerTest, FoldsDeepCallsIntoOneFrame) {
+    std::ostringstream out;
+    profiler.write_collapsed_stacks(out);
+    std::istringstream lines(out.str());
+    bool has_deep_frame = false;
+    for (std::string line; std::getline(lines, line); ) {
+        EXPECT_LE(std::count(line.begin(), line.end(), ';'), Profiler::MAX_STACK_DEPTH);
+        has_deep_frame = has_deep_frame || line.find(";<deep> ") != std::string::npos;
+    }
+    EXPECT_TRUE(has_deep_frame);
+}
@@ -0,0 +1,251 @@
+#include "Rom.h"
+#include <algorithm>
+#include <cctype>
+#include <fstream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Predefined symbols available to every Hack assembly program.
+static const std::unordered_map<std::string, uint16_t> PREDEFINED_SYMBOLS = {
+    {"R0", 0},   {"R1", 1},   {"R2", 2},   {"R3", 3},
+    {"R4", 4},   {"R5", 5},   {"R6", 6},   {"R7", 7},
+    {"R8", 8},   {"R9", 9},   {"R10", 10}, {"R11", 11},
+    {"R12", 12}, {"R13", 13}, {"R14", 14}, {"R15", 15},
+    {"SP", 0},
+    {"LCL", 1},
+    {"ARG", 2},
+    {"THIS", 3},
+    {"THAT", 4},
+    {"SCREEN", 16384},
+    {"KBD", 24576},
+};
+
+// Mnemonic to a-bit + 6 ALU control bits.
+static const std::unordered_map<std::string, uint8_t> COMP_TO_CODE = {
+    {"0", 0b0101010},
+    {"1", 0b0111111},
+    {"-1", 0b0111010},
+    {"D", 0b0001100},
+    {"A", 0b0110000},   {"M", 0b1110000},
+    {"!D", 0b0001101},
+    {"!A", 0b0110001},  {"!M", 0b1110001},
+    {"-D", 0b0001111},
+    {"-A", 0b0110011},  {"-M", 0b1110011},
+    {"D+1", 0b0011111},
+    {"A+1", 0b0110111}, {"M+1", 0b1110111},
+    {"D-1", 0b0001110},
+    {"A-1", 0b0110010}, {"M-1", 0b1110010},
+    {"D+A", 0b0000010}, {"D+M", 0b1000010},
+    {"A+D", 0b0000010}, {"M+D", 0b1000010},
+    {"D-A", 0b0010011}, {"D-M", 0b1010011},
+    {"A-D", 0b0000111}, {"M-D", 0b1000111},
+    {"D&A", 0b0000000}, {"D&M", 0b1000000},
+    {"A&D", 0b0000000}, {"M&D", 0b1000000},
+    {"D|A", 0b0010101}, {"D|M", 0b1010101},
+    {"A|D", 0b0010101}, {"M|D", 0b1010101},
+};
+
+static const std::unordered_map<std::string, uint8_t> JUMP_TO_CODE = {
+    {"JGT", 0b001},
+    {"JEQ", 0b010},
+    {"JGE", 0b011},
+    {"JLT", 0b100},
+    {"JNE", 0b101},
+    {"JLE", 0b110},
+    {"JMP", 0b111},
+};
+
+Rom::Rom(const std::vector<uint16_t>& words)
+        : _words(words) {
+    if (_words.size() > ROM_SIZE)
+        throw HackRomError("Program has " + std::to_string(_words.size()) +
+            " instructions, but the ROM only holds " + std::to_string(ROM_SIZE) + ".");
+
+    DecodedInstruction out_of_rom = { OpCode::OUT_OF_ROM, 0, 0, 0, 0, 0 };
+    _decoded.assign(ROM_SIZE + 1, out_of_rom);
+    for (size_t i = 0; i < _words.size(); ++i)
+        _decoded[i] = decode(_words[i]);
+    mark_halt_traps();
+
+    _checksum = 2166136261u;
+    for (const uint16_t word : _words) {
+        _checksum = (_checksum ^ (word & 0xFF)) * 16777619u;
+        _checksum = (_checksum ^ (word >> 8)) * 16777619u;
+    }
+}
+
+Rom Rom::from_hack(std::istream& hack_in) {
+    std::vector<uint16_t> words;
+    std::string line;
+    int line_num = 0;
+    while (std::getline(hack_in, line)) {
+        ++line_num;
+        line.erase(std::remove_if(line.begin(), line.end(),
+            [](const char& c) { return isspace(c); }), line.end());
+        if (line.empty()) continue;
+        if (line.size() != 16 || line.find_first_not_of("01") != std::string::npos)
+            throw HackRomError("Line " + std::to_string(line_num) + ": '" + line +
+                "' is not a 16-bit binary instruction.");
+        words.push_back(static_cast<uint16_t>(std::stoul(line, nullptr, 2)));
+    }
+    return Rom(words);
+}
+
+Rom Rom::from_asm(std::istream& asm_in) {
+    // Normalise every line by stripping whitespace and comments, keeping the
+    // original line numbers for error messages.
+    std::vector<std::pair<int, std::string>> lines;
+    std::string line;
+    int line_num = 0;
+    while (std::getline(asm_in, line)) {
+        ++line_num;
+        size_t comment_start = line.find("//");
+        if (comment_start != std::string::npos) line.erase(comment_start);
+        line.erase(std::remove_if(line.begin(), line.end(),
+            [](const char& c) { return isspace(c); }), line.end());
+        if (!line.empty()) lines.push_back({ line_num, line });
+    }
+
+    // First pass: bind each label declaration to the address of the
+    // instruction that follows it.
+    std::unordered_map<std::string, uint16_t> labels;
+    uint16_t address = 0;
+    for (const auto& [num, instruction] : lines) {
+        if (instruction.front() == '(') {
+            if (instruction.back() != ')' || instruction.size() < 3)
+                throw HackRomError("Line " + std::to_string(num) + ": malformed label '" + instruction + "'.");
+            labels.insert({ instruction.substr(1, instruction.size() - 2), address });
+        } else {
+            ++address;
+        }
+    }
+
+    // Second pass: encode instructions, allocating variables from RAM[16].
+    std::unordered_map<std::string, uint16_t> variables;
+    uint16_t next_free_data_addr = 16;
+    std::vector<uint16_t> words;
+    for (const auto& [num, instruction] : lines) {
+        if (instruction.front() == '(') continue;
+
+        if (instruction.front() == '@') {
+            const std::string symbol = instruction.substr(1);
+            if (symbol.empty())
+                throw HackRomError("Line " + std::to_string(num) + ": missing A-instruction value.");
+            if (std::all_of(symbol.begin(), symbol.end(), [](const char& c) { return isdigit(c); })) {
+                const unsigned long value = std::stoul(symbol);
+                if (value > 0x7FFF)
+                    throw HackRomError("Line " + std::to_string(num) + ": constant " + symbol + " does not fit in 15 bits.");
+                words.push_back(static_cast<uint16_t>(value));
+            } else if (PREDEFINED_SYMBOLS.count(symbol)) {
+                words.push_back(PREDEFINED_SYMBOLS.at(symbol));
+            } else if (labels.count(symbol)) {
+                words.push_back(labels.at(symbol));
+            } else {
+                if (!variables.count(symbol)) variables.insert({ symbol, next_free_data_addr++ });
+                words.push_back(variables.at(symbol));
+            }
+            continue;
+        }
+
+        // C-instruction: dest=comp;jump, where dest and jump are optional.
+        std::string dest, comp = instruction, jump;
+        size_t equals_index = comp.find('=');
+        if (equals_index != std::string::npos) {
+            dest = comp.substr(0, equals_index);
+            comp = comp.substr(equals_index + 1);
+        }
+        size_t semicolon_index = comp.find(';');
+        if (semicolon_index != std::string::npos) {
+            jump = comp.substr(semicolon_index + 1);
+            comp = comp.substr(0, semicolon_index);
+        }
+
+        uint8_t dest_code = 0;
+        for (const char& c : dest) {
+            if (c == 'A') dest_code |= 0b100;
+            else if (c == 'D') dest_code |= 0b010;
+            else if (c == 'M') dest_code |= 0b001;
+            else throw HackRomError("Line " + std::to_string(num) + ": invalid destination '" + dest + "'.");
+        }
+        if (!COMP_TO_CODE.count(comp))
+            throw HackRomError("Line " + std::to_string(num) + ": invalid computation '" + comp + "'.");
+        if (!jump.empty() && !JUMP_TO_CODE.count(jump))
+            throw HackRomError("Line " + std::to_string(num) + ": invalid jump '" + jump + "'.");
+        const uint8_t jump_code = jump.empty() ? 0 : JUMP_TO_CODE.at(jump);
+
+        words.push_back(static_cast<uint16_t>(0b111 << 13 | COMP_TO_CODE.at(comp) << 6 | dest_code << 3 | jump_code));
+    }
+
+    Rom rom(words);
+    rom._labels = labels;
+    return rom;
+}
+
+Rom Rom::from_file(const std::string& path) {
+    std::ifstream in(path);
+    if (!in) throw HackRomError("Could not open '" + path + "'.");
+
+    const std::string extension = path.substr(path.find_last_of('.') + 1);
+    if (extension == "hack") return from_hack(in);
+    if (extension == "asm") return from_asm(in);
+    throw HackRomError("Expected a .hack or .asm file, but got '" + path + "'.");
+}
+
+int Rom::size() const {
+    return _words.size();
+}
+
+const DecodedInstruction* Rom::decoded() const {
+    return _decoded.data();
+}
+
+const std::vector<uint16_t>& Rom::words() const {
+    return _words;
+}
+
+uint32_t Rom::checksum() const {
+    return _checksum;
+}
+
+const std::unordered_map<std::string, uint16_t>& Rom::labels() const {
+    return _labels;
+}
+
+DecodedInstruction Rom::decode(const uint16_t word) {
+    DecodedInstruction instruction = { OpCode::LOAD_A, 0, 0, 0, 0, word };
+    if (!(word & 0x8000)) {
+        instruction.value = word;
+        return instruction;
+    }
+    instruction.op = OpCode::COMPUTE;
+    instruction.comp = (word >> 6) & 0x7F;
+    instruction.dest = (word >> 3) & 0x7;
+    instruction.jump = word & 0x7;
+    return instruction;
+}
+
+void Rom::mark_halt_traps() {
+    for (size_t addr = 0; addr + 1 < _words.size(); ++addr) {
+        const DecodedInstruction& load = _decoded[addr];
+        const DecodedInstruction& jump = _decoded[addr + 1];
+        if (load.op != OpCode::LOAD_A || load.value != addr) continue;
+        if (jump.op != OpCode::COMPUTE || jump.dest != 0) continue;
+
+        // The jump must be taken no matter what D or M hold, so the comp must
+        // either be a constant or the jump must be unconditional.
+        bool always_taken = jump.jump == 0b111;
+        if (jump.comp == 0b0101010) always_taken |= (jump.jump & 0b010) != 0;       // 0
+        else if (jump.comp == 0b0111111) always_taken |= (jump.jump & 0b001) != 0;  // 1
+        else if (jump.comp == 0b0111010) always_taken |= (jump.jump & 0b100) != 0;  // -1
+        if (always_taken) _decoded[addr].op = OpCode::HALT_TRAP;
+    }
+}
+
+HackRomError::HackRomError(const std::string& message) throw()
+        : _message(message) {
+}
+
+char const* HackRomError::what() const throw() {
+    return _message.c_str();
+}
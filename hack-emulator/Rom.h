@@ -0,0 +1,115 @@
+#ifndef HACK_ROM_H
+#define HACK_ROM_H
+
+#include <cstdint>
+#include <exception>
+#include <istream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Number of addressable instruction words in the Hack ROM (ROM32K).
+constexpr int ROM_SIZE = 32768;
+
+/**
+ * What the emulator's run loop does when it reaches an instruction. Hack
+ * instructions are decoded once when the ROM is loaded so that the run loop
+ * never has to pick apart the bits of a 16-bit word again.
+ */
+enum class OpCode : uint8_t {
+    LOAD_A,       // A-instruction: `@value`.
+    COMPUTE,      // C-instruction: `dest=comp;jump`.
+    HALT_TRAP,    // `@self` followed by an unconditional jump back to it.
+    OUT_OF_ROM,   // Padding after the last loaded instruction.
+    BREAKPOINT    // Patched over an instruction by `HackComputer::add_breakpoint`.
+};
+
+struct DecodedInstruction {
+    OpCode op;
+    uint8_t comp;    // The a-bit followed by the 6 ALU control bits.
+    uint8_t dest;    // The A, D and M destination bits, from MSB to LSB.
+    uint8_t jump;    // The <0, =0 and >0 jump bits, from MSB to LSB.
+    uint16_t value;  // Constant loaded by an A-instruction.
+    uint16_t word;   // The original 16-bit machine instruction.
+};
+
+/**
+ * A read-only, pre-decoded Hack program. A single Rom may be shared between
+ * any number of emulator instances.
+ */
+class Rom {
+public:
+    /**
+     * Decodes the given machine instructions. At most ROM_SIZE instructions
+     * may be given.
+     */
+    explicit Rom(const std::vector<uint16_t>& words);
+
+    /**
+     * Loads a .hack file: one instruction per line, written as a string of
+     * 16 0s and 1s.
+     */
+    static Rom from_hack(std::istream& hack_in);
+
+    /**
+     * Assembles a .asm file. Unlike `from_hack`, the label declarations in
+     * the source are kept so they can be looked up with `labels()`.
+     */
+    static Rom from_asm(std::istream& asm_in);
+
+    /**
+     * Loads a .hack or .asm file, determined by the file extension.
+     */
+    static Rom from_file(const std::string& path);
+
+    /**
+     * Number of instructions that were loaded.
+     */
+    int size() const;
+
+    /**
+     * Decoded instructions. Always ROM_SIZE + 1 entries long so that any
+     * 15-bit program counter (plus one) can index into it without a bounds
+     * check. Entries past `size()` have the OUT_OF_ROM opcode.
+     */
+    const DecodedInstruction* decoded() const;
+
+    /**
+     * The raw 16-bit machine instructions.
+     */
+    const std::vector<uint16_t>& words() const;
+
+    /**
+     * Label declarations, eg. `(LOOP)`, mapped to the ROM address they mark.
+     * Empty for programs loaded from .hack files.
+     */
+    const std::unordered_map<std::string, uint16_t>& labels() const;
+
+    /**
+     * A 32-bit FNV-1a hash of the machine instructions, for telling whether
+     * saved state belongs to this program.
+     */
+    uint32_t checksum() const;
+
+private:
+    std::vector<uint16_t> _words;
+    uint32_t _checksum;
+    std::vector<DecodedInstruction> _decoded;
+    std::unordered_map<std::string, uint16_t> _labels;
+
+    static DecodedInstruction decode(const uint16_t word);
+
+    // Recognises `(L) @L 0;JMP`-style traps, such as the `(END_INF)` loop that
+    // the VM translator appends to every program, and marks them HALT_TRAP.
+    void mark_halt_traps();
+};
+
+class HackRomError : public std::exception {
+public:
+    HackRomError(const std::string& message) throw();
+    virtual char const* what() const throw();
+private:
+    std::string _message;
+};
+
+#endif
@@ -0,0 +1,80 @@
+#include "Rom.h"
+#include <gtest/gtest.h>
+#include <sstream>
+
+TEST(RomTest, AssemblesAInstructionsAndCInstructions) {
+    std::istringstream asm_in("@2\n"
+                              "D=A   // Inline comment.\n"
+                              "@3\n"
+                              "D = D + A\n"
+                              "@0\n"
+                              "M=D\n");
+    Rom rom = Rom::from_asm(asm_in);
+
+    std::vector<uint16_t> expected = {
+        0b0000000000000010,
+        0b1110110000010000,
+        0b0000000000000011,
+        0b1110000010010000,
+        0b0000000000000000,
+        0b1110001100001000,
+    };
+    EXPECT_EQ(rom.words(), expected);
+}
+
+TEST(RomTest, ResolvesLabelsAndVariables) {
+    std::istringstream asm_in("(START)\n"
+                              "@counter\n"
+                              "M=M+1\n"
+                              "@other\n"
+                              "@counter\n"
+                              "(END)\n"
+                              "@START\n"
+                              "0;JMP\n");
+    Rom rom = Rom::from_asm(asm_in);
+
+    EXPECT_EQ(rom.words()[0], 16);
+    EXPECT_EQ(rom.words()[2], 17);
+    EXPECT_EQ(rom.words()[3], 16);
+    EXPECT_EQ(rom.words()[4], 0);
+    EXPECT_EQ(rom.labels().at("START"), 0);
+    EXPECT_EQ(rom.labels().at("END"), 4);
+}
+
+TEST(RomTest, LoadsHackFiles) {
+    std::istringstream hack_in("0000000000000010\n"
+                               "1110110000010000\n");
+    Rom rom = Rom::from_hack(hack_in);
+
+    ASSERT_EQ(rom.size(), 2);
+    EXPECT_EQ(rom.decoded()[0].op, OpCode::LOAD_A);
+    EXPECT_EQ(rom.decoded()[0].value, 2);
+    EXPECT_EQ(rom.decoded()[1].op, OpCode::COMPUTE);
+    EXPECT_EQ(rom.decoded()[1].comp, 0b0110000);
+    EXPECT_EQ(rom.decoded()[1].dest, 0b010);
+    EXPECT_EQ(rom.decoded()[2].op, OpCode::OUT_OF_ROM);
+}
+
+TEST(RomTest, RejectsMalformedInstructions) {
+    std::istringstream bad_hack("0101\n");
+    EXPECT_THROW(Rom::from_hack(bad_hack), HackRomError);
+
+    std::istringstream bad_asm("D=D*A\n");
+    EXPECT_THROW(Rom::from_asm(bad_asm), HackRomError);
+}
+
+// The VM translator ends every program with `(END_INF) @END_INF 0;JEQ`.
+TEST(RomTest, MarksHaltTraps) {
+    std::istringstream asm_in("@1\n"
+                              "D=A\n"
+                              "(END_INF)\n"
+                              "@END_INF\n"
+                              "0;JEQ\n"
+                              "(NOT_A_TRAP)\n"
+                              "@NOT_A_TRAP\n"
+                              "D;JEQ\n");
+    Rom rom = Rom::from_asm(asm_in);
+
+    EXPECT_EQ(rom.decoded()[2].op, OpCode::HALT_TRAP);
+    EXPECT_EQ(rom.decoded()[4].op, OpCode::LOAD_A);
+}
@@ -0,0 +1,103 @@
+#include "Snapshot.h"
+#include "BinaryIO.h"
+#include "HackComputer.h"
+#include "Rom.h"
+#include <algorithm>
+#include <fstream>
+#include <zlib.h>
+
+// Identifies a snapshot file and the version of its format.
+static const char SNAPSHOT_MAGIC[8] = { 'H', 'A', 'C', 'K', 'S', 'N', 'P', '1' };
+
+Snapshot::Snapshot(const uint16_t pc, const int16_t a, const int16_t d, const uint64_t cycles,
+                   std::shared_ptr<const std::vector<int16_t>> ram, const uint32_t rom_checksum)
+        : _pc(pc),
+          _a(a),
+          _d(d),
+          _cycles(cycles),
+          _ram(ram),
+          _rom_checksum(rom_checksum) {
+}
+
+uint16_t Snapshot::pc() const {
+    return _pc;
+}
+
+int16_t Snapshot::a() const {
+    return _a;
+}
+
+int16_t Snapshot::d() const {
+    return _d;
+}
+
+uint64_t Snapshot::cycles() const {
+    return _cycles;
+}
+
+const std::shared_ptr<const std::vector<int16_t>>& Snapshot::ram() const {
+    return _ram;
+}
+
+uint32_t Snapshot::rom_checksum() const {
+    return _rom_checksum;
+}
+
+void Snapshot::save(std::ostream& snapshot_out) const {
+    // RAM is mostly zeros, so it deflates to a few KB.
+    std::vector<uint8_t> ram_bytes;
+    for (const int16_t word : *_ram) {
+        ram_bytes.push_back(static_cast<uint16_t>(word) & 0xFF);
+        ram_bytes.push_back(static_cast<uint16_t>(word) >> 8);
+    }
+    uLongf compressed_size = compressBound(ram_bytes.size());
+    std::vector<uint8_t> compressed(compressed_size);
+    compress2(compressed.data(), &compressed_size, ram_bytes.data(), ram_bytes.size(), Z_BEST_COMPRESSION);
+
+    snapshot_out.write(SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC));
+    write_int<uint32_t>(snapshot_out, _rom_checksum);
+    write_int<uint16_t>(snapshot_out, _pc);
+    write_int<int16_t>(snapshot_out, _a);
+    write_int<int16_t>(snapshot_out, _d);
+    write_int<uint64_t>(snapshot_out, _cycles);
+    write_int<uint32_t>(snapshot_out, compressed_size);
+    snapshot_out.write(reinterpret_cast<const char*>(compressed.data()), compressed_size);
+}
+
+Snapshot Snapshot::load(std::istream& snapshot_in) {
+    char magic[sizeof(SNAPSHOT_MAGIC)];
+    snapshot_in.read(magic, sizeof(magic));
+    if (!snapshot_in || !std::equal(magic, magic + sizeof(magic), SNAPSHOT_MAGIC))
+        throw HackRomError("Not a snapshot file.");
+
+    const uint32_t rom_checksum = read_int<uint32_t>(snapshot_in);
+    const uint16_t pc = read_int<uint16_t>(snapshot_in);
+    const int16_t a = read_int<int16_t>(snapshot_in);
+    const int16_t d = read_int<int16_t>(snapshot_in);
+    const uint64_t cycles = read_int<uint64_t>(snapshot_in);
+    std::vector<uint8_t> compressed(read_int<uint32_t>(snapshot_in));
+    snapshot_in.read(reinterpret_cast<char*>(compressed.data()), compressed.size());
+
+    std::vector<uint8_t> ram_bytes(2 * RAM_SIZE);
+    uLongf ram_size = ram_bytes.size();
+    if (!snapshot_in || uncompress(ram_bytes.data(), &ram_size, compressed.data(), compressed.size()) != Z_OK ||
+            ram_size != ram_bytes.size())
+        throw HackRomError("Snapshot is corrupt.");
+
+    auto ram = std::make_shared<std::vector<int16_t>>(RAM_SIZE);
+    for (int address = 0; address < RAM_SIZE; ++address)
+        (*ram)[address] = static_cast<int16_t>(ram_bytes[2 * address] | (ram_bytes[2 * address + 1] << 8));
+    return Snapshot(pc, a, d, cycles, ram, rom_checksum);
+}
+
+void Snapshot::save_to_file(const std::string& path) const {
+    std::ofstream snapshot_out(path, std::ios::binary);
+    if (!snapshot_out) throw HackRomError("Could not write '" + path + "'.");
+    save(snapshot_out);
+}
+
+Snapshot Snapshot::load_from_file(const std::string& path) {
+    std::ifstream snapshot_in(path, std::ios::binary);
+    if (!snapshot_in) throw HackRomError("Could not open '" + path + "'.");
+    return load(snapshot_in);
+}
@@ -0,0 +1,66 @@
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+#include <cstdint>
+#include <istream>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <vector>
+
+/**
+ * The full state of a HackComputer at some cycle: its registers, cycle count
+ * and RAM. Taken with `HackComputer::snapshot` and put back with
+ * `HackComputer::restore`.
+ *
+ * Snapshots are immutable, so one snapshot can be shared by any number of
+ * computers and threads, eg. to fork many test runs from the state right
+ * after the OS has booted rather than booting it every time.
+ */
+class Snapshot {
+public:
+    Snapshot(const uint16_t pc, const int16_t a, const int16_t d, const uint64_t cycles,
+             std::shared_ptr<const std::vector<int16_t>> ram, const uint32_t rom_checksum);
+
+    uint16_t pc() const;
+    int16_t a() const;
+    int16_t d() const;
+    uint64_t cycles() const;
+
+    /**
+     * All RAM_SIZE words of RAM.
+     */
+    const std::shared_ptr<const std::vector<int16_t>>& ram() const;
+
+    /**
+     * The checksum of the ROM the snapshot was taken with. Restoring into a
+     * computer running a different program is an error.
+     */
+    uint32_t rom_checksum() const;
+
+    /**
+     * Writes the snapshot in a compact binary format, with RAM deflated.
+     */
+    void save(std::ostream& snapshot_out) const;
+
+    /**
+     * Reads a snapshot written by `save`.
+     */
+    static Snapshot load(std::istream& snapshot_in);
+
+    /**
+     * `save`s to or `load`s from the file at `path`.
+     */
+    void save_to_file(const std::string& path) const;
+    static Snapshot load_from_file(const std::string& path);
+
+private:
+    uint16_t _pc;
+    int16_t _a;
+    int16_t _d;
+    uint64_t _cycles;
+    std::shared_ptr<const std::vector<int16_t>> _ram;
+    uint32_t _rom_checksum;
+};
+
+#endif
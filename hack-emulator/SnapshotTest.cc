@@ -0,0 +1,88 @@
+#include "EmulatorFarm.h"
+#include "HackComputer.h"
+#include "Snapshot.h"
+#include <gtest/gtest.h>
+#include <memory>
+#include <sstream>
+
+const std::string CALLS_PATH = "test-files/Calls.asm";
+
+TEST(SnapshotTest, RestoresMidRunState) {
+    std::shared_ptr<const Rom> rom = std::make_shared<const Rom>(Rom::from_file(CALLS_PATH));
+    HackComputer computer(rom);
+    computer.run(500);
+    const Snapshot checkpoint = computer.snapshot();
+
+    ASSERT_EQ(computer.run(100000), HaltReason::END_OF_PROGRAM);
+    const uint64_t end_cycles = computer.cycles();
+    ASSERT_EQ(computer.ram(5), 25);
+
+    // Clobber memory the run never touched too, then fork again.
+    computer.set_ram(20000, 7);
+    computer.restore(checkpoint);
+    EXPECT_EQ(computer.cycles(), 500);
+    EXPECT_EQ(computer.ram(5), 0);
+    EXPECT_EQ(computer.ram(20000), 0);
+    ASSERT_EQ(computer.run(100000), HaltReason::END_OF_PROGRAM);
+    EXPECT_EQ(computer.cycles(), end_cycles);
+    EXPECT_EQ(computer.ram(5), 25);
+
+    // A fresh computer restores the same state.
+    HackComputer fork(rom);
+    fork.restore(checkpoint);
+    EXPECT_EQ(fork.pc(), checkpoint.pc());
+    ASSERT_EQ(fork.run(100000), HaltReason::END_OF_PROGRAM);
+    EXPECT_EQ(fork.cycles(), end_cycles);
+    EXPECT_EQ(fork.ram(5), 25);
+}
+
+TEST(SnapshotTest, SavesAndLoads) {
+    std::shared_ptr<const Rom> rom = std::make_shared<const Rom>(Rom::from_file(CALLS_PATH));
+    HackComputer computer(rom);
+    computer.run(700);
+    computer.set_ram(30000, -12345);
+    const Snapshot original = computer.snapshot();
+
+    std::stringstream file;
+    original.save(file);
+    const Snapshot loaded = Snapshot::load(file);
+    EXPECT_EQ(loaded.pc(), original.pc());
+    EXPECT_EQ(loaded.a(), original.a());
+    EXPECT_EQ(loaded.d(), original.d());
+    EXPECT_EQ(loaded.cycles(), 700);
+    EXPECT_EQ(*loaded.ram(), *original.ram());
+    EXPECT_EQ(loaded.rom_checksum(), rom->checksum());
+
+    // RAM is mostly zeros, so the file is far smaller than 64 KB.
+    EXPECT_LT(file.str().size(), 4096);
+}
+
+TEST(SnapshotTest, RejectsOtherPrograms) {
+    HackComputer calls(std::make_shared<const Rom>(Rom::from_file(CALLS_PATH)));
+    HackComputer max(std::make_shared<const Rom>(Rom::from_file("test-files/Max.asm")));
+    EXPECT_THROW(max.restore(calls.snapshot()), HackRomError);
+
+    std::istringstream not_a_snapshot("HACKTRC1");
+    EXPECT_THROW(Snapshot::load(not_a_snapshot), HackRomError);
+}
+
+TEST(SnapshotTest, FarmJobsStartFromSnapshot) {
+    std::shared_ptr<const Rom> rom = std::make_shared<const Rom>(Rom::from_file(CALLS_PATH));
+    HackComputer computer(rom);
+    computer.run(1000);
+    auto checkpoint = std::make_shared<const Snapshot>(computer.snapshot());
+    ASSERT_EQ(computer.run(100000), HaltReason::END_OF_PROGRAM);
+
+    std::vector<FarmJob> jobs(50);
+    for (FarmJob& job : jobs) {
+        job.name = "Calls";
+        job.rom = rom;
+        job.max_cycles = 100000;
+        job.snapshot = checkpoint;
+        job.expected_ram = { { 5, 25 } };
+    }
+    for (const FarmResult& result : EmulatorFarm(4).run(jobs)) {
+        EXPECT_TRUE(result.passed());
+        EXPECT_EQ(result.cycles, computer.cycles() - 1000);
+    }
+}
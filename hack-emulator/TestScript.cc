@@ -0,0 +1,714 @@
+#include "TestScript.h"
+#include "ChipSimulator.h"
+#include "HackComputer.h"
+#include "NetlistCache.h"
+#include "NetlistOptimiser.h"
+#include "Rom.h"
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <optional>
+#include <sstream>
+#include <thread>
+
+// Upper bound on a `while` loop's iterations, so that a script waiting for a
+// key that no one will press fails rather than hanging.
+constexpr int64_t MAX_WHILE_ITERATIONS = 100000000;
+
+struct ScriptToken {
+    std::string text;
+    int line_num;
+    bool is_string;
+};
+
+// Splits a script into words, quoted strings and the punctuation `,;{}`,
+// dropping comments.
+std::vector<std::string> TestScript::find_chip_tests(const std::string& dir) {
+    std::vector<std::string> paths;
+    std::error_code error;
+    for (auto entry = std::filesystem::recursive_directory_iterator(dir, error);
+         entry != std::filesystem::recursive_directory_iterator(); entry.increment(error)) {
+        if (error) break;
+        if (!entry->is_regular_file() || entry->path().extension() != ".tst") continue;
+        const std::string path = entry->path().string();
+        try {
+            const TestScript script = from_file(path);
+            bool loads_chip = false;
+            bool has_compare_file = false;
+            for (const ScriptCommand& command : script._commands) {
+                const std::string& file_name = command.args.empty() ? "" : command.args[0];
+                if (command.kind == ScriptCommand::Kind::LOAD && command.args.size() == 1 &&
+                    std::filesystem::path(file_name).extension() == ".hdl")
+                    loads_chip = std::filesystem::exists(script._base_dir + file_name);
+                else if (command.kind == ScriptCommand::Kind::COMPARE_TO)
+                    has_compare_file = std::filesystem::exists(script._base_dir + file_name);
+            }
+            if (loads_chip && has_compare_file) paths.push_back(path);
+        } catch (const HackRomError&) {
+            // Scripts for the VM emulator use commands we don't support. One
+            // next to a chip of the same name is kept, so that running it
+            // reports why it can't be parsed.
+            if (std::filesystem::exists(std::filesystem::path(path).replace_extension(".hdl"))) paths.push_back(path);
+        }
+    }
+    if (error) throw HackRomError("Could not search '" + dir + "': " + error.message() + ".");
+    std::sort(paths.begin(), paths.end());
+    return paths;
+}
+
+static std::string xml_escaped(const std::string& text) {
+    std::string escaped;
+    for (const char c : text) {
+        switch (c) {
+            case '&': escaped += "&amp;"; break;
+            case '<': escaped += "&lt;"; break;
+            case '>': escaped += "&gt;"; break;
+            case '"': escaped += "&quot;"; break;
+            default: escaped += c;
+        }
+    }
+    return escaped;
+}
+
+void TestScript::write_junit_report(const std::vector<TestScriptResult>& results, std::ostream& report_out) {
+    size_t num_failures = 0;
+    double seconds = 0;
+    for (const TestScriptResult& result : results) {
+        num_failures += !result.passed;
+        seconds += result.seconds;
+    }
+
+    std::ostringstream report;
+    report << std::fixed << std::setprecision(3);
+    report << "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+           << "<testsuites tests=\"" << results.size() << "\" failures=\"" << num_failures << "\" time=\"" << seconds
+           << "\">\n"
+           << "  <testsuite name=\"HackTest\" tests=\"" << results.size() << "\" failures=\"" << num_failures
+           << "\" errors=\"0\" time=\"" << seconds << "\">\n";
+    for (const TestScriptResult& result : results) {
+        // Each script is a test case named after its file, in a class named
+        // after its directory, eg. `01` and `And`.
+        const std::filesystem::path path(result.path);
+        report << "    <testcase classname=\"" << xml_escaped(path.parent_path().string()) << "\" name=\""
+               << xml_escaped(path.stem().string()) << "\" time=\"" << result.seconds << "\"";
+        if (result.passed) {
+            report << "/>\n";
+        } else {
+            report << ">\n      <failure message=\"" << xml_escaped(result.message) << "\"/>\n    </testcase>\n";
+        }
+    }
+    report << "  </testsuite>\n</testsuites>\n";
+    report_out << report.str();
+}
+
+static std::vector<ScriptToken> tokenize(std::istream& script_in);
+
+// Parses commands up to the end of the tokens or, if `is_block`, the closing
+// brace, advancing `position`.
+static std::vector<ScriptCommand> parse_commands(const std::vector<ScriptToken>& tokens, size_t& position,
+                                                 const bool is_block);
+
+// Parses a number written in decimal or as %B, %X or %D.
+static int parse_value(const std::string& text, const int line_num);
+
+// Matches `<prefix>[<index>]` and returns the index.
+static std::optional<int> parse_index(const std::string& name, const std::string& prefix);
+
+static std::string file_name_of(const std::string& path) {
+    return path.substr(path.find_last_of('/') + 1);
+}
+
+/**
+ * Whatever a test script has loaded: a program or a chip. Variables are read
+ * and written by name, and the clock is advanced in half cycles.
+ */
+class ScriptTarget {
+public:
+    virtual ~ScriptTarget() = default;
+
+    // Returns std::nullopt if the target has no such variable.
+    virtual std::optional<int16_t> get(const std::string& name) = 0;
+    virtual bool set(const std::string& name, const int16_t value) = 0;
+
+    virtual void tick() {}
+    virtual void tock() = 0;
+    virtual void eval() {}
+
+    // Runs `num_cycles` full clock cycles.
+    virtual void ticktock(const uint64_t num_cycles) {
+        for (uint64_t i = 0; i < num_cycles; ++i) {
+            tick();
+            tock();
+        }
+    }
+
+    virtual void load_rom(const std::string& path) {
+        throw HackRomError("Only the Computer chip has a ROM to load '" + path + "' into.");
+    }
+};
+
+/**
+ * A program running on the CPU emulator. Its variables are `A`, `D`, `PC`
+ * and `RAM[i]`.
+ */
+class ProgramTarget : public ScriptTarget {
+public:
+    ProgramTarget(std::shared_ptr<const Rom> rom, std::shared_ptr<const KeyboardScript> keys)
+            : _computer(rom) {
+        _computer.set_idle_loop_policy(IdleLoopPolicy::FAST_FORWARD);
+        if (keys) _computer.set_keyboard_script(keys);
+    }
+
+    std::optional<int16_t> get(const std::string& name) override {
+        if (name == "A") return _computer.a();
+        if (name == "D") return _computer.d();
+        if (name == "PC") return _computer.pc();
+        const std::optional<int> address = parse_index(name, "RAM");
+        if (address && *address < RAM_SIZE) return _computer.ram(*address);
+        return std::nullopt;
+    }
+
+    bool set(const std::string& name, const int16_t value) override {
+        const std::optional<int> address = parse_index(name, "RAM");
+        if (name == "A") _computer.set_a(value);
+        else if (name == "D") _computer.set_d(value);
+        else if (name == "PC") _computer.set_pc(value);
+        else if (address && *address < RAM_SIZE) _computer.set_ram(*address, value);
+        else return false;
+        return true;
+    }
+
+    void tock() override {
+        _computer.step();
+    }
+
+    // Runs the whole stretch at once, skipping idle loops, rather than one
+    // instruction at a time.
+    void ticktock(const uint64_t num_cycles) override {
+        _computer.run(num_cycles);
+    }
+
+private:
+    HackComputer _computer;
+};
+
+/**
+ * Any chip written in HDL, simulated gate by gate. Its variables are its
+ * pins, the built-in registers inside it, eg. `DRegister[]`, and the words of
+ * its built-in memories, eg. `RAM16K[i]`. If there's a keyboard script, it
+ * drives the chip's `Keyboard`, with the script's clock as the cycle count.
+ */
+class HdlTarget : public ScriptTarget {
+public:
+    HdlTarget(std::shared_ptr<const Netlist> netlist, std::shared_ptr<const KeyboardScript> keys, const uint64_t& time)
+            : _chip(netlist), _keys(keys), _time(time) {
+    }
+
+    std::optional<int16_t> get(const std::string& name) override {
+        return _chip.get(name);
+    }
+
+    bool set(const std::string& name, const int16_t value) override {
+        return _chip.set(name, value);
+    }
+
+    void tick() override {
+        press_keys();
+        _chip.tick();
+    }
+
+    void tock() override {
+        press_keys();
+        _chip.tock();
+    }
+
+    void eval() override {
+        press_keys();
+        _chip.eval();
+    }
+
+    void load_rom(const std::string& path) override {
+        if (!_chip.load("ROM32K", Rom::from_file(path).words()))
+            throw HackRomError("The chip has no ROM32K to load '" + path + "' into.");
+    }
+
+private:
+    ChipSimulator _chip;
+    std::shared_ptr<const KeyboardScript> _keys;
+    const uint64_t& _time;
+
+    void press_keys() {
+        if (_keys) _chip.set("Keyboard[]", _keys->key_at(_time));
+    }
+};
+
+/**
+ * One column of the output list, eg. `RAM[0]%D2.6.2`: the variable, its
+ * format (Binary, Decimal, heX or String) and the padding either side.
+ */
+struct OutputColumn {
+    std::string name;
+    char format;
+    int left_padding;
+    int width;
+    int right_padding;
+};
+
+/**
+ * The state of one run of a script.
+ */
+class ScriptRun {
+public:
+    ScriptRun(const std::string& base_dir, std::shared_ptr<const KeyboardScript> keys,
+              std::shared_ptr<NetlistCache> netlists, TestScriptResult& result)
+            : _base_dir(base_dir), _keys(keys), _netlists(netlists), _result(result), _time(0),
+              _is_half_cycle(false), _has_compare_file(false), _num_output_lines(0) {
+    }
+
+    // Returns false once the output stops matching.
+    bool execute(const std::vector<ScriptCommand>& commands) {
+        for (const ScriptCommand& command : commands)
+            if (!execute(command)) return false;
+        return true;
+    }
+
+private:
+    std::string _base_dir;
+    std::shared_ptr<const KeyboardScript> _keys;
+    std::shared_ptr<NetlistCache> _netlists;
+    TestScriptResult& _result;
+    std::unique_ptr<ScriptTarget> _target;
+    uint64_t _time;
+    bool _is_half_cycle;
+    std::vector<OutputColumn> _columns;
+    std::vector<std::string> _compare_lines;
+    bool _has_compare_file;
+    size_t _num_output_lines;
+
+    bool execute(const ScriptCommand& command) {
+        switch (command.kind) {
+            case ScriptCommand::Kind::LOAD:
+                load(command);
+                return true;
+            case ScriptCommand::Kind::OUTPUT_FILE:
+                _result.output_path = _base_dir + command.args[0];
+                return true;
+            case ScriptCommand::Kind::COMPARE_TO:
+                read_compare_file(command);
+                return true;
+            case ScriptCommand::Kind::OUTPUT_LIST:
+                _columns.clear();
+                for (const std::string& arg : command.args) _columns.push_back(parse_column(arg, command.line_num));
+                return write_line(header_line());
+            case ScriptCommand::Kind::SET:
+                if (!target(command.line_num).set(command.args[0], parse_value(command.args[1], command.line_num)))
+                    throw_unknown_variable(command.args[0], command.line_num);
+                return true;
+            case ScriptCommand::Kind::TICK:
+                target(command.line_num).tick();
+                _is_half_cycle = true;
+                return true;
+            case ScriptCommand::Kind::TOCK:
+                target(command.line_num).tock();
+                ++_time;
+                _is_half_cycle = false;
+                return true;
+            case ScriptCommand::Kind::TICKTOCK:
+                target(command.line_num).ticktock(1);
+                ++_time;
+                return true;
+            case ScriptCommand::Kind::EVAL:
+                target(command.line_num).eval();
+                return true;
+            case ScriptCommand::Kind::OUTPUT:
+                return write_line(value_line(command.line_num));
+            case ScriptCommand::Kind::ECHO:
+                return true;
+            case ScriptCommand::Kind::REPEAT:
+                return repeat(command);
+            case ScriptCommand::Kind::WHILE:
+                for (int64_t i = 0; is_true(command); ++i) {
+                    if (i == MAX_WHILE_ITERATIONS)
+                        throw HackRomError("Line " + std::to_string(command.line_num) + ": the while loop never ended. "
+                                           "It may be waiting for a key, which needs a keyboard script.");
+                    if (!execute(command.body)) return false;
+                }
+                return true;
+        }
+        return true;
+    }
+
+    bool repeat(const ScriptCommand& command) {
+        if (command.count < 0)
+            throw HackRomError("Line " + std::to_string(command.line_num) + ": repeats forever, which needs a user to stop it.");
+        const bool is_only_ticktock = command.body.size() == 1 && command.body[0].kind == ScriptCommand::Kind::TICKTOCK;
+        if (is_only_ticktock && !_is_half_cycle) {
+            target(command.line_num).ticktock(command.count);
+            _time += command.count;
+            return true;
+        }
+        for (int64_t i = 0; i < command.count; ++i)
+            if (!execute(command.body)) return false;
+        return true;
+    }
+
+    void load(const ScriptCommand& command) {
+        if (command.args.size() == 2) {
+            if (command.args[1] != "ROM32K")
+                throw HackRomError("Line " + std::to_string(command.line_num) + ": can't load a file into " + command.args[1] + ".");
+            target(command.line_num).load_rom(_base_dir + command.args[0]);
+            return;
+        }
+
+        const std::string file_name = file_name_of(command.args[0]);
+        const std::string extension = file_name.substr(std::min(file_name.size(), file_name.find_last_of('.')));
+        if (extension == ".asm" || extension == ".hack") {
+            _target = std::make_unique<ProgramTarget>(std::make_shared<const Rom>(Rom::from_file(_base_dir + command.args[0])), _keys);
+        } else if (extension == ".hdl") {
+            const std::string path = _base_dir + command.args[0];
+            auto netlist = _netlists ? _netlists->get(path)
+                                     : std::make_shared<const Netlist>(NetlistOptimiser::optimise(Netlist::from_file(path)));
+            _target = std::make_unique<HdlTarget>(netlist, _keys, _time);
+        } else {
+            throw HackRomError("Line " + std::to_string(command.line_num) + ": can't load '" + command.args[0] +
+                               "'. Only programs and chips written in HDL are supported.");
+        }
+    }
+
+    void read_compare_file(const ScriptCommand& command) {
+        const std::string path = _base_dir + command.args[0];
+        std::ifstream compare_in(path);
+        if (!compare_in) throw HackRomError("Could not open '" + path + "'.");
+        _compare_lines.clear();
+        std::string line;
+        while (std::getline(compare_in, line)) {
+            if (!line.empty() && line.back() == '\r') line.pop_back();
+            _compare_lines.push_back(line);
+        }
+        _has_compare_file = true;
+    }
+
+    ScriptTarget& target(const int line_num) {
+        if (!_target) throw HackRomError("Line " + std::to_string(line_num) + ": nothing has been loaded.");
+        return *_target;
+    }
+
+    // Appends a line to the output and checks it against the compare file.
+    bool write_line(const std::string& line) {
+        _result.output += line + "\n";
+        if (!_has_compare_file) return true;
+
+        const size_t line_index = _num_output_lines++;
+        bool is_match = line_index < _compare_lines.size() && line.size() == _compare_lines[line_index].size();
+        for (size_t i = 0; is_match && i < line.size(); ++i)
+            is_match = _compare_lines[line_index][i] == '*' || _compare_lines[line_index][i] == line[i];
+        if (!is_match) _result.message = "Comparison failure at line " + std::to_string(line_index + 1);
+        return is_match;
+    }
+
+    std::string header_line() const {
+        std::string line = "|";
+        for (const OutputColumn& column : _columns) {
+            const int column_width = column.left_padding + column.width + column.right_padding;
+            const std::string name = column.name.substr(0, column_width);
+            const int left_spaces = (column_width - static_cast<int>(name.size())) / 2;
+            line += std::string(left_spaces, ' ') + name +
+                    std::string(column_width - name.size() - left_spaces, ' ') + "|";
+        }
+        return line;
+    }
+
+    std::string value_line(const int line_num) {
+        std::string line = "|";
+        for (const OutputColumn& column : _columns) {
+            std::string text;
+            if (column.name == "time") {
+                text = std::to_string(_time) + (_is_half_cycle ? "+" : "");
+            } else {
+                const std::optional<int16_t> value = target(line_num).get(column.name);
+                if (!value) throw_unknown_variable(column.name, line_num);
+                text = format_value(*value, column);
+            }
+            const int padding = std::max(0, column.width - static_cast<int>(text.size()));
+            if (column.format == 'S') text += std::string(padding, ' ');
+            else text = std::string(padding, ' ') + text;
+            line += std::string(column.left_padding, ' ') + text + std::string(column.right_padding, ' ') + "|";
+        }
+        return line;
+    }
+
+    bool is_true(const ScriptCommand& command) {
+        const std::optional<int16_t> maybe_value = command.args[0] == "time" ? std::optional<int16_t>(static_cast<int16_t>(_time))
+                                                                              : target(command.line_num).get(command.args[0]);
+        if (!maybe_value) throw_unknown_variable(command.args[0], command.line_num);
+        const int value = *maybe_value;
+        const int other = static_cast<int16_t>(parse_value(command.args[1], command.line_num));
+        if (command.op == "=") return value == other;
+        if (command.op == "<>") return value != other;
+        if (command.op == "<") return value < other;
+        if (command.op == ">") return value > other;
+        if (command.op == "<=") return value <= other;
+        if (command.op == ">=") return value >= other;
+        throw HackRomError("Line " + std::to_string(command.line_num) + ": unknown comparison '" + command.op + "'.");
+    }
+
+    static std::string format_value(const int16_t value, const OutputColumn& column) {
+        const uint16_t bits = value;
+        switch (column.format) {
+            case 'B': {
+                std::string text;
+                for (int bit = column.width - 1; bit >= 0; --bit) text += (bit < 16 && (bits >> bit) & 1) ? '1' : '0';
+                return text;
+            }
+            case 'X': {
+                static const char HEX_DIGITS[] = "0123456789ABCDEF";
+                std::string text;
+                for (int digit = column.width - 1; digit >= 0; --digit)
+                    text += digit < 4 ? HEX_DIGITS[(bits >> (4 * digit)) & 0xF] : '0';
+                return text;
+            }
+            default:
+                return std::to_string(value);
+        }
+    }
+
+    static OutputColumn parse_column(const std::string& text, const int line_num) {
+        const size_t percent = text.find('%');
+        if (percent == std::string::npos) return { text, 'B', 1, 16, 1 };
+
+        OutputColumn column = { text.substr(0, percent), 'D', 1, 6, 1 };
+        int left_padding, width, right_padding;
+        char format;
+        char dot1, dot2;
+        std::istringstream spec(text.substr(percent + 1));
+        if (!(spec >> format >> left_padding >> dot1 >> width >> dot2 >> right_padding) || dot1 != '.' || dot2 != '.' ||
+                std::string("BDXS").find(format) == std::string::npos)
+            throw HackRomError("Line " + std::to_string(line_num) + ": invalid output format '" + text + "'.");
+        column.format = format;
+        column.left_padding = left_padding;
+        column.width = width;
+        column.right_padding = right_padding;
+        return column;
+    }
+
+    [[noreturn]] static void throw_unknown_variable(const std::string& name, const int line_num) {
+        throw HackRomError("Line " + std::to_string(line_num) + ": unknown variable '" + name + "'.");
+    }
+};
+
+TestScript TestScript::parse(std::istream& script_in, const std::string& base_dir) {
+    TestScript script;
+    script._base_dir = (base_dir.empty() || base_dir.back() == '/') ? base_dir : base_dir + "/";
+    const std::vector<ScriptToken> tokens = tokenize(script_in);
+    size_t position = 0;
+    script._commands = parse_commands(tokens, position, false);
+    return script;
+}
+
+TestScript TestScript::from_file(const std::string& path) {
+    std::ifstream script_in(path);
+    if (!script_in) throw HackRomError("Could not open '" + path + "'.");
+    const size_t last_slash_index = path.find_last_of('/');
+    TestScript script = parse(script_in, last_slash_index == std::string::npos ? "" : path.substr(0, last_slash_index + 1));
+    script._path = path;
+    return script;
+}
+
+TestScriptResult TestScript::run(std::shared_ptr<const KeyboardScript> keys,
+                                 std::shared_ptr<NetlistCache> netlists) const {
+    const auto start_time = std::chrono::steady_clock::now();
+    TestScriptResult result;
+    result.path = _path;
+    try {
+        ScriptRun run(_base_dir, keys, netlists, result);
+        result.passed = run.execute(_commands);
+    } catch (const HackRomError& e) {
+        result.passed = false;
+        result.message = e.what();
+    }
+    result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start_time).count();
+    return result;
+}
+
+std::vector<TestScriptResult> TestScript::run_all(const std::vector<std::string>& paths, const int num_threads,
+                                                  std::shared_ptr<const KeyboardScript> keys) {
+    std::vector<TestScriptResult> results(paths.size());
+    std::atomic<size_t> next_index(0);
+    // Scripts for the same chip, eg. CPU.tst and CPU-external.tst, share its
+    // netlist.
+    auto netlists = std::make_shared<NetlistCache>();
+    auto worker = [&]() {
+        // Scripts are short, so handing them out one at a time from a shared
+        // counter balances the load well enough.
+        for (size_t i = next_index++; i < paths.size(); i = next_index++) {
+            try {
+                results[i] = TestScript::from_file(paths[i]).run(keys, netlists);
+            } catch (const HackRomError& e) {
+                results[i] = { paths[i], false, e.what(), "", "", 0 };
+            }
+        }
+    };
+
+    const int num_workers = std::min<int>(num_threads > 0 ? num_threads : std::max(1u, std::thread::hardware_concurrency()),
+                                          std::max<size_t>(paths.size(), 1));
+    std::vector<std::thread> workers;
+    for (int i = 1; i < num_workers; ++i) workers.emplace_back(worker);
+    worker();
+    for (std::thread& each_worker : workers) each_worker.join();
+    return results;
+}
+
+static std::vector<ScriptToken> tokenize(std::istream& script_in) {
+    std::vector<ScriptToken> tokens;
+    const std::string source((std::istreambuf_iterator<char>(script_in)), std::istreambuf_iterator<char>());
+    int line_num = 1;
+    for (size_t i = 0; i < source.size(); ) {
+        const char c = source[i];
+        if (c == '\n') {
+            ++line_num;
+            ++i;
+        } else if (std::isspace(static_cast<unsigned char>(c))) {
+            ++i;
+        } else if (source.compare(i, 2, "//") == 0) {
+            i = source.find('\n', i);
+            if (i == std::string::npos) i = source.size();
+        } else if (source.compare(i, 2, "/*") == 0) {
+            const size_t end = source.find("*/", i + 2);
+            const size_t comment_end = end == std::string::npos ? source.size() : end + 2;
+            line_num += std::count(source.begin() + i, source.begin() + comment_end, '\n');
+            i = comment_end;
+        } else if (c == '"') {
+            const size_t end = source.find('"', i + 1);
+            if (end == std::string::npos) throw HackRomError("Line " + std::to_string(line_num) + ": unterminated string.");
+            tokens.push_back({ source.substr(i + 1, end - i - 1), line_num, true });
+            i = end + 1;
+        } else if (c == ',' || c == ';' || c == '{' || c == '}') {
+            tokens.push_back({ std::string(1, c), line_num, false });
+            ++i;
+        } else {
+            const size_t start = i;
+            while (i < source.size() && !std::isspace(static_cast<unsigned char>(source[i])) &&
+                   std::string(",;{}\"").find(source[i]) == std::string::npos && source.compare(i, 2, "//") != 0)
+                ++i;
+            tokens.push_back({ source.substr(start, i - start), line_num, false });
+        }
+    }
+    return tokens;
+}
+
+static bool is_separator(const ScriptToken& token) {
+    return !token.is_string && (token.text == "," || token.text == ";" || token.text == "{" || token.text == "}");
+}
+
+static std::vector<ScriptCommand> parse_commands(const std::vector<ScriptToken>& tokens, size_t& position,
+                                                 const bool is_block) {
+    std::vector<ScriptCommand> commands;
+    // Takes the next token, which must be a word.
+    auto take_word = [&](const ScriptToken& after) -> std::string {
+        if (position >= tokens.size() || is_separator(tokens[position]))
+            throw HackRomError("Line " + std::to_string(after.line_num) + ": '" + after.text + "' is missing an argument.");
+        return tokens[position++].text;
+    };
+    // Takes the `{` that starts a loop body and parses the body.
+    auto take_body = [&](const ScriptToken& loop) {
+        if (position >= tokens.size() || tokens[position].text != "{")
+            throw HackRomError("Line " + std::to_string(loop.line_num) + ": expected '{' after '" + loop.text + "'.");
+        ++position;
+        return parse_commands(tokens, position, true);
+    };
+
+    while (position < tokens.size()) {
+        const ScriptToken& token = tokens[position++];
+        if (token.text == "," || token.text == ";") continue;
+        if (token.text == "}") {
+            if (is_block) return commands;
+            throw HackRomError("Line " + std::to_string(token.line_num) + ": unexpected '}'.");
+        }
+
+        ScriptCommand command;
+        command.line_num = token.line_num;
+        command.count = 0;
+        const std::string& name = token.text;
+        if (name == "load") {
+            command.kind = ScriptCommand::Kind::LOAD;
+            command.args.push_back(take_word(token));
+        } else if (name == "output-file" || name == "compare-to") {
+            command.kind = name == "output-file" ? ScriptCommand::Kind::OUTPUT_FILE : ScriptCommand::Kind::COMPARE_TO;
+            command.args.push_back(take_word(token));
+        } else if (name == "output-list") {
+            command.kind = ScriptCommand::Kind::OUTPUT_LIST;
+            while (position < tokens.size() && !is_separator(tokens[position]))
+                command.args.push_back(tokens[position++].text);
+        } else if (name == "set") {
+            command.kind = ScriptCommand::Kind::SET;
+            command.args.push_back(take_word(token));
+            command.args.push_back(take_word(token));
+            parse_value(command.args[1], command.line_num);
+        } else if (name == "tick" || name == "tock" || name == "ticktock" || name == "eval" || name == "output") {
+            command.kind = name == "tick" ? ScriptCommand::Kind::TICK :
+                           name == "tock" ? ScriptCommand::Kind::TOCK :
+                           name == "ticktock" ? ScriptCommand::Kind::TICKTOCK :
+                           name == "eval" ? ScriptCommand::Kind::EVAL : ScriptCommand::Kind::OUTPUT;
+        } else if (name == "echo" || name == "clear-echo") {
+            command.kind = ScriptCommand::Kind::ECHO;
+            if (name == "echo" && position < tokens.size() && tokens[position].is_string) ++position;
+        } else if (name == "repeat") {
+            command.kind = ScriptCommand::Kind::REPEAT;
+            command.count = -1;
+            if (position < tokens.size() && tokens[position].text != "{") {
+                const std::string count = take_word(token);
+                if (count.empty() || count.size() > 18 || count.find_first_not_of("0123456789") != std::string::npos)
+                    throw HackRomError("Line " + std::to_string(token.line_num) + ": invalid repeat count '" + count + "'.");
+                command.count = std::stoll(count);
+            }
+            command.body = take_body(token);
+        } else if (name == "while") {
+            command.kind = ScriptCommand::Kind::WHILE;
+            command.args.push_back(take_word(token));
+            command.op = take_word(token);
+            command.args.push_back(take_word(token));
+            parse_value(command.args[1], command.line_num);
+            command.body = take_body(token);
+        } else if (position < tokens.size() && tokens[position].text == "load" && !token.is_string) {
+            // `<chip> load <file>`, eg. `ROM32K load Max.hack`.
+            ++position;
+            command.kind = ScriptCommand::Kind::LOAD;
+            command.args.push_back(take_word(tokens[position - 1]));
+            command.args.push_back(name);
+        } else {
+            throw HackRomError("Line " + std::to_string(token.line_num) + ": unknown command '" + name + "'.");
+        }
+        commands.push_back(command);
+    }
+    if (is_block) throw HackRomError("The script ends inside a loop.");
+    return commands;
+}
+
+static int parse_value(const std::string& text, const int line_num) {
+    int base = 10;
+    std::string digits = text;
+    if (text.size() > 2 && text[0] == '%') {
+        base = text[1] == 'B' ? 2 : text[1] == 'X' ? 16 : text[1] == 'D' ? 10 : 0;
+        digits = text.substr(2);
+    }
+    try {
+        size_t end = 0;
+        const long value = base ? std::stol(digits, &end, base) : 0;
+        if (base && end == digits.size() && value >= -32768 && value <= 65535) return static_cast<int16_t>(value);
+    } catch (const std::logic_error&) {
+    }
+    throw HackRomError("Line " + std::to_string(line_num) + ": invalid value '" + text + "'.");
+}
+
+static std::optional<int> parse_index(const std::string& name, const std::string& prefix) {
+    if (name.size() < prefix.size() + 3 || name.compare(0, prefix.size(), prefix) != 0 ||
+            name[prefix.size()] != '[' || name.back() != ']')
+        return std::nullopt;
+    const std::string digits = name.substr(prefix.size() + 1, name.size() - prefix.size() - 2);
+    if (digits.find_first_not_of("0123456789") != std::string::npos || digits.size() > 5) return std::nullopt;
+    return std::stoi(digits);
+}
@@ -0,0 +1,125 @@
+#ifndef TEST_SCRIPT_H
+#define TEST_SCRIPT_H
+
+#include "KeyboardScript.h"
+#include "NetlistCache.h"
+#include <cstdint>
+#include <istream>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <vector>
+
+/**
+ * One command of a test script. Loops hold their body.
+ */
+struct ScriptCommand {
+    enum class Kind {
+        LOAD,           // `load <file>` or `<chip> load <file>`.
+        OUTPUT_FILE,
+        COMPARE_TO,
+        OUTPUT_LIST,
+        SET,
+        TICK,
+        TOCK,
+        TICKTOCK,
+        EVAL,
+        OUTPUT,
+        ECHO,           // Also `clear-echo`. Ignored when running headless.
+        REPEAT,
+        WHILE
+    };
+
+    Kind kind;
+    int line_num;
+    std::vector<std::string> args;
+
+    // For REPEAT, the number of iterations, or -1 to repeat forever.
+    int64_t count;
+
+    // For WHILE, `<args[0]> <op> <args[1]>`.
+    std::string op;
+
+    std::vector<ScriptCommand> body;
+};
+
+struct TestScriptResult {
+    std::string path;
+    bool passed;
+
+    // Why the script failed, eg. "Comparison failure at line 5". Empty if it
+    // passed.
+    std::string message;
+
+    // Everything the script output, which the course tools would write to
+    // its output file.
+    std::string output;
+    std::string output_path;
+    double seconds;
+};
+
+/**
+ * An interpreter for the nand2tetris test script language (.tst files), for
+ * running the course's tests without the Java tools.
+ *
+ * Only the parts of the language needed for the CPU emulator's scripts and
+ * for the CPU, Memory and Computer chips are supported: `load`, `output-file`,
+ * `compare-to`, `output-list`, `set`, `tick`, `tock`, `ticktock`, `eval`,
+ * `output`, `echo`, `repeat` and `while`. Loading a program (.asm or .hack)
+ * runs it on a HackComputer. Loading a chip flattens its HDL into a Netlist
+ * and simulates it gate by gate, with the built-in RAM, screen, keyboard and
+ * ROM chips kept as arrays of words. `ROM32K load <program>` loads a program
+ * into a chip's ROM, as for Computer.hdl.
+ *
+ * Output lines are compared against the `compare-to` file as they are
+ * written, and the script stops at the first mismatch like the course tools
+ * do. `*` in the compare file matches any character.
+ */
+class TestScript {
+public:
+    /**
+     * Parses a script. Files the script names are relative to `base_dir`.
+     */
+    static TestScript parse(std::istream& script_in, const std::string& base_dir);
+
+    static TestScript from_file(const std::string& path);
+
+    /**
+     * Runs the script. If `keys` is given, it drives the keyboard, with the
+     * script's clock as the cycle count. Chips are taken from `netlists` if
+     * given, rather than flattened afresh. Errors in the script are reported
+     * in the result rather than thrown.
+     */
+    TestScriptResult run(std::shared_ptr<const KeyboardScript> keys = nullptr,
+                         std::shared_ptr<NetlistCache> netlists = nullptr) const;
+
+    /**
+     * Runs the scripts at `paths` on `num_threads` threads, or one per core if
+     * 0, flattening each chip they load only once. Results are in the same
+     * order as `paths`.
+     */
+    static std::vector<TestScriptResult> run_all(const std::vector<std::string>& paths, const int num_threads,
+                                                 std::shared_ptr<const KeyboardScript> keys = nullptr);
+
+    /**
+     * Finds every script under `dir` that tests a chip: one that loads a .hdl
+     * file and compares against a .cmp file, both of which exist. Scripts
+     * that can't be parsed are included if there's a chip of the same name
+     * next to them, so that running them reports the error. Paths are
+     * sorted.
+     */
+    static std::vector<std::string> find_chip_tests(const std::string& dir);
+
+    /**
+     * Writes `results` as a JUnit XML report, which CI servers can show per
+     * test, with timings.
+     */
+    static void write_junit_report(const std::vector<TestScriptResult>& results, std::ostream& report_out);
+
+private:
+    std::string _path;
+    std::string _base_dir;
+    std::vector<ScriptCommand> _commands;
+};
+
+#endif
@@ -0,0 +1,101 @@
+#include "Rom.h"
+#include "TestScript.h"
+#include <algorithm>
+#include <gtest/gtest.h>
+#include <memory>
+#include <sstream>
+
+const std::string COURSE_SRC = "../nand2tetris-exercises/05";
+
+TEST(TestScriptTest, RunsProgramScript) {
+    const TestScriptResult result = TestScript::from_file("test-files/Max.tst").run();
+    EXPECT_TRUE(result.passed) << result.message;
+    EXPECT_EQ(result.output, "|  RAM[0]  |  RAM[1]  |  RAM[2]  |\n"
+                             "|       3  |      17  |      17  |\n"
+                             "|      -5  |      -8  |      -5  |\n");
+}
+
+TEST(TestScriptTest, StopsAtFirstMismatch) {
+    std::istringstream script_in("load Max.asm, compare-to Max.cmp, output-list RAM[0]%D2.6.2 RAM[1]%D2.6.2 RAM[2]%D2.6.2;\n"
+                                 "set RAM[0] 3, set RAM[1] 17, repeat 1000 { ticktock; } output;\n"
+                                 "set PC 0, set RAM[0] 3, set RAM[1] 4, repeat 1000 { ticktock; } output;\n"
+                                 "output;\n");
+    const TestScriptResult result = TestScript::parse(script_in, "test-files").run();
+    EXPECT_FALSE(result.passed);
+    EXPECT_EQ(result.message, "Comparison failure at line 3");
+    EXPECT_EQ(std::count(result.output.begin(), result.output.end(), '\n'), 3);
+}
+
+TEST(TestScriptTest, RunsCourseChipTests) {
+    for (const std::string name : { "CPU", "CPU-external", "ComputerAdd", "ComputerMax", "ComputerRect" }) {
+        const TestScriptResult result = TestScript::from_file(COURSE_SRC + "/" + name + ".tst").run();
+        EXPECT_TRUE(result.passed) << name << ": " << result.message;
+    }
+}
+
+TEST(TestScriptTest, MemoryTestReadsKeysFromScript) {
+    // Memory.tst waits for 'K' and then 'Y' to be held down.
+    auto keys = std::make_shared<const KeyboardScript>(std::vector<KeyPress>{ { 0, 200, 'K' }, { 200, 1000, 'Y' } });
+    const TestScriptResult result = TestScript::from_file(COURSE_SRC + "/Memory.tst").run(keys);
+    EXPECT_TRUE(result.passed) << result.message;
+}
+
+TEST(TestScriptTest, RunsManyScripts) {
+    std::vector<std::string> paths;
+    for (int i = 0; i < 20; ++i) paths.push_back(i % 2 ? "test-files/Max.tst" : COURSE_SRC + "/ComputerMax.tst");
+    paths.push_back("test-files/Missing.tst");
+    const std::vector<TestScriptResult> results = TestScript::run_all(paths, 4);
+    ASSERT_EQ(results.size(), paths.size());
+    for (size_t i = 0; i + 1 < paths.size(); ++i) {
+        EXPECT_EQ(results[i].path, paths[i]);
+        EXPECT_TRUE(results[i].passed);
+    }
+    EXPECT_FALSE(results.back().passed);
+}
+
+TEST(TestScriptTest, ReportsScriptErrors) {
+    std::istringstream unknown_command("load Max.asm, jump 5;");
+    EXPECT_THROW(TestScript::parse(unknown_command, "test-files"), HackRomError);
+
+    std::istringstream unknown_variable("load Max.asm, set R5 1;");
+    const TestScriptResult result = TestScript::parse(unknown_variable, "test-files").run();
+    EXPECT_FALSE(result.passed);
+    EXPECT_EQ(result.message, "Line 1: unknown variable 'R5'.");
+}
+
+TEST(TestScriptTest, RunsHdlChipTests) {
+    std::vector<std::string> paths;
+    for (const std::string name : { "01/Xor", "01/DMux8Way", "01/Mux8Way16", "02/ALU", "02/Add16", "03/a/Bit",
+                                    "03/a/PC", "03/a/RAM64", "03/b/RAM512" })
+        paths.push_back("../nand2tetris-exercises/" + name + ".tst");
+    for (const TestScriptResult& result : TestScript::run_all(paths, 0))
+        EXPECT_TRUE(result.passed) << result.path << ": " << result.message;
+}
+
+TEST(TestScriptTest, FindsChipTests) {
+    const std::vector<std::string> paths = TestScript::find_chip_tests("../nand2tetris-exercises");
+    EXPECT_TRUE(std::is_sorted(paths.begin(), paths.end()));
+    for (const std::string name : { "01/And", "02/ALU", "03/a/PC", "05/CPU-external", "05/ComputerMax" })
+        EXPECT_NE(std::find(paths.begin(), paths.end(), "../nand2tetris-exercises/" + name + ".tst"), paths.end()) << name;
+    // Project 4's scripts load programs rather than chips.
+    for (const std::string& path : paths) EXPECT_EQ(path.find("/04/"), std::string::npos) << path;
+}
+
+TEST(TestScriptTest, WritesJUnitReport) {
+    const std::vector<TestScriptResult> results = {
+        { "../nand2tetris-exercises/01/And.tst", true, "", "", "", 0.0125 },
+        { "../nand2tetris-exercises/01/Or.tst", false, "Comparison failure at line 3 <Or>", "", "", 0.5 }
+    };
+    std::ostringstream report;
+    TestScript::write_junit_report(results, report);
+    EXPECT_EQ(report.str(),
+              "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+              "<testsuites tests=\"2\" failures=\"1\" time=\"0.512\">\n"
+              "  <testsuite name=\"HackTest\" tests=\"2\" failures=\"1\" errors=\"0\" time=\"0.512\">\n"
+              "    <testcase classname=\"../nand2tetris-exercises/01\" name=\"And\" time=\"0.013\"/>\n"
+              "    <testcase classname=\"../nand2tetris-exercises/01\" name=\"Or\" time=\"0.500\">\n"
+              "      <failure message=\"Comparison failure at line 3 &lt;Or&gt;\"/>\n"
+              "    </testcase>\n"
+              "  </testsuite>\n"
+              "</testsuites>\n");
+}
@@ -0,0 +1,215 @@
+#include "Trace.h"
+#include "BinaryIO.h"
+#include "Rom.h"
+#include <algorithm>
+#include <zlib.h>
+
+// Identifies a trace file and the version of its format.
+static const char TRACE_MAGIC[8] = { 'H', 'A', 'C', 'K', 'T', 'R', 'C', '1' };
+
+// Reads a varint written by `TraceRecorder::put_varint`, advancing `position`.
+static uint32_t get_varint(const std::vector<uint8_t>& in, size_t& position) {
+    uint32_t value = 0;
+    for (int shift = 0; position < in.size(); shift += 7) {
+        const uint8_t byte = in[position++];
+        value |= static_cast<uint32_t>(byte & 0x7F) << shift;
+        if (!(byte & 0x80)) return value;
+    }
+    throw HackRomError("Trace block ends in the middle of a number.");
+}
+
+static int32_t unzigzag(const uint32_t value) {
+    return static_cast<int32_t>(value >> 1) ^ -static_cast<int32_t>(value & 1);
+}
+
+TraceRecorder::TraceRecorder(const std::string& path, const uint32_t block_cycles, const int max_pending_blocks)
+        : _trace_out(path, std::ios::binary),
+          _block_cycles(std::max<uint32_t>(block_cycles, 1)),
+          _max_pending_blocks(std::max(max_pending_blocks, 1)),
+          _next_block_cycle(0),
+          _next_pc(0),
+          _last_instruction_offset(0),
+          _last_write_address(0),
+          _last_write_value(0),
+          _is_closing(false) {
+    if (!_trace_out) throw HackRomError("Could not write '" + path + "'.");
+    _trace_out.write(TRACE_MAGIC, sizeof(TRACE_MAGIC));
+    write_int<uint32_t>(_trace_out, _block_cycles);
+
+    _block.num_cycles = 0;
+    _block.data.reserve(2 * _block_cycles);
+    _writer = std::thread(&TraceRecorder::write_blocks, this);
+}
+
+TraceRecorder::~TraceRecorder() {
+    close();
+}
+
+void TraceRecorder::close() {
+    if (!_writer.joinable()) return;
+    if (_block.num_cycles > 0) finish_block();
+    {
+        std::lock_guard<std::mutex> guard(_lock);
+        _is_closing = true;
+    }
+    _changed.notify_all();
+    _writer.join();
+    _trace_out.close();
+}
+
+void TraceRecorder::start_block(const uint16_t pc) {
+    _block.first_cycle = _next_block_cycle;
+    _block.first_pc = pc;
+    _block.written_pages.fill(0);
+    _block.data.clear();
+    _next_pc = pc;
+    _last_write_address = 0;
+    _last_write_value = 0;
+}
+
+void TraceRecorder::finish_block() {
+    _next_block_cycle += _block.num_cycles;
+    {
+        std::unique_lock<std::mutex> guard(_lock);
+        _changed.wait(guard, [this] { return _pending_blocks.size() < _max_pending_blocks; });
+        _pending_blocks.push_back(std::move(_block));
+    }
+    _changed.notify_all();
+
+    _block = TraceBlock();
+    _block.num_cycles = 0;
+    _block.data.reserve(2 * _block_cycles);
+}
+
+void TraceRecorder::write_blocks() {
+    std::vector<uint8_t> compressed;
+    while (true) {
+        TraceBlock block;
+        {
+            std::unique_lock<std::mutex> guard(_lock);
+            _changed.wait(guard, [this] { return !_pending_blocks.empty() || _is_closing; });
+            if (_pending_blocks.empty()) return;
+            block = std::move(_pending_blocks.front());
+            _pending_blocks.pop_front();
+        }
+        _changed.notify_all();
+
+        uLongf compressed_size = compressBound(block.data.size());
+        compressed.resize(compressed_size);
+        compress2(compressed.data(), &compressed_size, block.data.data(), block.data.size(), Z_BEST_SPEED);
+
+        write_int<uint64_t>(_trace_out, block.first_cycle);
+        write_int<uint32_t>(_trace_out, block.num_cycles);
+        write_int<uint16_t>(_trace_out, block.first_pc);
+        _trace_out.write(reinterpret_cast<const char*>(block.written_pages.data()), block.written_pages.size());
+        write_int<uint32_t>(_trace_out, block.data.size());
+        write_int<uint32_t>(_trace_out, compressed_size);
+        _trace_out.write(reinterpret_cast<const char*>(compressed.data()), compressed_size);
+    }
+}
+
+TraceReader::TraceReader(const std::string& path)
+        : _trace_in(path, std::ios::binary),
+          _decoded_block(SIZE_MAX) {
+    if (!_trace_in) throw HackRomError("Could not open '" + path + "'.");
+    char magic[sizeof(TRACE_MAGIC)];
+    _trace_in.read(magic, sizeof(magic));
+    if (!_trace_in || !std::equal(magic, magic + sizeof(magic), TRACE_MAGIC))
+        throw HackRomError("'" + path + "' is not a trace file.");
+    _block_cycles = read_int<uint32_t>(_trace_in);
+
+    // Hop from header to header, stopping at the first incomplete block.
+    _trace_in.seekg(0, std::ios::end);
+    const std::streamoff file_size = _trace_in.tellg();
+    _trace_in.seekg(sizeof(TRACE_MAGIC) + sizeof(uint32_t));
+    while (true) {
+        IndexEntry entry;
+        entry.header.first_cycle = read_int<uint64_t>(_trace_in);
+        entry.header.num_cycles = read_int<uint32_t>(_trace_in);
+        entry.header.first_pc = read_int<uint16_t>(_trace_in);
+        _trace_in.read(reinterpret_cast<char*>(entry.header.written_pages.data()), entry.header.written_pages.size());
+        entry.raw_size = read_int<uint32_t>(_trace_in);
+        entry.compressed_size = read_int<uint32_t>(_trace_in);
+        if (!_trace_in) break;
+        entry.data_offset = _trace_in.tellg();
+        if (entry.data_offset + entry.compressed_size > file_size) break;
+        _index.push_back(entry);
+        _trace_in.seekg(entry.data_offset + entry.compressed_size);
+    }
+    _trace_in.clear();
+}
+
+uint64_t TraceReader::num_cycles() const {
+    if (_index.empty()) return 0;
+    return _index.back().header.first_cycle + _index.back().header.num_cycles;
+}
+
+uint32_t TraceReader::block_cycles() const {
+    return _block_cycles;
+}
+
+TraceEvent TraceReader::event_at(const uint64_t cycle) {
+    if (cycle >= num_cycles()) throw HackRomError("Cycle " + std::to_string(cycle) + " is past the end of the trace.");
+    const std::vector<TraceEvent>& events = decode_block(cycle / _block_cycles);
+    return events[cycle % _block_cycles];
+}
+
+std::vector<TraceEvent> TraceReader::events(const uint64_t from_cycle, const uint64_t to_cycle) {
+    std::vector<TraceEvent> events;
+    const uint64_t end_cycle = std::min(to_cycle, num_cycles());
+    for (uint64_t cycle = from_cycle; cycle < end_cycle; ) {
+        const std::vector<TraceEvent>& block_events = decode_block(cycle / _block_cycles);
+        const uint64_t block_end_cycle = std::min(end_cycle, block_events.front().cycle + block_events.size());
+        for (; cycle < block_end_cycle; ++cycle)
+            events.push_back(block_events[cycle - block_events.front().cycle]);
+    }
+    return events;
+}
+
+std::optional<TraceEvent> TraceReader::last_write_before(const uint16_t address, const uint64_t before_cycle) {
+    const uint64_t end_cycle = std::min(before_cycle, num_cycles());
+    const int page = (address & 0x7FFF) / TRACE_PAGE_SIZE;
+    for (int64_t block = static_cast<int64_t>((end_cycle + _block_cycles - 1) / _block_cycles) - 1; block >= 0; --block) {
+        if (!(_index[block].header.written_pages[page / 8] & (1 << (page % 8)))) continue;
+
+        const std::vector<TraceEvent>& block_events = decode_block(block);
+        for (auto event = block_events.rbegin(); event != block_events.rend(); ++event)
+            if (event->cycle < end_cycle && event->wrote_ram && event->address == (address & 0x7FFF)) return *event;
+    }
+    return std::nullopt;
+}
+
+const std::vector<TraceEvent>& TraceReader::decode_block(const size_t block) {
+    if (block == _decoded_block) return _decoded_events;
+    const IndexEntry& entry = _index.at(block);
+
+    std::vector<uint8_t> compressed(entry.compressed_size);
+    _trace_in.seekg(entry.data_offset);
+    _trace_in.read(reinterpret_cast<char*>(compressed.data()), compressed.size());
+    std::vector<uint8_t> data(entry.raw_size);
+    uLongf raw_size = data.size();
+    if (!_trace_in || uncompress(data.data(), &raw_size, compressed.data(), compressed.size()) != Z_OK || raw_size != data.size())
+        throw HackRomError("Trace block " + std::to_string(block) + " is corrupt.");
+
+    _decoded_events.clear();
+    _decoded_block = SIZE_MAX;
+    size_t position = 0;
+    int next_pc = entry.header.first_pc;
+    int last_write_address = 0;
+    int16_t last_write_value = 0;
+    for (uint32_t i = 0; i < entry.header.num_cycles; ++i) {
+        const uint32_t token = get_varint(data, position);
+        TraceEvent event = { entry.header.first_cycle + i, static_cast<uint16_t>(next_pc + unzigzag(token >> 1)), false, 0, 0 };
+        if (token & 1) {
+            event.wrote_ram = true;
+            event.address = last_write_address + unzigzag(get_varint(data, position));
+            event.value = static_cast<int16_t>(last_write_value + unzigzag(get_varint(data, position)));
+            last_write_address = event.address;
+            last_write_value = event.value;
+        }
+        next_pc = event.pc + 1;
+        _decoded_events.push_back(event);
+    }
+    _decoded_block = block;
+    return _decoded_events;
+}
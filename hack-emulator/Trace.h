@@ -0,0 +1,210 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <array>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <fstream>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Written pages are tracked per 64-word page of RAM.
+constexpr int TRACE_PAGE_SIZE = 64;
+constexpr int TRACE_NUM_PAGES = 32768 / TRACE_PAGE_SIZE;
+
+/**
+ * One instruction from a trace: where it was, and what it wrote to RAM, if
+ * anything. Cycles count from the start of the recording.
+ */
+struct TraceEvent {
+    uint64_t cycle;
+    uint16_t pc;
+    bool wrote_ram;
+    uint16_t address;
+    int16_t value;
+};
+
+/**
+ * A run of consecutive cycles, which is the unit that's compressed, written
+ * and indexed.
+ *
+ * Each instruction is encoded relative to the one before it. The program
+ * counter is stored as its difference from the previous PC + 1, so straight
+ * line code is 1 byte per instruction. RAM writes are stored as the
+ * difference from the previous write's address and value. The differences
+ * are zigzag-encoded varints, and the whole block is then deflated.
+ */
+struct TraceBlock {
+    uint64_t first_cycle;
+    uint32_t num_cycles;
+    uint16_t first_pc;
+
+    // Bit i is set if the block writes anywhere in page i of RAM, so queries
+    // about an address can skip blocks that never touch it.
+    std::array<uint8_t, TRACE_NUM_PAGES / 8> written_pages;
+
+    // Encoded instructions, before compression when recording.
+    std::vector<uint8_t> data;
+};
+
+/**
+ * Streams the PC of every executed instruction and every RAM write to a trace
+ * file. Attach it to a HackComputer with `HackComputer::set_trace_recorder`.
+ *
+ * The emulator thread only encodes instructions into the current block.
+ * Finished blocks are compressed and written by a background thread. At most
+ * `max_pending_blocks` blocks may be waiting for it, after which the emulator
+ * waits too, so memory use stays bounded however long the run is.
+ */
+class TraceRecorder {
+public:
+    /**
+     * Starts a trace at `path` with a block, and an index entry, every
+     * `block_cycles` cycles.
+     */
+    explicit TraceRecorder(const std::string& path, const uint32_t block_cycles = 65536, const int max_pending_blocks = 4);
+
+    /**
+     * Calls `close`.
+     */
+    ~TraceRecorder();
+
+    /**
+     * Records that the instruction at `pc` is about to be executed.
+     */
+    void record(const uint16_t pc) {
+        if (_block.num_cycles == _block_cycles) finish_block();
+        if (_block.num_cycles == 0) start_block(pc);
+        _last_instruction_offset = _block.data.size();
+        put_varint(_block.data, zigzag(pc - _next_pc) << 1);
+        _next_pc = pc + 1;
+        ++_block.num_cycles;
+    }
+
+    /**
+     * Records that the instruction just passed to `record` wrote `value` to
+     * RAM[address].
+     */
+    void record_write(const uint16_t address, const int16_t value) {
+        // The lowest bit of an instruction's first byte marks a write.
+        _block.data[_last_instruction_offset] |= 1;
+        put_varint(_block.data, zigzag(address - _last_write_address));
+        put_varint(_block.data, zigzag(static_cast<int16_t>(value - _last_write_value)));
+        _last_write_address = address;
+        _last_write_value = value;
+        _block.written_pages[address / TRACE_PAGE_SIZE / 8] |= 1 << (address / TRACE_PAGE_SIZE % 8);
+    }
+
+    /**
+     * Writes out everything recorded so far and closes the file. Nothing can
+     * be recorded afterwards.
+     */
+    void close();
+
+    static uint32_t zigzag(const int32_t value) {
+        return (static_cast<uint32_t>(value) << 1) ^ static_cast<uint32_t>(value >> 31);
+    }
+
+    static void put_varint(std::vector<uint8_t>& out, uint32_t value) {
+        while (value >= 0x80) {
+            out.push_back(static_cast<uint8_t>(value) | 0x80);
+            value >>= 7;
+        }
+        out.push_back(static_cast<uint8_t>(value));
+    }
+
+private:
+    std::ofstream _trace_out;
+    const uint32_t _block_cycles;
+    const size_t _max_pending_blocks;
+
+    // The block being recorded, and the state its encoding is relative to.
+    TraceBlock _block;
+    uint64_t _next_block_cycle;
+    uint16_t _next_pc;
+    size_t _last_instruction_offset;
+    uint16_t _last_write_address;
+    int16_t _last_write_value;
+
+    // Finished blocks waiting for the writer thread.
+    std::mutex _lock;
+    std::condition_variable _changed;
+    std::deque<TraceBlock> _pending_blocks;
+    bool _is_closing;
+    std::thread _writer;
+
+    void start_block(const uint16_t pc);
+
+    // Hands the current block to the writer thread.
+    void finish_block();
+
+    // Compresses and writes pending blocks until closed.
+    void write_blocks();
+};
+
+/**
+ * Answers questions about a recorded trace without re-running the program.
+ *
+ * Opening a trace only reads the block headers, which serve as an index: any
+ * cycle can be found by decompressing the single block that contains it.
+ * Since every block header is complete before its data is written, a trace
+ * that was cut short is readable up to its last complete block.
+ */
+class TraceReader {
+public:
+    explicit TraceReader(const std::string& path);
+
+    /**
+     * Number of instructions in the trace.
+     */
+    uint64_t num_cycles() const;
+
+    /**
+     * Cycles per block that the trace was recorded with.
+     */
+    uint32_t block_cycles() const;
+
+    /**
+     * The instruction executed at `cycle`, which must be less than
+     * `num_cycles()`.
+     */
+    TraceEvent event_at(const uint64_t cycle);
+
+    /**
+     * Every instruction executed in the cycles [from_cycle, to_cycle).
+     */
+    std::vector<TraceEvent> events(const uint64_t from_cycle, const uint64_t to_cycle);
+
+    /**
+     * The last write to RAM[address] at a cycle before `before_cycle`, if
+     * there was one. Blocks that never wrote to the address's page are
+     * skipped without being decompressed.
+     */
+    std::optional<TraceEvent> last_write_before(const uint16_t address, const uint64_t before_cycle);
+
+private:
+    // A block header, and where its compressed data is.
+    struct IndexEntry {
+        TraceBlock header;
+        uint32_t raw_size;
+        uint32_t compressed_size;
+        std::streamoff data_offset;
+    };
+
+    std::ifstream _trace_in;
+    uint32_t _block_cycles;
+    std::vector<IndexEntry> _index;
+
+    // The most recently decoded block, since queries tend to stay nearby.
+    size_t _decoded_block;
+    std::vector<TraceEvent> _decoded_events;
+
+    // Decodes the block at `_index[block]` into `_decoded_events`.
+    const std::vector<TraceEvent>& decode_block(const size_t block);
+};
+
+#endif
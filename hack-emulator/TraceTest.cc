@@ -0,0 +1,70 @@
+#include "HackComputer.h"
+#include "Trace.h"
+#include <gtest/gtest.h>
+#include <memory>
+
+// Records Calls.asm in blocks much smaller than the run, so queries have to
+// cross block boundaries. Each test gets its own trace file, since ctest runs
+// the tests as separate processes at once.
+class TraceTest : public ::testing::Test {
+protected:
+    const std::string trace_path = ::testing::TempDir() + "TraceTest." +
+        ::testing::UnitTest::GetInstance()->current_test_info()->name() + ".hacktrace";
+    std::shared_ptr<const Rom> rom = std::make_shared<const Rom>(Rom::from_file("test-files/Calls.asm"));
+    HackComputer computer { rom };
+
+    void SetUp() override {
+        TraceRecorder recorder(trace_path, 100, 2);
+        computer.set_trace_recorder(&recorder);
+        ASSERT_EQ(computer.run(100000), HaltReason::END_OF_PROGRAM);
+        recorder.close();
+    }
+
+    void TearDown() override {
+        std::remove(trace_path.c_str());
+    }
+};
+
+TEST_F(TraceTest, ReplaysEveryInstruction) {
+    TraceReader trace(trace_path);
+    ASSERT_EQ(trace.num_cycles(), computer.cycles());
+
+    // Step a second computer through the same program alongside the trace.
+    HackComputer replay(rom);
+    const std::vector<TraceEvent> events = trace.events(0, trace.num_cycles());
+    ASSERT_EQ(events.size(), computer.cycles());
+    for (const TraceEvent& event : events) {
+        ASSERT_EQ(event.pc, replay.pc()) << "at cycle " << event.cycle;
+        replay.step();
+        if (event.wrote_ram) {
+            EXPECT_EQ(replay.ram(event.address), event.value) << "at cycle " << event.cycle;
+        }
+    }
+    EXPECT_EQ(trace.event_at(0).pc, 0);
+    EXPECT_EQ(trace.event_at(trace.num_cycles() - 1).pc, events.back().pc);
+}
+
+TEST_F(TraceTest, FindsLastWriteBeforeCycle) {
+    TraceReader trace(trace_path);
+    const std::vector<TraceEvent> events = trace.events(0, trace.num_cycles());
+
+    // Check against a linear scan for the stack pointer and the result.
+    for (const uint16_t address : { 0, 5 }) {
+        for (uint64_t cycle = 0; cycle <= trace.num_cycles(); cycle += 37) {
+            std::optional<TraceEvent> expected;
+            for (const TraceEvent& event : events)
+                if (event.cycle < cycle && event.wrote_ram && event.address == address) expected = event;
+
+            const std::optional<TraceEvent> actual = trace.last_write_before(address, cycle);
+            ASSERT_EQ(actual.has_value(), expected.has_value()) << "RAM[" << address << "] before cycle " << cycle;
+            if (expected) {
+                EXPECT_EQ(actual->cycle, expected->cycle);
+            }
+        }
+    }
+
+    const std::optional<TraceEvent> result = trace.last_write_before(5, trace.num_cycles());
+    ASSERT_TRUE(result.has_value());
+    EXPECT_EQ(result->value, 25);
+    EXPECT_FALSE(trace.last_write_before(1000, trace.num_cycles()).has_value());
+}
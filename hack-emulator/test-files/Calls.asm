@@ -0,0 +1,554 @@
+// ===== Boostrap Start =====
+@261  // Initialise stack pointer to base of stack.
+D = A
+@SP
+M = D
+// ===== Boostrap End =====
+// function Sys.init 0
+(Sys.init)  // Function declaration.
+// call Main.main 0
+	@Calls.Main.main$ret.1
+	D = A
+	@SP   // Pushing to stack.
+	M = M + 1
+	A = M - 1
+	M = D // Done pushing.
+	@LCL
+	D = M
+	@SP   // Pushing to stack.
+	M = M + 1
+	A = M - 1
+	M = D // Done pushing.
+	@ARG
+	D = M
+	@SP   // Pushing to stack.
+	M = M + 1
+	A = M - 1
+	M = D // Done pushing.
+	@THIS
+	D = M
+	@SP   // Pushing to stack.
+	M = M + 1
+	A = M - 1
+	M = D // Done pushing.
+	@THAT
+	D = M
+	@SP   // Pushing to stack.
+	M = M + 1
+	A = M - 1
+	M = D // Done pushing.
+	@SP
+	D = M
+	@5
+	D = D - A
+	@0
+	D = D - A
+	@ARG
+	M = D
+	@SP
+	D = M
+	@LCL
+	M = D
+	@Main.main
+	0;JMP
+(Calls.Main.main$ret.1)
+// pop temp 0
+	@5
+	D = A
+	@R13
+	M = D
+	@SP   // Popping from stack.
+	M = M - 1
+	A = M
+	D = M // Done popping.
+	@R13
+	A = M
+	M = D
+// label HALT
+(Calls.Sys.init$HALT)
+// goto HALT
+	@Calls.Sys.init$HALT
+	0;JMP
+// function Main.main 0
+(Main.main)  // Function declaration.
+// push constant 3
+	@3
+	D = A
+	@SP   // Pushing to stack.
+	M = M + 1
+	A = M - 1
+	M = D // Done pushing.
+// call Main.square 1
+	@Calls.Main.square$ret.1
+	D = A
+	@SP   // Pushing to stack.
+	M = M + 1
+	A = M - 1
+	M = D // Done pushing.
+	@LCL
+	D = M
+	@SP   // Pushing to stack.
+	M = M + 1
+	A = M - 1
+	M = D // Done pushing.
+	@ARG
+	D = M
+	@SP   // Pushing to stack.
+	M = M + 1
+	A = M - 1
+	M = D // Done pushing.
+	@THIS
+	D = M
+	@SP   // Pushing to stack.
+	M = M + 1
+	A = M - 1
+	M = D // Done pushing.
+	@THAT
+	D = M
+	@SP   // Pushing to stack.
+	M = M + 1
+	A = M - 1
+	M = D // Done pushing.
+	@SP
+	D = M
+	@5
+	D = D - A
+	@1
+	D = D - A
+	@ARG
+	M = D
+	@SP
+	D = M
+	@LCL
+	M = D
+	@Main.square
+	0;JMP
+(Calls.Main.square$ret.1)
+// push constant 4
+	@4
+	D = A
+	@SP   // Pushing to stack.
+	M = M + 1
+	A = M - 1
+	M = D // Done pushing.
+// call Main.square 1
+	@Calls.Main.square$ret.2
+	D = A
+	@SP   // Pushing to stack.
+	M = M + 1
+	A = M - 1
+	M = D // Done pushing.
+	@LCL
+	D = M
+	@SP   // Pushing to stack.
+	M = M + 1
+	A = M - 1
+	M = D // Done pushing.
+	@ARG
+	D = M
+	@SP   // Pushing to stack.
+	M = M + 1
+	A = M - 1
+	M = D // Done pushing.
+	@THIS
+	D = M
+	@SP   // Pushing to stack.
+	M = M + 1
+	A = M - 1
+	M = D // Done pushing.
+	@THAT
+	D = M
+	@SP   // Pushing to stack.
+	M = M + 1
+	A = M - 1
+	M = D // Done pushing.
+	@SP
+	D = M
+	@5
+	D = D - A
+	@1
+	D = D - A
+	@ARG
+	M = D
+	@SP
+	D = M
+	@LCL
+	M = D
+	@Main.square
+	0;JMP
+(Calls.Main.square$ret.2)
+// add
+	@SP   // Popping from stack.
+	M = M - 1
+	A = M
+	D = M // Done popping.
+	A = A - 1
+	M = M + D
+// return
+	@LCL // frame = LCL
+	D = M
+	@R13
+	M = D
+	@5 // R14 = *(frame - 5)
+	D = D - A
+	A = D
+	D = M
+	@R14 // Saving return address.
+	M = D
+	@SP   // Popping from stack.
+	M = M - 1
+	A = M
+	D = M // Done popping.
+	@ARG
+	A = M
+	M = D
+	D = A + 1
+	@SP
+	M = D
+// Restoring THAT, THIS, ARG, LCL.
+	@R13
+	A = M - 1
+	D = M
+	@THAT
+	M = D
+	@R13
+	A = M - 1
+	A = A - 1
+	D = M
+	@THIS
+	M = D
+	@R13
+	A = M - 1
+	A = A - 1
+	A = A - 1
+	D = M
+	@ARG
+	M = D
+	@R13
+	A = M - 1
+	A = A - 1
+	A = A - 1
+	A = A - 1
+	D = M
+	@LCL
+	M = D
+	@R14
+	A = M
+	0;JMP
+// function Main.square 0
+(Main.square)  // Function declaration.
+// push argument 0
+	@ARG
+	D = M
+	@0
+	A = A + D
+	D = M
+	@SP   // Pushing to stack.
+	M = M + 1
+	A = M - 1
+	M = D // Done pushing.
+// push argument 0
+	@ARG
+	D = M
+	@0
+	A = A + D
+	D = M
+	@SP   // Pushing to stack.
+	M = M + 1
+	A = M - 1
+	M = D // Done pushing.
+// call Math.multiply 2
+	@Calls.Math.multiply$ret.1
+	D = A
+	@SP   // Pushing to stack.
+	M = M + 1
+	A = M - 1
+	M = D // Done pushing.
+	@LCL
+	D = M
+	@SP   // Pushing to stack.
+	M = M + 1
+	A = M - 1
+	M = D // Done pushing.
+	@ARG
+	D = M
+	@SP   // Pushing to stack.
+	M = M + 1
+	A = M - 1
+	M = D // Done pushing.
+	@THIS
+	D = M
+	@SP   // Pushing to stack.
+	M = M + 1
+	A = M - 1
+	M = D // Done pushing.
+	@THAT
+	D = M
+	@SP   // Pushing to stack.
+	M = M + 1
+	A = M - 1
+	M = D // Done pushing.
+	@SP
+	D = M
+	@5
+	D = D - A
+	@2
+	D = D - A
+	@ARG
+	M = D
+	@SP
+	D = M
+	@LCL
+	M = D
+	@Math.multiply
+	0;JMP
+(Calls.Math.multiply$ret.1)
+// return
+	@LCL // frame = LCL
+	D = M
+	@R13
+	M = D
+	@5 // R14 = *(frame - 5)
+	D = D - A
+	A = D
+	D = M
+	@R14 // Saving return address.
+	M = D
+	@SP   // Popping from stack.
+	M = M - 1
+	A = M
+	D = M // Done popping.
+	@ARG
+	A = M
+	M = D
+	D = A + 1
+	@SP
+	M = D
+// Restoring THAT, THIS, ARG, LCL.
+	@R13
+	A = M - 1
+	D = M
+	@THAT
+	M = D
+	@R13
+	A = M - 1
+	A = A - 1
+	D = M
+	@THIS
+	M = D
+	@R13
+	A = M - 1
+	A = A - 1
+	A = A - 1
+	D = M
+	@ARG
+	M = D
+	@R13
+	A = M - 1
+	A = A - 1
+	A = A - 1
+	A = A - 1
+	D = M
+	@LCL
+	M = D
+	@R14
+	A = M
+	0;JMP
+// function Math.multiply 1
+(Math.multiply)  // Function declaration.
+	@0
+	D = A
+	@SP   // Pushing to stack.
+	M = M + 1
+	A = M - 1
+	M = D // Done pushing.
+// label LOOP
+(Calls.Math.multiply$LOOP)
+// push argument 1
+	@ARG
+	D = M
+	@1
+	A = A + D
+	D = M
+	@SP   // Pushing to stack.
+	M = M + 1
+	A = M - 1
+	M = D // Done pushing.
+// push constant 0
+	@0
+	D = A
+	@SP   // Pushing to stack.
+	M = M + 1
+	A = M - 1
+	M = D // Done pushing.
+// eq
+	@SP   // Popping from stack.
+	M = M - 1
+	A = M
+	D = M // Done popping.
+	A = A - 1
+	D = M - D
+	M = -1
+	@COMP_0
+	D;JEQ
+	@SP
+	A = M - 1
+	M = 0
+(COMP_0)
+// if-goto END
+	@SP   // Popping from stack.
+	M = M - 1
+	A = M
+	D = M // Done popping.
+	@Calls.Math.multiply$END // Conditional jump.
+	D;JNE
+// push local 0
+	@LCL
+	D = M
+	@0
+	A = A + D
+	D = M
+	@SP   // Pushing to stack.
+	M = M + 1
+	A = M - 1
+	M = D // Done pushing.
+// push argument 0
+	@ARG
+	D = M
+	@0
+	A = A + D
+	D = M
+	@SP   // Pushing to stack.
+	M = M + 1
+	A = M - 1
+	M = D // Done pushing.
+// add
+	@SP   // Popping from stack.
+	M = M - 1
+	A = M
+	D = M // Done popping.
+	A = A - 1
+	M = M + D
+// pop local 0
+	@LCL
+	D = M
+	@0
+	D = A + D
+	@R13
+	M = D
+	@SP   // Popping from stack.
+	M = M - 1
+	A = M
+	D = M // Done popping.
+	@R13
+	A = M
+	M = D
+// push argument 1
+	@ARG
+	D = M
+	@1
+	A = A + D
+	D = M
+	@SP   // Pushing to stack.
+	M = M + 1
+	A = M - 1
+	M = D // Done pushing.
+// push constant 1
+	@1
+	D = A
+	@SP   // Pushing to stack.
+	M = M + 1
+	A = M - 1
+	M = D // Done pushing.
+// sub
+	@SP   // Popping from stack.
+	M = M - 1
+	A = M
+	D = M // Done popping.
+	A = A - 1
+	M = M - D
+// pop argument 1
+	@ARG
+	D = M
+	@1
+	D = A + D
+	@R13
+	M = D
+	@SP   // Popping from stack.
+	M = M - 1
+	A = M
+	D = M // Done popping.
+	@R13
+	A = M
+	M = D
+// goto LOOP
+	@Calls.Math.multiply$LOOP
+	0;JMP
+// label END
+(Calls.Math.multiply$END)
+// push local 0
+	@LCL
+	D = M
+	@0
+	A = A + D
+	D = M
+	@SP   // Pushing to stack.
+	M = M + 1
+	A = M - 1
+	M = D // Done pushing.
+// return
+	@LCL // frame = LCL
+	D = M
+	@R13
+	M = D
+	@5 // R14 = *(frame - 5)
+	D = D - A
+	A = D
+	D = M
+	@R14 // Saving return address.
+	M = D
+	@SP   // Popping from stack.
+	M = M - 1
+	A = M
+	D = M // Done popping.
+	@ARG
+	A = M
+	M = D
+	D = A + 1
+	@SP
+	M = D
+// Restoring THAT, THIS, ARG, LCL.
+	@R13
+	A = M - 1
+	D = M
+	@THAT
+	M = D
+	@R13
+	A = M - 1
+	A = A - 1
+	D = M
+	@THIS
+	M = D
+	@R13
+	A = M - 1
+	A = A - 1
+	A = A - 1
+	D = M
+	@ARG
+	M = D
+	@R13
+	A = M - 1
+	A = A - 1
+	A = A - 1
+	A = A - 1
+	D = M
+	@LCL
+	M = D
+	@R14
+	A = M
+	0;JMP
+// ===== Final infinite loop =====
+(END_INF)
+	@END_INF
+	0;JEQ
+// Done.
\ No newline at end of file
@@ -0,0 +1,18 @@
+// Counts RAM[0] down to 0, then halts in a loop that keeps writing to RAM[1]
+// but never changes its value.
+(LOOP)
+    @0
+    D=M
+    @IDLE
+    D;JEQ
+    @0
+    M=M-1
+    @LOOP
+    0;JMP
+(IDLE)
+    @1
+    M=0
+    M=M+1
+    M=M-1
+    @IDLE
+    0;JMP
@@ -0,0 +1,329 @@
+// ===== Boostrap Start =====
+@256  // Initialise stack pointer to base of stack.
+D = A
+@SP
+M = D
+// call Sys.init 0
+	@Deep.Sys.init$ret.0
+	D = A
+	@SP   // Pushing to stack.
+	M = M + 1
+	A = M - 1
+	M = D // Done pushing.
+	@LCL
+	D = M
+	@SP   // Pushing to stack.
+	M = M + 1
+	A = M - 1
+	M = D // Done pushing.
+	@ARG
+	D = M
+	@SP   // Pushing to stack.
+	M = M + 1
+	A = M - 1
+	M = D // Done pushing.
+	@THIS
+	D = M
+	@SP   // Pushing to stack.
+	M = M + 1
+	A = M - 1
+	M = D // Done pushing.
+	@THAT
+	D = M
+	@SP   // Pushing to stack.
+	M = M + 1
+	A = M - 1
+	M = D // Done pushing.
+	@SP
+	D = M
+	@5
+	D = D - A
+	@0
+	D = D - A
+	@ARG
+	M = D
+	@SP
+	D = M
+	@LCL
+	M = D
+	@Sys.init
+	0;JMP
+(Deep.Sys.init$ret.0)
+// ===== Boostrap End =====
+// function Main.down 0
+(Main.down)  // Function declaration.
+// push argument 0
+	@ARG
+	D = M
+	@0
+	A = A + D
+	D = M
+	@SP   // Pushing to stack.
+	M = M + 1
+	A = M - 1
+	M = D // Done pushing.
+// if-goto RECURSE
+	@SP   // Popping from stack.
+	M = M - 1
+	A = M
+	D = M // Done popping.
+	@Main.Main.down$RECURSE // Conditional jump.
+	D;JNE
+// push constant 0
+	@0
+	D = A
+	@SP   // Pushing to stack.
+	M = M + 1
+	A = M - 1
+	M = D // Done pushing.
+// return
+	@LCL // frame = LCL
+	D = M
+	@R13
+	M = D
+	@5 // R14 = *(frame - 5)
+	D = D - A
+	A = D
+	D = M
+	@R14 // Saving return address.
+	M = D
+	@SP   // Popping from stack.
+	M = M - 1
+	A = M
+	D = M // Done popping.
+	@ARG
+	A = M
+	M = D
+	D = A + 1
+	@SP
+	M = D
+// Restoring THAT, THIS, ARG, LCL.
+	@R13
+	A = M - 1
+	D = M
+	@THAT
+	M = D
+	@R13
+	A = M - 1
+	A = A - 1
+	D = M
+	@THIS
+	M = D
+	@R13
+	A = M - 1
+	A = A - 1
+	A = A - 1
+	D = M
+	@ARG
+	M = D
+	@R13
+	A = M - 1
+	A = A - 1
+	A = A - 1
+	A = A - 1
+	D = M
+	@LCL
+	M = D
+	@R14
+	A = M
+	0;JMP
+// label RECURSE
+(Main.Main.down$RECURSE)
+// push argument 0
+	@ARG
+	D = M
+	@0
+	A = A + D
+	D = M
+	@SP   // Pushing to stack.
+	M = M + 1
+	A = M - 1
+	M = D // Done pushing.
+// push constant 1
+	@1
+	D = A
+	@SP   // Pushing to stack.
+	M = M + 1
+	A = M - 1
+	M = D // Done pushing.
+// sub
+	@SP   // Popping from stack.
+	M = M - 1
+	A = M
+	D = M // Done popping.
+	A = A - 1
+	M = M - D
+// call Main.down 1
+	@Main.Main.down$ret.1
+	D = A
+	@SP   // Pushing to stack.
+	M = M + 1
+	A = M - 1
+	M = D // Done pushing.
+	@LCL
+	D = M
+	@SP   // Pushing to stack.
+	M = M + 1
+	A = M - 1
+	M = D // Done pushing.
+	@ARG
+	D = M
+	@SP   // Pushing to stack.
+	M = M + 1
+	A = M - 1
+	M = D // Done pushing.
+	@THIS
+	D = M
+	@SP   // Pushing to stack.
+	M = M + 1
+	A = M - 1
+	M = D // Done pushing.
+	@THAT
+	D = M
+	@SP   // Pushing to stack.
+	M = M + 1
+	A = M - 1
+	M = D // Done pushing.
+	@SP
+	D = M
+	@5
+	D = D - A
+	@1
+	D = D - A
+	@ARG
+	M = D
+	@SP
+	D = M
+	@LCL
+	M = D
+	@Main.down
+	0;JMP
+(Main.Main.down$ret.1)
+// return
+	@LCL // frame = LCL
+	D = M
+	@R13
+	M = D
+	@5 // R14 = *(frame - 5)
+	D = D - A
+	A = D
+	D = M
+	@R14 // Saving return address.
+	M = D
+	@SP   // Popping from stack.
+	M = M - 1
+	A = M
+	D = M // Done popping.
+	@ARG
+	A = M
+	M = D
+	D = A + 1
+	@SP
+	M = D
+// Restoring THAT, THIS, ARG, LCL.
+	@R13
+	A = M - 1
+	D = M
+	@THAT
+	M = D
+	@R13
+	A = M - 1
+	A = A - 1
+	D = M
+	@THIS
+	M = D
+	@R13
+	A = M - 1
+	A = A - 1
+	A = A - 1
+	D = M
+	@ARG
+	M = D
+	@R13
+	A = M - 1
+	A = A - 1
+	A = A - 1
+	A = A - 1
+	D = M
+	@LCL
+	M = D
+	@R14
+	A = M
+	0;JMP
+// function Sys.init 0
+(Sys.init)  // Function declaration.
+// push constant 300
+	@300
+	D = A
+	@SP   // Pushing to stack.
+	M = M + 1
+	A = M - 1
+	M = D // Done pushing.
+// call Main.down 1
+	@Sys.Main.down$ret.1
+	D = A
+	@SP   // Pushing to stack.
+	M = M + 1
+	A = M - 1
+	M = D // Done pushing.
+	@LCL
+	D = M
+	@SP   // Pushing to stack.
+	M = M + 1
+	A = M - 1
+	M = D // Done pushing.
+	@ARG
+	D = M
+	@SP   // Pushing to stack.
+	M = M + 1
+	A = M - 1
+	M = D // Done pushing.
+	@THIS
+	D = M
+	@SP   // Pushing to stack.
+	M = M + 1
+	A = M - 1
+	M = D // Done pushing.
+	@THAT
+	D = M
+	@SP   // Pushing to stack.
+	M = M + 1
+	A = M - 1
+	M = D // Done pushing.
+	@SP
+	D = M
+	@5
+	D = D - A
+	@1
+	D = D - A
+	@ARG
+	M = D
+	@SP
+	D = M
+	@LCL
+	M = D
+	@Main.down
+	0;JMP
+(Sys.Main.down$ret.1)
+// pop temp 0
+	@5
+	D = A
+	@R13
+	M = D
+	@SP   // Popping from stack.
+	M = M - 1
+	A = M
+	D = M // Done popping.
+	@R13
+	A = M
+	M = D
+// label HALT
+(Sys.Sys.init$HALT)
+// goto HALT
+	@Sys.Sys.init$HALT
+	0;JMP
+// ===== Final infinite loop =====
+(END_INF)
+	@END_INF
+	0;JEQ
+// Done.
\ No newline at end of file
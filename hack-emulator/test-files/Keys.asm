@@ -0,0 +1,25 @@
+// Waits for a key, stores its code in RAM[0] and counts the press in RAM[1],
+// then waits for it to be released. Stops after ESC (140) is released.
+(WAIT_PRESS)
+    @KBD
+    D=M
+    @WAIT_PRESS
+    D;JEQ
+    @0
+    M=D
+    @1
+    M=M+1
+(WAIT_RELEASE)
+    @KBD
+    D=M
+    @WAIT_RELEASE
+    D;JNE
+    @0
+    D=M
+    @140
+    D=D-A
+    @WAIT_PRESS
+    D;JNE
+(END)
+    @END
+    0;JMP
@@ -0,0 +1,17 @@
+// Runs Max.asm on two pairs of numbers.
+
+load Max.asm,
+compare-to Max.cmp,
+output-list RAM[0]%D2.6.2 RAM[1]%D2.6.2 RAM[2]%D2.6.2;
+
+set RAM[0] 3, set RAM[1] 17;
+repeat 1000 {
+  ticktock;
+}
+output;
+
+set PC 0, set RAM[0] -5, set RAM[1] %B1111111111111000;
+while PC <> 14 {
+  ticktock;
+}
+output;
@@ -0,0 +1,11 @@
+// Blackens the top-left 16 pixels and the bottom-right word's leftmost pixel,
+// then draws the top-left word again without changing it.
+    @SCREEN
+    M=-1
+    @24575
+    M=1
+    @SCREEN
+    M=-1
+(END)
+    @END
+    0;JMP
@@ -1,6 +1,5 @@
 #include "AsmMapper.h"
 #include <iostream>
-#include <fstream>
 #include <unordered_map>
 #include <string>
 
@@ -18,6 +17,7 @@ std::unordered_map<std::string, std::string> AsmMapper::_init_segment_addr_regis
 
 std::string AsmMapper::_constant_segment = "constant";
 std::string AsmMapper::_pointer_segment = "pointer";
+std::string AsmMapper::_named_segment = "named";
 
 std::unordered_map<std::string, const char> AsmMapper::_arithmetic_logical_binary_op = {
     {"add", '+'},
@@ -31,19 +31,33 @@ std::unordered_map<std::string, const char> AsmMapper::_arithmetic_logical_unary
     {"neg", '-'}
 };
 
+std::unordered_map<std::string, std::string> AsmMapper::_branch_comparison_op = {
+    {"eq", "JEQ"},
+    {"gt", "JGT"},
+    {"lt", "JLT"},
+    {"ne", "JNE"},
+    {"le", "JLE"},
+    {"ge", "JGE"}
+};
+
+std::unordered_map<std::string, const char> AsmMapper::_increment_op = {
+    {"inc", '+'},
+    {"dec", '-'}
+};
+
 std::unordered_map<std::string, std::string> AsmMapper::_comparison_op = {
     {"eq", "JEQ"},
     {"gt", "JGT"},
     {"lt", "JLT"}
 };
 
-AsmMapper::AsmMapper(const std::string& asm_output_file_path, const std::string& translation_unit_name)
-        : _asm_out(std::ofstream(asm_output_file_path)) {
+AsmMapper::AsmMapper(std::ostream& asm_out, const std::string& translation_unit_name)
+        : _asm_out(asm_out), _symbols(nullptr), _shared_call_routines(false), _top_of_stack_caching(false),
+          _is_top_in_d(false) {
     start_new_translation_unit(translation_unit_name);
 }
 
 void AsmMapper::start_new_translation_unit(const std::string& translation_unit_name) {
-    // Initialise new .asm output stream.
     _trans_unit_name = translation_unit_name;
     _label_count = 0;
 }
@@ -67,6 +81,8 @@ void AsmMapper::start_new_translation_unit(const std::string& translation_unit_n
  *      @SP
  *      A = M - 1
  *      M = op M
+ *
+ * The fused `inc` and `dec` ops write M = M + 1 or M = M - 1 the same way.
  * 
  * Comparison operators:
  * 1. First decrement sp by performing sp--
@@ -77,15 +93,20 @@ void AsmMapper::start_new_translation_unit(const std::string& translation_unit_n
  *      A = A - 1   // Look up RAM[sp - 2], which is where first operand `a` is.
  *      D = M - D   // a - b
  *      M = -1      // Write 'true' to where 'a' is.
- *      @COMP_i     
+ *      @COMP_unit_i
  *      D;JEQ       // if a - b == 0, then leave the result as true. We change JEQ to JLT or JGT depending on the comparison operator.
  *      M = 0
- *  (COMP_i) 
+ *  (COMP_unit_i)   // Qualified by the translation unit so that each file's labels stay distinct.
  *      ...
  */
 void AsmMapper::write_arithmetic(const std::string& command) {
     _asm_out << "// " << command << "\n";
 
+    if (_top_of_stack_caching) {
+        write_arithmetic_on_d(command);
+        return;
+    }
+
     if (_arithmetic_logical_binary_op.find(command) != _arithmetic_logical_binary_op.end()) {
         // Binary arithmetic/logic operation.
         const char op_character = _arithmetic_logical_binary_op[command];
@@ -98,24 +119,117 @@ void AsmMapper::write_arithmetic(const std::string& command) {
         _asm_out << "\t@SP\n" 
                  << "\tA = M - 1\n"
                  << "\tM = " << op_character << "M\n";
+    } else if (_increment_op.find(command) != _increment_op.end()) {
+        const char op_character = _increment_op[command];
+        _asm_out << "\t@SP\n"
+                 << "\tA = M - 1\n"
+                 << "\tM = M " << op_character << " 1\n";
     } else if (_comparison_op.find(command) != _comparison_op.end()) {
         // Comparison operation.
         const std::string jump_instr = _comparison_op[command];
+        const std::string comp_label = "COMP_" + _trans_unit_name + "_" + std::to_string(_label_count++);
         pop_from_stack();             // D contains first operand.
         _asm_out << "\tA = A - 1\n"   // M contains second operand.
                  << "\tD = M - D\n"
                  << "\tM = -1\n"
-                 << "\t@COMP_" << _label_count << "\n"
+                 << "\t@" << comp_label << "\n"
                  << "\tD;" << jump_instr << "\n"
                  << "\t@SP\n"
                  << "\tA = M - 1\n"
                  << "\tM = 0\n"
-                 << "(COMP_" << _label_count++ << ")\n";
+                 << "(" << comp_label << ")\n";
+    } else {
+        std::cerr << "Syntax Error: unknown arithmetic command '" << command << "', len: " << command.size() << "\n";
+    }
+}
+
+/**
+ * With the top of the stack held in D, the second operand is the only one
+ * left in RAM, and the result stays in D:
+ *      @SP
+ *      AM = M - 1
+ *      D = M op D
+ *
+ * Comparisons branch on a - b to set D to true or false:
+ *      D = M - D
+ *      @COMP_unit_i
+ *      D;JEQ
+ *      D = 0
+ *      @COMP_unit_i_END
+ *      0;JMP
+ *  (COMP_unit_i)
+ *      D = -1
+ *  (COMP_unit_i_END)
+ */
+void AsmMapper::write_arithmetic_on_d(const std::string& command) {
+    if (_arithmetic_logical_binary_op.find(command) != _arithmetic_logical_binary_op.end()) {
+        const char op_character = _arithmetic_logical_binary_op[command];
+        load_top_of_stack();
+        _asm_out << "\t@SP\n"
+                 << "\tAM = M - 1\n"
+                 << "\tD = M " << op_character << " D\n";
+    } else if (_arithmetic_logical_unary_op.find(command) != _arithmetic_logical_unary_op.end()) {
+        const char op_character = _arithmetic_logical_unary_op[command];
+        load_top_of_stack();
+        _asm_out << "\tD = " << op_character << "D\n";
+    } else if (_increment_op.find(command) != _increment_op.end()) {
+        const char op_character = _increment_op[command];
+        load_top_of_stack();
+        _asm_out << "\tD = D " << op_character << " 1\n";
+    } else if (_comparison_op.find(command) != _comparison_op.end()) {
+        const std::string jump_instr = _comparison_op[command];
+        const std::string comp_label = "COMP_" + _trans_unit_name + "_" + std::to_string(_label_count++);
+        load_top_of_stack();
+        _asm_out << "\t@SP\n"
+                 << "\tAM = M - 1\n"
+                 << "\tD = M - D\n"
+                 << "\t@" << comp_label << "\n"
+                 << "\tD;" << jump_instr << "\n"
+                 << "\tD = 0\n"
+                 << "\t@" << comp_label << "_END\n"
+                 << "\t0;JMP\n"
+                 << "(" << comp_label << ")\n"
+                 << "\tD = -1\n"
+                 << "(" << comp_label << "_END)\n";
     } else {
         std::cerr << "Syntax Error: unknown arithmetic command '" << command << "', len: " << command.size() << "\n";
     }
 }
 
+void AsmMapper::use_symbol_table(const std::vector<std::string>& symbols) {
+    _symbols = &symbols;
+}
+
+void AsmMapper::use_top_of_stack_caching(const bool& enabled) {
+    _top_of_stack_caching = enabled;
+}
+
+void AsmMapper::end_translation_unit() {
+    spill_top_of_stack();
+}
+
+void AsmMapper::push_d() {
+    if (_top_of_stack_caching) {
+        _is_top_in_d = true;
+    } else {
+        push_to_stack();
+    }
+}
+
+void AsmMapper::spill_top_of_stack() {
+    if (!_is_top_in_d) return;
+    push_to_stack();
+    _is_top_in_d = false;
+}
+
+void AsmMapper::load_top_of_stack() {
+    if (_is_top_in_d) return;
+    _asm_out << "\t@SP\n"
+             << "\tAM = M - 1\n"
+             << "\tD = M\n";
+    _is_top_in_d = true;
+}
+
 void AsmMapper::push_to_stack() {
     _asm_out << "\t@SP   // Pushing to stack.\n"
              << "\tM = M + 1\n"
@@ -168,7 +282,11 @@ void AsmMapper::pop_from_stack() {
 void AsmMapper::write_push(const std::string& command,
         const std::string& segment, const int& index) {
     _asm_out << "// " << command << "\n";
+    spill_top_of_stack();
+    if (read_segment_into_d(segment, index)) push_d();
+}
 
+bool AsmMapper::read_segment_into_d(const std::string& segment, const int& index) {
     if (_predef_segment_base_addresses.find(segment) != _predef_segment_base_addresses.end()) {
         if (segment == "static") {
             // Symbol names get resolved to a memory address in the static segment.
@@ -180,7 +298,6 @@ void AsmMapper::write_push(const std::string& command,
             _asm_out << "\t@" << segment_base_addr + index << "\n"
                      << "\tD = M\n";
         }
-        push_to_stack();
     } else if (_init_segment_addr_registers.find(segment) != _init_segment_addr_registers.end()) {
         const std::string segment_register = _init_segment_addr_registers[segment];
         _asm_out << "\t@" << segment_register << "\n"
@@ -188,20 +305,31 @@ void AsmMapper::write_push(const std::string& command,
                  << "\t@" << index << "\n"
                  << "\tA = A + D\n"
                  << "\tD = M\n";
-        push_to_stack();
     } else if (segment == _constant_segment) {
-        _asm_out << "\t@" << index << "\n"
-                 << "\tD = A\n";
-        push_to_stack();
+        // Negative constants only come from the peephole optimiser folding a
+        // `neg` into the push.
+        if (index == -1) {
+            _asm_out << "\tD = -1\n";
+        } else if (index < 0) {
+            _asm_out << "\t@" << -index << "\n"
+                     << "\tD = -A\n";
+        } else {
+            _asm_out << "\t@" << index << "\n"
+                     << "\tD = A\n";
+        }
     } else if (segment == _pointer_segment) {
         // Retrieve value directly from the `this` or `that` register.
         const std::string this_or_that = (index == 0) ? _init_segment_addr_registers["this"] : _init_segment_addr_registers["that"];
         _asm_out << "\t@" << this_or_that << "\n"
                  << "\tD = M\n";
-        push_to_stack();
+    } else if (segment == _named_segment && _symbols) {
+        _asm_out << "\t@" << (*_symbols)[index] << "\n"
+                 << "\tD = M\n";
     } else {
         std::cerr << "Syntax Error: unknown segment '" << segment << "'\n";
+        return false;
     }
+    return true;
 }
 
 /**
@@ -227,6 +355,12 @@ void AsmMapper::write_pop(const std::string& command,
         const std::string& segment,
         const int& index) {
     _asm_out << "// " << command << "\n";
+    if (_top_of_stack_caching) {
+        load_top_of_stack();
+        write_d_to_segment(segment, index);
+        _is_top_in_d = false;
+        return;
+    }
     if (_predef_segment_base_addresses.find(segment) != _predef_segment_base_addresses.end()) {
         if (segment == "static") {
             const std::string symbol_name = _trans_unit_name + "_" + std::to_string(index);
@@ -262,13 +396,70 @@ void AsmMapper::write_pop(const std::string& command,
         pop_from_stack();
         _asm_out << "\t@" << this_or_that << "\n"
                  << "\tM = D\n";
+    } else if (segment == _named_segment && _symbols) {
+        pop_from_stack();
+        _asm_out << "\t@" << (*_symbols)[index] << "\n"
+                 << "\tM = D\n";
     } else {
         std::cerr << "Syntax Error: unknown segment '" << segment << "'\n";
     }
 }
 
+/**
+ * With the value to store in D, the address of `segment[index]` has to be
+ * formed in A alone. Near the base of a segment, that's
+ *      @segmentReg
+ *      A = M + 1
+ *      A = A + 1   // index - 1 times
+ *      M = D
+ * Further in, D is parked in R13 while the address is worked out as usual.
+ */
+bool AsmMapper::write_d_to_segment(const std::string& segment, const int& index) {
+    if (_predef_segment_base_addresses.find(segment) != _predef_segment_base_addresses.end()) {
+        const std::string address = (segment == "static")
+            ? _trans_unit_name + "_" + std::to_string(index)
+            : std::to_string(_predef_segment_base_addresses[segment] + index);
+        _asm_out << "\t@" << address << "\n"
+                 << "\tM = D\n";
+    } else if (_init_segment_addr_registers.find(segment) != _init_segment_addr_registers.end()) {
+        const std::string segment_register = _init_segment_addr_registers[segment];
+        if (index <= _max_stepped_pop_index) {
+            _asm_out << "\t@" << segment_register << "\n"
+                     << (index == 0 ? "\tA = M\n" : "\tA = M + 1\n");
+            for (int i = 1; i < index; ++i) _asm_out << "\tA = A + 1\n";
+        } else {
+            _asm_out << "\t@R13\n"
+                     << "\tM = D\n"
+                     << "\t@" << segment_register << "\n"
+                     << "\tD = M\n"
+                     << "\t@" << index << "\n"
+                     << "\tD = D + A\n"
+                     << "\t@R14\n"
+                     << "\tM = D\n"
+                     << "\t@R13\n"
+                     << "\tD = M\n"
+                     << "\t@R14\n"
+                     << "\tA = M\n";
+        }
+        _asm_out << "\tM = D\n";
+    } else if (segment == _pointer_segment) {
+        const std::string this_or_that = (index == 0) ? _init_segment_addr_registers["this"] : _init_segment_addr_registers["that"];
+        _asm_out << "\t@" << this_or_that << "\n"
+                 << "\tM = D\n";
+    } else if (segment == _named_segment && _symbols) {
+        _asm_out << "\t@" << (*_symbols)[index] << "\n"
+                 << "\tM = D\n";
+    } else {
+        std::cerr << "Syntax Error: unknown segment '" << segment << "'\n";
+        return false;
+    }
+    return true;
+}
+
 void AsmMapper::write_label(const std::string& command, const std::string& label, const std::string& function_name) {
     _asm_out << "// " << command << "\n";
+    // Jumps arrive with the whole stack in RAM.
+    spill_top_of_stack();
     if (function_name.empty()) {
         const std::string label_name = _trans_unit_name + "." + label;
         _asm_out << "(" << label_name << ")\n";
@@ -281,6 +472,7 @@ void AsmMapper::write_label(const std::string& command, const std::string& label
 void AsmMapper::write_goto(const std::string& command, const std::string& label, const std::string& function_name) {
     _asm_out << "// " << command << "\n";
     const std::string dest_name = get_dest_name(label, function_name);
+    spill_top_of_stack();
     _asm_out << "\t@"  << dest_name << "\n" 
                 << "\t0;JMP\n";
 }
@@ -288,25 +480,127 @@ void AsmMapper::write_goto(const std::string& command, const std::string& label,
 void AsmMapper::write_if(const std::string& command, const std::string& label, const std::string& function_name) {
     _asm_out << "// " << command << "\n";
     const std::string dest_name = get_dest_name(label, function_name);
-    pop_from_stack();
+    if (_top_of_stack_caching) {
+        load_top_of_stack();
+        _is_top_in_d = false;
+    } else {
+        pop_from_stack();
+    }
     _asm_out << "\t@" << dest_name << " // Conditional jump.\n"
              << "\tD;JNE\n";
 }
 
+void AsmMapper::write_if_not(const std::string& command, const std::string& label, const std::string& function_name) {
+    _asm_out << "// " << command << "\n";
+    const std::string dest_name = get_dest_name(label, function_name);
+    if (_top_of_stack_caching) {
+        load_top_of_stack();
+        _is_top_in_d = false;
+    } else {
+        pop_from_stack();
+    }
+    // `not` only gives 0 for -1, so this jumps unless D + 1 == 0.
+    _asm_out << "\tD = D + 1\n"
+             << "\t@" << dest_name << " // Conditional jump.\n"
+             << "\tD;JNE\n";
+}
+
+/**
+ * Pops both operands and branches on a - b, without writing the boolean that
+ * `lt` and the like would, eg. for `if-lt-goto L`:
+ *      @SP
+ *      AM = M - 1
+ *      D = M       // b
+ *      @SP
+ *      AM = M - 1
+ *      D = M - D   // a - b
+ *      @L
+ *      D;JLT
+ */
+void AsmMapper::write_compare_and_branch(const std::string& command, const std::string& comparison,
+        const std::string& label, const std::string& function_name) {
+    _asm_out << "// " << command << "\n";
+    if (_branch_comparison_op.find(comparison) == _branch_comparison_op.end()) {
+        std::cerr << "Syntax Error: unknown comparison '" << comparison << "'\n";
+        return;
+    }
+    const std::string dest_name = get_dest_name(label, function_name);
+    if (_top_of_stack_caching) {
+        load_top_of_stack();
+        _is_top_in_d = false;
+    } else {
+        _asm_out << "\t@SP\n"
+                 << "\tAM = M - 1\n"
+                 << "\tD = M\n";
+    }
+    _asm_out << "\t@SP\n"
+             << "\tAM = M - 1\n"
+             << "\tD = M - D\n"
+             << "\t@" << dest_name << " // Conditional jump.\n"
+             << "\tD;" << _branch_comparison_op[comparison] << "\n";
+}
+
+/**
+ * Reads `segment[index]` into D and writes it straight to
+ * `target_segment[target_index]`, eg. for `move static 0 local 1`:
+ *      @Unit_0
+ *      D = M
+ *      @LCL
+ *      A = M + 1
+ *      M = D
+ */
+void AsmMapper::write_move(const std::string& command, const std::string& segment, const int& index,
+        const std::string& target_segment, const int& target_index) {
+    _asm_out << "// " << command << "\n";
+    spill_top_of_stack();
+    if (read_segment_into_d(segment, index)) write_d_to_segment(target_segment, target_index);
+}
+
 void AsmMapper::write_function(const std::string& command, const std::string& function_name, const int& num_local_vars) {
     _asm_out << "// " << command << "\n";
 
     // Create label and push to the stack `num_local_vars` local variables whose
     // values are 0.
+    spill_top_of_stack();
     _asm_out << "(" << function_name << ")  // Function declaration.\n";
     for (int i = 0; i < num_local_vars; ++i)
         push_to_stack(0, true);
 }
 
+void AsmMapper::use_shared_call_routines(const bool& enabled) {
+    _shared_call_routines = enabled;
+}
+
 void AsmMapper::write_call(const std::string& command, const std::string& target_function_name, const int& num_args, const int& return_counter) {
     _asm_out << "// " << command << "\n";
     
     const std::string return_label = _trans_unit_name + "." + target_function_name + "$ret." + std::to_string(return_counter);
+    spill_top_of_stack();
+
+    if (_shared_call_routines) {
+        // R13 = num_args, R14 = callee, D = return address. `$$CALL` does the
+        // rest.
+        if (num_args == 0 || num_args == 1) {
+            // Methods with no other arguments take 1, so this is common.
+            _asm_out << "\t@R13\n"
+                     << "\tM = " << num_args << "\n";
+        } else {
+            _asm_out << "\t@" << num_args << "\n"
+                     << "\tD = A\n"
+                     << "\t@R13\n"
+                     << "\tM = D\n";
+        }
+        _asm_out << "\t@" << target_function_name << "\n"
+                 << "\tD = A\n"
+                 << "\t@R14\n"
+                 << "\tM = D\n"
+                 << "\t@" << return_label << "\n"
+                 << "\tD = A\n"
+                 << "\t@$$CALL\n"
+                 << "\t0;JMP\n"
+                 << "(" << return_label << ")\n";
+        return;
+    }
 
     // Save return address that the callee returns to.
     push_to_stack(return_label, true);
@@ -346,6 +640,14 @@ void AsmMapper::write_call(const std::string& command, const std::string& target
 
 void AsmMapper::write_return(const std::string& command, const std::string& function_name) {
     _asm_out << "// " << command << "\n";
+    // Finding the frame needs D, so the return value goes back to the stack.
+    spill_top_of_stack();
+
+    if (_shared_call_routines) {
+        _asm_out << "\t@$$RETURN\n"
+                 << "\t0;JMP\n";
+        return;
+    }
 
     // Save R13 = LCL (ie. int frame = LCL address).
     _asm_out << "\t@LCL // frame = LCL\n"
@@ -415,21 +717,101 @@ void AsmMapper::write_inf_loop() {
     _asm_out << "// ===== Final infinite loop =====\n";
     _asm_out << "(END_INF)\n"
              << "\t@END_INF\n"
-             << "\t0;JEQ\n"
-             << "// Done.";
+             << "\t0;JEQ\n";
+    if (_shared_call_routines) write_shared_call_routines();
+    _asm_out << "// Done.";
 }
 
-void AsmMapper::write_bootstrap_init() {
+/**
+ * The shared routines do the same as the code `write_call` and `write_return`
+ * otherwise inline, using AM = M +/- 1 to step SP and the saved frame pointer
+ * in one instruction.
+ *
+ * $$CALL expects R13 = num_args, R14 = the callee's address and D = the return
+ * address:
+ *      push D, LCL, ARG, THIS, THAT
+ *      ARG = SP - 5 - R13
+ *      LCL = SP
+ *      goto R14
+ *
+ * $$RETURN:
+ *      R13 = LCL (frame), R14 = *(frame - 5) (return address)
+ *      *ARG = pop(), SP = ARG + 1
+ *      THAT = *--R13, THIS = *--R13, ARG = *--R13, LCL = *--R13
+ *      goto R14
+ */
+void AsmMapper::write_shared_call_routines() {
+    _asm_out << "// ===== Shared call/return routines =====\n";
+    _asm_out << "($$CALL)\n"
+             << "\t@SP\n"
+             << "\tAM = M + 1\n"
+             << "\tA = A - 1\n"
+             << "\tM = D\n";          // Pushed the return address.
+    for (const std::string segment_register : { "LCL", "ARG", "THIS", "THAT" }) {
+        _asm_out << "\t@" << segment_register << "\n"
+                 << "\tD = M\n"
+                 << "\t@SP\n"
+                 << "\tAM = M + 1\n"
+                 << "\tA = A - 1\n"
+                 << "\tM = D\n";
+    }
+    _asm_out << "\t@SP\n"
+             << "\tD = M\n"
+             << "\t@LCL\n"
+             << "\tM = D\n"          // LCL = SP.
+             << "\t@5\n"
+             << "\tD = D - A\n"
+             << "\t@R13\n"
+             << "\tD = D - M\n"
+             << "\t@ARG\n"
+             << "\tM = D\n"          // ARG = SP - 5 - num_args.
+             << "\t@R14\n"
+             << "\tA = M\n"
+             << "\t0;JMP\n";
+
+    _asm_out << "($$RETURN)\n"
+             << "\t@LCL\n"
+             << "\tD = M\n"
+             << "\t@R13\n"
+             << "\tM = D\n"          // R13 = frame.
+             << "\t@5\n"
+             << "\tA = D - A\n"
+             << "\tD = M\n"
+             << "\t@R14\n"
+             << "\tM = D\n"          // R14 = return address.
+             << "\t@SP\n"
+             << "\tAM = M - 1\n"
+             << "\tD = M\n"
+             << "\t@ARG\n"
+             << "\tA = M\n"
+             << "\tM = D\n"          // *ARG = return value.
+             << "\tD = A + 1\n"
+             << "\t@SP\n"
+             << "\tM = D\n";         // SP = ARG + 1.
+    for (const std::string segment_register : { "THAT", "THIS", "ARG", "LCL" }) {
+        _asm_out << "\t@R13\n"
+                 << "\tAM = M - 1\n"
+                 << "\tD = M\n"
+                 << "\t@" << segment_register << "\n"
+                 << "\tM = D\n";
+    }
+    _asm_out << "\t@R14\n"
+             << "\tA = M\n"
+             << "\t0;JMP\n";
+}
+
+void AsmMapper::write_bootstrap_init(const bool& call_sys_init) {
+    // Without Sys.init, the stack starts where it would after the call to
+    // Sys.init had pushed its frame.
     _asm_out << "// ===== Boostrap Start =====\n"
-             << "@261  // Initialise stack pointer to base of stack.\n"
+             << (call_sys_init ? "@256" : "@261") << "  // Initialise stack pointer to base of stack.\n"
              << "D = A\n"
              << "@SP\n"
-             << "M = D\n"
-             << "// ===== Boostrap End =====\n";
-}
-
-void AsmMapper::close() {
-    _asm_out.close();
+             << "M = D\n";
+    // No call in a translation unit is numbered 0, so this return label can't
+    // collide with theirs.
+    if (call_sys_init) write_call("call Sys.init 0", "Sys.init", 0, 0);
+    _asm_out << "// ===== Boostrap End =====\n";
 }
 
 std::string AsmMapper::get_dest_name(const std::string& label, const std::string& function_name) {
@@ -2,24 +2,24 @@
 #define ASM_MAPPER_H
 
 #include <string>
-#include <fstream>
+#include <ostream>
 #include <unordered_map>
 #include <unordered_set>
+#include <vector>
 
 class AsmMapper {
 public:
     /**
-     * Opens a file output stream for writing the translated VM instructions to.
-     * Expects the output file path to have the .asm extension.
+     * Writes the translated VM instructions to the given stream, eg. an .asm
+     * file or a buffer for one translation unit.
      * The translation unit name should be the basename of the source file in
      * most cases.
      */
-    explicit AsmMapper(const std::string& asm_output_file_path,
-        const std::string& translation_unit_name);
+    explicit AsmMapper(std::ostream& asm_out, const std::string& translation_unit_name);
 
     /**
-     * Opens a new write `ofstream` for a new .vm input file. Closes the current
-     * `ofstream`.
+     * Starts writing the instructions of a new .vm input file. Labels stay
+     * unique across translation units as long as their names differ.
      */
     void start_new_translation_unit(const std::string& translation_unit_name);
 
@@ -61,6 +61,28 @@ public:
      */
     void write_if(const std::string& command, const std::string& label, const std::string& function_name);
 
+    /**
+     * Writes the Hack assembly code for the fused `not; if-goto`, which jumps
+     * unless the item at the top of the stack is -1 (true).
+     */
+    void write_if_not(const std::string& command, const std::string& label, const std::string& function_name);
+
+    /**
+     * Writes the Hack assembly code for a comparison fused with the `if-goto`
+     * that tests it. `comparison` is one of eq, gt, lt, ne, le and ge, and the
+     * jump is taken if it holds between the two items at the top of the stack.
+     */
+    void write_compare_and_branch(const std::string& command, const std::string& comparison,
+        const std::string& label, const std::string& function_name);
+
+    /**
+     * Writes the Hack assembly code for the fused `push segment index; pop
+     * target_segment target_index`, which copies the value without going
+     * through the stack.
+     */
+    void write_move(const std::string& command, const std::string& segment, const int& index,
+        const std::string& target_segment, const int& target_index);
+
     /**
      * Writes the corresponding Hack assembly code for declaring a new function.
      */
@@ -81,22 +103,51 @@ public:
     void write_return(const std::string& command, const std::string& function_name);
 
     /**
-     * Inserts a final infinite loop at the end of the Hack assembly program.
+     * Inserts a final infinite loop at the end of the Hack assembly program,
+     * followed by the shared call and return routines if they're used.
      */
     void write_inf_loop();
 
     /**
-     * Inserts the bootstrapping code for initialising special registers.
+     * Makes `call` and `return` jump to one shared `$$CALL` and `$$RETURN`
+     * routine instead of inlining the frame handling at every site. This costs
+     * a few cycles per call, but shrinks programs linked with the OS enough to
+     * fit in the ROM. Every `AsmMapper` writing into the same program must
+     * agree on this.
+     */
+    void use_shared_call_routines(const bool& enabled);
+
+    /**
+     * Inserts the bootstrapping code for initialising special registers. If
+     * `call_sys_init` is set, it also calls `Sys.init`, otherwise execution
+     * falls through to the first translated instruction.
+     */
+    void write_bootstrap_init(const bool& call_sys_init);
+
+    /**
+     * Keeps the top of the stack in D between VM instructions instead of
+     * storing it to RAM after every push and loading it back for the next
+     * instruction. The value is only stored when something else needs D, and
+     * at labels, calls and returns, where the whole stack is always in RAM.
      */
-    void write_bootstrap_init();
+    void use_top_of_stack_caching(const bool& enabled);
 
     /**
-     * Closes the output file stream.
+     * Sets the names of the variables in the `named` segment, which only the
+     * translator's own passes use: `named i` is the RAM variable called
+     * `symbols[i]`. The symbols must outlive the mapper's use of them.
      */
-    void close();
+    void use_symbol_table(const std::vector<std::string>& symbols);
+
+    /**
+     * Stores the top of the stack if it's still held in D. Call this after the
+     * last instruction of a translation unit.
+     */
+    void end_translation_unit();
+
 private:
-    // Hack assembly file output stream (write mode).
-    std::ofstream _asm_out;
+    // Hack assembly output stream.
+    std::ostream& _asm_out;
     std::string _trans_unit_name;
 
     // Pre-defined segments: static and temp.
@@ -119,15 +170,37 @@ private:
     // Pointer segment: pointer
     static std::string _pointer_segment;
 
+    // Named segment: RAM variables named by `_symbols`.
+    static std::string _named_segment;
+    const std::vector<std::string>* _symbols;
+
     // VM instruction to Hack instruction/operator maps.
     static std::unordered_map<std::string, const char> _arithmetic_logical_binary_op;
     static std::unordered_map<std::string, const char> _arithmetic_logical_unary_op;
     static std::unordered_map<std::string, std::string> _comparison_op;
 
+    // The conditions fused compare-and-branch ops jump on.
+    static std::unordered_map<std::string, std::string> _branch_comparison_op;
+
+    // The fused `inc` and `dec` ops.
+    static std::unordered_map<std::string, const char> _increment_op;
+
     // For comparison ops, we need to create a label to jump to and we must not
     // create name collisions.
     int _label_count;
 
+    // Whether calls and returns go through `$$CALL` and `$$RETURN`.
+    bool _shared_call_routines;
+
+    // Whether the top of the stack may be held in D, and whether it currently
+    // is. While it is, SP points at where it would be stored.
+    bool _top_of_stack_caching;
+    bool _is_top_in_d;
+
+    // Pops from D into segments addressed through a register step A to the
+    // address up to this index, which is shorter than computing it.
+    static constexpr int _max_stepped_pop_index = 9;
+
     // Writes the assembly code necessary to push the contents of D onto the stack.
     void push_to_stack();
     
@@ -138,11 +211,30 @@ private:
     void push_to_stack(const T& value, const bool& use_register_a);
 
 
+    // Pushes D, or with top-of-stack caching just marks the top as held in D.
+    void push_d();
+
+    // With top-of-stack caching, stores the top of the stack if it's in D, or
+    // loads it into D if it isn't.
+    void spill_top_of_stack();
+    void load_top_of_stack();
+
+    // The top-of-stack caching version of `write_arithmetic`.
+    void write_arithmetic_on_d(const std::string& command);
+
+    // Write the code to read `segment[index]` into D, or to write D to it.
+    // Both report unknown segments and return false for them.
+    bool read_segment_into_d(const std::string& segment, const int& index);
+    bool write_d_to_segment(const std::string& segment, const int& index);
+
     // Writes the assembly code necessary to pop a value from the stack into D.
     // After invocation, the A register will be set to SP - 1.
     void pop_from_stack();
 
     std::string get_dest_name(const std::string& label, const std::string& function_name);
+
+    // Writes the `$$CALL` and `$$RETURN` routines.
+    void write_shared_call_routines();
 };
 
 #endif
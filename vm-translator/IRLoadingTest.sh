@@ -0,0 +1,74 @@
+#!/bin/sh
+# Tests that .vmir files saved with --emit-ir translate to the same assembly as
+# the .vm files they came from, including in a directory that holds only
+# .vmir files, and that invalid .vmir files fall back to their .vm files or
+# fail the run.
+
+# ANSI colours.
+RED='\033[0;31m'
+GREEN='\033[0;32m'
+RESET='\033[0m'
+
+echo "Building VM Translator..."
+make -s || exit 1
+
+test_dir=$(mktemp -d)
+trap 'rm -rf "$test_dir"' EXIT
+mkdir "$test_dir/Prog"
+cat > "$test_dir/Prog/Sys.vm" << 'VM'
+function Sys.init 0
+push constant 7
+push constant 3
+call Sys.sub 2
+pop static 0
+label HALT
+goto HALT
+function Sys.sub 1
+push argument 0
+push argument 1
+sub
+pop local 0
+push local 0
+return
+VM
+
+echo "══════════ IR Loading Tests ══════════"
+failed=0
+if ./VMTranslator --emit-ir "$test_dir/Prog" > /dev/null && [ -f "$test_dir/Prog/Sys.vmir" ]; then
+    printf "\t${GREEN}Passed: --emit-ir saves a .vmir file.${RESET}\n"
+else
+    printf "\t${RED}FAILED: --emit-ir saves a .vmir file.${RESET}\n"
+    failed=1
+fi
+mv "$test_dir/Prog/Prog.asm" "$test_dir/expected.asm"
+
+mv "$test_dir/Prog/Sys.vm" "$test_dir/Sys.vm"
+if ./VMTranslator "$test_dir/Prog" > /dev/null &&
+        diff -s "$test_dir/Prog/Prog.asm" "$test_dir/expected.asm" > /dev/null; then
+    printf "\t${GREEN}Passed: a directory holding only a .vmir file translates.${RESET}\n"
+else
+    printf "\t${RED}FAILED: a directory holding only a .vmir file translates.${RESET}\n"
+    failed=1
+fi
+
+# An invalid .vmir file newer than its .vm file, eg. from an older version of
+# the translator.
+cp "$test_dir/Sys.vm" "$test_dir/Prog/Sys.vm"
+echo "not IR" > "$test_dir/Prog/Sys.vmir"
+touch -d "+1 minute" "$test_dir/Prog/Sys.vmir"
+if ./VMTranslator "$test_dir/Prog" > /dev/null 2>&1 &&
+        diff -s "$test_dir/Prog/Prog.asm" "$test_dir/expected.asm" > /dev/null; then
+    printf "\t${GREEN}Passed: an invalid .vmir file falls back to its .vm file.${RESET}\n"
+else
+    printf "\t${RED}FAILED: an invalid .vmir file falls back to its .vm file.${RESET}\n"
+    failed=1
+fi
+
+rm "$test_dir/Prog/Sys.vm"
+if ./VMTranslator "$test_dir/Prog" > /dev/null 2>&1; then
+    printf "\t${RED}FAILED: an invalid .vmir file without a .vm file fails the run.${RESET}\n"
+    failed=1
+else
+    printf "\t${GREEN}Passed: an invalid .vmir file without a .vm file fails the run.${RESET}\n"
+fi
+exit $failed
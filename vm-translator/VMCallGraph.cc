@@ -0,0 +1,116 @@
+#include "VMCallGraph.h"
+#include <algorithm>
+#include <functional>
+
+VMCallGraph::VMCallGraph(const std::vector<VMTranslationUnit>& units) {
+    for (size_t i = 0; i < units.size(); ++i) {
+        const std::vector<VMInstruction>& instructions = units[i].instructions();
+        for (size_t j = 0; j < instructions.size(); ++j) {
+            if (instructions[j].opcode != VMOpcode::FUNCTION) continue;
+            if (!_functions.empty() && _functions.back().unit == i) _functions.back().end = j;
+            const std::string& name = units[i].symbol(instructions[j].symbol);
+            _function_ids.emplace(name, _functions.size());
+            _functions.push_back({ name, i, j, instructions.size(), {} });
+        }
+    }
+
+    for (VMFunction& function : _functions) {
+        const VMTranslationUnit& unit = units[function.unit];
+        for (size_t j = function.begin; j < function.end; ++j) {
+            const VMInstruction& instruction = unit.instructions()[j];
+            if (instruction.opcode != VMOpcode::CALL) continue;
+            const size_t callee = find(unit.symbol(instruction.symbol));
+            if (callee != NOT_FOUND && std::find(function.callees.begin(), function.callees.end(), callee) == function.callees.end())
+                function.callees.push_back(callee);
+        }
+    }
+}
+
+const std::vector<VMFunction>& VMCallGraph::functions() const {
+    return _functions;
+}
+
+size_t VMCallGraph::find(const std::string& name) const {
+    const auto function_id = _function_ids.find(name);
+    return function_id == _function_ids.end() ? NOT_FOUND : function_id->second;
+}
+
+std::vector<bool> VMCallGraph::reachable_from(const size_t root) const {
+    std::vector<bool> is_reachable(_functions.size(), false);
+    std::vector<size_t> pending = { root };
+    is_reachable[root] = true;
+    while (!pending.empty()) {
+        const size_t function = pending.back();
+        pending.pop_back();
+        for (const size_t callee : _functions[function].callees) {
+            if (is_reachable[callee]) continue;
+            is_reachable[callee] = true;
+            pending.push_back(callee);
+        }
+    }
+    return is_reachable;
+}
+
+std::vector<std::vector<size_t>> VMCallGraph::strongly_connected_components() const {
+    // Tarjan's algorithm. `order` is when a function was first visited, and
+    // `low` the earliest visited function it can get back to while that's
+    // still on `path`.
+    constexpr size_t UNVISITED = static_cast<size_t>(-1);
+    std::vector<size_t> order(_functions.size(), UNVISITED), low(_functions.size());
+    std::vector<bool> is_on_path(_functions.size(), false);
+    std::vector<size_t> path;
+    std::vector<std::vector<size_t>> components;
+    size_t num_visited = 0;
+    std::function<void(size_t)> visit = [&](const size_t function) {
+        order[function] = low[function] = num_visited++;
+        path.push_back(function);
+        is_on_path[function] = true;
+        for (const size_t callee : _functions[function].callees) {
+            if (order[callee] == UNVISITED) {
+                visit(callee);
+                low[function] = std::min(low[function], low[callee]);
+            } else if (is_on_path[callee]) {
+                low[function] = std::min(low[function], order[callee]);
+            }
+        }
+        if (low[function] != order[function]) return;
+        components.emplace_back();
+        size_t member;
+        do {
+            member = path.back();
+            path.pop_back();
+            is_on_path[member] = false;
+            components.back().push_back(member);
+        } while (member != function);
+    };
+    for (size_t i = 0; i < _functions.size(); ++i)
+        if (order[i] == UNVISITED) visit(i);
+    return components;
+}
+
+std::vector<VMTranslationUnit> VMCallGraph::remove_dead_functions(std::vector<VMTranslationUnit>& units) const {
+    // The removed instructions keep their unit's symbol table, so that they
+    // can still be translated.
+    std::vector<VMTranslationUnit> removed = units;
+    for (VMTranslationUnit& unit : removed) unit.instructions().clear();
+    const size_t sys_init = find("Sys.init");
+    if (sys_init == NOT_FOUND) return removed;
+
+    const std::vector<bool> is_reachable = reachable_from(sys_init);
+    std::vector<std::vector<VMInstruction>> kept(units.size());
+    for (size_t i = 0; i < units.size(); ++i) {
+        // Code before the first function.
+        const std::vector<VMInstruction>& instructions = units[i].instructions();
+        const auto first_function = std::find_if(instructions.begin(), instructions.end(),
+            [](const VMInstruction& instruction) { return instruction.opcode == VMOpcode::FUNCTION; });
+        kept[i].assign(instructions.begin(), first_function);
+    }
+    for (size_t i = 0; i < _functions.size(); ++i) {
+        const VMFunction& function = _functions[i];
+        const std::vector<VMInstruction>& instructions = units[function.unit].instructions();
+        std::vector<VMInstruction>& destination = is_reachable[i] ? kept[function.unit] : removed[function.unit].instructions();
+        destination.insert(destination.end(), instructions.begin() + function.begin, instructions.begin() + function.end);
+    }
+    for (size_t i = 0; i < units.size(); ++i) units[i].instructions() = std::move(kept[i]);
+    return removed;
+}
@@ -0,0 +1,72 @@
+#ifndef VMCALL_GRAPH_H
+#define VMCALL_GRAPH_H
+
+#include "VMProgram.h"
+#include <cstddef>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * A function defined in one of the translation units of a program: the
+ * `function` instruction at `begin` up to the next one, or the end of the
+ * unit.
+ */
+struct VMFunction {
+    std::string name;
+    size_t unit;
+    size_t begin;
+    size_t end;
+
+    // The functions this one calls, as indices into `VMCallGraph::functions`,
+    // once each. Calls to functions that no unit defines are left out.
+    std::vector<size_t> callees;
+};
+
+/**
+ * Which functions of a whole program call which, built from its `call`
+ * instructions. VM code can only call functions by name, so the graph is
+ * exact.
+ */
+class VMCallGraph {
+public:
+    explicit VMCallGraph(const std::vector<VMTranslationUnit>& units);
+
+    const std::vector<VMFunction>& functions() const;
+
+    /**
+     * Returns the index of the function with the given name, or `NOT_FOUND`.
+     */
+    size_t find(const std::string& name) const;
+    static constexpr size_t NOT_FOUND = static_cast<size_t>(-1);
+
+    /**
+     * Marks the functions that can be reached by calls from the given one,
+     * including itself.
+     */
+    std::vector<bool> reachable_from(const size_t root) const;
+
+    /**
+     * Groups the functions into strongly connected components, the sets of
+     * functions that can all call each other through some chain of calls. A
+     * function is recursive if its component has more than one function, or
+     * it calls itself. Components come after every component they call into.
+     */
+    std::vector<std::vector<size_t>> strongly_connected_components() const;
+
+    /**
+     * Removes every function that can't be reached from `Sys.init` from the
+     * given units, which the graph must have been built from. Returns the
+     * removed instructions of each unit, for measuring what was saved. Code
+     * before the first function of a unit is kept. Does nothing if no unit
+     * defines `Sys.init`, since then every function could be the entry point.
+     * The graph no longer matches the units afterwards.
+     */
+    std::vector<VMTranslationUnit> remove_dead_functions(std::vector<VMTranslationUnit>& units) const;
+
+private:
+    std::vector<VMFunction> _functions;
+    std::unordered_map<std::string, size_t> _function_ids;
+};
+
+#endif
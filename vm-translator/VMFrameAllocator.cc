@@ -0,0 +1,155 @@
+#include "VMFrameAllocator.h"
+#include <algorithm>
+#include <functional>
+#include <string>
+#include <unordered_set>
+
+// Variables are allocated from RAM[16] up to the stack at RAM[256].
+constexpr size_t NUM_VARIABLE_WORDS = 256 - 16;
+
+// What a function's frame holds, and where it goes.
+struct Frame {
+    size_t num_locals = 0;
+
+    // The highest local and argument indices used, plus 1.
+    int32_t num_locals_used = 0;
+    int32_t num_args_used = 0;
+
+    // The first `$$FRAME.i` variable of the frame. The arguments come first,
+    // then the locals.
+    size_t start = 0;
+};
+
+// The `push`, `pop` and `move` operands of an instruction.
+static void for_each_operand(VMInstruction& instruction, const std::function<void(VMSegment&, int32_t&)>& visit) {
+    if (instruction.opcode == VMOpcode::PUSH || instruction.opcode == VMOpcode::POP) {
+        visit(instruction.segment, instruction.index);
+    } else if (instruction.opcode == VMOpcode::MOVE) {
+        visit(instruction.segment, instruction.index);
+        int32_t target_index = static_cast<int32_t>(instruction.symbol);
+        visit(instruction.target_segment, target_index);
+        instruction.symbol = static_cast<uint32_t>(target_index);
+    }
+}
+
+// How many variables the statics and named variables of the program take up
+// already.
+static size_t count_variables(std::vector<VMTranslationUnit>& units) {
+    std::unordered_set<std::string> variables;
+    for (VMTranslationUnit& unit : units) {
+        for (VMInstruction instruction : unit.instructions()) {
+            for_each_operand(instruction, [&](VMSegment& segment, int32_t& index) {
+                if (segment == VMSegment::STATIC) variables.insert(unit.name() + "_" + std::to_string(index));
+                else if (segment == VMSegment::NAMED) variables.insert(unit.symbol(index));
+            });
+        }
+    }
+    return variables.size();
+}
+
+VMStaticFrames VMFrameAllocator::allocate_static_frames(std::vector<VMTranslationUnit>& units,
+        const VMCallGraph& call_graph) {
+    const std::vector<VMFunction>& functions = call_graph.functions();
+    VMStaticFrames static_frames = { std::vector<bool>(functions.size(), false), 0 };
+    const size_t sys_init = call_graph.find("Sys.init");
+    if (sys_init == VMCallGraph::NOT_FOUND) return static_frames;
+
+    std::vector<Frame> frames(functions.size());
+    for (size_t i = 0; i < functions.size(); ++i) {
+        VMTranslationUnit& unit = units[functions[i].unit];
+        frames[i].num_locals = unit.instructions()[functions[i].begin].index;
+        for (size_t j = functions[i].begin + 1; j < functions[i].end; ++j) {
+            VMInstruction instruction = unit.instructions()[j];
+            for_each_operand(instruction, [&](VMSegment& segment, int32_t& index) {
+                if (segment == VMSegment::LOCAL) frames[i].num_locals_used = std::max(frames[i].num_locals_used, index + 1);
+                else if (segment == VMSegment::ARGUMENT) frames[i].num_args_used = std::max(frames[i].num_args_used, index + 1);
+            });
+        }
+    }
+
+    // Callers are placed before their callees, so every frame can start past
+    // the frames of everything that could be running when it is.
+    const size_t num_free_words = NUM_VARIABLE_WORDS - std::min(NUM_VARIABLE_WORDS, count_variables(units));
+    const std::vector<bool> is_reachable = call_graph.reachable_from(sys_init);
+    std::vector<std::vector<size_t>> components = call_graph.strongly_connected_components();
+    std::vector<size_t> component_of(functions.size());
+    for (size_t i = 0; i < components.size(); ++i)
+        for (const size_t function : components[i]) component_of[function] = i;
+    for (size_t i = components.size(); i-- > 0; ) {
+        size_t start = 0;
+        for (const size_t function : components[i]) start = std::max(start, frames[function].start);
+        size_t size = 0;
+        const size_t function = components[i].front();
+        const Frame& frame = frames[function];
+        const std::vector<size_t>& callees = functions[function].callees;
+        const bool is_recursive = components[i].size() > 1 ||
+            std::find(callees.begin(), callees.end(), function) != callees.end();
+        if (!is_recursive && is_reachable[function] && frame.num_locals_used <= static_cast<int32_t>(frame.num_locals) &&
+                start + frame.num_args_used + frame.num_locals <= num_free_words) {
+            static_frames.is_static[function] = true;
+            size = frame.num_args_used + frame.num_locals;
+            static_frames.num_words = std::max(static_frames.num_words, start + size);
+        }
+        for (const size_t member : components[i]) {
+            frames[member].start = start;
+            for (const size_t callee : functions[member].callees)
+                if (component_of[callee] != i) frames[callee].start = std::max(frames[callee].start, start + size);
+        }
+    }
+
+    for (size_t i = 0; i < units.size(); ++i) {
+        VMTranslationUnit& unit = units[i];
+        auto slot = [&](const size_t index) {
+            return static_cast<int32_t>(unit.intern("$$FRAME." + std::to_string(index)));
+        };
+        auto instruction = [](const VMOpcode opcode, const VMSegment segment, const int32_t index) {
+            return VMInstruction{ opcode, segment, VMSegment::NONE, index, 0 };
+        };
+
+        std::vector<VMInstruction> allocated;
+        allocated.reserve(unit.instructions().size());
+        // The function being rewritten, if it has a static frame.
+        size_t function = VMCallGraph::NOT_FOUND;
+        for (size_t j = 0; j < unit.instructions().size(); ++j) {
+            VMInstruction each = unit.instructions()[j];
+            if (each.opcode == VMOpcode::FUNCTION) {
+                // Functions with the same name as an earlier one are left alone.
+                function = call_graph.find(unit.symbol(each.symbol));
+                if (function != VMCallGraph::NOT_FOUND &&
+                        (!static_frames.is_static[function] || functions[function].unit != i || functions[function].begin != j))
+                    function = VMCallGraph::NOT_FOUND;
+                if (function == VMCallGraph::NOT_FOUND) {
+                    allocated.push_back(each);
+                    continue;
+                }
+                each.index = 0;
+                allocated.push_back(each);
+                const Frame& frame = frames[function];
+                for (int32_t k = 0; k < frame.num_args_used; ++k) {
+                    allocated.push_back(instruction(VMOpcode::PUSH, VMSegment::ARGUMENT, k));
+                    allocated.push_back(instruction(VMOpcode::POP, VMSegment::NAMED, slot(frame.start + k)));
+                }
+                for (size_t k = 0; k < frame.num_locals; ++k) {
+                    allocated.push_back(instruction(VMOpcode::PUSH, VMSegment::CONSTANT, 0));
+                    allocated.push_back(instruction(VMOpcode::POP, VMSegment::NAMED, slot(frame.start + frame.num_args_used + k)));
+                }
+                continue;
+            }
+            if (function != VMCallGraph::NOT_FOUND) {
+                const Frame& frame = frames[function];
+                for_each_operand(each, [&](VMSegment& segment, int32_t& index) {
+                    if (segment == VMSegment::ARGUMENT) {
+                        segment = VMSegment::NAMED;
+                        index = slot(frame.start + index);
+                    } else if (segment == VMSegment::LOCAL) {
+                        segment = VMSegment::NAMED;
+                        index = slot(frame.start + frame.num_args_used + index);
+                    }
+                });
+            }
+            allocated.push_back(each);
+        }
+        unit.instructions() = std::move(allocated);
+    }
+    return static_frames;
+}
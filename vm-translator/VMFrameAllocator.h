@@ -0,0 +1,46 @@
+#ifndef VMFRAME_ALLOCATOR_H
+#define VMFRAME_ALLOCATOR_H
+
+#include "VMCallGraph.h"
+#include "VMProgram.h"
+#include <cstddef>
+#include <vector>
+
+/**
+ * Which functions were given static frames, and how much RAM they share.
+ */
+struct VMStaticFrames {
+    // Indexed like `VMCallGraph::functions`.
+    std::vector<bool> is_static;
+    size_t num_words = 0;
+};
+
+/**
+ * Gives the arguments and locals of functions that are never recursive fixed
+ * RAM addresses, so that they're read and written with `@addr` instead of
+ * through ARG and LCL.
+ *
+ * A function that isn't on a cycle of the call graph can only be running once
+ * at a time, so its frame can live in `named $$FRAME.i` variables. Calls are
+ * left as they are: the function copies the arguments it uses into its frame
+ * on entry, and clears its locals there rather than pushing them. Two frames
+ * only overlap if their functions can never be running at the same time, ie.
+ * neither calls the other through any chain of calls.
+ *
+ * Recursive functions, functions that use locals they don't declare, and any
+ * that don't fit in the RAM left between the statics and the stack keep their
+ * usual frames on the stack.
+ */
+class VMFrameAllocator {
+public:
+    /**
+     * Moves the frames of the functions that `Sys.init` can reach out of the
+     * stack where possible, throughout the given units, which `call_graph`
+     * must have been built from. Does nothing if no unit defines `Sys.init`,
+     * since then functions could be run directly, by test scripts that look
+     * at their frames on the stack.
+     */
+    static VMStaticFrames allocate_static_frames(std::vector<VMTranslationUnit>& units, const VMCallGraph& call_graph);
+};
+
+#endif
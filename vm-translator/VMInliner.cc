@@ -0,0 +1,226 @@
+#include "VMInliner.h"
+#include <algorithm>
+#include <string>
+#include <unordered_map>
+
+// A function that can be inlined, with its symbols resolved to names since
+// it's copied into other units.
+struct InlineBody {
+    std::string unit_name;
+    size_t num_locals;
+    std::vector<VMInstruction> instructions;
+    std::vector<std::string> symbols;
+
+    // The highest argument index used, plus 1.
+    int32_t num_args_used;
+
+    // Whether the body sets `pointer 0` or `pointer 1`.
+    bool sets_this;
+    bool sets_that;
+};
+
+// How many items an unfused instruction takes off the stack, and how many it
+// puts back.
+static void stack_effect(const VMOpcode opcode, int& num_popped, int& num_pushed) {
+    num_popped = num_pushed = 0;
+    switch (opcode) {
+        case VMOpcode::PUSH:
+            num_pushed = 1;
+            break;
+        case VMOpcode::NEG:
+        case VMOpcode::NOT:
+            num_popped = num_pushed = 1;
+            break;
+        case VMOpcode::POP:
+        case VMOpcode::IF_GOTO:
+        case VMOpcode::RETURN:
+            num_popped = 1;
+            break;
+        case VMOpcode::LABEL:
+        case VMOpcode::GOTO:
+            break;
+        default:
+            num_popped = 2;
+            num_pushed = 1;
+            break;
+    }
+}
+
+// Checks that the body can be copied into a caller: it only uses unfused
+// instructions, never runs off its end, and keeps the stack at the same depth
+// on every path, with just the return value on it at every return.
+static bool is_stack_balanced(const VMTranslationUnit& unit, const size_t begin, const size_t end) {
+    std::unordered_map<uint32_t, size_t> label_index;
+    for (size_t i = begin; i < end; ++i)
+        if (unit.instructions()[i].opcode == VMOpcode::LABEL) label_index[unit.instructions()[i].symbol] = i;
+
+    std::vector<int> depth(end - begin, -1);
+    std::vector<size_t> pending = { begin };
+    depth[0] = 0;
+    // Records the depth an instruction is reached with, and whether it agrees
+    // with any earlier path to it.
+    auto reach = [&](const size_t index, const int each_depth) {
+        if (index >= end) return false;
+        if (depth[index - begin] == -1) {
+            depth[index - begin] = each_depth;
+            pending.push_back(index);
+        }
+        return depth[index - begin] == each_depth;
+    };
+    while (!pending.empty()) {
+        const size_t i = pending.back();
+        pending.pop_back();
+        const VMInstruction& instruction = unit.instructions()[i];
+        if (instruction.opcode > VMOpcode::RETURN || instruction.opcode == VMOpcode::FUNCTION ||
+                instruction.opcode == VMOpcode::CALL)
+            return false;
+        int num_popped, num_pushed;
+        stack_effect(instruction.opcode, num_popped, num_pushed);
+        if (depth[i - begin] < num_popped) return false;
+        const int after = depth[i - begin] - num_popped + num_pushed;
+
+        if (instruction.opcode == VMOpcode::RETURN) {
+            if (depth[i - begin] != 1) return false;
+            continue;
+        }
+        if (instruction.opcode == VMOpcode::GOTO || instruction.opcode == VMOpcode::IF_GOTO) {
+            const auto target = label_index.find(instruction.symbol);
+            if (target == label_index.end() || !reach(target->second, after)) return false;
+            if (instruction.opcode == VMOpcode::GOTO) continue;
+        }
+        if (!reach(i + 1, after)) return false;
+    }
+    return true;
+}
+
+// Copies the body of the given function if it can be inlined.
+static bool find_inline_body(const VMTranslationUnit& unit, const VMFunction& function, const size_t max_size,
+        InlineBody& body) {
+    const size_t begin = function.begin + 1;
+    body.num_locals = unit.instructions()[function.begin].index;
+    if (!function.callees.empty() || begin >= function.end || function.end - begin + body.num_locals > max_size ||
+            !is_stack_balanced(unit, begin, function.end))
+        return false;
+
+    body.unit_name = unit.name();
+    body.instructions.assign(unit.instructions().begin() + begin, unit.instructions().begin() + function.end);
+    body.symbols = unit.symbols();
+    body.num_args_used = 0;
+    body.sets_this = body.sets_that = false;
+    for (const VMInstruction& instruction : body.instructions) {
+        if (instruction.segment == VMSegment::ARGUMENT) body.num_args_used = std::max(body.num_args_used, instruction.index + 1);
+        if (instruction.opcode == VMOpcode::POP && instruction.segment == VMSegment::POINTER) {
+            if (instruction.index == 0) body.sets_this = true;
+            else body.sets_that = true;
+        }
+    }
+    return true;
+}
+
+// Writes a copy of the body into `out` in place of `call`, the `site`th call
+// inlined into the unit.
+static void expand_call(VMTranslationUnit& unit, const VMInstruction& call, const InlineBody& body, const size_t site,
+        std::vector<VMInstruction>& out) {
+    const std::string callee = unit.symbol(call.symbol);
+    auto instruction = [](const VMOpcode opcode, const VMSegment segment, const int32_t index) {
+        return VMInstruction{ opcode, segment, VMSegment::NONE, index, 0 };
+    };
+    auto scratch = [&](const std::string& name) {
+        return static_cast<int32_t>(unit.intern("$$INLINE." + name));
+    };
+
+    // The arguments are on the stack, the last one on top.
+    for (int32_t i = call.index - 1; i >= 0; --i) out.push_back(instruction(VMOpcode::POP, VMSegment::NAMED, scratch(std::to_string(i))));
+    for (size_t i = 0; i < body.num_locals; ++i) {
+        out.push_back(instruction(VMOpcode::PUSH, VMSegment::CONSTANT, 0));
+        out.push_back(instruction(VMOpcode::POP, VMSegment::NAMED, scratch(std::to_string(call.index + i))));
+    }
+    if (body.sets_this) {
+        out.push_back(instruction(VMOpcode::PUSH, VMSegment::POINTER, 0));
+        out.push_back(instruction(VMOpcode::POP, VMSegment::NAMED, scratch("THIS")));
+    }
+    if (body.sets_that) {
+        out.push_back(instruction(VMOpcode::PUSH, VMSegment::POINTER, 1));
+        out.push_back(instruction(VMOpcode::POP, VMSegment::NAMED, scratch("THAT")));
+    }
+
+    // Labels are scoped to the caller, so they're qualified by the callee and
+    // the call site.
+    const std::string label_prefix = callee + "$" + std::to_string(site) + "$";
+    const uint32_t end_label = unit.intern(label_prefix + "END");
+    bool is_end_used = false;
+    for (size_t i = 0; i < body.instructions.size(); ++i) {
+        VMInstruction each = body.instructions[i];
+        switch (each.opcode) {
+            case VMOpcode::PUSH:
+            case VMOpcode::POP:
+                if (each.segment == VMSegment::ARGUMENT) {
+                    each.segment = VMSegment::NAMED;
+                    each.index = scratch(std::to_string(each.index));
+                } else if (each.segment == VMSegment::LOCAL) {
+                    each.segment = VMSegment::NAMED;
+                    each.index = scratch(std::to_string(call.index + each.index));
+                } else if (each.segment == VMSegment::STATIC && body.unit_name != unit.name()) {
+                    each.segment = VMSegment::NAMED;
+                    each.index = unit.intern(body.unit_name + "_" + std::to_string(each.index));
+                }
+                break;
+            case VMOpcode::LABEL:
+            case VMOpcode::GOTO:
+            case VMOpcode::IF_GOTO:
+                each.symbol = unit.intern(label_prefix + body.symbols[each.symbol]);
+                break;
+            case VMOpcode::RETURN:
+                // The return value is already where the call would leave it.
+                if (i + 1 == body.instructions.size()) continue;
+                each = { VMOpcode::GOTO, VMSegment::NONE, VMSegment::NONE, 0, end_label };
+                is_end_used = true;
+                break;
+            default:
+                break;
+        }
+        out.push_back(each);
+    }
+    if (is_end_used) out.push_back({ VMOpcode::LABEL, VMSegment::NONE, VMSegment::NONE, 0, end_label });
+
+    if (body.sets_this) {
+        out.push_back(instruction(VMOpcode::PUSH, VMSegment::NAMED, scratch("THIS")));
+        out.push_back(instruction(VMOpcode::POP, VMSegment::POINTER, 0));
+    }
+    if (body.sets_that) {
+        out.push_back(instruction(VMOpcode::PUSH, VMSegment::NAMED, scratch("THAT")));
+        out.push_back(instruction(VMOpcode::POP, VMSegment::POINTER, 1));
+    }
+}
+
+std::vector<size_t> VMInliner::inline_calls(std::vector<VMTranslationUnit>& units, const VMCallGraph& call_graph,
+        const size_t max_size) {
+    // Leaves don't change when calls are inlined, so their bodies can be
+    // copied up front.
+    const std::vector<VMFunction>& functions = call_graph.functions();
+    std::vector<InlineBody> bodies(functions.size());
+    std::vector<bool> is_inlinable(functions.size());
+    for (size_t i = 0; i < functions.size(); ++i)
+        is_inlinable[i] = find_inline_body(units[functions[i].unit], functions[i], max_size, bodies[i]);
+
+    std::vector<size_t> num_inlined(functions.size(), 0);
+    for (VMTranslationUnit& unit : units) {
+        std::vector<VMInstruction> inlined;
+        inlined.reserve(unit.instructions().size());
+        size_t site = 0;
+        for (const VMInstruction& instruction : unit.instructions()) {
+            const size_t callee = instruction.opcode == VMOpcode::CALL ? call_graph.find(unit.symbol(instruction.symbol))
+                                                                      : VMCallGraph::NOT_FOUND;
+            // A call with too few arguments is left for the callee to deal
+            // with.
+            if (callee == VMCallGraph::NOT_FOUND || !is_inlinable[callee] || instruction.index < bodies[callee].num_args_used) {
+                inlined.push_back(instruction);
+                continue;
+            }
+            expand_call(unit, instruction, bodies[callee], site++, inlined);
+            ++num_inlined[callee];
+        }
+        unit.instructions() = std::move(inlined);
+    }
+    return num_inlined;
+}
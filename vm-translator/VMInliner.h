@@ -0,0 +1,38 @@
+#ifndef VMINLINER_H
+#define VMINLINER_H
+
+#include "VMCallGraph.h"
+#include "VMProgram.h"
+#include <cstddef>
+#include <vector>
+
+/**
+ * Replaces calls to small functions with a copy of the function's body, which
+ * saves the call and return sequences, about 90 Hack instructions, per call.
+ *
+ * Only leaf functions, which call nothing, are inlined. A leaf runs to its end
+ * before any other inlined code can, so every inlined body can keep its
+ * arguments and locals in the same scratch variables (`named $$INLINE.i`), and
+ * no leaf can be on a recursive cycle. At each call site, the arguments are
+ * popped into scratch variables and the locals are cleared. Statics of other
+ * units become named variables, labels are renamed after the call site, and
+ * returns jump to the end of the copy with the return value on the stack. If
+ * the body sets `pointer`, the caller's THIS or THAT is saved and restored
+ * around it, as a real call would.
+ *
+ * A function is only inlined if its body and locals come to at most
+ * `max_size` VM instructions, and every return leaves exactly the return
+ * value on the stack, which compiled Jack code always does.
+ */
+class VMInliner {
+public:
+    /**
+     * Inlines calls throughout the given units, which `call_graph` must have
+     * been built from. Returns how many calls to each function of the graph
+     * were inlined.
+     */
+    static std::vector<size_t> inline_calls(std::vector<VMTranslationUnit>& units, const VMCallGraph& call_graph,
+        const size_t max_size);
+};
+
+#endif
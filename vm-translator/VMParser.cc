@@ -1,49 +1,130 @@
 #include "VMParser.h"
+#include <array>
+#include <charconv>
 #include <fstream>
 #include <iostream>
-#include <regex>
-#include <unordered_set>
-
-std::unordered_set<std::string> VMParser::_arithmetic_logic_operators = {
-    "add", "sub", "and", "or", "eq", "gt", "lt", "neg", "not"
-};
-
-// Instruction parsing and argument extraction patterns.
-std::regex VMParser::_push_pop_pattern         = std::regex(R"(^(push|pop) +([a-zA-Z]+) +([0-9]+))");
-std::regex VMParser::_arithmetic_logic_pattern = std::regex(R"(^\S+)");
-std::regex VMParser::_label_pattern            = std::regex(R"(^label +(\S+))");
-std::regex VMParser::_goto_pattern             = std::regex(R"(^goto +(\S+))");
-std::regex VMParser::_if_pattern               = std::regex(R"(^if-goto +(\S+))");
-std::regex VMParser::_function_pattern         = std::regex(R"(^function +(\S+) +([0-9]+))");
-std::regex VMParser::_call_pattern             = std::regex(R"(^call +(\S+) +([0-9]+))");
-std::regex VMParser::_return_pattern           = std::regex(R"(^return)");
-std::smatch VMParser::_match_results           = std::smatch();
+#include <sstream>
 
 // Empty argument constants.
 constexpr std::string_view EMPTY_ARG1 = ""; 
 constexpr int EMPTY_ARG2 = -1;
 
+constexpr std::string_view WHITESPACE = " \t\n\r\f\v";
+
+// Every VM command word, found through a perfect hash rather than by trying
+// each in turn. The hash was picked so that no two words share a slot.
+struct VMCommandWord {
+    std::string_view word;
+    VMOperationType type;
+};
+
+constexpr std::array<VMCommandWord, 17> VM_COMMAND_WORDS = {{
+    {"push", VMOperationType::C_PUSH},
+    {"pop", VMOperationType::C_POP},
+    {"add", VMOperationType::C_ARITHMETIC},
+    {"sub", VMOperationType::C_ARITHMETIC},
+    {"and", VMOperationType::C_ARITHMETIC},
+    {"or", VMOperationType::C_ARITHMETIC},
+    {"eq", VMOperationType::C_ARITHMETIC},
+    {"gt", VMOperationType::C_ARITHMETIC},
+    {"lt", VMOperationType::C_ARITHMETIC},
+    {"neg", VMOperationType::C_ARITHMETIC},
+    {"not", VMOperationType::C_ARITHMETIC},
+    {"label", VMOperationType::C_LABEL},
+    {"goto", VMOperationType::C_GOTO},
+    {"if-goto", VMOperationType::C_IF},
+    {"function", VMOperationType::C_FUNCTION},
+    {"call", VMOperationType::C_CALL},
+    {"return", VMOperationType::C_RETURN},
+}};
+
+constexpr size_t command_word_hash(const std::string_view word) {
+    return (3 * word.size() + word[0] + 11 * word[1] + word.back()) & 31;
+}
+
+constexpr std::array<VMCommandWord, 32> make_command_word_table() {
+    std::array<VMCommandWord, 32> table = {};
+    for (const VMCommandWord& command_word : VM_COMMAND_WORDS) table[command_word_hash(command_word.word)] = command_word;
+    return table;
+}
+
+constexpr std::array<VMCommandWord, 32> COMMAND_WORD_TABLE = make_command_word_table();
+
+// Returns the type of the VM command `word`, or INVALID if it isn't one.
+static VMOperationType command_type(const std::string_view word) {
+    if (word.size() < 2) return VMOperationType::INVALID;
+    const VMCommandWord& command_word = COMMAND_WORD_TABLE[command_word_hash(word)];
+    return command_word.word == word ? command_word.type : VMOperationType::INVALID;
+}
+
+// Splits off and returns the next whitespace-separated token of `line`.
+static std::string_view next_token(std::string_view& line) {
+    const size_t start_index = line.find_first_not_of(WHITESPACE);
+    if (start_index == std::string_view::npos) {
+        line = std::string_view();
+        return line;
+    }
+    line.remove_prefix(start_index);
+    const size_t end_index = std::min(line.find_first_of(WHITESPACE), line.size());
+    const std::string_view token = line.substr(0, end_index);
+    line.remove_prefix(end_index);
+    return token;
+}
+
+// Parses the leading digits of `token` into `value`. Returns false if it
+// doesn't start with a digit.
+static bool parse_index(const std::string_view token, int& value) {
+    if (token.empty() || token[0] < '0' || token[0] > '9') return false;
+    return std::from_chars(token.data(), token.data() + token.size(), value).ec == std::errc();
+}
+
+static bool is_segment_name(const std::string_view token) {
+    if (token.empty()) return false;
+    for (const char c : token)
+        if (!((c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z'))) return false;
+    return true;
+}
+
 VMParser::VMParser(const std::string& vm_source_file_path, const bool& debug_mode) 
-    : _vm_in(std::ifstream(vm_source_file_path)),
+    : _next_line_start(0),
+      _debug_mode(debug_mode),
       _curr_line(0),
       _return_counter(0),
-      _debug_mode(debug_mode) {
+      _instruction_type(VMOperationType::INVALID),
+      _arg2(EMPTY_ARG2) {
+    std::ifstream vm_in(vm_source_file_path);
+    if (!vm_in) {
+        std::cerr << "Error: could not open '" << vm_source_file_path << "'.\n";
+        return;
+    }
+    std::stringstream vm_source;
+    vm_source << vm_in.rdbuf();
+    _vm_source = vm_source.str();
 }
 
 bool VMParser::has_more_lines() {
-    return !_vm_in.eof();
+    return _next_line_start < _vm_source.size();
 }
 
 void VMParser::advance() {
-    if (!std::getline(_vm_in, _curr_instruction)) {
-        _instruction_type = VMOperationType::INVALID;
-        _arg1 = EMPTY_ARG1; 
-        _arg2 = EMPTY_ARG2;
+    // Skips past blank lines, comments and invalid instructions.
+    while (_next_line_start < _vm_source.size()) {
+        const std::string_view source = _vm_source;
+        size_t line_end = source.find('\n', _next_line_start);
+        if (line_end == std::string_view::npos) line_end = source.size();
+        const std::string_view line = source.substr(_next_line_start, line_end - _next_line_start);
+        _next_line_start = line_end + 1;
+        ++_curr_line;
+
+        const std::string_view instruction = preprocess(line);
+        if (instruction.empty() || !parse(instruction)) continue;
+        _curr_instruction.assign(instruction);
+        if (_debug_mode) show_instruction_debug_info();
         return;
     }
-    ++_curr_line;
-    if (!parse()) advance();
-    else if (_debug_mode) show_instruction_debug_info();
+    _instruction_type = VMOperationType::INVALID;
+    _arg1 = EMPTY_ARG1; 
+    _arg2 = EMPTY_ARG2;
 }
 
 VMOperationType VMParser::instruction_type() {
@@ -70,127 +151,85 @@ int VMParser::get_return_couter() {
     return _return_counter;
 }
 
-void VMParser::preprocess() {
-    // Strips all leading whitespace.
-    const std::string WHITESPACE = " \n\r\t\f\v";
-
-    int start_index = _curr_instruction.find_first_not_of(WHITESPACE);
-    if (start_index != std::string::npos) _curr_instruction = _curr_instruction.substr(start_index);
-    
+std::string_view VMParser::preprocess(std::string_view line) {
     // Strip inline comments.
-    int comment_start_index = _curr_instruction.find_first_of("/");
-    if (comment_start_index != std::string::npos) _curr_instruction = _curr_instruction.substr(0, comment_start_index);
+    const size_t comment_start_index = line.find('/');
+    if (comment_start_index != std::string_view::npos) line = line.substr(0, comment_start_index);
 
-    // Strip all trailing whitespace.
-    int last_index = _curr_instruction.find_last_not_of(WHITESPACE);
-    if (last_index != std::string::npos) _curr_instruction = _curr_instruction.substr(0, last_index + 1);
+    // Strip all leading and trailing whitespace.
+    const size_t start_index = line.find_first_not_of(WHITESPACE);
+    if (start_index == std::string_view::npos) return std::string_view();
+    const size_t last_index = line.find_last_not_of(WHITESPACE);
+    return line.substr(start_index, last_index - start_index + 1);
 }
 
-bool VMParser::parse() {
-    preprocess();
-    if (_curr_instruction.empty()) return false;
-    
+bool VMParser::parse(std::string_view instruction) {
     // First, we determine what command type and therefore what subsequent
     // arguments to expect.
-    int run_len = 0; 
-    while (run_len < _curr_instruction.size()) {
-        const char& c = _curr_instruction[run_len];
-        if (c == ' ') break;
-        ++run_len;
-    }
-    std::string instruction = _curr_instruction.substr(0, run_len);
+    const std::string_view command = next_token(instruction);
+    const VMOperationType type = command_type(command);
 
     // Next, we pull out the expected arguments and populate/clear _arg1 and
-    // _arg2.
-    if (instruction == "push") {
-        // Expect the segment name, followed by the index.
-        if (!std::regex_search(_curr_instruction, _match_results, _push_pop_pattern)) {
-            std::cerr << "Syntax Error: push/pop commands expect 2 args.\n";
-            return false;
-        }
-        _arg1 = _match_results[2];
-        _arg2 = stoi(_match_results[3]);
-        _instruction_type = VMOperationType::C_PUSH;
-    } else if (instruction == "pop") {
-        // Expect the segment name, followed by the index.
-        if (!std::regex_search(_curr_instruction, _match_results, _push_pop_pattern)) {
-            std::cerr << "Syntax Error: push/pop commands expect 2 args.\n";
-            return false;
-        }
-        _arg1 = _match_results[2];
-        _arg2 = stoi(_match_results[3]);
-        _instruction_type = VMOperationType::C_POP;
-    } else if (_arithmetic_logic_operators.find(instruction) != _arithmetic_logic_operators.end()) {
-        // If additional arguments were supplied, then the instruction is invalid.
-        if (!std::regex_search(_curr_instruction, _match_results, _arithmetic_logic_pattern)) {
-            std::cerr << "Syntax Error: arithmetic/logical instructions expect no arguments.\n";
-            return false;
-        }
-        // Clear _arg1 and _arg2.
-        _arg1 = EMPTY_ARG1; 
-        _arg2 = EMPTY_ARG2;
-        _instruction_type = VMOperationType::C_ARITHMETIC;
-    } else if (instruction == "label") {
-        if (!std::regex_search(_curr_instruction, _match_results, _label_pattern)) {
-            std::cerr << "Syntax Error: label expects 1 argument.\n";
-            return false;
-        }
-        _arg1 = _match_results[1];
-        _arg2 = EMPTY_ARG2;
-        _instruction_type = VMOperationType::C_LABEL;
-    } else if (instruction == "goto") {
-        if (!std::regex_search(_curr_instruction, _match_results, _goto_pattern)) {
-            std::cerr << "Syntax Error: goto expects 1 argument.\n";
-            return false;
-        }
-        _arg1 = _match_results[1];
-        _arg2 = EMPTY_ARG2;
-        _instruction_type = VMOperationType::C_GOTO;
-    } else if (instruction == "if-goto") {
-        if (!std::regex_search(_curr_instruction, _match_results, _if_pattern)) {
-            std::cerr << "Syntax Error: if-goto expects 1 argument.\n";
-            return false;
-        }
-        _arg1 = _match_results[1];
-        _arg2 = EMPTY_ARG2;
-        _instruction_type = VMOperationType::C_IF;
-    } else if (instruction == "function") {
-        if (!std::regex_search(_curr_instruction, _match_results, _function_pattern)) {
-            std::cerr << "Syntax Error: invalid function declaration.\n";
-            return false;
-        }
-        _curr_function_name = _match_results[1];
-        // Reset the return counter so that we can maintain a new running return
-        // address label ID for the new function body that we're in.
-        _return_counter = 0;
-        _arg1 = _match_results[1];
-        _arg2 = stoi(_match_results[2]);
-        _instruction_type = VMOperationType::C_FUNCTION;
-    } else if (instruction == "call") {
-        if (!std::regex_search(_curr_instruction, _match_results, _call_pattern)) {
-            std::cerr << "Syntax Error: invalid function invocation.\n";
-            return false;
-        }
-        _arg1 = _match_results[1];
-        _arg2 = stoi(_match_results[2]);
-        ++_return_counter;
-        _instruction_type = VMOperationType::C_CALL;
-    } else if (instruction == "return") {
-        if (!std::regex_search(_curr_instruction, _match_results, _return_pattern)) {
-            std::cerr << "Syntax Error: invalid return statement.\n";
+    // _arg2. Anything after them is ignored.
+    const std::string_view arg1 = next_token(instruction);
+    const std::string_view arg2 = next_token(instruction);
+    int index = EMPTY_ARG2;
+    switch (type) {
+        case VMOperationType::C_PUSH:
+        case VMOperationType::C_POP:
+            // Expect the segment name, followed by the index.
+            if (!is_segment_name(arg1) || !parse_index(arg2, index)) {
+                std::cerr << "Syntax Error: push/pop commands expect 2 args.\n";
+                return false;
+            }
+            _arg1.assign(arg1);
+            _arg2 = index;
+            break;
+        case VMOperationType::C_ARITHMETIC:
+        case VMOperationType::C_RETURN:
+            // Clear _arg1 and _arg2.
+            _arg1 = EMPTY_ARG1; 
+            _arg2 = EMPTY_ARG2;
+            break;
+        case VMOperationType::C_LABEL:
+        case VMOperationType::C_GOTO:
+        case VMOperationType::C_IF:
+            if (arg1.empty()) {
+                std::cerr << "Syntax Error: " << command << " expects 1 argument.\n";
+                return false;
+            }
+            _arg1.assign(arg1);
+            _arg2 = EMPTY_ARG2;
+            break;
+        case VMOperationType::C_FUNCTION:
+            if (arg1.empty() || !parse_index(arg2, index)) {
+                std::cerr << "Syntax Error: invalid function declaration.\n";
+                return false;
+            }
+            _curr_function_name.assign(arg1);
+            // Reset the return counter so that we can maintain a new running return
+            // address label ID for the new function body that we're in.
+            _return_counter = 0;
+            _arg1.assign(arg1);
+            _arg2 = index;
+            break;
+        case VMOperationType::C_CALL:
+            if (arg1.empty() || !parse_index(arg2, index)) {
+                std::cerr << "Syntax Error: invalid function invocation.\n";
+                return false;
+            }
+            _arg1.assign(arg1);
+            _arg2 = index;
+            ++_return_counter;
+            break;
+        default:
+            // Clear _arg1 and _arg2.
+            _arg1 = EMPTY_ARG1; 
+            _arg2 = EMPTY_ARG2;
+            _instruction_type = VMOperationType::INVALID;
             return false;
-        }
-        // Clear arguments.
-        _arg1 = EMPTY_ARG1; 
-        _arg2 = EMPTY_ARG2;
-        _instruction_type = VMOperationType::C_RETURN;
-    } else {
-        // Clear _arg1 and _arg2.
-        _arg1 = EMPTY_ARG1; 
-        _arg2 = EMPTY_ARG2;
-        _instruction_type = VMOperationType::INVALID;
-        return false;
     }
+    _instruction_type = type;
     return true;
 }
 
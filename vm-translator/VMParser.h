@@ -2,9 +2,7 @@
 #define VMPARSER_H
 
 #include <string>
-#include <fstream>
-#include <unordered_set>
-#include <regex>
+#include <string_view>
 
 enum class VMOperationType {
     C_ARITHMETIC,
@@ -71,11 +69,10 @@ public:
     int get_return_couter();
 
 private:
-    // Set of arithmetic-logic VM instructions:
-    static std::unordered_set<std::string> _arithmetic_logic_operators;
-
-    // Stream of source VM instructions to map to Hack assembly. 
-    std::ifstream _vm_in;
+    // The whole source .vm file, read in up front so that lines can be
+    // tokenised in place rather than copied out.
+    std::string _vm_source;
+    size_t _next_line_start;
 
     // Whether or not to show additional parsing debug information.
     bool _debug_mode;
@@ -102,25 +99,13 @@ private:
     std::string _arg1;
     int _arg2;
 
-    // Regex patterns for extracting arguments (via capture groups) from various
-    // VM instruction formats.
-    static std::regex _push_pop_pattern;
-    static std::regex _arithmetic_logic_pattern;
-    static std::regex _label_pattern;
-    static std::regex _goto_pattern;
-    static std::regex _if_pattern;
-    static std::regex _function_pattern;
-    static std::regex _call_pattern;
-    static std::regex _return_pattern;
-    static std::smatch _match_results;
-    
-    // Applies transformations to the current instruction to normalise it for
-    // parsing.
-    void preprocess();
+    // Strips leading whitespace, comments and trailing whitespace from a line.
+    static std::string_view preprocess(std::string_view line);
 
-    // Parses the current instruction and populates _command_type, _arg1 and
-    // _arg2. Returns true if the instruction is valid.
-    bool parse();
+    // Parses the given preprocessed instruction and populates
+    // _instruction_type, _arg1 and _arg2. Returns true if the instruction is
+    // valid.
+    bool parse(std::string_view instruction);
 
     // Prints to `stdout` parsing debugging information.
     void show_instruction_debug_info();
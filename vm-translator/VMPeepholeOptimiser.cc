@@ -0,0 +1,95 @@
+#include "VMPeepholeOptimiser.h"
+
+static void remove_matched(const VMInstruction*, std::vector<VMInstruction>&) {
+}
+
+// Fuses `eq|gt|lt`, an optional `not` and `if-goto` into one branch on the
+// comparison.
+static void fuse_compare_and_branch(const VMInstruction* matched, std::vector<VMInstruction>& out) {
+    const bool is_negated = matched[1].opcode == VMOpcode::NOT;
+    VMOpcode opcode = VMOpcode::IF_EQ_GOTO;
+    if (matched[0].opcode == VMOpcode::GT) opcode = is_negated ? VMOpcode::IF_LE_GOTO : VMOpcode::IF_GT_GOTO;
+    else if (matched[0].opcode == VMOpcode::LT) opcode = is_negated ? VMOpcode::IF_GE_GOTO : VMOpcode::IF_LT_GOTO;
+    else if (is_negated) opcode = VMOpcode::IF_NE_GOTO;
+    out.push_back({ opcode, VMSegment::NONE, VMSegment::NONE, 0, matched[is_negated ? 2 : 1].symbol });
+}
+
+const std::vector<VMPeepholeRule> VMPeepholeOptimiser::RULES = {
+    // push segment i; pop target j  =>  move segment i target j
+    { "move", { { VMOpcode::PUSH }, { VMOpcode::POP } },
+        [](const VMInstruction* matched, std::vector<VMInstruction>& out) {
+            out.push_back({
+                VMOpcode::MOVE, matched[0].segment, matched[1].segment,
+                matched[0].index, static_cast<uint32_t>(matched[1].index)
+            });
+        } },
+    // push constant n; neg  =>  push constant -n
+    { "negate-constant", { { VMOpcode::PUSH, VMSegment::CONSTANT }, { VMOpcode::NEG } },
+        [](const VMInstruction* matched, std::vector<VMInstruction>& out) {
+            out.push_back({ VMOpcode::PUSH, VMSegment::CONSTANT, VMSegment::NONE, -matched[0].index, 0 });
+        } },
+    // x + 0 and x - 0 are x.
+    { "add-zero", { { VMOpcode::PUSH, VMSegment::CONSTANT, 0 }, { VMOpcode::ADD } }, remove_matched },
+    { "sub-zero", { { VMOpcode::PUSH, VMSegment::CONSTANT, 0 }, { VMOpcode::SUB } }, remove_matched },
+    { "increment", { { VMOpcode::PUSH, VMSegment::CONSTANT, 1 }, { VMOpcode::ADD } },
+        [](const VMInstruction*, std::vector<VMInstruction>& out) {
+            out.push_back({ VMOpcode::INC, VMSegment::NONE, VMSegment::NONE, 0, 0 });
+        } },
+    { "decrement", { { VMOpcode::PUSH, VMSegment::CONSTANT, 1 }, { VMOpcode::SUB } },
+        [](const VMInstruction*, std::vector<VMInstruction>& out) {
+            out.push_back({ VMOpcode::DEC, VMSegment::NONE, VMSegment::NONE, 0, 0 });
+        } },
+    { "double-not", { { VMOpcode::NOT }, { VMOpcode::NOT } }, remove_matched },
+    { "double-neg", { { VMOpcode::NEG }, { VMOpcode::NEG } }, remove_matched },
+    // lt; if-goto L  =>  if-lt-goto L, and likewise for the other comparisons.
+    // Comparisons only give 0 or -1, so a `not` between them flips the
+    // condition.
+    { "eq-if-goto", { { VMOpcode::EQ }, { VMOpcode::IF_GOTO } }, fuse_compare_and_branch },
+    { "gt-if-goto", { { VMOpcode::GT }, { VMOpcode::IF_GOTO } }, fuse_compare_and_branch },
+    { "lt-if-goto", { { VMOpcode::LT }, { VMOpcode::IF_GOTO } }, fuse_compare_and_branch },
+    { "eq-not-if-goto", { { VMOpcode::EQ }, { VMOpcode::NOT }, { VMOpcode::IF_GOTO } }, fuse_compare_and_branch },
+    { "gt-not-if-goto", { { VMOpcode::GT }, { VMOpcode::NOT }, { VMOpcode::IF_GOTO } }, fuse_compare_and_branch },
+    { "lt-not-if-goto", { { VMOpcode::LT }, { VMOpcode::NOT }, { VMOpcode::IF_GOTO } }, fuse_compare_and_branch },
+    // not; if-goto L  =>  if-not-goto L
+    { "not-if-goto", { { VMOpcode::NOT }, { VMOpcode::IF_GOTO } },
+        [](const VMInstruction* matched, std::vector<VMInstruction>& out) {
+            out.push_back({ VMOpcode::IF_NOT_GOTO, VMSegment::NONE, VMSegment::NONE, 0, matched[1].symbol });
+        } },
+};
+
+static bool matches(const VMPatternStep& step, const VMInstruction& instruction) {
+    return step.opcode == instruction.opcode &&
+        (step.segment == VMSegment::NONE || step.segment == instruction.segment) &&
+        (!step.index || *step.index == instruction.index);
+}
+
+std::vector<size_t> VMPeepholeOptimiser::optimise(VMTranslationUnit& unit, const std::vector<bool>& enabled_rules) {
+    std::vector<size_t> rule_counts(RULES.size(), 0);
+    std::vector<VMInstruction> optimised;
+    optimised.reserve(unit.instructions().size());
+    for (const VMInstruction& instruction : unit.instructions()) {
+        optimised.push_back(instruction);
+
+        // Every rule shortens the instructions, so this stops.
+        for (bool is_rewritten = true; is_rewritten; ) {
+            is_rewritten = false;
+            for (size_t i = 0; i < RULES.size() && !is_rewritten; ++i) {
+                const std::vector<VMPatternStep>& pattern = RULES[i].pattern;
+                if (!enabled_rules[i] || optimised.size() < pattern.size()) continue;
+                const size_t start = optimised.size() - pattern.size();
+                bool is_match = true;
+                for (size_t j = 0; j < pattern.size() && is_match; ++j)
+                    is_match = matches(pattern[j], optimised[start + j]);
+                if (!is_match) continue;
+
+                const std::vector<VMInstruction> matched(optimised.begin() + start, optimised.end());
+                optimised.resize(start);
+                RULES[i].rewrite(matched.data(), optimised);
+                ++rule_counts[i];
+                is_rewritten = true;
+            }
+        }
+    }
+    unit.instructions() = std::move(optimised);
+    return rule_counts;
+}
@@ -0,0 +1,49 @@
+#ifndef VMPEEPHOLE_OPTIMISER_H
+#define VMPEEPHOLE_OPTIMISER_H
+
+#include "VMProgram.h"
+#include <cstddef>
+#include <optional>
+#include <string>
+#include <vector>
+
+/**
+ * One instruction of a peephole pattern. Segments and indices that aren't
+ * given match any.
+ */
+struct VMPatternStep {
+    VMOpcode opcode;
+    VMSegment segment = VMSegment::NONE;
+    std::optional<int32_t> index = std::nullopt;
+};
+
+/**
+ * Replaces a run of instructions matching `pattern` with what `rewrite`
+ * appends to `out` for it, which must be fewer instructions.
+ */
+struct VMPeepholeRule {
+    std::string name;
+    std::vector<VMPatternStep> pattern;
+    void (*rewrite)(const VMInstruction* matched, std::vector<VMInstruction>& out);
+};
+
+/**
+ * Rewrites short sequences that compiled Jack code is full of into fewer,
+ * cheaper instructions, eg. `push local 0; pop static 1` into a `move` that
+ * `AsmMapper` writes without going through the stack. Rules are matched
+ * against the end of the rewritten instructions as each instruction is added,
+ * so the result of one rule can take part in another. Labels sit between
+ * instructions, so nothing is rewritten across a jump target.
+ */
+class VMPeepholeOptimiser {
+public:
+    static const std::vector<VMPeepholeRule> RULES;
+
+    /**
+     * Applies the rules of `RULES` whose entry in `enabled_rules` is set, and
+     * returns how many times each one fired.
+     */
+    static std::vector<size_t> optimise(VMTranslationUnit& unit, const std::vector<bool>& enabled_rules);
+};
+
+#endif
@@ -0,0 +1,245 @@
+#include "VMProgram.h"
+#include "VMParser.h"
+#include <array>
+#include <iostream>
+
+static_assert(sizeof(VMInstruction) == 12, "VM instructions should stay compact.");
+
+// Segment names, indexed by `VMSegment`.
+constexpr std::array<std::string_view, 10> SEGMENT_NAMES = {
+    "", "argument", "local", "static", "constant", "this", "that", "pointer", "temp", "named"
+};
+
+// VM command words, indexed by `VMOpcode`.
+constexpr std::array<std::string_view, 27> OPCODE_NAMES = {
+    "push", "pop", "add", "sub", "neg", "eq", "gt", "lt", "and", "or", "not",
+    "label", "goto", "if-goto", "function", "call", "return",
+    "move", "if-not-goto", "inc", "dec",
+    "if-eq-goto", "if-gt-goto", "if-lt-goto", "if-ne-goto", "if-le-goto", "if-ge-goto"
+};
+
+// Identifies serialised translation units, and changes whenever their layout
+// does.
+constexpr uint32_t IR_MAGIC = 0x52494d56;  // "VMIR", little-endian.
+constexpr uint32_t IR_VERSION = 1;
+
+static void write_u32(std::ostream& ir_out, const uint32_t value) {
+    const char bytes[4] = {
+        static_cast<char>(value), static_cast<char>(value >> 8),
+        static_cast<char>(value >> 16), static_cast<char>(value >> 24)
+    };
+    ir_out.write(bytes, 4);
+}
+
+static bool read_u32(std::istream& ir_in, uint32_t& value) {
+    unsigned char bytes[4];
+    if (!ir_in.read(reinterpret_cast<char*>(bytes), 4)) return false;
+    value = bytes[0] | bytes[1] << 8 | bytes[2] << 16 | static_cast<uint32_t>(bytes[3]) << 24;
+    return true;
+}
+
+static void write_string(std::ostream& ir_out, const std::string& text) {
+    write_u32(ir_out, text.size());
+    ir_out.write(text.data(), text.size());
+}
+
+static bool read_string(std::istream& ir_in, std::string& text) {
+    uint32_t size;
+    if (!read_u32(ir_in, size)) return false;
+    text.resize(size);
+    return static_cast<bool>(ir_in.read(text.data(), size));
+}
+
+VMTranslationUnit::VMTranslationUnit(const std::string& name)
+    : _name(name) {
+}
+
+VMTranslationUnit VMTranslationUnit::from_vm_file(const std::string& path, const std::string& name) {
+    VMTranslationUnit unit(name);
+    VMParser parser(path, false);
+    while (parser.has_more_lines()) {
+        parser.advance();
+        VMInstruction instruction = { VMOpcode::PUSH, VMSegment::NONE, VMSegment::NONE, 0, 0 };
+        switch (parser.instruction_type()) {
+            case VMOperationType::C_ARITHMETIC: {
+                const std::string command = parser.get_curr_instruction();
+                const std::string_view word = std::string_view(command).substr(0, command.find_first_of(" \t"));
+                for (size_t i = 0; i < OPCODE_NAMES.size(); ++i)
+                    if (OPCODE_NAMES[i] == word) instruction.opcode = static_cast<VMOpcode>(i);
+                break;
+            }
+            case VMOperationType::C_PUSH:
+            case VMOperationType::C_POP:
+                instruction.opcode = parser.instruction_type() == VMOperationType::C_PUSH ? VMOpcode::PUSH : VMOpcode::POP;
+                instruction.segment = segment_of(parser.arg1());
+                instruction.index = parser.arg2();
+                if (instruction.segment == VMSegment::NONE || instruction.segment == VMSegment::NAMED ||
+                        (instruction.opcode == VMOpcode::POP && instruction.segment == VMSegment::CONSTANT)) {
+                    std::cerr << "Syntax Error: unknown segment '" << parser.arg1() << "'\n";
+                    continue;
+                }
+                break;
+            case VMOperationType::C_LABEL:
+                instruction.opcode = VMOpcode::LABEL;
+                instruction.symbol = unit.intern(parser.arg1());
+                break;
+            case VMOperationType::C_GOTO:
+                instruction.opcode = VMOpcode::GOTO;
+                instruction.symbol = unit.intern(parser.arg1());
+                break;
+            case VMOperationType::C_IF:
+                instruction.opcode = VMOpcode::IF_GOTO;
+                instruction.symbol = unit.intern(parser.arg1());
+                break;
+            case VMOperationType::C_FUNCTION:
+                instruction.opcode = VMOpcode::FUNCTION;
+                instruction.symbol = unit.intern(parser.arg1());
+                instruction.index = parser.arg2();
+                break;
+            case VMOperationType::C_CALL:
+                instruction.opcode = VMOpcode::CALL;
+                instruction.symbol = unit.intern(parser.arg1());
+                instruction.index = parser.arg2();
+                break;
+            case VMOperationType::C_RETURN:
+                instruction.opcode = VMOpcode::RETURN;
+                break;
+            default:
+                continue;
+        }
+        unit._instructions.push_back(instruction);
+    }
+    return unit;
+}
+
+bool VMTranslationUnit::read(std::istream& ir_in, VMTranslationUnit& unit) {
+    uint32_t magic, version, num_symbols, num_instructions;
+    if (!read_u32(ir_in, magic) || magic != IR_MAGIC || !read_u32(ir_in, version) || version != IR_VERSION)
+        return false;
+    if (!read_string(ir_in, unit._name) || !read_u32(ir_in, num_symbols)) return false;
+
+    unit._symbols.clear();
+    unit._symbol_ids.clear();
+    for (uint32_t i = 0; i < num_symbols; ++i) {
+        std::string symbol;
+        if (!read_string(ir_in, symbol)) return false;
+        unit.intern(symbol);
+    }
+
+    // Each instruction is stored as its opcode and segments, then its index
+    // and symbol.
+    if (!read_u32(ir_in, num_instructions)) return false;
+    unit._instructions.clear();
+    unit._instructions.reserve(num_instructions);
+    for (uint32_t i = 0; i < num_instructions; ++i) {
+        uint32_t kind, index, symbol;
+        if (!read_u32(ir_in, kind) || !read_u32(ir_in, index) || !read_u32(ir_in, symbol)) return false;
+        const uint8_t opcode = kind & 0xFF;
+        const uint8_t segment = kind >> 8 & 0xFF;
+        const uint8_t target_segment = kind >> 16 & 0xFF;
+        if (opcode >= OPCODE_NAMES.size() || segment >= SEGMENT_NAMES.size() || target_segment >= SEGMENT_NAMES.size())
+            return false;
+        const VMOpcode each_opcode = static_cast<VMOpcode>(opcode);
+        if (has_symbol(each_opcode) && symbol >= num_symbols) return false;
+        if ((segment == static_cast<uint8_t>(VMSegment::NAMED) && index >= num_symbols) ||
+                (target_segment == static_cast<uint8_t>(VMSegment::NAMED) && symbol >= num_symbols))
+            return false;
+        unit._instructions.push_back({
+            each_opcode, static_cast<VMSegment>(segment), static_cast<VMSegment>(target_segment),
+            static_cast<int32_t>(index), symbol
+        });
+    }
+    return true;
+}
+
+void VMTranslationUnit::write(std::ostream& ir_out) const {
+    write_u32(ir_out, IR_MAGIC);
+    write_u32(ir_out, IR_VERSION);
+    write_string(ir_out, _name);
+    write_u32(ir_out, _symbols.size());
+    for (const std::string& symbol : _symbols) write_string(ir_out, symbol);
+    write_u32(ir_out, _instructions.size());
+    for (const VMInstruction& instruction : _instructions) {
+        write_u32(ir_out, static_cast<uint32_t>(instruction.opcode) | static_cast<uint32_t>(instruction.segment) << 8 |
+            static_cast<uint32_t>(instruction.target_segment) << 16);
+        write_u32(ir_out, instruction.index);
+        write_u32(ir_out, instruction.symbol);
+    }
+}
+
+const std::string& VMTranslationUnit::name() const {
+    return _name;
+}
+
+std::vector<VMInstruction>& VMTranslationUnit::instructions() {
+    return _instructions;
+}
+
+const std::vector<VMInstruction>& VMTranslationUnit::instructions() const {
+    return _instructions;
+}
+
+uint32_t VMTranslationUnit::intern(std::string_view symbol) {
+    const auto inserted = _symbol_ids.emplace(std::string(symbol), _symbols.size());
+    if (inserted.second) _symbols.emplace_back(symbol);
+    return inserted.first->second;
+}
+
+const std::string& VMTranslationUnit::symbol(const uint32_t id) const {
+    return _symbols[id];
+}
+
+const std::vector<std::string>& VMTranslationUnit::symbols() const {
+    return _symbols;
+}
+
+std::string VMTranslationUnit::to_string(const VMInstruction& instruction) const {
+    std::string text(opcode_name(instruction.opcode));
+    // Named variables are shown by name rather than symbol ID.
+    auto operand = [&](const VMSegment segment, const uint32_t index) {
+        return " " + std::string(segment_name(segment)) + " " +
+            (segment == VMSegment::NAMED ? symbol(index) : std::to_string(static_cast<int32_t>(index)));
+    };
+    switch (instruction.opcode) {
+        case VMOpcode::PUSH:
+        case VMOpcode::POP:
+            return text + operand(instruction.segment, instruction.index);
+        case VMOpcode::MOVE:
+            return text + operand(instruction.segment, instruction.index) + operand(instruction.target_segment, instruction.symbol);
+        case VMOpcode::LABEL:
+        case VMOpcode::GOTO:
+        case VMOpcode::IF_GOTO:
+        case VMOpcode::IF_NOT_GOTO:
+        case VMOpcode::IF_EQ_GOTO:
+        case VMOpcode::IF_GT_GOTO:
+        case VMOpcode::IF_LT_GOTO:
+        case VMOpcode::IF_NE_GOTO:
+        case VMOpcode::IF_LE_GOTO:
+        case VMOpcode::IF_GE_GOTO:
+            return text + " " + symbol(instruction.symbol);
+        case VMOpcode::FUNCTION:
+        case VMOpcode::CALL:
+            return text + " " + symbol(instruction.symbol) + " " + std::to_string(instruction.index);
+        default:
+            return text;
+    }
+}
+
+VMSegment VMTranslationUnit::segment_of(std::string_view name) {
+    for (size_t i = 1; i < SEGMENT_NAMES.size(); ++i)
+        if (SEGMENT_NAMES[i] == name) return static_cast<VMSegment>(i);
+    return VMSegment::NONE;
+}
+
+std::string_view VMTranslationUnit::segment_name(const VMSegment segment) {
+    return SEGMENT_NAMES[static_cast<size_t>(segment)];
+}
+
+std::string_view VMTranslationUnit::opcode_name(const VMOpcode opcode) {
+    return OPCODE_NAMES[static_cast<size_t>(opcode)];
+}
+
+bool VMTranslationUnit::has_symbol(const VMOpcode opcode) {
+    return (opcode >= VMOpcode::LABEL && opcode <= VMOpcode::CALL) || opcode == VMOpcode::IF_NOT_GOTO ||
+        opcode >= VMOpcode::IF_EQ_GOTO;
+}
@@ -0,0 +1,154 @@
+#ifndef VMPROGRAM_H
+#define VMPROGRAM_H
+
+#include <cstdint>
+#include <istream>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+enum class VMOpcode : uint8_t {
+    PUSH,
+    POP,
+    ADD,
+    SUB,
+    NEG,
+    EQ,
+    GT,
+    LT,
+    AND,
+    OR,
+    NOT,
+    LABEL,
+    GOTO,
+    IF_GOTO,
+    FUNCTION,
+    CALL,
+    RETURN,
+
+    // Pseudo-ops that `VMPeepholeOptimiser` fuses common sequences into.
+    MOVE,         // push segment index; pop target_segment symbol
+    IF_NOT_GOTO,  // not; if-goto symbol
+    INC,          // push constant 1; add
+    DEC,          // push constant 1; sub
+    IF_EQ_GOTO,   // eq; if-goto symbol
+    IF_GT_GOTO,   // gt; if-goto symbol
+    IF_LT_GOTO,   // lt; if-goto symbol
+    IF_NE_GOTO,   // eq; not; if-goto symbol
+    IF_LE_GOTO,   // gt; not; if-goto symbol
+    IF_GE_GOTO    // lt; not; if-goto symbol
+};
+
+enum class VMSegment : uint8_t {
+    NONE,
+    ARGUMENT,
+    LOCAL,
+    STATIC,
+    CONSTANT,
+    THIS,
+    THAT,
+    POINTER,
+    TEMP,
+
+    // The RAM variable named by the symbol whose ID is the index, eg. the
+    // scratch variables that `VMInliner` gives an inlined function's
+    // arguments. Only used inside the translator.
+    NAMED
+};
+
+/**
+ * One VM instruction. Labels and function names are IDs into the symbol table
+ * of the translation unit the instruction belongs to, which keeps every
+ * instruction the same small size.
+ */
+struct VMInstruction {
+    VMOpcode opcode;
+    VMSegment segment;
+
+    // The segment `move` writes to.
+    VMSegment target_segment;
+
+    // The index for push/pop, the number of local variables for `function`
+    // and the number of arguments for `call`.
+    int32_t index;
+
+    // The label for label/goto/if-goto, the function name for function/call
+    // and the index `move` writes to.
+    uint32_t symbol;
+};
+
+/**
+ * The instructions of one .vm file, held in memory between parsing and code
+ * generation so that passes can run over them.
+ */
+class VMTranslationUnit {
+public:
+    explicit VMTranslationUnit(const std::string& name);
+
+    /**
+     * Parses the given .vm file. The unit is named after the file's basename.
+     * Invalid instructions are reported to `stderr` and skipped, like
+     * `VMParser` does.
+     */
+    static VMTranslationUnit from_vm_file(const std::string& path, const std::string& name);
+
+    /**
+     * Reads a unit written by `write`, so that the .vm file doesn't have to be
+     * parsed again. Returns false if the stream doesn't hold a valid unit.
+     */
+    static bool read(std::istream& ir_in, VMTranslationUnit& unit);
+
+    /**
+     * Writes the unit in a compact binary form that `read` loads back.
+     */
+    void write(std::ostream& ir_out) const;
+
+    const std::string& name() const;
+    std::vector<VMInstruction>& instructions();
+    const std::vector<VMInstruction>& instructions() const;
+
+    /**
+     * Returns the ID of the given label or function name, adding it to the
+     * symbol table if it's new.
+     */
+    uint32_t intern(std::string_view symbol);
+
+    const std::string& symbol(const uint32_t id) const;
+    const std::vector<std::string>& symbols() const;
+
+    /**
+     * Returns the instruction as it would be written in a .vm file, eg.
+     * `push local 2`.
+     */
+    std::string to_string(const VMInstruction& instruction) const;
+
+    /**
+     * Maps between segment names in .vm files and `VMSegment`. Unknown names
+     * map to `VMSegment::NONE`.
+     */
+    static VMSegment segment_of(std::string_view name);
+    static std::string_view segment_name(const VMSegment segment);
+
+    /**
+     * Returns the VM command word for the given opcode, eg. `if-goto`.
+     */
+    static std::string_view opcode_name(const VMOpcode opcode);
+
+    /**
+     * Whether instructions with the given opcode name a label or function in
+     * `symbol`.
+     */
+    static bool has_symbol(const VMOpcode opcode);
+
+private:
+    std::string _name;
+    std::vector<VMInstruction> _instructions;
+
+    // Interned labels and function names, indexed by ID.
+    std::vector<std::string> _symbols;
+    std::unordered_map<std::string, uint32_t> _symbol_ids;
+};
+
+#endif
@@ -1,20 +1,97 @@
 #include "AsmMapper.h"
-#include "VMParser.h"
+#include "VMCallGraph.h"
+#include "VMFrameAllocator.h"
+#include "VMInliner.h"
+#include "VMPeepholeOptimiser.h"
+#include "VMProgram.h"
+#include <algorithm>
+#include <atomic>
+#include <functional>
+#include <iomanip>
 #include <iostream>
+#include <numeric>
 #include <regex>
 #include <fstream>
 #include <filesystem>
+#include <sstream>
+#include <thread>
 
-// Reads in the VM instructions in the given .vm file and produces an .asm file
-// containing all the translated Hack assembly instructions.
-// Assumes that the given .vm file exists.
-void translate_vm_file_to_asm_file(AsmMapper& code_mapper, std::string& path);
+// Options given on the command line.
+struct TranslatorOptions {
+    // `--emit-ir`: save each parsed .vm file as a .vmir file, which later runs
+    // can load without parsing.
+    bool emit_ir = false;
+
+    // `--shared-calls`: call and return through shared routines rather than
+    // inlining them. See `AsmMapper::use_shared_call_routines`.
+    bool shared_calls = false;
+
+    // `--cache-tos`: keep the top of the stack in D between instructions. See
+    // `AsmMapper::use_top_of_stack_caching`.
+    bool cache_top_of_stack = false;
+
+    // `--peephole[=rule,...]`: which of `VMPeepholeOptimiser::RULES` to apply.
+    // Empty if the peephole optimiser is off.
+    std::vector<bool> peephole_rules;
+
+    // `--peephole-stats`: report how many times each peephole rule fired.
+    bool peephole_stats = false;
+
+    // `--remove-dead-functions`: leave out the functions that `Sys.init`
+    // never calls, directly or indirectly.
+    bool remove_dead_functions = false;
+
+    // `--inline[=size]`: inline calls to leaf functions of up to this many VM
+    // instructions, counting their locals. 0 if the inliner is off.
+    size_t max_inline_size = 0;
+
+    // `--static-frames`: give non-recursive functions frames at fixed RAM
+    // addresses. See `VMFrameAllocator`.
+    bool static_frames = false;
+};
+
+// The `--inline` size if none is given, which takes in getters, setters and
+// the likes of `Math.abs` and `Memory.peek`.
+constexpr size_t DEFAULT_MAX_INLINE_SIZE = 16;
+
+// The result of translating one translation unit.
+struct TranslatedUnit {
+    std::string assembly;
+
+    // How many times each peephole rule fired, if the optimiser ran.
+    std::vector<size_t> peephole_counts;
+};
+
+// Reads in the VM instructions in the given .vm file.
+// Assumes that the given .vm file exists. If `options.emit_ir` is set, the
+// parsed instructions are also saved next to the .vm file as a .vmir file. A
+// .vmir file can be given in place of a .vm file to skip parsing. An invalid
+// .vmir file falls back to the .vm file next to it, and returns false if
+// there's none.
+bool load_vm_file(std::string path, const TranslatorOptions& options, VMTranslationUnit& unit);
+
+// Optimises the given unit as the options ask and returns its Hack assembly.
+TranslatedUnit translate_unit(VMTranslationUnit& unit, const TranslatorOptions& options);
+
+// Counts the Hack instructions in the given assembly, ie. the lines that aren't
+// labels, comments or blank.
+size_t count_hack_instructions(const std::string& assembly);
+
+// Parses the rule names in `--peephole=rule,...` into `options`. Returns false
+// for unknown rules.
+bool parse_peephole_rules(const std::string& rule_names, TranslatorOptions& options);
+
+// Writes the Hack assembly for every instruction of the given translation unit.
+void write_translation_unit(AsmMapper& code_mapper, const VMTranslationUnit& unit);
+
+// Runs `task(0)` to `task(count - 1)` across all cores.
+void run_in_parallel(const size_t count, const std::function<void(size_t)>& task);
 
 // Extracts the basename from a given path.
 // Eg. Given "/home/linus/hello.txt", `get_basename` returns "hello".
 std::string get_basename(std::string& path);
 
-// Determines whether the given file has the .vm file extension.
+// Determines whether the given file has the .vm or .vmir file extension.
 bool is_vm_file(const std::string& path);
 
 // Returns the same path that was given, but one level back.
@@ -22,10 +99,52 @@ bool is_vm_file(const std::string& path);
 std::string get_directory_of_file(const std::string& path);
 
 int main(int argc, char* argv[]) {
-    if (argc < 2) std::cerr << "Insufficient arguments. Please supply a path to the .vm source file.\n";
-    else if (argc > 3) std::cerr << "Too many arguments.\n";
-
-    std::string input_file_path = argv[1];
+    TranslatorOptions options;
+    std::string input_file_path;
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        if (arg == "--emit-ir") {
+            options.emit_ir = true;
+        } else if (arg == "--shared-calls") {
+            options.shared_calls = true;
+        } else if (arg == "--cache-tos") {
+            options.cache_top_of_stack = true;
+        } else if (arg == "--peephole") {
+            options.peephole_rules.assign(VMPeepholeOptimiser::RULES.size(), true);
+        } else if (arg.rfind("--peephole=", 0) == 0) {
+            if (!parse_peephole_rules(arg.substr(11), options)) return 1;
+        } else if (arg == "--peephole-stats") {
+            options.peephole_stats = true;
+        } else if (arg == "--remove-dead-functions") {
+            options.remove_dead_functions = true;
+        } else if (arg == "--inline") {
+            options.max_inline_size = DEFAULT_MAX_INLINE_SIZE;
+        } else if (arg.rfind("--inline=", 0) == 0) {
+            const std::string size = arg.substr(9);
+            if (size.empty() || size.find_first_not_of("0123456789") != std::string::npos) {
+                std::cerr << "Invalid inline size '" << size << "'.\n";
+                return 1;
+            }
+            options.max_inline_size = std::stoul(size);
+        } else if (arg == "--static-frames") {
+            options.static_frames = true;
+        } else if (arg.rfind("--", 0) == 0) {
+            std::cerr << "Unknown option '" << arg << "'.\n";
+            return 1;
+        } else if (!input_file_path.empty()) {
+            std::cerr << "Too many arguments.\n";
+            return 1;
+        } else {
+            input_file_path = arg;
+        }
+    }
+    if (input_file_path.empty()) {
+        std::cerr << "Insufficient arguments. Please supply a path to the .vm source file.\n"
+                  << "Usage: " << argv[0] << " [--emit-ir] [--shared-calls] [--cache-tos] [--peephole[=rule,...]] [--peephole-stats]\n"
+                  << "    [--remove-dead-functions] [--inline[=size]] [--static-frames]\n"
+                  << "    <file.vm | file.vmir | dir>\n";
+        return 1;
+    }
     // std::string output_file_path = output_dir + basename + ".asm";
     std::string basename = get_basename(input_file_path);
     std::string output_file_path;
@@ -36,73 +155,260 @@ int main(int argc, char* argv[]) {
         output_file_path = get_directory_of_file(input_file_path) + basename + ".asm";
     }
 
-    AsmMapper code_mapper(output_file_path, basename);
-
     // If the given path points to a directory, then process all .vm files found
     // in that directory. Otherwise, process a single file.
+    std::vector<std::string> paths;
     if (std::filesystem::is_directory(input_file_path)) {
         std::cout << argv[0] << ": Translating and concatenating all .vm files in the given directory.\n";
 
-        // Translate each .vm file in the given directory.
         for (std::filesystem::directory_entry each_file : std::filesystem::directory_iterator(input_file_path)) {
             if (is_vm_file(each_file.path())) {
-                std::cout << argv[0] << ": Processing " << each_file.path() << "\n";
-                std::string path = each_file.path();
-                translate_vm_file_to_asm_file(code_mapper, path);
+                // A .vmir file saved from a .vm file stands in for it until the
+                // .vm file is edited. A .vmir file without a .vm file is
+                // loaded as it is.
+                std::filesystem::path vm_path = each_file.path();
+                std::filesystem::path ir_path = each_file.path();
+                vm_path.replace_extension(".vm");
+                ir_path.replace_extension(".vmir");
+                const bool has_vm_file = std::filesystem::exists(vm_path);
+                if (each_file.path() == ir_path && has_vm_file) continue;
+                if (!has_vm_file) {
+                    paths.push_back(ir_path);
+                    continue;
+                }
+                const bool is_ir_current = !options.emit_ir && std::filesystem::exists(ir_path) &&
+                    std::filesystem::last_write_time(ir_path) >= std::filesystem::last_write_time(vm_path);
+                paths.push_back(is_ir_current ? ir_path : vm_path);
             }
         }
+        // Files are concatenated in name order, so the output doesn't depend
+        // on the order the file system lists them in.
+        std::sort(paths.begin(), paths.end());
+        for (const std::string& path : paths) std::cout << argv[0] << ": Processing \"" << path << "\"\n";
     } else {
         std::cout << argv[0] << ": Translating a single file.\n\n";
-        translate_vm_file_to_asm_file(code_mapper, input_file_path);
+        paths.push_back(input_file_path);
     }
+
+    // Each file is loaded, and later translated into its own buffer, on its
+    // own thread. Labels are qualified by the file's name, so the buffers can
+    // simply be joined. Passes over the whole program run in between.
+    std::vector<VMTranslationUnit> units(paths.size(), VMTranslationUnit(""));
+    std::atomic<bool> is_loaded(true);
+    run_in_parallel(paths.size(), [&](const size_t i) {
+        if (!load_vm_file(paths[i], options, units[i])) is_loaded = false;
+    });
+    if (!is_loaded) return 1;
+
+    std::vector<size_t> num_inlined_calls;
+    if (options.max_inline_size > 0)
+        num_inlined_calls = VMInliner::inline_calls(units, VMCallGraph(units), options.max_inline_size);
+    const VMCallGraph call_graph(units);
+    const bool defines_sys_init = call_graph.find("Sys.init") != VMCallGraph::NOT_FOUND;
+
+    std::vector<VMTranslationUnit> dead_functions;
+    if (options.remove_dead_functions) {
+        if (defines_sys_init) dead_functions = call_graph.remove_dead_functions(units);
+        else std::cerr << "Warning: no Sys.init to find the live functions from, so none were removed.\n";
+    }
+    VMStaticFrames static_frames;
+    if (options.static_frames) {
+        if (defines_sys_init) static_frames = VMFrameAllocator::allocate_static_frames(units, VMCallGraph(units));
+        else std::cerr << "Warning: no Sys.init to start the program from, so no frames were made static.\n";
+    }
+
+    std::vector<TranslatedUnit> translated_units(units.size());
+    run_in_parallel(units.size(), [&](const size_t i) {
+        translated_units[i] = translate_unit(units[i], options);
+    });
+
+    std::ofstream asm_out(output_file_path);
+    AsmMapper code_mapper(asm_out, basename);
+    code_mapper.use_shared_call_routines(options.shared_calls);
+    code_mapper.write_bootstrap_init(defines_sys_init);
+    for (const TranslatedUnit& translated_unit : translated_units) asm_out << translated_unit.assembly;
     code_mapper.write_inf_loop();
-    code_mapper.close();
+    asm_out.close();
     std::cout << "Output path: " << output_file_path << std::endl;
+
+    if (options.max_inline_size > 0) {
+        const size_t num_calls = std::accumulate(num_inlined_calls.begin(), num_inlined_calls.end(), size_t(0));
+        const size_t num_functions = num_inlined_calls.size() - std::count(num_inlined_calls.begin(), num_inlined_calls.end(), 0);
+        std::cout << "Inlined " << num_calls << " calls to " << num_functions << " functions.\n";
+    }
+    if (!static_frames.is_static.empty()) {
+        std::cout << "Gave " << std::count(static_frames.is_static.begin(), static_frames.is_static.end(), true) << " of "
+                  << static_frames.is_static.size() << " functions static frames, in " << static_frames.num_words
+                  << " words of RAM.\n";
+    }
+    if (!dead_functions.empty()) {
+        // The dead functions are translated too, just to measure them.
+        size_t num_functions = 0, num_vm_instructions = 0, num_bytes = 0, num_hack_instructions = 0;
+        for (VMTranslationUnit& unit : dead_functions) {
+            for (const VMInstruction& instruction : unit.instructions())
+                if (instruction.opcode == VMOpcode::FUNCTION) ++num_functions;
+            num_vm_instructions += unit.instructions().size();
+            const std::string assembly = translate_unit(unit, options).assembly;
+            num_bytes += assembly.size();
+            num_hack_instructions += count_hack_instructions(assembly);
+        }
+        std::cout << "Removed " << num_functions << " of " << call_graph.functions().size() << " functions ("
+                  << num_vm_instructions << " VM instructions), saving " << num_bytes << " bytes of assembly and "
+                  << num_hack_instructions << " Hack instructions.\n";
+    }
+
+    if (options.peephole_stats && !options.peephole_rules.empty()) {
+        std::cout << "\nPeephole rules fired:\n";
+        for (size_t i = 0; i < VMPeepholeOptimiser::RULES.size(); ++i) {
+            if (!options.peephole_rules[i]) continue;
+            size_t count = 0;
+            for (const TranslatedUnit& translated_unit : translated_units) count += translated_unit.peephole_counts[i];
+            std::cout << "    " << std::left << std::setw(20) << VMPeepholeOptimiser::RULES[i].name << count << "\n";
+        }
+    }
     return 0;
 }
 
-void translate_vm_file_to_asm_file(AsmMapper& code_mapper, std::string& path) {
-    VMParser parser(path, false);
+bool parse_peephole_rules(const std::string& rule_names, TranslatorOptions& options) {
+    options.peephole_rules.assign(VMPeepholeOptimiser::RULES.size(), false);
+    std::istringstream names_in(rule_names);
+    for (std::string name; std::getline(names_in, name, ','); ) {
+        const auto rule = std::find_if(VMPeepholeOptimiser::RULES.begin(), VMPeepholeOptimiser::RULES.end(),
+            [&](const VMPeepholeRule& each_rule) { return each_rule.name == name; });
+        if (rule == VMPeepholeOptimiser::RULES.end()) {
+            std::cerr << "Unknown peephole rule '" << name << "'. The rules are:";
+            for (const VMPeepholeRule& each_rule : VMPeepholeOptimiser::RULES) std::cerr << " " << each_rule.name;
+            std::cerr << "\n";
+            return false;
+        }
+        options.peephole_rules[rule - VMPeepholeOptimiser::RULES.begin()] = true;
+    }
+    return true;
+}
 
+bool load_vm_file(std::string path, const TranslatorOptions& options, VMTranslationUnit& unit) {
+    const bool is_ir_file = path.size() > 5 && path.compare(path.size() - 5, 5, ".vmir") == 0;
     std::string translation_unit_name = get_basename(path);
-    std::cout << path << "  ->  " << translation_unit_name << "\n";
-    code_mapper.start_new_translation_unit(translation_unit_name);
-
-    code_mapper.write_bootstrap_init();
-    while (parser.has_more_lines()) {
-        parser.advance();
-        switch (parser.instruction_type()) {
-            case VMOperationType::C_ARITHMETIC:
-                code_mapper.write_arithmetic(parser.get_curr_instruction());
+
+    unit = VMTranslationUnit(translation_unit_name);
+    if (is_ir_file) {
+        std::ifstream ir_in(path, std::ios::binary);
+        if (VMTranslationUnit::read(ir_in, unit)) return true;
+        // Eg. a .vmir file from an older version of the translator.
+        const std::string vm_path = path.substr(0, path.size() - 2);
+        if (!std::filesystem::exists(vm_path)) {
+            std::cerr << "Error: '" << path << "' is not a valid .vmir file.\n";
+            return false;
+        }
+        std::cerr << "Warning: '" << path << "' is not a valid .vmir file, so '" << vm_path << "' is parsed instead.\n";
+        path = vm_path;
+    }
+    unit = VMTranslationUnit::from_vm_file(path, translation_unit_name);
+    if (options.emit_ir) {
+        std::ofstream ir_out(get_directory_of_file(path) + translation_unit_name + ".vmir", std::ios::binary);
+        unit.write(ir_out);
+    }
+    return true;
+}
+
+TranslatedUnit translate_unit(VMTranslationUnit& unit, const TranslatorOptions& options) {
+    TranslatedUnit translated_unit;
+    if (!options.peephole_rules.empty())
+        translated_unit.peephole_counts = VMPeepholeOptimiser::optimise(unit, options.peephole_rules);
+
+    std::ostringstream asm_out;
+    AsmMapper code_mapper(asm_out, unit.name());
+    code_mapper.use_shared_call_routines(options.shared_calls);
+    code_mapper.use_top_of_stack_caching(options.cache_top_of_stack);
+    code_mapper.use_symbol_table(unit.symbols());
+    write_translation_unit(code_mapper, unit);
+    translated_unit.assembly = asm_out.str();
+    return translated_unit;
+}
+
+void write_translation_unit(AsmMapper& code_mapper, const VMTranslationUnit& unit) {
+    code_mapper.start_new_translation_unit(unit.name());
+
+    // Labels are scoped to the function they're in. Return labels are named
+    // after the callee, so they're numbered across the whole unit to stay
+    // unique when several functions call the same one.
+    std::string function_name;
+    int return_counter = 0;
+    for (const VMInstruction& instruction : unit.instructions()) {
+        const std::string command = unit.to_string(instruction);
+        switch (instruction.opcode) {
+            case VMOpcode::PUSH:
+                code_mapper.write_push(command, std::string(VMTranslationUnit::segment_name(instruction.segment)), instruction.index);
                 break;
-            case VMOperationType::C_PUSH:
-                code_mapper.write_push(parser.get_curr_instruction(), parser.arg1(), parser.arg2());
+            case VMOpcode::POP:
+                code_mapper.write_pop(command, std::string(VMTranslationUnit::segment_name(instruction.segment)), instruction.index);
                 break;
-            case VMOperationType::C_POP:
-                code_mapper.write_pop(parser.get_curr_instruction(), parser.arg1(), parser.arg2());
+            case VMOpcode::LABEL:
+                code_mapper.write_label(command, unit.symbol(instruction.symbol), function_name);
                 break;
-            case VMOperationType::C_LABEL:
-                code_mapper.write_label(parser.get_curr_instruction(), parser.arg1(), parser.curr_function_name());
+            case VMOpcode::GOTO:
+                code_mapper.write_goto(command, unit.symbol(instruction.symbol), function_name);
                 break;
-            case VMOperationType::C_GOTO:
-                code_mapper.write_goto(parser.get_curr_instruction(), parser.arg1(), parser.curr_function_name());
+            case VMOpcode::IF_GOTO:
+                code_mapper.write_if(command, unit.symbol(instruction.symbol), function_name);
                 break;
-            case VMOperationType::C_IF:
-                code_mapper.write_if(parser.get_curr_instruction(), parser.arg1(), parser.curr_function_name());
+            case VMOpcode::IF_NOT_GOTO:
+                code_mapper.write_if_not(command, unit.symbol(instruction.symbol), function_name);
                 break;
-            case VMOperationType::C_FUNCTION:
-                code_mapper.write_function(parser.get_curr_instruction(), parser.arg1(), parser.arg2());
+            case VMOpcode::IF_EQ_GOTO:
+            case VMOpcode::IF_GT_GOTO:
+            case VMOpcode::IF_LT_GOTO:
+            case VMOpcode::IF_NE_GOTO:
+            case VMOpcode::IF_LE_GOTO:
+            case VMOpcode::IF_GE_GOTO:
+                // The comparison is the middle of `if-<comparison>-goto`.
+                code_mapper.write_compare_and_branch(command, std::string(VMTranslationUnit::opcode_name(instruction.opcode).substr(3, 2)),
+                    unit.symbol(instruction.symbol), function_name);
                 break;
-            case VMOperationType::C_CALL:
-                code_mapper.write_call(parser.get_curr_instruction(), parser.arg1(), parser.arg2(), parser.get_return_couter());
+            case VMOpcode::MOVE:
+                code_mapper.write_move(command, std::string(VMTranslationUnit::segment_name(instruction.segment)), instruction.index,
+                    std::string(VMTranslationUnit::segment_name(instruction.target_segment)), instruction.symbol);
                 break;
-            case VMOperationType::C_RETURN:
-                code_mapper.write_return(parser.get_curr_instruction(), parser.curr_function_name());
+            case VMOpcode::FUNCTION:
+                function_name = unit.symbol(instruction.symbol);
+                code_mapper.write_function(command, function_name, instruction.index);
+                break;
+            case VMOpcode::CALL:
+                code_mapper.write_call(command, unit.symbol(instruction.symbol), instruction.index, ++return_counter);
+                break;
+            case VMOpcode::RETURN:
+                code_mapper.write_return(command, function_name);
                 break;
             default:
+                code_mapper.write_arithmetic(command);
                 break;
         }
     }
+    code_mapper.end_translation_unit();
+}
+
+size_t count_hack_instructions(const std::string& assembly) {
+    size_t num_instructions = 0;
+    std::istringstream assembly_in(assembly);
+    for (std::string line; std::getline(assembly_in, line); ) {
+        const size_t start = line.find_first_not_of(" \t");
+        if (start != std::string::npos && line[start] != '(' && line.compare(start, 2, "//") != 0) ++num_instructions;
+    }
+    return num_instructions;
+}
+
+void run_in_parallel(const size_t count, const std::function<void(size_t)>& task) {
+    // Files vary a lot in size, so each thread takes the next file from a
+    // shared counter rather than a fixed share of them.
+    std::atomic<size_t> next_index(0);
+    auto worker = [&]() {
+        for (size_t i = next_index++; i < count; i = next_index++) task(i);
+    };
+    const size_t num_workers = std::min<size_t>(std::max(1u, std::thread::hardware_concurrency()), count);
+    std::vector<std::thread> workers;
+    for (size_t i = 1; i < num_workers; ++i) workers.emplace_back(worker);
+    worker();
+    for (std::thread& each_worker : workers) each_worker.join();
 }
 
 std::string get_directory_of_file(const std::string& path) {
@@ -126,7 +432,7 @@ std::string get_basename(std::string& path) {
         start_index = -1;
     }
     std::string filename = path.substr(start_index + 1);
-    std::regex basename_pattern(R"(^(.*)\.vm$)");
+    std::regex basename_pattern(R"(^(.*)\.vm(ir)?$)");
     std::smatch matches;
     if (!std::regex_search(filename, matches, basename_pattern)) {
         return filename;
@@ -136,6 +442,6 @@ std::string get_basename(std::string& path) {
 }
 
 bool is_vm_file(const std::string& path) {
-    int back = path.size() - 1;
-    return path[back - 2] == '.' && path[back - 1] == 'v' &&  path[back] == 'm';
+    const std::string extension = std::filesystem::path(path).extension();
+    return extension == ".vm" || extension == ".vmir";
 }